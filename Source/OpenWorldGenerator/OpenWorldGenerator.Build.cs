@@ -26,10 +26,11 @@ public class OpenWorldGenerator : ModuleRules
 			"ChaosSolverEngine",
 			"PhysicsCore",
 			"RenderCore",
+			"RHI",
 			"DynamicMesh",
 			"Foliage",
 			"StructUtils"
 		} );
-		PrivateDependencyModuleNames.AddRange(new string[] {});
+		PrivateDependencyModuleNames.AddRange(new string[] { "Projects" });
 	}
 }
@@ -0,0 +1,331 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "Commandlets/OWGPregenerateWorldCommandlet.h"
+#include "OpenWorldGeneratorSubsystem.h"
+#include "OWGTrace.h"
+#include "Algo/Reverse.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Partition/OWGChunk.h"
+#include "Partition/OWGServerChunkManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC( LogOWGPregeneration, Log, All );
+
+namespace PregenerateWorldInternal
+{
+	/** Name of the file in the region folder listing the regions that have been fully pregenerated, together with the parameters of the run that has generated them */
+	static const TCHAR* ProgressFilename = TEXT("Pregeneration.progress");
+	/** Prefixes of the progress file lines recording the world and the area of the run */
+	static const TCHAR* WorldParametersPrefix = TEXT("World=");
+	static const TCHAR* AreaParametersPrefix = TEXT("Area=");
+	/** Upper bound on the delta time passed to the world tick, to avoid huge time steps after a long GC or region save */
+	static constexpr double MaxTickDeltaTime = 0.1;
+	/** Interval between garbage collections, in seconds */
+	static constexpr double GarbageCollectionInterval = 30.0;
+	/** Interval between progress reports, in seconds */
+	static constexpr double ProgressReportInterval = 10.0;
+}
+
+void UOWGPregenerationStreamingProvider::GetStreamingSources( TArray<FChunkStreamingSource>& OutStreamingSources ) const
+{
+	for ( const FChunkCoord& ChunkCoord : ActiveChunks )
+	{
+		// Box source covering just the chunk itself
+		OutStreamingSources.Add( FChunkStreamingSource( TargetStage, 0, ChunkCoord.ToOriginWorldLocation(), FVector( 1.0f ) ) );
+	}
+}
+
+UOWGPregenerateWorldCommandlet::UOWGPregenerateWorldCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UOWGPregenerateWorldCommandlet::Main( const FString& Params )
+{
+	FString MapName;
+	FString WorldGeneratorName;
+	FString RegionFolder;
+	FString TargetStageName = TEXT("Decoration");
+	int32 WorldSeed = 0;
+	int32 Radius = 0;
+	int32 CenterX = 0;
+	int32 CenterY = 0;
+	int32 MaxConcurrentChunks = FPlatformMisc::NumberOfCoresIncludingHyperthreads() * 2;
+
+	if ( !FParse::Value( *Params, TEXT("Map="), MapName ) || !FParse::Value( *Params, TEXT("WorldGenerator="), WorldGeneratorName ) ||
+		!FParse::Value( *Params, TEXT("RegionFolder="), RegionFolder ) || !FParse::Value( *Params, TEXT("Radius="), Radius ) )
+	{
+		UE_LOG( LogOWGPregeneration, Error, TEXT("Usage: -run=OWGPregenerateWorld -Map=<Map> -WorldGenerator=<Generator> -Seed=<Seed> -RegionFolder=<Path> -Radius=<Chunks> [-CenterX=<Chunk> -CenterY=<Chunk>] [-Stage=Decoration] [-MaxConcurrentChunks=<Num>]") );
+		return 1;
+	}
+	FParse::Value( *Params, TEXT("Seed="), WorldSeed );
+	FParse::Value( *Params, TEXT("CenterX="), CenterX );
+	FParse::Value( *Params, TEXT("CenterY="), CenterY );
+	FParse::Value( *Params, TEXT("Stage="), TargetStageName );
+	FParse::Value( *Params, TEXT("MaxConcurrentChunks="), MaxConcurrentChunks );
+	MaxConcurrentChunks = FMath::Max( MaxConcurrentChunks, 1 );
+
+	const int64 TargetStageValue = StaticEnum<EChunkGeneratorStage>()->GetValueByNameString( TargetStageName );
+	if ( TargetStageValue == INDEX_NONE || TargetStageValue > (int64) EChunkGeneratorStage::Latest )
+	{
+		UE_LOG( LogOWGPregeneration, Error, TEXT("Invalid generation stage '%s'"), *TargetStageName );
+		return 1;
+	}
+	const EChunkGeneratorStage TargetStage = (EChunkGeneratorStage) TargetStageValue;
+
+	UOWGWorldGeneratorConfiguration* WorldGenerator = UOpenWorldGeneratorSubsystem::LoadWorldGeneratorPackageFromShortName( WorldGeneratorName );
+	if ( WorldGenerator == nullptr )
+	{
+		UE_LOG( LogOWGPregeneration, Error, TEXT("Failed to load world generator '%s'"), *WorldGeneratorName );
+		return 1;
+	}
+
+	RegionFolder = FPaths::ConvertRelativePathToFull( RegionFolder );
+	IFileManager::Get().MakeDirectory( *RegionFolder, true );
+	const FString ProgressFilename = FPaths::Combine( RegionFolder, PregenerateWorldInternal::ProgressFilename );
+
+	// Completed regions can only be skipped if they have been generated for the same area, since a previous run might have covered them only partially
+	const FString WorldParameters = FString::Printf( TEXT("%s %d"), *WorldGenerator->GetPathName(), WorldSeed );
+	const FString AreaParameters = FString::Printf( TEXT("%d %d %d %s"), CenterX, CenterY, Radius, *TargetStageName );
+	FString RecordedWorldParameters;
+	FString RecordedAreaParameters;
+	TSet<FChunkCoord> CompletedRegions = LoadCompletedRegions( ProgressFilename, RecordedWorldParameters, RecordedAreaParameters );
+
+	// Chunks already in the region folder would be loaded instead of generated, so generating a different world into it would mix the two worlds
+	if ( !RecordedWorldParameters.IsEmpty() && RecordedWorldParameters != WorldParameters )
+	{
+		UE_LOG( LogOWGPregeneration, Error, TEXT("Region folder '%s' has been pregenerated with a different world generator or seed (%s), refusing to mix it with '%s'. Use an empty region folder"),
+			*RegionFolder, *RecordedWorldParameters, *WorldParameters );
+		return 1;
+	}
+	if ( RecordedWorldParameters.IsEmpty() || RecordedAreaParameters != AreaParameters )
+	{
+		if ( !CompletedRegions.IsEmpty() )
+		{
+			UE_LOG( LogOWGPregeneration, Display, TEXT("Discarding the progress of the previous run because it has been made for a different area or stage (%s)"), *RecordedAreaParameters );
+			CompletedRegions.Empty();
+		}
+		ResetProgress( ProgressFilename, WorldParameters, AreaParameters );
+	}
+
+	// Load the map as a game world, the same way the dedicated server would
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext( EWorldType::Game );
+	FString LoadMapError;
+	if ( !GEngine->LoadMap( WorldContext, FURL( *MapName ), nullptr, LoadMapError ) )
+	{
+		UE_LOG( LogOWGPregeneration, Error, TEXT("Failed to load map '%s': %s"), *MapName, *LoadMapError );
+		return 1;
+	}
+	UWorld* World = WorldContext.World();
+
+	UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = World ? World->GetSubsystem<UOpenWorldGeneratorSubsystem>() : nullptr;
+	UOWGServerChunkManager* ChunkManager = OpenWorldGeneratorSubsystem ? Cast<UOWGServerChunkManager>( OpenWorldGeneratorSubsystem->GetChunkManager().GetObject() ) : nullptr;
+	if ( ChunkManager == nullptr )
+	{
+		UE_LOG( LogOWGPregeneration, Error, TEXT("Map '%s' does not have an open world generator server chunk manager. Make sure it uses a game mode implementing IInterface_OWGGameMode"), *MapName );
+		return 1;
+	}
+	OpenWorldGeneratorSubsystem->OverrideWorldParameters( WorldGenerator, WorldSeed, RegionFolder );
+
+	UOWGPregenerationStreamingProvider* StreamingProvider = NewObject<UOWGPregenerationStreamingProvider>( ChunkManager );
+	StreamingProvider->TargetStage = TargetStage;
+	ChunkManager->RegisterStreamingProvider( StreamingProvider );
+
+	// Collect the chunks in the radius, grouped by region, skipping the regions completed by the previous runs
+	const FChunkCoord CenterChunkCoord( CenterX, CenterY );
+	TMap<FChunkCoord, TArray<FChunkCoord>> RegionChunks;
+
+	for ( int32 PosX = -Radius; PosX <= Radius; PosX++ )
+	{
+		for ( int32 PosY = -Radius; PosY <= Radius; PosY++ )
+		{
+			if ( PosX * PosX + PosY * PosY <= Radius * Radius )
+			{
+				const FChunkCoord ChunkCoord( CenterX + PosX, CenterY + PosY );
+				if ( !CompletedRegions.Contains( ChunkCoord.ToRegionCoord() ) )
+				{
+					RegionChunks.FindOrAdd( ChunkCoord.ToRegionCoord() ).Add( ChunkCoord );
+				}
+			}
+		}
+	}
+
+	// Regions closest to the center are generated first, so the most visited area is available even if the pregeneration is interrupted
+	const auto ChunkDistanceSquared = [&]( const FChunkCoord& ChunkCoord )
+	{
+		return FMath::Square( (int64) ChunkCoord.PosX - CenterChunkCoord.PosX ) + FMath::Square( (int64) ChunkCoord.PosY - CenterChunkCoord.PosY );
+	};
+	TArray<FChunkCoord> RegionsToGenerate;
+	RegionChunks.GenerateKeyArray( RegionsToGenerate );
+	RegionsToGenerate.Sort( [&]( const FChunkCoord& A, const FChunkCoord& B )
+	{
+		return FVector2D::DistSquared( FVector2D( A.ToRegionOriginWorldLocation() ), FVector2D( CenterChunkCoord.ToOriginWorldLocation() ) ) <
+			FVector2D::DistSquared( FVector2D( B.ToRegionOriginWorldLocation() ), FVector2D( CenterChunkCoord.ToOriginWorldLocation() ) );
+	} );
+
+	TArray<FChunkCoord> PendingChunks;
+	TMap<FChunkCoord, int32> RemainingChunksPerRegion;
+	for ( const FChunkCoord& RegionCoord : RegionsToGenerate )
+	{
+		TArray<FChunkCoord>& Chunks = RegionChunks.FindChecked( RegionCoord );
+		Chunks.Sort( [&]( const FChunkCoord& A, const FChunkCoord& B ) { return ChunkDistanceSquared( A ) < ChunkDistanceSquared( B ); } );
+
+		PendingChunks.Append( Chunks );
+		RemainingChunksPerRegion.Add( RegionCoord, Chunks.Num() );
+	}
+	// Chunks are popped from the back of the array
+	Algo::Reverse( PendingChunks );
+
+	const int32 TotalChunks = PendingChunks.Num();
+	UE_LOG( LogOWGPregeneration, Display, TEXT("Pregenerating %d chunks in %d regions up to the %s stage (%d regions already completed) with up to %d chunks in flight"),
+		TotalChunks, RegionsToGenerate.Num(), *TargetStageName, CompletedRegions.Num(), MaxConcurrentChunks );
+
+	// Fully generated regions are evicted once all of their chunks can be unloaded, so the memory use does not grow with the radius
+	TArray<FChunkCoord> RegionsPendingEviction;
+	int32 NumCompletedChunks = 0;
+	bool bInterrupted = false;
+	const double StartTime = FPlatformTime::Seconds();
+	double LastTickTime = StartTime;
+	double LastGarbageCollectionTime = StartTime;
+	double LastProgressReportTime = StartTime;
+
+	while ( !PendingChunks.IsEmpty() || !StreamingProvider->ActiveChunks.IsEmpty() || !RegionsPendingEviction.IsEmpty() )
+	{
+		if ( IsEngineExitRequested() )
+		{
+			bInterrupted = true;
+			break;
+		}
+
+		// Keep the amount of chunks in flight bounded, the async work of all of them (noise, PCG, meshes) is spread across the worker threads
+		while ( StreamingProvider->ActiveChunks.Num() < MaxConcurrentChunks && !PendingChunks.IsEmpty() )
+		{
+			StreamingProvider->ActiveChunks.Add( PendingChunks.Pop() );
+		}
+
+		const double CurrentTime = FPlatformTime::Seconds();
+		TickWorld( World, FMath::Min( CurrentTime - LastTickTime, PregenerateWorldInternal::MaxTickDeltaTime ) );
+		LastTickTime = CurrentTime;
+
+		for ( TSet<FChunkCoord>::TIterator It( StreamingProvider->ActiveChunks ); It; ++It )
+		{
+			const FChunkCoord ChunkCoord = *It;
+			const AOWGChunk* Chunk = ChunkManager->FindChunk( ChunkCoord );
+			if ( Chunk == nullptr )
+			{
+				// The chunk should have been loaded by the streaming tick, if it cannot be created at all there is nothing to wait for
+				if ( ChunkManager->LoadOrCreateChunk( ChunkCoord ) != nullptr )
+				{
+					continue;
+				}
+				UE_LOG( LogOWGPregeneration, Warning, TEXT("Failed to create chunk %d,%d, skipping it"), ChunkCoord.PosX, ChunkCoord.PosY );
+			}
+			// The chunk has finished the target stage once it has advanced past it
+			else if ( Chunk->GetCurrentGenerationStage() <= TargetStage )
+			{
+				continue;
+			}
+
+			It.RemoveCurrent();
+			NumCompletedChunks++;
+
+			const FChunkCoord RegionCoord = ChunkCoord.ToRegionCoord();
+			if ( --RemainingChunksPerRegion.FindChecked( RegionCoord ) == 0 )
+			{
+				RegionsPendingEviction.Add( RegionCoord );
+			}
+		}
+
+		for ( int32 RegionIndex = RegionsPendingEviction.Num() - 1; RegionIndex >= 0; RegionIndex-- )
+		{
+			const FChunkCoord RegionCoord = RegionsPendingEviction[ RegionIndex ];
+			OWG_TRACE_CHUNK_SCOPE( SavePregeneratedRegion, RegionCoord );
+
+			if ( ChunkManager->UnloadRegionContainer( RegionCoord ) )
+			{
+				MarkRegionCompleted( ProgressFilename, RegionCoord );
+				UE_LOG( LogOWGPregeneration, Display, TEXT("Region %d,%d completed"), RegionCoord.PosX, RegionCoord.PosY );
+				RegionsPendingEviction.RemoveAtSwap( RegionIndex );
+			}
+		}
+
+		if ( CurrentTime - LastGarbageCollectionTime >= PregenerateWorldInternal::GarbageCollectionInterval )
+		{
+			CollectGarbage( GARBAGE_COLLECTION_KEEPFLAGS );
+			LastGarbageCollectionTime = FPlatformTime::Seconds();
+		}
+		if ( CurrentTime - LastProgressReportTime >= PregenerateWorldInternal::ProgressReportInterval )
+		{
+			const double ElapsedTime = CurrentTime - StartTime;
+			UE_LOG( LogOWGPregeneration, Display, TEXT("Pregenerated %d/%d chunks (%.1f%%) in %.0fs, %.2f chunks/s"), NumCompletedChunks, TotalChunks,
+				TotalChunks > 0 ? NumCompletedChunks * 100.0 / TotalChunks : 100.0, ElapsedTime, NumCompletedChunks / FMath::Max( ElapsedTime, 1.0 ) );
+			LastProgressReportTime = CurrentTime;
+		}
+	}
+
+	// Tearing down the world persists all of the loaded regions, including the partially generated neighbours of the generated chunks
+	ChunkManager->UnregisterStreamingProvider( StreamingProvider );
+	World->DestroyWorld( false );
+	GEngine->DestroyWorldContext( World );
+
+	UE_LOG( LogOWGPregeneration, Display, TEXT("Pregeneration %s: %d/%d chunks generated in %.0fs"), bInterrupted ? TEXT("interrupted") : TEXT("finished"),
+		NumCompletedChunks, TotalChunks, FPlatformTime::Seconds() - StartTime );
+	return bInterrupted ? 1 : 0;
+}
+
+void UOWGPregenerateWorldCommandlet::TickWorld( UWorld* World, float DeltaTime )
+{
+	World->Tick( LEVELTICK_All, DeltaTime );
+
+	// Dispatch the game thread callbacks of the async tasks, such as the landscape LOD generation
+	FTaskGraphInterface::Get().ProcessThreadUntilIdle( ENamedThreads::GameThread );
+	FTSTicker::GetCoreTicker().Tick( DeltaTime );
+	GFrameCounter++;
+}
+
+TSet<FChunkCoord> UOWGPregenerateWorldCommandlet::LoadCompletedRegions( const FString& ProgressFilename, FString& OutWorldParameters, FString& OutAreaParameters )
+{
+	TSet<FChunkCoord> CompletedRegions;
+	TArray<FString> ProgressLines;
+
+	if ( FFileHelper::LoadFileToStringArray( ProgressLines, *ProgressFilename ) )
+	{
+		for ( const FString& ProgressLine : ProgressLines )
+		{
+			FString RegionX, RegionY;
+			if ( ProgressLine.StartsWith( PregenerateWorldInternal::WorldParametersPrefix ) )
+			{
+				OutWorldParameters = ProgressLine.RightChop( FCString::Strlen( PregenerateWorldInternal::WorldParametersPrefix ) );
+			}
+			else if ( ProgressLine.StartsWith( PregenerateWorldInternal::AreaParametersPrefix ) )
+			{
+				OutAreaParameters = ProgressLine.RightChop( FCString::Strlen( PregenerateWorldInternal::AreaParametersPrefix ) );
+			}
+			else if ( ProgressLine.Split( TEXT(","), &RegionX, &RegionY ) )
+			{
+				CompletedRegions.Add( FChunkCoord( FCString::Atoi( *RegionX ), FCString::Atoi( *RegionY ) ) );
+			}
+		}
+	}
+	return CompletedRegions;
+}
+
+void UOWGPregenerateWorldCommandlet::ResetProgress( const FString& ProgressFilename, const FString& WorldParameters, const FString& AreaParameters )
+{
+	FFileHelper::SaveStringToFile( FString::Printf( TEXT("%s%s%s%s%s%s"), PregenerateWorldInternal::WorldParametersPrefix, *WorldParameters, LINE_TERMINATOR,
+		PregenerateWorldInternal::AreaParametersPrefix, *AreaParameters, LINE_TERMINATOR ), *ProgressFilename );
+}
+
+void UOWGPregenerateWorldCommandlet::MarkRegionCompleted( const FString& ProgressFilename, const FChunkCoord& RegionCoord )
+{
+	FFileHelper::SaveStringToFile( FString::Printf( TEXT("%d,%d%s"), RegionCoord.PosX, RegionCoord.PosY, LINE_TERMINATOR ), *ProgressFilename,
+		FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append );
+}
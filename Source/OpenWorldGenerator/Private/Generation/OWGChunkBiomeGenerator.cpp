@@ -100,7 +100,7 @@ bool UOWGChunkBiomeGenerator::AdvanceChunkGeneration_Implementation()
 	// Initialize chunk's biome palette, and copy the global biome data into the palette indices
 	FChunkBiomePalette ChunkBiomePalette( ChunkProtoBiomePalette );
 	// Biome map does not support interpolation, even though Lerp is defined for FBiomePaletteIndex
-	FChunkData2D ChunkBiomeMap = FChunkData2D::Create<FBiomePaletteIndex>( NoiseResolutionXY, false );
+	FChunkData2D ChunkBiomeMap = FChunkData2D::CreateUninitialized<FBiomePaletteIndex>( NoiseResolutionXY, false );
 
 	FBiomePaletteIndex* RawBiomeDataPtr = ChunkBiomeMap.GetMutableDataPtr<FBiomePaletteIndex>();
 	for ( int32 ElementIndex = 0; ElementIndex < NoiseResolutionXY * NoiseResolutionXY; ElementIndex++ )
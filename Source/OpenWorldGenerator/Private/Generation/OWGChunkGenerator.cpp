@@ -45,6 +45,17 @@ void UOWGChunkGenerator::NotifyAboutToUnloadChunk_Implementation()
 {
 }
 
+bool UOWGChunkGenerator::CanReuseGeneratorInstance() const
+{
+	return bReuseGeneratorInstances;
+}
+
+void UOWGChunkGenerator::ResetGeneratorState_Implementation()
+{
+	// Target biomes are assigned by the chunk each time the generator is acquired, so there is nothing to carry over to the next chunk
+	TargetBiomes.Empty();
+}
+
 bool UOWGChunkGenerator::WaitForAdjacentChunkGeneration( EChunkGeneratorStage TargetStage, int32 Range )
 {
 	if ( const UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = UOpenWorldGeneratorSubsystem::Get( this ) )
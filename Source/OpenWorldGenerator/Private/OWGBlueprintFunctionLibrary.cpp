@@ -2,6 +2,8 @@
 
 #include "OWGBlueprintFunctionLibrary.h"
 #include "OpenWorldGeneratorSubsystem.h"
+#include "Async/ParallelFor.h"
+#include "Partition/ChunkLandscapeTransaction.h"
 #include "Partition/OWGChunk.h"
 #include "Partition/OWGChunkManagerInterface.h"
 
@@ -44,14 +46,17 @@ FVector2D UOWGBlueprintFunctionLibrary::GetPolymorphicBrushExtents( const FPolym
 
 void UOWGBlueprintFunctionLibrary::ModifyWorldLandscape( const UObject* WorldContext, const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, const FChunkLandscapeModification& LandscapeModification, float MinWeight )
 {
-	TArray<AOWGChunk*> LoadedChunks;
-	const FVector BrushExtents = FVector( FVector2d( Brush->GetBrushExtents() ), 0.0f );
-	GetLoadedChunksInBoundingBox( WorldContext, WorldLocation, BrushExtents, LoadedChunks );
+	FChunkLandscapeTransaction LandscapeTransaction( WorldContext );
+	LandscapeTransaction.ModifyLandscape( WorldLocation, Brush, LandscapeModification, MinWeight );
+}
 
-	// Apply the modification to each chunk
-	for ( AOWGChunk* LoadedChunk : LoadedChunks )
+void UOWGBlueprintFunctionLibrary::ModifyWorldLandscapeBatch( const UObject* WorldContext, const TArray<FChunkLandscapeModificationStamp>& Stamps )
+{
+	// Apply all stamps first and recalculate each modified chunk only once when the transaction goes out of scope
+	FChunkLandscapeTransaction LandscapeTransaction( WorldContext );
+	for ( const FChunkLandscapeModificationStamp& Stamp : Stamps )
 	{
-		LoadedChunk->ModifyLandscape( WorldLocation, Brush, LandscapeModification, MinWeight );
+		LandscapeTransaction.ModifyLandscape( Stamp.WorldLocation, Stamp.Brush, Stamp.LandscapeModification, Stamp.MinWeight );
 	}
 }
 
@@ -61,18 +66,31 @@ FChunkLandscapeMetrics UOWGBlueprintFunctionLibrary::GetChunkLandscapeMetrics( c
 	const FVector BrushExtents = FVector( FVector2d( Brush->GetBrushExtents() ), 0.0f );
 	GetLoadedChunksInBoundingBox( WorldContext, WorldLocation, BrushExtents, LoadedChunks );
 
-	// Sample the metrics from each chunk along the way, and then combine them all
-	TArray<FChunkLandscapeMetrics> PerChunkMetrics;
-	for ( AOWGChunk* LoadedChunk : LoadedChunks )
+	if ( LoadedChunks.IsEmpty() )
 	{
-		PerChunkMetrics.Add( LoadedChunk->GetLandscapeMetrics( WorldLocation, Brush, bIncludeWeights, MinWeight ) );
+		return FChunkLandscapeMetrics{};
 	}
+
+	// All chunks share the same grid resolution, so the brush only needs to be rendered once
+	const FChunkData2D* HeightMapData = LoadedChunks[ 0 ]->FindRawChunkData( ChunkDataID::SurfaceHeightmap );
+	check( HeightMapData );
+	const FChunkLandscapeBrushGrid BrushGrid = FChunkLandscapeBrushGrid::Render( WorldLocation, Brush, HeightMapData->GetSurfaceResolutionXY() );
+
+	// Sample the metrics from each chunk in parallel, and then combine them all
+	TArray<FChunkLandscapeMetrics> PerChunkMetrics;
+	PerChunkMetrics.SetNum( LoadedChunks.Num() );
+
+	ParallelFor( LoadedChunks.Num(), [&]( int32 ChunkIndex )
+	{
+		PerChunkMetrics[ ChunkIndex ] = LoadedChunks[ ChunkIndex ]->GetLandscapeMetricsFromBrushGrid( BrushGrid, bIncludeWeights, MinWeight );
+	} );
 	return FChunkLandscapeMetrics::Merge( WorldContext, PerChunkMetrics );
 }
 
 FChunkLandscapePoint UOWGBlueprintFunctionLibrary::GetChunkLandscapePoint( const UObject* WorldContext, const FVector& WorldLocation )
 {
-	if ( const UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = UOpenWorldGeneratorSubsystem::Get( WorldContext ) )
+	const UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = UOpenWorldGeneratorSubsystem::Get( WorldContext );
+	if ( OpenWorldGeneratorSubsystem && OpenWorldGeneratorSubsystem->GetChunkManager() )
 	{
 		const FChunkCoord ChunkCoord = FChunkCoord::FromWorldLocation( WorldLocation );
 		AOWGChunk* Chunk = OpenWorldGeneratorSubsystem->GetChunkManager()->FindChunk( ChunkCoord );
@@ -88,11 +106,18 @@ FChunkLandscapePoint UOWGBlueprintFunctionLibrary::GetChunkLandscapePoint( const
 	return EmptyLandscapePoint;
 }
 
+bool UOWGBlueprintFunctionLibrary::LineTraceWorldLandscape( const UObject* WorldContext, const FVector& TraceStart, const FVector& TraceEnd, FChunkLandscapeTraceHit& OutHit )
+{
+	const FChunkLandscapeTracer LandscapeTracer( WorldContext, FBox( TArray<FVector>{ TraceStart, TraceEnd } ) );
+	return LandscapeTracer.LineTrace( TraceStart, TraceEnd, OutHit );
+}
+
 void UOWGBlueprintFunctionLibrary::GetLoadedChunksInBoundingBox( const UObject* WorldContext, const FVector& WorldLocation, const FVector& BoxExtents, TArray<AOWGChunk*>& OutChunks )
 {
 	OutChunks.Reset();
 	
-	if ( const UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = UOpenWorldGeneratorSubsystem::Get( WorldContext ) )
+	const UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = UOpenWorldGeneratorSubsystem::Get( WorldContext );
+	if ( OpenWorldGeneratorSubsystem && OpenWorldGeneratorSubsystem->GetChunkManager() )
 	{
 		const FChunkCoord MinChunkCoord = FChunkCoord::FromWorldLocation( WorldLocation - BoxExtents );
 		const FChunkCoord MaxChunkCoord = FChunkCoord::FromWorldLocation( WorldLocation + BoxExtents );
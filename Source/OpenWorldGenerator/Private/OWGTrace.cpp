@@ -0,0 +1,46 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "OWGTrace.h"
+
+#if CPUPROFILERTRACE_ENABLED
+UE_TRACE_CHANNEL_DEFINE( OWGChannel );
+
+FOWGTraceChunkScope::FOWGTraceChunkScope( uint32& InOutSpecId, const TCHAR* StaticName, const FChunkCoord& ChunkCoord, int32 Index )
+{
+	if ( UE_TRACE_CHANNELEXPR_IS_ENABLED( OWGChannel | CpuChannel ) )
+	{
+		if ( InOutSpecId == 0 )
+		{
+			InOutSpecId = FCpuProfilerTrace::OutputEventType( StaticName );
+		}
+		FCpuProfilerTrace::OutputBeginEvent( InOutSpecId );
+		BeginChunkCoordEvent( ChunkCoord, Index );
+	}
+}
+
+FOWGTraceChunkScope::FOWGTraceChunkScope( const TCHAR* ScopeName, const FChunkCoord& ChunkCoord, int32 Index )
+{
+	if ( ScopeName != nullptr && UE_TRACE_CHANNELEXPR_IS_ENABLED( OWGChannel | CpuChannel ) )
+	{
+		FCpuProfilerTrace::OutputBeginDynamicEvent( ScopeName );
+		BeginChunkCoordEvent( ChunkCoord, Index );
+	}
+}
+
+FOWGTraceChunkScope::~FOWGTraceChunkScope()
+{
+	// End the chunk coordinate scope and the outer scope. Events are ended even if the channel has been disabled in the meantime, so they stay balanced
+	if ( bEventsBegun )
+	{
+		FCpuProfilerTrace::OutputEndEvent();
+		FCpuProfilerTrace::OutputEndEvent();
+	}
+}
+
+void FOWGTraceChunkScope::BeginChunkCoordEvent( const FChunkCoord& ChunkCoord, int32 Index )
+{
+	const FString ChunkCoordName = Index != INDEX_NONE ? FString::Printf( TEXT("Chunk %d,%d #%d"), ChunkCoord.PosX, ChunkCoord.PosY, Index ) : FString::Printf( TEXT("Chunk %d,%d"), ChunkCoord.PosX, ChunkCoord.PosY );
+	FCpuProfilerTrace::OutputBeginDynamicEvent( *ChunkCoordName );
+	bEventsBegun = true;
+}
+#endif
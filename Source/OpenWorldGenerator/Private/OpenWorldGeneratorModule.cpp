@@ -4,7 +4,9 @@
 #include "OpenWorldGeneratorSubsystem.h"
 #include "Engine/World.h"
 #include "GameFramework/HUD.h"
+#include "Partition/ChunkData2D.h"
 #include "Partition/OWGServerChunkManager.h"
+#include "Partition/TerraformingBrush.h"
 
 OPENWORLDGENERATOR_API DEFINE_LOG_CATEGORY(LogOpenWorldGenerator);
 
@@ -25,6 +27,11 @@ void FOpenWorldGeneratorModule::StartupModule()
 
 void FOpenWorldGeneratorModule::ShutdownModule()
 {
+	// Chunk data pool outlives the module, so release the blocks it holds while the allocator and the console variables are still around
+	FChunkData2D::ShutdownPooledMemory();
+
+	// Stamp cache is a function-local static too, and the brushes it holds need their script structs to be destroyed
+	FTerraformingBrushStampCache::Get().Reset();
 }
 
 IMPLEMENT_MODULE(FOpenWorldGeneratorModule, OpenWorldGenerator)
@@ -7,7 +7,9 @@
 UOpenWorldGeneratorSettings::UOpenWorldGeneratorSettings() :
 	ChunkClass( AOWGChunk::StaticClass() ),
 	RegionContainerClass( UOWGRegionContainer::StaticClass() ),
-	ChunkUnloadIdleTime( 20.0f )
+	ChunkUnloadIdleTime( 20.0f ),
+	MaxPooledChunkActors( 0 ),
+	FarFieldProxyDistance( 0.0f )
 {
 }
 
@@ -10,11 +10,23 @@
 #include "GameFramework/GameModeBase.h"
 #include "Misc/PackageName.h"
 #include "Net/UnrealNetwork.h"
+#include "Partition/OWGChunk.h"
 #include "Partition/OWGChunkManagerInterface.h"
+#include "Partition/OWGClientChunkManager.h"
 #include "Partition/OWGServerChunkManager.h"
 #include "Rendering/ChunkTextureManager.h"
 #include "UObject/Package.h"
 
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT("Pooled Chunk Generators"), STAT_PooledChunkGenerators, STATGROUP_Game );
+DECLARE_DWORD_COUNTER_STAT( TEXT("Allocated Chunk Generators"), STAT_AllocatedChunkGenerators, STATGROUP_Game );
+
+static TAutoConsoleVariable CVarMaxPooledGeneratorsPerClass(
+	TEXT("owg.MaxPooledGeneratorsPerClass"),
+	16,
+	TEXT("Maximum number of finished chunk generator instances of a single class kept around to be reused by other chunks. 0 disables the generator reuse"),
+	ECVF_Default
+);
+
 UOpenWorldGeneratorSubsystem::UOpenWorldGeneratorSubsystem()
 {
 	TextureManager = CreateDefaultSubobject<UChunkTextureManager>( TEXT("ChunkTextureManager") );
@@ -41,6 +53,12 @@ void UOpenWorldGeneratorSubsystem::Initialize(FSubsystemCollectionBase& Collecti
 {
 	Super::Initialize(Collection);
 
+	// Clients have no game mode to pick the world parameters, they receive them from the server later and create the chunk manager then
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
 	IInterface_OWGGameMode* GameMode = CastChecked<IInterface_OWGGameMode>(GetWorld()->GetAuthGameMode());
 	
 	FOWGSaveGameData LoadedSaveGameData;
@@ -97,7 +115,10 @@ void UOpenWorldGeneratorSubsystem::OnWorldBeginPlay(UWorld& InWorld)
 {
 	Super::OnWorldBeginPlay(InWorld);
 	
-	ChunkManager->BeginPlay();
+	if (ChunkManager)
+	{
+		ChunkManager->BeginPlay();
+	}
 }
 
 bool UOpenWorldGeneratorSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
@@ -108,8 +129,8 @@ bool UOpenWorldGeneratorSubsystem::DoesSupportWorldType(const EWorldType::Type W
 bool UOpenWorldGeneratorSubsystem::ShouldCreateSubsystem(UObject* Outer) const
 {
 	UWorld* World = CastChecked<UWorld>(Outer);
-	return Super::ShouldCreateSubsystem(Outer) && World->GetAuthGameMode() &&
-		World->GetAuthGameMode()->Implements<UInterface_OWGGameMode>();
+	return Super::ShouldCreateSubsystem(Outer) && (World->GetNetMode() == NM_Client || (World->GetAuthGameMode() &&
+		World->GetAuthGameMode()->Implements<UInterface_OWGGameMode>()));
 }
 
 UOWGWorldGeneratorConfiguration* UOpenWorldGeneratorSubsystem::LoadWorldGeneratorPackageFromShortName( const FString& InWorldGeneratorName )
@@ -145,12 +166,101 @@ UOWGWorldGeneratorConfiguration* UOpenWorldGeneratorSubsystem::LoadWorldGenerato
 	return nullptr;
 }
 
+void UOpenWorldGeneratorSubsystem::OverrideWorldParameters( UOWGWorldGeneratorConfiguration* InWorldGenerator, int32 InWorldSeed, const FString& InRegionFolderPath )
+{
+	check( InWorldGenerator );
+	WorldGeneratorDefinition = InWorldGenerator;
+	WorldSeed = InWorldSeed;
+
+	if ( UOWGServerChunkManager* ServerChunkManager = Cast<UOWGServerChunkManager>( ChunkManager.GetObject() ) )
+	{
+		ServerChunkManager->SetRegionFolderPath( InRegionFolderPath );
+	}
+}
+
+void UOpenWorldGeneratorSubsystem::InitializeClientWorldParameters( UOWGWorldGeneratorConfiguration* InWorldGenerator, int32 InWorldSeed )
+{
+	check( InWorldGenerator && GetWorld()->GetNetMode() == NM_Client );
+	if ( ChunkManager )
+	{
+		return;
+	}
+	WorldGeneratorDefinition = InWorldGenerator;
+	WorldSeed = InWorldSeed;
+
+	ChunkManager = NewObject<UOWGClientChunkManager>( this, TEXT("ClientChunkManager"), RF_Transient );
+	ChunkManager->Initialize();
+
+	// World parameters usually arrive after the world has already begun play
+	if ( GetWorld()->HasBegunPlay() )
+	{
+		ChunkManager->BeginPlay();
+	}
+}
+
 void UOpenWorldGeneratorSubsystem::Deinitialize()
 {
 	Super::Deinitialize();
 
-	ChunkManager->Deinitialize();
+	if ( ChunkManager )
+	{
+		ChunkManager->Deinitialize();
+	}
 	TextureManager->ReleasePooledTextures();
+
+	for ( const TPair<TSubclassOf<UOWGChunkGenerator>, FChunkGeneratorPool>& Pair : PooledChunkGenerators )
+	{
+		DEC_DWORD_STAT_BY( STAT_PooledChunkGenerators, Pair.Value.Generators.Num() );
+	}
+	PooledChunkGenerators.Empty();
+}
+
+UOWGChunkGenerator* UOpenWorldGeneratorSubsystem::AcquireChunkGenerator( AOWGChunk* Chunk, TSubclassOf<UOWGChunkGenerator> GeneratorClass )
+{
+	check( Chunk && GeneratorClass );
+
+	if ( FChunkGeneratorPool* GeneratorPool = PooledChunkGenerators.Find( GeneratorClass ) )
+	{
+		while ( !GeneratorPool->Generators.IsEmpty() )
+		{
+			UOWGChunkGenerator* ChunkGenerator = GeneratorPool->Generators.Pop();
+			DEC_DWORD_STAT( STAT_PooledChunkGenerators );
+
+			// Pooled generators might have been destroyed by the outside code, in which case we just drop them
+			if ( IsValid( ChunkGenerator ) )
+			{
+				// Move the generator into the new chunk. Renaming the object is much cheaper than allocating a new one, and does not leave garbage behind
+				ChunkGenerator->Rename( nullptr, Chunk, REN_DontCreateRedirectors | REN_NonTransactional | REN_DoNotDirty | REN_ForceNoResetLoaders );
+				ChunkGenerator->ClearFlags( RF_Transient );
+				return ChunkGenerator;
+			}
+		}
+	}
+
+	INC_DWORD_STAT( STAT_AllocatedChunkGenerators );
+	return NewObject<UOWGChunkGenerator>( Chunk, GeneratorClass );
+}
+
+void UOpenWorldGeneratorSubsystem::ReleaseChunkGenerator( UOWGChunkGenerator* ChunkGenerator )
+{
+	check( ChunkGenerator );
+
+	// Make sure the save system does not try to save the generator as a part of the chunk it has just finished generating
+	ChunkGenerator->SetFlags( RF_Transient );
+
+	const FChunkGeneratorPool* ExistingGeneratorPool = PooledChunkGenerators.Find( ChunkGenerator->GetClass() );
+	if ( !ChunkGenerator->CanReuseGeneratorInstance() || ( ExistingGeneratorPool && ExistingGeneratorPool->Generators.Num() >= CVarMaxPooledGeneratorsPerClass.GetValueOnGameThread() ) )
+	{
+		ChunkGenerator->MarkAsGarbage();
+		return;
+	}
+
+	// Park the idle generator under the subsystem owning the pool so it does not keep the chunk it has generated alive
+	ChunkGenerator->ResetGeneratorState();
+	ChunkGenerator->Rename( nullptr, this, REN_DontCreateRedirectors | REN_NonTransactional | REN_DoNotDirty | REN_ForceNoResetLoaders );
+
+	PooledChunkGenerators.FindOrAdd( ChunkGenerator->GetClass() ).Generators.Add( ChunkGenerator );
+	INC_DWORD_STAT( STAT_PooledChunkGenerators );
 }
 
 void UOpenWorldGeneratorSubsystem::Tick( float DeltaTime )
@@ -1,6 +1,7 @@
 ﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
 
 #include "Partition/ChunkData2D.h"
+#include "Hash/CityHash.h"
 
 const FName ChunkDataID::SurfaceHeightmap( TEXT("SurfaceHeightmap") );
 const FName ChunkDataID::SurfaceNormal( TEXT("SurfaceNormal") );
@@ -9,41 +10,137 @@ const FName ChunkDataID::SurfaceSteepness( TEXT("SurfaceSteepness") );
 const FName ChunkDataID::SurfaceWeights( TEXT("SurfaceWeights") );
 const FName ChunkDataID::BiomeMap( TEXT("BiomeMap") );
 
+DECLARE_MEMORY_STAT( TEXT("Chunk Data Pooled Memory"), STAT_ChunkDataPooledMemory, STATGROUP_Game );
+DECLARE_DWORD_COUNTER_STAT( TEXT("Chunk Data Pool Hits"), STAT_ChunkDataPoolHits, STATGROUP_Game );
+DECLARE_DWORD_COUNTER_STAT( TEXT("Chunk Data Pool Misses"), STAT_ChunkDataPoolMisses, STATGROUP_Game );
+
+static TAutoConsoleVariable CVarChunkDataPoolMaxBlocksPerSize(
+	TEXT("owg.ChunkDataPoolMaxBlocksPerSize"),
+	64,
+	TEXT("Maximum number of free chunk data blocks of each size kept in the pool for re-use. 0 disables pooling"),
+	ECVF_Default
+);
+
+namespace ChunkData2DInternal
+{
+	/**
+	 * Pool of the chunk data blocks. Chunks allocate a handful of large blocks of the same few sizes when they are loaded, and free them when they are unloaded,
+	 * so recycling the blocks avoids the allocator round trips and the heap fragmentation over long sessions. Blocks are keyed by their size in bytes,
+	 * which is determined by the resolution and the element size of the data.
+	 * The pool is intentionally never destroyed, since chunk data owned by the static objects can be freed during the static destruction after the pool would have been.
+	 * Pooled blocks are released and pooling is disabled on module shutdown instead.
+	 */
+	class FChunkData2DBlockPool
+	{
+		FCriticalSection PoolCriticalSection;
+		TMap<int32, TArray<void*>> FreeBlocksBySize;
+		bool bIsShutDown{false};
+	public:
+		static FChunkData2DBlockPool& Get()
+		{
+			static FChunkData2DBlockPool* BlockPool = new FChunkData2DBlockPool();
+			return *BlockPool;
+		}
+
+		void* Allocate( int32 BlockSize )
+		{
+			{
+				FScopeLock ScopeLock( &PoolCriticalSection );
+				if ( TArray<void*>* FreeBlocks = FreeBlocksBySize.Find( BlockSize ); FreeBlocks && !FreeBlocks->IsEmpty() )
+				{
+					DEC_MEMORY_STAT_BY( STAT_ChunkDataPooledMemory, BlockSize );
+					INC_DWORD_STAT( STAT_ChunkDataPoolHits );
+					return FreeBlocks->Pop();
+				}
+			}
+			INC_DWORD_STAT( STAT_ChunkDataPoolMisses );
+			return FMemory::Malloc( BlockSize );
+		}
+
+		void Free( void* Block, int32 BlockSize )
+		{
+			{
+				FScopeLock ScopeLock( &PoolCriticalSection );
+
+				// Console variable might already be destroyed once the module has been shut down, so it is only read while the pool is active
+				const int32 MaxBlocksPerSize = bIsShutDown ? 0 : CVarChunkDataPoolMaxBlocksPerSize.GetValueOnAnyThread();
+				if ( MaxBlocksPerSize > 0 )
+				{
+					TArray<void*>& FreeBlocks = FreeBlocksBySize.FindOrAdd( BlockSize );
+					if ( FreeBlocks.Num() < MaxBlocksPerSize )
+					{
+						FreeBlocks.Add( Block );
+						INC_MEMORY_STAT_BY( STAT_ChunkDataPooledMemory, BlockSize );
+						return;
+					}
+				}
+			}
+			FMemory::Free( Block );
+		}
+
+		void Trim()
+		{
+			FScopeLock ScopeLock( &PoolCriticalSection );
+			for ( TPair<int32, TArray<void*>>& Pair : FreeBlocksBySize )
+			{
+				for ( void* Block : Pair.Value )
+				{
+					FMemory::Free( Block );
+				}
+				DEC_MEMORY_STAT_BY( STAT_ChunkDataPooledMemory, (int64) Pair.Key * Pair.Value.Num() );
+			}
+			FreeBlocksBySize.Empty();
+		}
+
+		void Shutdown()
+		{
+			{
+				FScopeLock ScopeLock( &PoolCriticalSection );
+				bIsShutDown = true;
+			}
+			Trim();
+		}
+	};
+}
+
+static FAutoConsoleCommand TrimChunkDataPoolCommand(
+	TEXT("owg.TrimChunkDataPool"),
+	TEXT("Frees all of the chunk data blocks currently held in the pool"),
+	FConsoleCommandDelegate::CreateStatic( &FChunkData2D::TrimPooledMemory )
+);
+
 FChunkData2D::FChunkData2D()
 {
 }
 
-FChunkData2D::FChunkData2D( int32 InSurfaceResolutionXY, int32 InDataElementSize, bool InAllowInterpolation ) : DataElementSize( InDataElementSize ), SurfaceResolutionXY( InSurfaceResolutionXY ), bAllowInterpolation( InAllowInterpolation )
+FChunkData2D::FChunkData2D( int32 InSurfaceResolutionXY, int32 InDataElementSize, bool InAllowInterpolation, bool bZeroInitialize ) : DataElementSize( InDataElementSize ), SurfaceResolutionXY( InSurfaceResolutionXY ), bAllowInterpolation( InAllowInterpolation )
 {
 	check( SurfaceResolutionXY >= 0 );
 	check( DataElementSize > 0 || ( DataElementSize == 0 && SurfaceResolutionXY == 0 ) );
 
 	if ( SurfaceResolutionXY > 0 )
 	{
-		const int32 TotalDataSize = SurfaceResolutionXY * SurfaceResolutionXY * DataElementSize;
+		AllocateData();
 
-		SurfaceDataPtr = FMemory::Malloc( TotalDataSize );
-		FMemory::Memzero( SurfaceDataPtr, TotalDataSize );
+		// Recycled blocks contain the data of the previous owner, so they need to be zeroed unless the caller is going to overwrite all of the data anyway
+		if ( bZeroInitialize )
+		{
+			FMemory::Memzero( SurfaceDataPtr, GetTotalDataSize() );
+		}
 	}
 }
 
 FChunkData2D::~FChunkData2D()
 {
-	if ( SurfaceDataPtr )
-	{
-		FMemory::Free( SurfaceDataPtr );
-		SurfaceDataPtr = nullptr;
-	}
+	FreeData();
 }
 
 FChunkData2D::FChunkData2D( const FChunkData2D& InOther ) : DataElementSize( InOther.DataElementSize ), SurfaceResolutionXY( InOther.SurfaceResolutionXY ), bAllowInterpolation( InOther.bAllowInterpolation )
 {
 	if ( SurfaceResolutionXY > 0 && InOther.SurfaceDataPtr )
 	{
-		const int32 TotalDataSize = SurfaceResolutionXY * SurfaceResolutionXY * DataElementSize;
-
-		SurfaceDataPtr = FMemory::Malloc( TotalDataSize );
-		FMemory::Memcpy( SurfaceDataPtr, InOther.SurfaceDataPtr, TotalDataSize );
+		AllocateData();
+		FMemory::Memcpy( SurfaceDataPtr, InOther.SurfaceDataPtr, GetTotalDataSize() );
 	}
 }
 
@@ -63,11 +160,7 @@ FChunkData2D& FChunkData2D::operator=( const FChunkData2D& InOther )
 	if ( this != &InOther )
 	{
 		// Free old data
-		if ( SurfaceDataPtr )
-		{
-			FMemory::Free( SurfaceDataPtr );
-			SurfaceDataPtr = nullptr;
-		}
+		FreeData();
 
 		// Copy other data properties
 		DataElementSize = InOther.DataElementSize;
@@ -77,10 +170,8 @@ FChunkData2D& FChunkData2D::operator=( const FChunkData2D& InOther )
 		// Copy element data from the other data object if it had any
 		if ( SurfaceResolutionXY > 0 && InOther.SurfaceDataPtr )
 		{
-			const int32 TotalDataSize = SurfaceResolutionXY * SurfaceResolutionXY * DataElementSize;
-
-			SurfaceDataPtr = FMemory::Malloc( TotalDataSize );
-			FMemory::Memcpy( SurfaceDataPtr, InOther.SurfaceDataPtr, TotalDataSize );
+			AllocateData();
+			FMemory::Memcpy( SurfaceDataPtr, InOther.SurfaceDataPtr, GetTotalDataSize() );
 		}
 	}
 	return *this;
@@ -99,8 +190,94 @@ FChunkData2D& FChunkData2D::operator=( FChunkData2D&& InOther ) noexcept
 	return *this;
 }
 
+void FChunkData2D::AllocateData()
+{
+	check( SurfaceDataPtr == nullptr );
+	SurfaceDataPtr = ChunkData2DInternal::FChunkData2DBlockPool::Get().Allocate( GetTotalDataSize() );
+}
+
+void FChunkData2D::FreeData()
+{
+	// Size of the block is derived from the current resolution and element size, so this needs to be called before they are changed
+	if ( SurfaceDataPtr )
+	{
+		ChunkData2DInternal::FChunkData2DBlockPool::Get().Free( SurfaceDataPtr, GetTotalDataSize() );
+		SurfaceDataPtr = nullptr;
+	}
+}
+
+void FChunkData2D::TrimPooledMemory()
+{
+	ChunkData2DInternal::FChunkData2DBlockPool::Get().Trim();
+}
+
+void FChunkData2D::ShutdownPooledMemory()
+{
+	ChunkData2DInternal::FChunkData2DBlockPool::Get().Shutdown();
+}
+
+uint64 FChunkData2D::ComputeDataHash() const
+{
+	const int32 Dimensions[] { SurfaceResolutionXY, DataElementSize };
+	const uint64 DataHash = CityHash64( reinterpret_cast<const char*>( Dimensions ), sizeof(Dimensions) );
+
+	if ( SurfaceDataPtr == nullptr )
+	{
+		return DataHash;
+	}
+	return CityHash64WithSeed( static_cast<const char*>( SurfaceDataPtr ), GetTotalDataSize(), DataHash );
+}
+
+int32 FChunkData2D::CountMismatchingElements( const FChunkData2D& Other, float FloatTolerance ) const
+{
+	if ( SurfaceResolutionXY != Other.SurfaceResolutionXY || DataElementSize != Other.DataElementSize || ( SurfaceDataPtr == nullptr ) != ( Other.SurfaceDataPtr == nullptr ) )
+	{
+		return FMath::Max( GetSurfaceElementCount(), Other.GetSurfaceElementCount() );
+	}
+	if ( SurfaceDataPtr == nullptr )
+	{
+		return 0;
+	}
+
+	const uint8* DataA = static_cast<const uint8*>( SurfaceDataPtr );
+	const uint8* DataB = static_cast<const uint8*>( Other.SurfaceDataPtr );
+	const bool bCompareAsFloats = FloatTolerance > 0.0f && DataElementSize % sizeof(float) == 0;
+	const int32 NumFloatsPerElement = DataElementSize / sizeof(float);
+	int32 NumMismatchingElements = 0;
+
+	for ( int32 ElementIndex = 0; ElementIndex < GetSurfaceElementCount(); ElementIndex++ )
+	{
+		const uint8* ElementA = DataA + ElementIndex * DataElementSize;
+		const uint8* ElementB = DataB + ElementIndex * DataElementSize;
+
+		// Bitwise equal elements always match, including the NaNs
+		if ( FMemory::Memcmp( ElementA, ElementB, DataElementSize ) == 0 )
+		{
+			continue;
+		}
+		bool bElementMatches = bCompareAsFloats;
+		for ( int32 FloatIndex = 0; bElementMatches && FloatIndex < NumFloatsPerElement; FloatIndex++ )
+		{
+			const float ValueA = reinterpret_cast<const float*>( ElementA )[ FloatIndex ];
+			const float ValueB = reinterpret_cast<const float*>( ElementB )[ FloatIndex ];
+			bElementMatches = FMath::Abs( ValueA - ValueB ) <= FloatTolerance;
+		}
+		if ( !bElementMatches )
+		{
+			NumMismatchingElements++;
+		}
+	}
+	return NumMismatchingElements;
+}
+
 void FChunkData2D::Serialize( FArchive& Ar )
 {
+	// Release the old data before the metadata is overwritten. Loaded data fully overwrites the block, so it does not need to be zeroed
+	if ( Ar.IsLoading() )
+	{
+		FreeData();
+	}
+
 	// Serialize metadata about the memory first
 	Ar << SurfaceResolutionXY;
 	Ar << DataElementSize;
@@ -111,10 +288,10 @@ void FChunkData2D::Serialize( FArchive& Ar )
 	check( DataElementSize > 0 || ( DataElementSize == 0 && SurfaceResolutionXY == 0 ) );
 
 	// If we are about to load data, allocate the memory to fit it
-	const int32 TotalDataSize = SurfaceResolutionXY * SurfaceResolutionXY * DataElementSize;
-	if ( SurfaceResolutionXY > 0 )
+	const int32 TotalDataSize = GetTotalDataSize();
+	if ( Ar.IsLoading() && SurfaceResolutionXY > 0 )
 	{
-		SurfaceDataPtr = FMemory::Realloc( SurfaceDataPtr, TotalDataSize );
+		AllocateData();
 	}
 
 	// Load/save the raw data into the archive
@@ -124,3 +301,21 @@ void FChunkData2D::Serialize( FArchive& Ar )
 		Ar.Serialize( SurfaceDataPtr, TotalDataSize );
 	}
 }
+
+void FChunkData2D::SerializeRegion( FArchive& Ar, int32 StartX, int32 StartY, int32 EndX, int32 EndY )
+{
+	StartX = FMath::Max( StartX, 0 );
+	StartY = FMath::Max( StartY, 0 );
+	EndX = FMath::Min( EndX, SurfaceResolutionXY - 1 );
+	EndY = FMath::Min( EndY, SurfaceResolutionXY - 1 );
+
+	// Rows of the rectangle are contiguous in memory, so serialize them one by one
+	if ( StartX <= EndX && StartY <= EndY )
+	{
+		const int32 RowDataSize = ( EndX - StartX + 1 ) * DataElementSize;
+		for ( int32 PosY = StartY; PosY <= EndY; PosY++ )
+		{
+			Ar.Serialize( GetRawElementAt( StartX, PosY ), RowDataSize );
+		}
+	}
+}
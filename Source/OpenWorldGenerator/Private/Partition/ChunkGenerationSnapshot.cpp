@@ -0,0 +1,79 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "Partition/ChunkGenerationSnapshot.h"
+
+void FChunkGenerationSnapshot::Serialize( FArchive& Ar )
+{
+	Ar << ChunkCoord;
+
+	int32 NumGrids = Grids.Num();
+	Ar << NumGrids;
+
+	if ( Ar.IsLoading() )
+	{
+		Grids.Empty( NumGrids );
+		for ( int32 GridIndex = 0; GridIndex < NumGrids; GridIndex++ )
+		{
+			FName GridName;
+			Ar << GridName;
+			Grids.Add( GridName ).Serialize( Ar );
+		}
+	}
+	else
+	{
+		for ( TPair<FName, FChunkData2D>& Pair : Grids )
+		{
+			Ar << Pair.Key;
+			Pair.Value.Serialize( Ar );
+		}
+	}
+	Ar << BiomePalette;
+	Ar << WeightMapLayers;
+}
+
+bool FChunkGenerationSnapshot::Compare( const FChunkGenerationSnapshot& Expected, const TMap<FName, float>& GridTolerances, TArray<FString>& OutDifferences ) const
+{
+	const int32 NumDifferencesBefore = OutDifferences.Num();
+
+	for ( const TPair<FName, FChunkData2D>& Pair : Expected.Grids )
+	{
+		const FChunkData2D* ActualGrid = Grids.Find( Pair.Key );
+		if ( ActualGrid == nullptr )
+		{
+			OutDifferences.Add( FString::Printf( TEXT("Chunk %d,%d: grid %s is missing"), ChunkCoord.PosX, ChunkCoord.PosY, *Pair.Key.ToString() ) );
+			continue;
+		}
+		if ( ActualGrid->GetSurfaceResolutionXY() != Pair.Value.GetSurfaceResolutionXY() || ActualGrid->GetDataElementSize() != Pair.Value.GetDataElementSize() )
+		{
+			OutDifferences.Add( FString::Printf( TEXT("Chunk %d,%d: grid %s has resolution %d and element size %d, expected %d and %d"), ChunkCoord.PosX, ChunkCoord.PosY, *Pair.Key.ToString(),
+				ActualGrid->GetSurfaceResolutionXY(), ActualGrid->GetDataElementSize(), Pair.Value.GetSurfaceResolutionXY(), Pair.Value.GetDataElementSize() ) );
+			continue;
+		}
+
+		const float GridTolerance = GridTolerances.FindRef( Pair.Key );
+		if ( const int32 NumMismatchingElements = ActualGrid->CountMismatchingElements( Pair.Value, GridTolerance ); NumMismatchingElements > 0 )
+		{
+			OutDifferences.Add( FString::Printf( TEXT("Chunk %d,%d: %d/%d elements of grid %s differ by more than %g"), ChunkCoord.PosX, ChunkCoord.PosY,
+				NumMismatchingElements, Pair.Value.GetSurfaceElementCount(), *Pair.Key.ToString(), GridTolerance ) );
+		}
+	}
+	for ( const TPair<FName, FChunkData2D>& Pair : Grids )
+	{
+		if ( !Expected.Grids.Contains( Pair.Key ) )
+		{
+			OutDifferences.Add( FString::Printf( TEXT("Chunk %d,%d: grid %s is not expected"), ChunkCoord.PosX, ChunkCoord.PosY, *Pair.Key.ToString() ) );
+		}
+	}
+
+	if ( BiomePalette != Expected.BiomePalette )
+	{
+		OutDifferences.Add( FString::Printf( TEXT("Chunk %d,%d: biome palette is [%s], expected [%s]"), ChunkCoord.PosX, ChunkCoord.PosY,
+			*FString::Join( BiomePalette, TEXT(", ") ), *FString::Join( Expected.BiomePalette, TEXT(", ") ) ) );
+	}
+	if ( WeightMapLayers != Expected.WeightMapLayers )
+	{
+		OutDifferences.Add( FString::Printf( TEXT("Chunk %d,%d: weight map layers are [%s], expected [%s]"), ChunkCoord.PosX, ChunkCoord.PosY,
+			*FString::Join( WeightMapLayers, TEXT(", ") ), *FString::Join( Expected.WeightMapLayers, TEXT(", ") ) ) );
+	}
+	return OutDifferences.Num() == NumDifferencesBefore;
+}
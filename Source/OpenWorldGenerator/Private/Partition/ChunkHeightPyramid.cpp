@@ -0,0 +1,341 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "Partition/ChunkHeightPyramid.h"
+#include "Partition/ChunkData2D.h"
+#include "Algo/Sort.h"
+
+DECLARE_CYCLE_STAT( TEXT("Chunk Height Pyramid Update"), STAT_ChunkHeightPyramidUpdate, STATGROUP_Game );
+
+/** Data shared across all nodes visited by a single trace */
+struct FChunkHeightPyramid::FTraceContext
+{
+	const FChunkData2D* HeightMap{};
+	/** Segment start and delta in chunk local space. Used for intersecting the actual landscape triangles */
+	FVector LocalStart{};
+	FVector LocalDelta{};
+	/** Segment start and delta in grid space, where X and Y are measured in heightmap cells and Z is unchanged. Used for intersecting the pyramid nodes */
+	FVector GridStart{};
+	FVector GridDelta{};
+};
+
+namespace ChunkHeightPyramidInternal
+{
+	/** Intersects the segment with the axis aligned box. Returns the time at which the segment enters the box */
+	static bool IntersectSegmentBox( const FVector& Origin, const FVector& Delta, const FVector& BoxMin, const FVector& BoxMax, double& OutEntryTime )
+	{
+		double EntryTime = 0.0;
+		double ExitTime = 1.0;
+
+		for ( int32 Axis = 0; Axis < 3; Axis++ )
+		{
+			// Segment is parallel to the slab, so it is either always inside of it or never is
+			if ( FMath::IsNearlyZero( Delta[ Axis ] ) )
+			{
+				if ( Origin[ Axis ] < BoxMin[ Axis ] || Origin[ Axis ] > BoxMax[ Axis ] )
+				{
+					return false;
+				}
+				continue;
+			}
+			const double InvDelta = 1.0 / Delta[ Axis ];
+			double SlabEntryTime = ( BoxMin[ Axis ] - Origin[ Axis ] ) * InvDelta;
+			double SlabExitTime = ( BoxMax[ Axis ] - Origin[ Axis ] ) * InvDelta;
+			if ( SlabEntryTime > SlabExitTime )
+			{
+				Swap( SlabEntryTime, SlabExitTime );
+			}
+
+			EntryTime = FMath::Max( EntryTime, SlabEntryTime );
+			ExitTime = FMath::Min( ExitTime, SlabExitTime );
+			if ( EntryTime > ExitTime )
+			{
+				return false;
+			}
+		}
+		OutEntryTime = EntryTime;
+		return true;
+	}
+
+	/** Intersects the segment with the triangle, from both sides. Returns the time of the intersection */
+	static bool IntersectSegmentTriangle( const FVector& Origin, const FVector& Delta, const FVector& A, const FVector& B, const FVector& C, double& OutTime )
+	{
+		const FVector EdgeAB = B - A;
+		const FVector EdgeAC = C - A;
+		const FVector PVec = Delta ^ EdgeAC;
+		const double Determinant = EdgeAB | PVec;
+
+		// Segment is parallel to the triangle plane
+		if ( FMath::IsNearlyZero( Determinant ) )
+		{
+			return false;
+		}
+		const double InvDeterminant = 1.0 / Determinant;
+
+		const FVector TVec = Origin - A;
+		const double U = ( TVec | PVec ) * InvDeterminant;
+		if ( U < 0.0 || U > 1.0 )
+		{
+			return false;
+		}
+		const FVector QVec = TVec ^ EdgeAB;
+		const double V = ( Delta | QVec ) * InvDeterminant;
+		if ( V < 0.0 || U + V > 1.0 )
+		{
+			return false;
+		}
+		const double Time = ( EdgeAC | QVec ) * InvDeterminant;
+		if ( Time < 0.0 || Time > 1.0 )
+		{
+			return false;
+		}
+		OutTime = Time;
+		return true;
+	}
+}
+
+FFloatInterval FChunkHeightPyramid::GetHeightRange() const
+{
+	return IsEmpty() ? FFloatInterval( 0.0f, 0.0f ) : Cells[ LevelOffsets.Last() ];
+}
+
+void FChunkHeightPyramid::Build( const FChunkData2D& HeightMap )
+{
+	SCOPE_CYCLE_COUNTER( STAT_ChunkHeightPyramidUpdate );
+
+	Cells.Reset();
+	LevelOffsets.Reset();
+	LevelResolutions.Reset();
+	HeightMapResolutionXY = 0;
+
+	// We need at least a single quad to build a pyramid
+	if ( HeightMap.GetSurfaceResolutionXY() < 2 )
+	{
+		return;
+	}
+	HeightMapResolutionXY = HeightMap.GetSurfaceResolutionXY();
+
+	// Lay out the levels. Level 0 has a cell for each heightmap quad, and each next level halves the resolution (rounding up) until we reach a single cell
+	int32 LevelResolution = HeightMapResolutionXY - 1;
+	int32 TotalNumCells = 0;
+	while ( true )
+	{
+		LevelOffsets.Add( TotalNumCells );
+		LevelResolutions.Add( LevelResolution );
+		TotalNumCells += LevelResolution * LevelResolution;
+
+		if ( LevelResolution == 1 )
+		{
+			break;
+		}
+		LevelResolution = FMath::DivideAndRoundUp( LevelResolution, 2 );
+	}
+	Cells.SetNumUninitialized( TotalNumCells );
+
+	for ( int32 Level = 0; Level < LevelResolutions.Num(); Level++ )
+	{
+		UpdateLevelCells( HeightMap, Level, 0, 0, LevelResolutions[ Level ] - 1, LevelResolutions[ Level ] - 1 );
+	}
+}
+
+void FChunkHeightPyramid::PartialUpdate( const FChunkData2D& HeightMap, int32 StartX, int32 StartY, int32 EndX, int32 EndY )
+{
+	if ( IsEmpty() || HeightMap.GetSurfaceResolutionXY() != HeightMapResolutionXY )
+	{
+		Build( HeightMap );
+		return;
+	}
+	SCOPE_CYCLE_COUNTER( STAT_ChunkHeightPyramidUpdate );
+
+	// Each heightmap point is shared by up to 4 quads, so the quads starting one point before the range are affected too
+	int32 CellStartX = FMath::Max( StartX - 1, 0 );
+	int32 CellStartY = FMath::Max( StartY - 1, 0 );
+	int32 CellEndX = FMath::Min( EndX, LevelResolutions[ 0 ] - 1 );
+	int32 CellEndY = FMath::Min( EndY, LevelResolutions[ 0 ] - 1 );
+
+	for ( int32 Level = 0; Level < LevelResolutions.Num(); Level++ )
+	{
+		if ( CellStartX > CellEndX || CellStartY > CellEndY )
+		{
+			break;
+		}
+		UpdateLevelCells( HeightMap, Level, CellStartX, CellStartY, CellEndX, CellEndY );
+
+		CellStartX /= 2;
+		CellStartY /= 2;
+		CellEndX /= 2;
+		CellEndY /= 2;
+	}
+}
+
+void FChunkHeightPyramid::UpdateLevelCells( const FChunkData2D& HeightMap, int32 Level, int32 StartX, int32 StartY, int32 EndX, int32 EndY )
+{
+	const int32 LevelResolution = LevelResolutions[ Level ];
+	FFloatInterval* LevelCells = &Cells[ LevelOffsets[ Level ] ];
+
+	if ( Level == 0 )
+	{
+		const float* HeightMapData = HeightMap.GetDataPtr<float>();
+
+		for ( int32 CellY = StartY; CellY <= EndY; CellY++ )
+		{
+			const float* HeightRowY0 = &HeightMapData[ CellY * HeightMapResolutionXY ];
+			const float* HeightRowY1 = HeightRowY0 + HeightMapResolutionXY;
+
+			for ( int32 CellX = StartX; CellX <= EndX; CellX++ )
+			{
+				const float MinHeight = FMath::Min( FMath::Min( HeightRowY0[ CellX ], HeightRowY0[ CellX + 1 ] ), FMath::Min( HeightRowY1[ CellX ], HeightRowY1[ CellX + 1 ] ) );
+				const float MaxHeight = FMath::Max( FMath::Max( HeightRowY0[ CellX ], HeightRowY0[ CellX + 1 ] ), FMath::Max( HeightRowY1[ CellX ], HeightRowY1[ CellX + 1 ] ) );
+				LevelCells[ CellY * LevelResolution + CellX ] = FFloatInterval( MinHeight, MaxHeight );
+			}
+		}
+		return;
+	}
+
+	// Combine up to 4 cells from the previous level. Cells at the last row/column of the odd sized levels only have a part of the children
+	const int32 ChildResolution = LevelResolutions[ Level - 1 ];
+	const FFloatInterval* ChildCells = &Cells[ LevelOffsets[ Level - 1 ] ];
+
+	for ( int32 CellY = StartY; CellY <= EndY; CellY++ )
+	{
+		for ( int32 CellX = StartX; CellX <= EndX; CellX++ )
+		{
+			FFloatInterval CellRange = ChildCells[ ( CellY * 2 ) * ChildResolution + CellX * 2 ];
+			const bool bHasChildX1 = CellX * 2 + 1 < ChildResolution;
+			const bool bHasChildY1 = CellY * 2 + 1 < ChildResolution;
+
+			if ( bHasChildX1 )
+			{
+				const FFloatInterval& ChildRange = ChildCells[ ( CellY * 2 ) * ChildResolution + CellX * 2 + 1 ];
+				CellRange = FFloatInterval( FMath::Min( CellRange.Min, ChildRange.Min ), FMath::Max( CellRange.Max, ChildRange.Max ) );
+			}
+			if ( bHasChildY1 )
+			{
+				const FFloatInterval& ChildRange = ChildCells[ ( CellY * 2 + 1 ) * ChildResolution + CellX * 2 ];
+				CellRange = FFloatInterval( FMath::Min( CellRange.Min, ChildRange.Min ), FMath::Max( CellRange.Max, ChildRange.Max ) );
+			}
+			if ( bHasChildX1 && bHasChildY1 )
+			{
+				const FFloatInterval& ChildRange = ChildCells[ ( CellY * 2 + 1 ) * ChildResolution + CellX * 2 + 1 ];
+				CellRange = FFloatInterval( FMath::Min( CellRange.Min, ChildRange.Min ), FMath::Max( CellRange.Max, ChildRange.Max ) );
+			}
+			LevelCells[ CellY * LevelResolution + CellX ] = CellRange;
+		}
+	}
+}
+
+bool FChunkHeightPyramid::LineTrace_Local( const FChunkData2D& HeightMap, const FVector& TraceStart, const FVector& TraceEnd, double& OutHitTime, FVector& OutHitNormal ) const
+{
+	if ( IsEmpty() || HeightMap.GetSurfaceResolutionXY() != HeightMapResolutionXY )
+	{
+		return false;
+	}
+
+	const double GridCellSize = FChunkCoord::ChunkSizeWorldUnits / ( HeightMapResolutionXY - 1.0 );
+	constexpr double GridOriginOffset = FChunkCoord::ChunkSizeWorldUnits / 2.0;
+
+	FTraceContext Context;
+	Context.HeightMap = &HeightMap;
+	Context.LocalStart = TraceStart;
+	Context.LocalDelta = TraceEnd - TraceStart;
+	Context.GridStart = FVector( ( TraceStart.X + GridOriginOffset ) / GridCellSize, ( TraceStart.Y + GridOriginOffset ) / GridCellSize, TraceStart.Z );
+	Context.GridDelta = FVector( Context.LocalDelta.X / GridCellSize, Context.LocalDelta.Y / GridCellSize, Context.LocalDelta.Z );
+
+	// Start at the root node and descend into the children that overlap with the segment
+	double HitTime = UE_BIG_NUMBER;
+	if ( TraceNode_Recursive( Context, LevelResolutions.Num() - 1, 0, 0, HitTime, OutHitNormal ) )
+	{
+		OutHitTime = HitTime;
+		return true;
+	}
+	return false;
+}
+
+bool FChunkHeightPyramid::IntersectNodeBounds( const FTraceContext& Context, int32 Level, int32 NodeX, int32 NodeY, double& OutEntryTime ) const
+{
+	// Node at the given level covers 2^Level quads across each axis, clamped to the heightmap size
+	const int32 NumQuadCells = LevelResolutions[ 0 ];
+	const FFloatInterval HeightRange = GetCellHeightRange( Level, NodeX, NodeY );
+
+	const FVector BoxMin( NodeX << Level, NodeY << Level, HeightRange.Min );
+	const FVector BoxMax( FMath::Min( ( NodeX + 1 ) << Level, NumQuadCells ), FMath::Min( ( NodeY + 1 ) << Level, NumQuadCells ), HeightRange.Max );
+
+	return ChunkHeightPyramidInternal::IntersectSegmentBox( Context.GridStart, Context.GridDelta, BoxMin, BoxMax, OutEntryTime );
+}
+
+bool FChunkHeightPyramid::TraceNode_Recursive( const FTraceContext& Context, int32 Level, int32 NodeX, int32 NodeY, double& InOutHitTime, FVector& OutHitNormal ) const
+{
+	double NodeEntryTime = 0.0;
+	if ( !IntersectNodeBounds( Context, Level, NodeX, NodeY, NodeEntryTime ) || NodeEntryTime > InOutHitTime )
+	{
+		return false;
+	}
+	if ( Level == 0 )
+	{
+		return TraceQuadCell( Context, NodeX, NodeY, InOutHitTime, OutHitNormal );
+	}
+
+	// Gather the children that the segment passes through, and visit them from the closest to the furthest
+	const int32 ChildResolution = LevelResolutions[ Level - 1 ];
+	TPair<double, FIntPoint> ChildNodes[4];
+	int32 NumChildNodes = 0;
+
+	for ( int32 ChildY = NodeY * 2; ChildY < FMath::Min( NodeY * 2 + 2, ChildResolution ); ChildY++ )
+	{
+		for ( int32 ChildX = NodeX * 2; ChildX < FMath::Min( NodeX * 2 + 2, ChildResolution ); ChildX++ )
+		{
+			double ChildEntryTime = 0.0;
+			if ( IntersectNodeBounds( Context, Level - 1, ChildX, ChildY, ChildEntryTime ) )
+			{
+				ChildNodes[ NumChildNodes++ ] = TPair<double, FIntPoint>( ChildEntryTime, FIntPoint( ChildX, ChildY ) );
+			}
+		}
+	}
+	Algo::SortBy( TArrayView<TPair<double, FIntPoint>>( ChildNodes, NumChildNodes ), []( const TPair<double, FIntPoint>& ChildNode ) { return ChildNode.Key; } );
+
+	bool bFoundHit = false;
+	for ( int32 ChildIndex = 0; ChildIndex < NumChildNodes; ChildIndex++ )
+	{
+		// Children further than the closest hit we have found so far cannot contain a closer hit
+		if ( ChildNodes[ ChildIndex ].Key > InOutHitTime )
+		{
+			break;
+		}
+		bFoundHit |= TraceNode_Recursive( Context, Level - 1, ChildNodes[ ChildIndex ].Value.X, ChildNodes[ ChildIndex ].Value.Y, InOutHitTime, OutHitNormal );
+	}
+	return bFoundHit;
+}
+
+bool FChunkHeightPyramid::TraceQuadCell( const FTraceContext& Context, int32 CellX, int32 CellY, double& InOutHitTime, FVector& OutHitNormal ) const
+{
+	const FChunkData2D& HeightMap = *Context.HeightMap;
+	const FVector PointX0Y0 = HeightMap.PointToChunkLocalPosition( CellX, CellY, HeightMap.GetElementAt<float>( CellX, CellY ) );
+	const FVector PointX1Y0 = HeightMap.PointToChunkLocalPosition( CellX + 1, CellY, HeightMap.GetElementAt<float>( CellX + 1, CellY ) );
+	const FVector PointX0Y1 = HeightMap.PointToChunkLocalPosition( CellX, CellY + 1, HeightMap.GetElementAt<float>( CellX, CellY + 1 ) );
+	const FVector PointX1Y1 = HeightMap.PointToChunkLocalPosition( CellX + 1, CellY + 1, HeightMap.GetElementAt<float>( CellX + 1, CellY + 1 ) );
+
+	// Quads are split along the X0Y1-X1Y0 diagonal, same as the landscape mesh
+	const FVector Triangles[2][3] = {
+		{ PointX0Y0, PointX1Y0, PointX0Y1 },
+		{ PointX1Y1, PointX0Y1, PointX1Y0 }
+	};
+
+	bool bFoundHit = false;
+	for ( const FVector* Triangle : Triangles )
+	{
+		double TriangleHitTime = 0.0;
+		if ( ChunkHeightPyramidInternal::IntersectSegmentTriangle( Context.LocalStart, Context.LocalDelta, Triangle[0], Triangle[1], Triangle[2], TriangleHitTime ) && TriangleHitTime < InOutHitTime )
+		{
+			// Landscape normal always points upwards, regardless of the triangle winding
+			const FVector TriangleNormal = ( ( Triangle[1] - Triangle[0] ) ^ ( Triangle[2] - Triangle[0] ) ).GetSafeNormal();
+			OutHitNormal = TriangleNormal.Z >= 0.0 ? TriangleNormal : -TriangleNormal;
+			InOutHitTime = TriangleHitTime;
+			bFoundHit = true;
+		}
+	}
+	return bFoundHit;
+}
+
+SIZE_T FChunkHeightPyramid::GetAllocatedSize() const
+{
+	return Cells.GetAllocatedSize() + LevelOffsets.GetAllocatedSize() + LevelResolutions.GetAllocatedSize();
+}
@@ -8,9 +8,11 @@
 #include "Engine/Engine.h"
 #include "Physics/Experimental/PhysScene_Chaos.h"
 #include "Engine/World.h"
+#include "OWGTrace.h"
 #include "Materials/Material.h"
 #include "Materials/MaterialRenderProxy.h"
 #include "Partition/ChunkData2D.h"
+#include "Partition/ChunkLandscapeWeight.h"
 #include "Partition/OWGChunk.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "Physics/PhysicsFiltering.h"
@@ -62,6 +64,18 @@ UChunkHeightFieldCollisionComponent::UChunkHeightFieldCollisionComponent()
 	HeightfieldColumnsCount = -1;
 }
 
+SIZE_T UChunkHeightFieldCollisionComponent::GetCollisionAllocatedSize() const
+{
+	SIZE_T AllocatedSize = CachedHeightFieldSamples.Heights.GetAllocatedSize() + CachedHeightFieldSamples.Holes.GetAllocatedSize();
+	if ( HeightFieldRef.IsValid() && HeightFieldRef->HeightField.IsValid() )
+	{
+		AllocatedSize += HeightFieldRef->HeightField->GeomData.Heights.GetAllocatedSize();
+		AllocatedSize += HeightFieldRef->HeightField->GeomData.MaterialIndices.GetAllocatedSize();
+		AllocatedSize += HeightFieldRef->UsedChaosMaterials.GetAllocatedSize();
+	}
+	return AllocatedSize;
+}
+
 void UChunkHeightFieldCollisionComponent::CreateCollisionData()
 {
 	SCOPE_CYCLE_COUNTER( STAT_ChunkLandscapeCollisionBuild );
@@ -73,20 +87,25 @@ void UChunkHeightFieldCollisionComponent::CreateCollisionData()
 	}
 	
 	const AOWGChunk* Chunk = CastChecked<AOWGChunk>( GetOwner() );
+	OWG_TRACE_CHUNK_SCOPE( CreateCollisionData, Chunk->GetChunkCoord() );
 	const FChunkData2D& ChunkHeightmapData = Chunk->ChunkData2D.FindChecked( ChunkDataID::SurfaceHeightmap );
 	
 	TArray<Chaos::FReal> HeightFieldHeights;
 
 	const int32 SurfaceResolutionXY = ChunkHeightmapData.GetSurfaceResolutionXY();
-	const float* RawHeightmapDataPtr = ChunkHeightmapData.GetDataPtr<float>();
+	const TChunkData2DView<const float> HeightmapView( ChunkHeightmapData );
 
 	// Scale in that context should map input range into the [0; SurfaceResolutionXY) range
 	const Chaos::FVec3 HeightFieldScale( FChunkCoord::ChunkSizeWorldUnits / (SurfaceResolutionXY - 1), FChunkCoord::ChunkSizeWorldUnits / (SurfaceResolutionXY - 1), 1.0f );
 
-	// Height field heights are per cell and column.
-	for ( int32 ElementIndex = 0; ElementIndex < ChunkHeightmapData.GetSurfaceElementCount(); ElementIndex++ )
+	// Height field heights are per cell and column. Copy them row by row
+	HeightFieldHeights.Reserve( ChunkHeightmapData.GetSurfaceElementCount() );
+	for ( int32 PosY = 0; PosY < SurfaceResolutionXY; PosY++ )
 	{
-		HeightFieldHeights.Add( RawHeightmapDataPtr[ElementIndex] );
+		for ( const float Height : HeightmapView.GetRow( PosY ) )
+		{
+			HeightFieldHeights.Add( Height );
+		}
 	}
 
 	TArray<Chaos::FMaterialHandle> UsedPhysicalMaterials;
@@ -99,15 +118,13 @@ void UChunkHeightFieldCollisionComponent::CreateCollisionData()
 	TArray<uint8> HeightFieldMaterials;
 	const FChunkData2D& ChunkWeightMapData = Chunk->ChunkData2D.FindChecked( ChunkDataID::SurfaceWeights );
 
-	// Height field materials are per cell! Which means 1 column and 1 row less
+	// Height field materials are per cell! Which means 1 column and 1 row less. Weight map has a different resolution, so it is sampled through the weight sampler instead of a view
 	for ( int32 CellX = 0; CellX < SurfaceResolutionXY - 1; CellX++ )
 	{
 		for ( int32 CellY = 0; CellY < SurfaceResolutionXY - 1; CellY++ )
 		{
 			const FVector2f NormalizedPosition( CellX * 1.0f / ( SurfaceResolutionXY - 1 ), CellY * 1.0f / ( SurfaceResolutionXY - 1 ) );
-			const FChunkLandscapeWeight LandscapeWeight = ChunkWeightMapData.GetInterpolatedElementAt<FChunkLandscapeWeight>( NormalizedPosition );
-			
-			const int32 LargestContributionLayer = LandscapeWeight.GetLayerWithLargestContribution();
+			const int32 LargestContributionLayer = FChunkLandscapeWeightSampler::SampleLayerWithLargestContribution( ChunkWeightMapData, NormalizedPosition );
 			HeightFieldMaterials.Add( (uint8) FMath::Min( LargestContributionLayer, HeightFieldMaterials.Num() - 1 ) );
 		}
 	}
@@ -140,6 +157,16 @@ void UChunkHeightFieldCollisionComponent::PartialUpdateOrCreateHeightField( int3
 	}
 }
 
+void UChunkHeightFieldCollisionComponent::ReleaseCollisionData()
+{
+	DestroyPhysicsState();
+
+	HeightFieldRef.SafeRelease();
+	CachedHeightFieldSamples.Empty();
+	HeightfieldRowsCount = -1;
+	HeightfieldColumnsCount = -1;
+}
+
 void UChunkHeightFieldCollisionComponent::PartialUpdateCollisionData( int32 StartX, int32 StartY, int32 EndX, int32 EndY )
 {
 	if ( BodyInstance.IsValidBodyInstance() )
@@ -186,10 +213,11 @@ bool UChunkHeightFieldCollisionComponent::PartialUpdateCollisionData_AssumesLock
 	SCOPE_CYCLE_COUNTER( STAT_ChunkLandscapeCollisionBuild );
 
 	const AOWGChunk* Chunk = CastChecked<AOWGChunk>( GetOwner() );
+	OWG_TRACE_CHUNK_SCOPE( PartialUpdateCollisionData, Chunk->GetChunkCoord() );
 	const FChunkData2D& ChunkHeightmapData = Chunk->ChunkData2D.FindChecked( ChunkDataID::SurfaceHeightmap );
 
 	const int32 SurfaceResolutionXY = ChunkHeightmapData.GetSurfaceResolutionXY();
-	const float* RawHeightmapDataPtr = ChunkHeightmapData.GetDataPtr<float>();
+	const TChunkData2DView<const float> HeightmapView( ChunkHeightmapData );
 
 	const int32 CurrentMaterialsSize = HeightFieldRef->UsedChaosMaterials.Num();
 	TArray<Chaos::FMaterialHandle>& UsedChaosMaterials = HeightFieldRef->UsedChaosMaterials;
@@ -208,16 +236,15 @@ bool UChunkHeightFieldCollisionComponent::PartialUpdateCollisionData_AssumesLock
 	TArray<Chaos::FReal> HeightFieldHeights;
 	HeightFieldHeights.AddZeroed( NumRows * NumColumns );
 	
-	// Height field heights are per row and column
-	for ( int32 PosX = ClampedStartX; PosX <= ClampedEndX; PosX++ )
+	// Height field heights are per row and column, with the columns stored in the reverse order
+	HeightmapView.ForEachRowInRect( ClampedStartX, ClampedStartY, ClampedEndX, ClampedEndY, [&]( int32 PosY, int32 RowStartX, TArrayView<const float> RowSpan )
 	{
-		for ( int32 PosY = ClampedStartY; PosY <= ClampedEndY; PosY++ )
+		Chaos::FReal* HeightFieldRow = HeightFieldHeights.GetData() + ( PosY - ClampedStartY ) * NumColumns;
+		for ( int32 LocalX = 0; LocalX < RowSpan.Num(); LocalX++ )
 		{
-			const int32 HeightFieldIndex = ( PosY - ClampedStartY ) * NumColumns + ( NumColumns - ( PosX - ClampedStartX ) - 1 );
-			const int32 HeightmapIndex = PosY * SurfaceResolutionXY + PosX;
-			HeightFieldHeights[ HeightFieldIndex ] = RawHeightmapDataPtr[ HeightmapIndex ];
+			HeightFieldRow[ NumColumns - LocalX - 1 ] = RowSpan[ LocalX ];
 		}
-	}
+	} );
 
 	// Height field materials are per cell
 	for ( int32 CellX = ClampedStartX; CellX < ClampedEndX; CellX++ )
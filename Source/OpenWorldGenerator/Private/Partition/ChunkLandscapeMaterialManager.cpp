@@ -17,6 +17,32 @@ DEFINE_LOG_CATEGORY_STATIC( LogChunkLandscapeMaterialManager, All, All );
 
 FChunkLandscapeMaterialManager::FChunkLandscapeMaterialManager( AOWGChunk* InChunk, UChunkTextureManager* InChunkTextureManager ) : OwnerChunk( InChunk ), ChunkTextureManager( InChunkTextureManager )
 {
+	const UOpenWorldGeneratorMaterialSettings* MaterialSettings = UOpenWorldGeneratorMaterialSettings::Get();
+	bUseWeightMapAtlas = MaterialSettings->bUseWeightMapAtlas;
+	bShareMaterialInstances = bUseWeightMapAtlas && MaterialSettings->bShareLandscapeMaterialInstances;
+}
+
+int32 FChunkLandscapeMaterialManager::GetNumWeightMapTextures() const
+{
+	return bUseWeightMapAtlas ? WeightMapAtlasSlices.Num() : WeightMapTextures.Num();
+}
+
+SIZE_T FChunkLandscapeMaterialManager::GetWeightMapTextureMemory() const
+{
+	// Weight map textures are always uncompressed BGRA8 with a single mip
+	SIZE_T TextureMemory = 0;
+	for ( const UTexture2DDynamic* WeightMapTexture : WeightMapTextures )
+	{
+		TextureMemory += (SIZE_T) WeightMapTexture->SizeX * WeightMapTexture->SizeY * sizeof(FColor);
+	}
+	for ( const FChunkWeightMapAtlasSlice& AtlasSlice : WeightMapAtlasSlices )
+	{
+		if ( const UChunkWeightMapAtlasTexture* AtlasTexture = ChunkTextureManager->GetWeightMapAtlasTexture( AtlasSlice ) )
+		{
+			TextureMemory += (SIZE_T) AtlasTexture->GetSliceSizeXY() * AtlasTexture->GetSliceSizeXY() * sizeof(FColor);
+		}
+	}
+	return TextureMemory;
 }
 
 void FLandscapeLayerParameterData::PopulateMetadataFromLayer( const UMaterialInterface* BaseMaterial, int32 BlendLayerIndex )
@@ -50,15 +76,18 @@ void FChunkLandscapeMaterialManager::PartialUpdateWeightMap( int32 StartX, int32
 {
 	const FChunkData2D& WeightMapLayers = OwnerChunk->ChunkData2D.FindChecked( ChunkDataID::SurfaceWeights );
 
-	// Update existing weight map textures
-	for ( int32 TextureIndex = 0; TextureIndex < WeightMapTextures.Num(); TextureIndex++ )
+	// Update all existing weight map textures at once
+	if ( bUseWeightMapAtlas )
 	{
-		UTexture2D* WeightMapTexture = WeightMapTextures[ TextureIndex ];
-		ChunkTextureManager->PartialUpdateWeightMap( WeightMapTexture, TextureIndex, &WeightMapLayers, StartX, StartY, EndX, EndY );
+		ChunkTextureManager->PartialUpdateWeightMapAtlasSlices( WeightMapAtlasSlices, 0, &WeightMapLayers, StartX, StartY, EndX, EndY );
+	}
+	else
+	{
+		ChunkTextureManager->PartialUpdateWeightMap( ObjectPtrDecay( WeightMapTextures ), 0, &WeightMapLayers, StartX, StartY, EndX, EndY );
 	}
 
 	// Create new weight map textures if needed, if we already have a valid material instance
-	if ( !WeightMapTextures.IsEmpty() )
+	if ( GetNumWeightMapTextures() != 0 )
 	{
 		RegenerateTextures();
 	}
@@ -71,13 +100,20 @@ void FChunkLandscapeMaterialManager::RegenerateTextures()
 	const FChunkLandscapeWeightMapDescriptor* ChunkLandscapeWeightMap = OwnerChunk->GetWeightMapDescriptor();
 
 	const int32 ExpectedNumberOfTextures = FMath::DivideAndRoundUp( ChunkLandscapeWeightMap->GetNumLayers(), ChannelsPerTexture );
-	if ( ExpectedNumberOfTextures > WeightMapTextures.Num() )
+	if ( ExpectedNumberOfTextures > GetNumWeightMapTextures() )
 	{
 		const FChunkData2D* WeightMapLayers = OwnerChunk->FindRawChunkData( ChunkDataID::SurfaceWeights );
 
-		for ( int32 NewTextureIndex = WeightMapTextures.Num(); NewTextureIndex < ExpectedNumberOfTextures; NewTextureIndex++ )
+		for ( int32 NewTextureIndex = GetNumWeightMapTextures(); NewTextureIndex < ExpectedNumberOfTextures; NewTextureIndex++ )
 		{
-			WeightMapTextures.Add( ChunkTextureManager->CreateWeightMapTexture( WeightMapLayers, NewTextureIndex ) );
+			if ( bUseWeightMapAtlas )
+			{
+				WeightMapAtlasSlices.Add( ChunkTextureManager->CreateWeightMapAtlasSlice( WeightMapLayers, NewTextureIndex ) );
+			}
+			else
+			{
+				WeightMapTextures.Add( ChunkTextureManager->CreateWeightMapTexture( WeightMapLayers, NewTextureIndex ) );
+			}
 		}
 	}
 
@@ -92,20 +128,60 @@ void FChunkLandscapeMaterialManager::RegenerateTextures()
 	}
 
 	// Re-bind new textures to the materials
+	bool bAnyMaterialInstanceReplaced = false;
 	for ( FChunkBiomeLandscapeMaterial& BiomeLandscapeMaterial : PerBiomeMaterials )
 	{
-		BiomeLandscapeMaterial.RebindTexturesToMaterialParameters();
+		bAnyMaterialInstanceReplaced |= BiomeLandscapeMaterial.RebindTexturesToMaterialParameters();
+	}
+	UpdateCustomPrimitiveData();
+
+	// Shared material instances are swapped instead of being updated when the weight map layout changes, so they need to be re-applied to the mesh
+	if ( bAnyMaterialInstanceReplaced && OwnerChunk->LandscapeMeshComponent )
+	{
+		for ( int32 MaterialIndex = 0; MaterialIndex < PerBiomeMaterials.Num(); MaterialIndex++ )
+		{
+			if ( UMaterialInstance* MaterialInstance = PerBiomeMaterials[ MaterialIndex ].GetMaterialInstance( false ) )
+			{
+				OwnerChunk->LandscapeMeshComponent->SetMaterial( MaterialIndex, MaterialInstance );
+			}
+		}
+	}
+}
+
+void FChunkLandscapeMaterialManager::UpdateCustomPrimitiveData()
+{
+	if ( !bShareMaterialInstances || OwnerChunk->LandscapeMeshComponent == nullptr )
+	{
+		return;
+	}
+
+	// Slice index of each weight map texture of the chunk is stored in a separate float, starting at the configured offset
+	const int32 PrimitiveDataOffset = UOpenWorldGeneratorMaterialSettings::Get()->WeightMapPrimitiveDataOffset;
+	for ( int32 TextureIndex = 0; TextureIndex < WeightMapAtlasSlices.Num(); TextureIndex++ )
+	{
+		const int32 PrimitiveDataIndex = PrimitiveDataOffset + TextureIndex;
+		if ( !ensureMsgf( PrimitiveDataIndex < FCustomPrimitiveData::NumCustomPrimitiveDataFloats, TEXT("Weight map primitive data index %d exceeds the custom primitive data size"), PrimitiveDataIndex ) )
+		{
+			break;
+		}
+		OwnerChunk->LandscapeMeshComponent->SetCustomPrimitiveDataFloat( PrimitiveDataIndex, WeightMapAtlasSlices[ TextureIndex ].SliceIndex );
 	}
 }
 
 void FChunkLandscapeMaterialManager::ReleaseTextures()
 {
-	for ( UTexture2D* WeightMapTexture : WeightMapTextures )
+	for ( UTexture2DDynamic* WeightMapTexture : WeightMapTextures )
 	{
 		ChunkTextureManager->ReleaseSurfaceLayersTexture( WeightMapTexture );
 	}
 	WeightMapTextures.Empty();
 
+	for ( const FChunkWeightMapAtlasSlice& AtlasSlice : WeightMapAtlasSlices )
+	{
+		ChunkTextureManager->ReleaseWeightMapAtlasSlice( AtlasSlice );
+	}
+	WeightMapAtlasSlices.Empty();
+
 	for ( FChunkBiomeLandscapeMaterial& BiomeMaterial : PerBiomeMaterials )
 	{
 		BiomeMaterial.ReleaseMaterialInstance();
@@ -118,7 +194,14 @@ FChunkBiomeLandscapeMaterial::FChunkBiomeLandscapeMaterial( FChunkLandscapeMater
 
 void FChunkBiomeLandscapeMaterial::ReleaseMaterialInstance()
 {
-	if ( MaterialInstance != nullptr )
+	// Shared material instances are owned by the texture manager and are only destroyed once no chunks are using them
+	if ( SharedMaterialKey.IsValid() )
+	{
+		ParentManager->ChunkTextureManager->ReleaseSharedLandscapeMaterial( SharedMaterialKey );
+		SharedMaterialKey = FSharedLandscapeMaterialKey();
+		MaterialInstance = nullptr;
+	}
+	else if ( MaterialInstance != nullptr )
 	{
 		MaterialInstance->MarkAsGarbage();
 		MaterialInstance = nullptr;
@@ -128,6 +211,7 @@ void FChunkBiomeLandscapeMaterial::ReleaseMaterialInstance()
 void FChunkBiomeLandscapeMaterial::AddReferencedObjects( FReferenceCollector& ReferenceCollector )
 {
 	ReferenceCollector.AddStableReference( &Biome );
+	ReferenceCollector.AddStableReference( &BaseMaterial );
 	ReferenceCollector.AddStableReferenceMap( LayerToBlendTextureNameAndChannelMaskParameters );
 }
 
@@ -145,29 +229,46 @@ void FChunkBiomeLandscapeMaterial::CreateNewMaterialInstance()
 	SCOPE_CYCLE_COUNTER( STAT_ChunkMaterialGeneration );
 
 	// Delete old material instance
-	if ( MaterialInstance != nullptr )
-	{
-		MaterialInstance->MarkAsGarbage();
-		MaterialInstance = nullptr;
-	}
+	ReleaseMaterialInstance();
 
 	// Load the base material, exit if we failed
-	UMaterialInterface* BaseMaterial = Biome->LandscapeMaterial.SolidMaterial.LoadSynchronous();
+	BaseMaterial = Biome->LandscapeMaterial.SolidMaterial.LoadSynchronous();
 	if ( BaseMaterial == nullptr )
 	{
 		BaseMaterial = ParentManager->OwnerChunk->GetWorldGeneratorDefinition()->DefaultLandscapeMaterial.SolidMaterial.LoadSynchronous();
 	}
+
+	// Shared material instances only need the layer bindings, the textures are bound once when the shared instance is created
+	if ( ParentManager->bShareMaterialInstances )
+	{
+		PopulateLayerParameters( BaseMaterial );
+		SharedMaterialKey = MakeSharedMaterialKey();
+		MaterialInstance = AcquireSharedMaterialInstance( SharedMaterialKey );
+		return;
+	}
+
 	MaterialInstance = UMaterialInstanceDynamic::Create( BaseMaterial, ParentManager->OwnerChunk, *FString::Printf( TEXT("LandscapeMaterial_%s"), *Biome->GetName() ) );
 
+	// Bind textures to the parameters
+	if ( PopulateLayerParameters( BaseMaterial ) )
+	{
+		RebindTexturesToMaterialParameters();
+	}
+}
+
+bool FChunkBiomeLandscapeMaterial::PopulateLayerParameters( UMaterialInterface* InBaseMaterial )
+{
+	LayerToBlendTextureNameAndChannelMaskParameters.Empty();
+
 	// Retrieve material layers for our selected base material
 	FMaterialLayersFunctions MaterialLayersFunctions;
-	if ( !BaseMaterial->GetMaterialLayers( MaterialLayersFunctions ) )
+	if ( !InBaseMaterial->GetMaterialLayers( MaterialLayersFunctions ) )
 	{
-		UE_LOG( LogChunkLandscapeMaterialManager, Warning, TEXT("Landscape Material %s does not have valid Material Layers!"), *BaseMaterial->GetFullName() );
+		UE_LOG( LogChunkLandscapeMaterialManager, Warning, TEXT("Landscape Material %s does not have valid Material Layers!"), *InBaseMaterial->GetFullName() );
 	}
 
 	FMaterialInheritanceChain MaterialInheritanceChain;
-	BaseMaterial->GetMaterialInheritanceChain( MaterialInheritanceChain );
+	InBaseMaterial->GetMaterialInheritanceChain( MaterialInheritanceChain );
 
 	// Retrieve the most recent material user data instance for this material
 	const UChunkLandscapeMaterialUserData* MaterialUserData = const_cast<UMaterial*>(MaterialInheritanceChain.BaseMaterial)->GetAssetUserData<UChunkLandscapeMaterialUserData>();
@@ -184,8 +285,8 @@ void FChunkBiomeLandscapeMaterial::CreateNewMaterialInstance()
 	// Make sure we have valid data in the chain, otherwise we should just stop here
 	if ( !MaterialUserData )
 	{
-		UE_LOG( LogChunkLandscapeMaterialManager, Warning, TEXT("Landscape Material %s does not have valid LandscapeMaterialUserData in it's inheritance chain!"), *BaseMaterial->GetFullName() );
-		return;
+		UE_LOG( LogChunkLandscapeMaterialManager, Warning, TEXT("Landscape Material %s does not have valid LandscapeMaterialUserData in it's inheritance chain!"), *InBaseMaterial->GetFullName() );
+		return false;
 	}
 
 	const UOpenWorldGeneratorMaterialSettings* MaterialSettings = UOpenWorldGeneratorMaterialSettings::Get();
@@ -197,8 +298,6 @@ void FChunkBiomeLandscapeMaterial::CreateNewMaterialInstance()
 	CombinedMaterialLayers.Append( MaterialUserData->LayerOverrides );
 	CombinedMaterialBlends.Append( MaterialUserData->BlendOverrides );
 
-	LayerToBlendTextureNameAndChannelMaskParameters.Empty();
-
 	// First material layer needs to be bound explicitly as it will not have a dedicated blend layer, but can still represent a material layer
 	if ( !MaterialLayersFunctions.Layers.IsEmpty() )
 	{
@@ -208,7 +307,7 @@ void FChunkBiomeLandscapeMaterial::CreateNewMaterialInstance()
 			FLandscapeLayerParameterData ParameterData{};
 			ParameterData.bIsBackgroundLayer = true;
 
-			ParameterData.PopulateMetadataFromLayer( BaseMaterial, 0 );
+			ParameterData.PopulateMetadataFromLayer( InBaseMaterial, 0 );
 			LayerToBlendTextureNameAndChannelMaskParameters.Add( LayerInfo->LandscapeLayer, ParameterData );
 		}
 	}
@@ -225,26 +324,89 @@ void FChunkBiomeLandscapeMaterial::CreateNewMaterialInstance()
 			{
 				ParameterData.WeightMapTexture = FMaterialParameterInfo( BlendInfo->WeightMapTextureParameterName, BlendParameter, BlendIndex );
 				ParameterData.WeightMapChannelMask = FMaterialParameterInfo( BlendInfo->WeightMapChannelMaskParameterName, BlendParameter, BlendIndex );
+				ParameterData.WeightMapTextureArray = FMaterialParameterInfo( BlendInfo->WeightMapTextureArrayParameterName, BlendParameter, BlendIndex );
+				ParameterData.WeightMapSliceIndex = FMaterialParameterInfo( BlendInfo->WeightMapSliceIndexParameterName, BlendParameter, BlendIndex );
+				ParameterData.WeightMapPrimitiveDataIndex = FMaterialParameterInfo( BlendInfo->WeightMapPrimitiveDataIndexParameterName, BlendParameter, BlendIndex );
 			}
-			ParameterData.PopulateMetadataFromLayer( BaseMaterial, MaterialLayerIndex );
+			ParameterData.PopulateMetadataFromLayer( InBaseMaterial, MaterialLayerIndex );
 			LayerToBlendTextureNameAndChannelMaskParameters.Add( LayerInfo->LandscapeLayer, ParameterData );
 		}
 	}
-
-	// Bind textures to the parameters
-	RebindTexturesToMaterialParameters();
+	return true;
 }
 
-void FChunkBiomeLandscapeMaterial::RebindTexturesToMaterialParameters()
+FSharedLandscapeMaterialKey FChunkBiomeLandscapeMaterial::MakeSharedMaterialKey() const
 {
 	constexpr int32 ChannelsPerTexture = 4;
+	const FChunkLandscapeWeightMapDescriptor* ChunkLandscapeWeightMap = ParentManager->OwnerChunk->GetWeightMapDescriptor();
+
+	FSharedLandscapeMaterialKey MaterialKey;
+	MaterialKey.BaseMaterial = BaseMaterial;
+	MaterialKey.Biome = Biome;
+
+	// Layer index determines both the weight map texture and the channel, and the atlas determines the texture array bound to the material
+	for ( const TPair<UOWGChunkLandscapeLayer*, FLandscapeLayerParameterData>& Pair : LayerToBlendTextureNameAndChannelMaskParameters )
+	{
+		const int32 LayerIndex = ChunkLandscapeWeightMap->FindLayerIndex( Pair.Key );
+		const int32 WeightMapTextureIndex = LayerIndex / ChannelsPerTexture;
+
+		if ( LayerIndex == INDEX_NONE || !ParentManager->WeightMapAtlasSlices.IsValidIndex( WeightMapTextureIndex ) )
+		{
+			MaterialKey.LayerBindings.Add( INDEX_NONE );
+			continue;
+		}
+		MaterialKey.LayerBindings.Add( LayerIndex | ( ParentManager->WeightMapAtlasSlices[ WeightMapTextureIndex ].AtlasIndex << 8 ) );
+	}
+	return MaterialKey;
+}
 
+UMaterialInstanceDynamic* FChunkBiomeLandscapeMaterial::AcquireSharedMaterialInstance( const FSharedLandscapeMaterialKey& MaterialKey ) const
+{
+	UChunkTextureManager* ChunkTextureManager = ParentManager->ChunkTextureManager;
+
+	return ChunkTextureManager->AcquireSharedLandscapeMaterial( MaterialKey, [&]()
+	{
+		// Shared material instances outlive the chunk that has created them, so they are owned by the texture manager
+		const FName MaterialInstanceName = MakeUniqueObjectName( ChunkTextureManager, UMaterialInstanceDynamic::StaticClass(), *FString::Printf( TEXT("SharedLandscapeMaterial_%s"), *Biome->GetName() ) );
+		UMaterialInstanceDynamic* NewMaterialInstance = UMaterialInstanceDynamic::Create( BaseMaterial, ChunkTextureManager, MaterialInstanceName );
+		ApplyLayerParameters( NewMaterialInstance, true );
+		return NewMaterialInstance;
+	} );
+}
+
+bool FChunkBiomeLandscapeMaterial::RebindTexturesToMaterialParameters()
+{
 	// Apply new values to the material instance
 	if ( MaterialInstance == nullptr )
 	{
-		return;
+		return false;
+	}
+
+	// Shared material instances are never modified. If the weight map layout has changed, we need to switch to the shared instance matching the new layout
+	if ( SharedMaterialKey.IsValid() )
+	{
+		FSharedLandscapeMaterialKey NewSharedMaterialKey = MakeSharedMaterialKey();
+		if ( NewSharedMaterialKey == SharedMaterialKey )
+		{
+			return false;
+		}
+		UMaterialInstanceDynamic* NewMaterialInstance = AcquireSharedMaterialInstance( NewSharedMaterialKey );
+		ParentManager->ChunkTextureManager->ReleaseSharedLandscapeMaterial( SharedMaterialKey );
+
+		SharedMaterialKey = MoveTemp( NewSharedMaterialKey );
+		MaterialInstance = NewMaterialInstance;
+		return true;
 	}
+
+	ApplyLayerParameters( MaterialInstance, false );
+	return false;
+}
+
+void FChunkBiomeLandscapeMaterial::ApplyLayerParameters( UMaterialInstanceDynamic* TargetMaterialInstance, bool bIsSharedInstance ) const
+{
+	constexpr int32 ChannelsPerTexture = 4;
 	const FChunkLandscapeWeightMapDescriptor* ChunkLandscapeWeightMap = ParentManager->OwnerChunk->GetWeightMapDescriptor();
+	const int32 PrimitiveDataOffset = UOpenWorldGeneratorMaterialSettings::Get()->WeightMapPrimitiveDataOffset;
 
 	// Bind weight map textures to blend layers
 	for ( const TPair<UOWGChunkLandscapeLayer*, FLandscapeLayerParameterData>& Pair : LayerToBlendTextureNameAndChannelMaskParameters )
@@ -252,12 +414,12 @@ void FChunkBiomeLandscapeMaterial::RebindTexturesToMaterialParameters()
 		const int32 LayerIndex = ChunkLandscapeWeightMap->FindLayerIndex( Pair.Key );
 
 		// If the layer index is not valid, we do not need to bind a valid texture, but should instead mask out that layer completely
-		if ( LayerIndex == INDEX_NONE )
+		if ( LayerIndex == INDEX_NONE || ( bIsSharedInstance && !ParentManager->WeightMapAtlasSlices.IsValidIndex( LayerIndex / ChannelsPerTexture ) ) )
 		{
 			if ( Pair.Value.WeightMapChannelMask.Name != NAME_None )
 			{
 				constexpr FLinearColor MaskedOutChannelMask( 0.0f, 0.0f, 0.0f, 0.0f );
-				MaterialInstance->SetVectorParameterValueByInfo( Pair.Value.WeightMapChannelMask, MaskedOutChannelMask );
+				TargetMaterialInstance->SetVectorParameterValueByInfo( Pair.Value.WeightMapChannelMask, MaskedOutChannelMask );
 			}
 			continue;
 		}
@@ -266,22 +428,38 @@ void FChunkBiomeLandscapeMaterial::RebindTexturesToMaterialParameters()
 		const int32 WeightMapTextureIndex = LayerIndex / ChannelsPerTexture;
 		const int32 WeightMapChannelIndex = LayerIndex % ChannelsPerTexture;
 
-		// Apply the texture
-		if ( Pair.Value.WeightMapTexture.Name != NAME_None )
+		// Apply the texture, or the atlas and the slice index. Shared instances read the slice index from the custom primitive data of the chunk instead
+		if ( ParentManager->bUseWeightMapAtlas )
+		{
+			const FChunkWeightMapAtlasSlice& AtlasSlice = ParentManager->WeightMapAtlasSlices[ WeightMapTextureIndex ];
+			if ( Pair.Value.WeightMapTextureArray.Name != NAME_None )
+			{
+				TargetMaterialInstance->SetTextureParameterValueByInfo( Pair.Value.WeightMapTextureArray, ParentManager->ChunkTextureManager->GetWeightMapAtlasTexture( AtlasSlice ) );
+			}
+			if ( bIsSharedInstance && Pair.Value.WeightMapPrimitiveDataIndex.Name != NAME_None )
+			{
+				TargetMaterialInstance->SetScalarParameterValueByInfo( Pair.Value.WeightMapPrimitiveDataIndex, PrimitiveDataOffset + WeightMapTextureIndex );
+			}
+			else if ( !bIsSharedInstance && Pair.Value.WeightMapSliceIndex.Name != NAME_None )
+			{
+				TargetMaterialInstance->SetScalarParameterValueByInfo( Pair.Value.WeightMapSliceIndex, AtlasSlice.SliceIndex );
+			}
+		}
+		else if ( Pair.Value.WeightMapTexture.Name != NAME_None )
 		{
-			UTexture2D* WeightMapTexture = ParentManager->WeightMapTextures[ WeightMapTextureIndex ];
-			MaterialInstance->SetTextureParameterValueByInfo( Pair.Value.WeightMapTexture, WeightMapTexture );
+			UTexture2DDynamic* WeightMapTexture = ParentManager->WeightMapTextures[ WeightMapTextureIndex ];
+			TargetMaterialInstance->SetTextureParameterValueByInfo( Pair.Value.WeightMapTexture, WeightMapTexture );
 		}
 		// Apply the channel mask
 		if ( Pair.Value.WeightMapChannelMask.Name != NAME_None )
 		{
 			const FLinearColor ChannelMask( WeightMapChannelIndex == 0 ? 1.0f : 0.0f, WeightMapChannelIndex == 1 ? 1.0f : 0.0f, WeightMapChannelIndex == 2 ? 1.0f : 0.0f, WeightMapChannelIndex == 3 ? 1.0f : 0.0f );
-			MaterialInstance->SetVectorParameterValueByInfo( Pair.Value.WeightMapChannelMask, ChannelMask );
+			TargetMaterialInstance->SetVectorParameterValueByInfo( Pair.Value.WeightMapChannelMask, ChannelMask );
 		}
 		// Apply grass color
 		if ( Pair.Value.GrassColor.Name != NAME_None )
 		{
-			MaterialInstance->SetVectorParameterValueByInfo( Pair.Value.GrassColor, Biome->GrassColor );
+			TargetMaterialInstance->SetVectorParameterValueByInfo( Pair.Value.GrassColor, Biome->GrassColor );
 		}
 	}
 }
@@ -4,17 +4,142 @@
 #include "Async/Async.h"
 #include "Async/TaskGraphInterfaces.h"
 #include "Components/DynamicMeshComponent.h"
+#include "OpenWorldGeneratorModule.h"
+#include "OWGTrace.h"
 #include "Partition/OWGChunk.h"
 #include "Rendering/SurfaceMeshGenerator.h"
 
 DECLARE_CYCLE_STAT( TEXT("Async Chunk Landscape LOD generation"), STAT_AsyncChunkLandscapeLODs, STATGROUP_Game );
 DECLARE_CYCLE_STAT( TEXT("Blocking Chunk Landscape LOD generation"), STAT_BlockingChunkLandscapeLODs, STATGROUP_Game );
 DECLARE_CYCLE_STAT( TEXT("Edit Chunk Landscape Mesh Component"), STAT_EditChunkLandscapeMeshComponent, STATGROUP_Game );
+DECLARE_MEMORY_STAT( TEXT("Landscape Mesh Cache Memory"), STAT_LandscapeMeshCacheMemory, STATGROUP_Game );
+DECLARE_DWORD_COUNTER_STAT( TEXT("Landscape Mesh Cache Hits"), STAT_LandscapeMeshCacheHits, STATGROUP_Game );
+DECLARE_DWORD_COUNTER_STAT( TEXT("Landscape Mesh Cache Misses"), STAT_LandscapeMeshCacheMisses, STATGROUP_Game );
+DECLARE_DWORD_COUNTER_STAT( TEXT("Landscape Mesh Cache Evictions"), STAT_LandscapeMeshCacheEvictions, STATGROUP_Game );
+
+static TAutoConsoleVariable CVarLandscapeMeshCacheBudgetMB(
+	TEXT("owg.LandscapeMeshCacheBudgetMB"),
+	256.0f,
+	TEXT("Maximum memory in MB used by the landscape meshes of the LODs the chunks are not currently using. Least recently used meshes are evicted when the budget is exceeded. Negative value disables the budget"),
+	ECVF_Default
+);
+
+static FAutoConsoleCommand DumpLandscapeMeshCacheCommand(
+	TEXT("owg.DumpLandscapeMeshCache"),
+	TEXT("Logs the memory used by the landscape LOD mesh cache, it's hit rate and the number of evictions"),
+	FConsoleCommandDelegate::CreateLambda( []() { FChunkLandscapeMeshCache::Get().DumpStats(); } )
+);
+
+FChunkLandscapeMeshCache& FChunkLandscapeMeshCache::Get()
+{
+	static FChunkLandscapeMeshCache MeshCache;
+	return MeshCache;
+}
+
+void FChunkLandscapeMeshCache::UpdateCachedMesh( FChunkLandscapeMeshManager* MeshManager, int32 LODIndex, SIZE_T MeshSize )
+{
+	check( IsInGameThread() );
+	const TPair<FChunkLandscapeMeshManager*, int32> MeshKey( MeshManager, LODIndex );
+
+	if ( MeshSize == 0 )
+	{
+		FCachedMeshEntry RemovedEntry;
+		if ( CachedMeshes.RemoveAndCopyValue( MeshKey, RemovedEntry ) )
+		{
+			TotalCachedMemory -= RemovedEntry.MeshSize;
+			DEC_MEMORY_STAT_BY( STAT_LandscapeMeshCacheMemory, RemovedEntry.MeshSize );
+		}
+		return;
+	}
+
+	FCachedMeshEntry& CachedMeshEntry = CachedMeshes.FindOrAdd( MeshKey );
+	TotalCachedMemory = TotalCachedMemory - CachedMeshEntry.MeshSize + MeshSize;
+	DEC_MEMORY_STAT_BY( STAT_LandscapeMeshCacheMemory, CachedMeshEntry.MeshSize );
+	INC_MEMORY_STAT_BY( STAT_LandscapeMeshCacheMemory, MeshSize );
+
+	CachedMeshEntry.MeshSize = MeshSize;
+	CachedMeshEntry.LastUseIndex = NextUseIndex++;
+	Trim();
+}
+
+void FChunkLandscapeMeshCache::RecordLookup( bool bHit )
+{
+	if ( bHit )
+	{
+		NumHits++;
+		INC_DWORD_STAT( STAT_LandscapeMeshCacheHits );
+	}
+	else
+	{
+		NumMisses++;
+		INC_DWORD_STAT( STAT_LandscapeMeshCacheMisses );
+	}
+}
+
+void FChunkLandscapeMeshCache::Trim()
+{
+	const float BudgetMB = CVarLandscapeMeshCacheBudgetMB.GetValueOnGameThread();
+	const SIZE_T BudgetBytes = (SIZE_T) ( FMath::Max( BudgetMB, 0.0f ) * 1024 * 1024 );
+	if ( BudgetMB < 0.0f || TotalCachedMemory <= BudgetBytes )
+	{
+		return;
+	}
+
+	// Eviction is rare compared to the updates, so sort the entries by their last use only when we actually need to evict something
+	TArray<TPair<TPair<FChunkLandscapeMeshManager*, int32>, FCachedMeshEntry>> CachedMeshesByLastUse = CachedMeshes.Array();
+	CachedMeshesByLastUse.Sort( []( const auto& A, const auto& B ) { return A.Value.LastUseIndex < B.Value.LastUseIndex; } );
+
+	for ( const TPair<TPair<FChunkLandscapeMeshManager*, int32>, FCachedMeshEntry>& Pair : CachedMeshesByLastUse )
+	{
+		if ( TotalCachedMemory <= BudgetBytes )
+		{
+			break;
+		}
+		CachedMeshes.Remove( Pair.Key );
+		TotalCachedMemory -= Pair.Value.MeshSize;
+		DEC_MEMORY_STAT_BY( STAT_LandscapeMeshCacheMemory, Pair.Value.MeshSize );
+
+		Pair.Key.Key->EvictCachedLODMesh( Pair.Key.Value );
+		NumEvictions++;
+		INC_DWORD_STAT( STAT_LandscapeMeshCacheEvictions );
+	}
+}
+
+void FChunkLandscapeMeshCache::DumpStats() const
+{
+	const uint64 NumLookups = NumHits + NumMisses;
+	UE_LOG( LogOpenWorldGenerator, Display, TEXT("Landscape mesh cache: %d meshes, %.2f MB (budget %.2f MB), hit rate %.1f%% (%llu hits, %llu misses), %llu evictions"),
+		CachedMeshes.Num(), TotalCachedMemory / ( 1024.0 * 1024.0 ), CVarLandscapeMeshCacheBudgetMB.GetValueOnGameThread(),
+		NumLookups > 0 ? NumHits * 100.0 / NumLookups : 0.0, NumHits, NumMisses, NumEvictions );
+}
 
 FChunkLandscapeMeshManager::FChunkLandscapeMeshManager( AOWGChunk* InChunk ) : OwnerChunk( InChunk )
 {
 }
 
+FChunkLandscapeMeshManager::~FChunkLandscapeMeshManager()
+{
+	for ( int32 LODIndex = 0; LODIndex < LandscapeLODMeshes.Num(); LODIndex++ )
+	{
+		FChunkLandscapeMeshCache::Get().UpdateCachedMesh( this, LODIndex, 0 );
+	}
+}
+
+void FChunkLandscapeMeshManager::UpdateCachedLODMesh( int32 LODIndex )
+{
+	if ( LandscapeLODMeshes.IsValidIndex( LODIndex ) )
+	{
+		const UE::Geometry::FDynamicMesh3& CachedMesh = LandscapeLODMeshes[ LODIndex ].Key;
+		FChunkLandscapeMeshCache::Get().UpdateCachedMesh( this, LODIndex, CachedMesh.VertexCount() > 0 ? CachedMesh.GetByteCount() : 0 );
+	}
+}
+
+void FChunkLandscapeMeshManager::EvictCachedLODMesh( int32 LODIndex )
+{
+	// Keep the changelist number, the empty mesh will be considered missing and regenerated when needed
+	LandscapeLODMeshes[ LODIndex ].Key = UE::Geometry::FDynamicMesh3();
+}
+
 void FChunkLandscapeMeshManager::OnChunkLODLevelChanged()
 {
 	const int32 NewChunkLODIndex = OwnerChunk->GetCurrentChunkLOD();
@@ -22,11 +147,13 @@ void FChunkLandscapeMeshManager::OnChunkLODLevelChanged()
 	// Directly swap out the mesh with the new LOD variant when we already have a mesh for it generated.
 	if ( LandscapeLODMeshes.IsValidIndex( NewChunkLODIndex ) && LandscapeLODMeshes[ NewChunkLODIndex ].Key.VertexCount() > 0 )
 	{
+		FChunkLandscapeMeshCache::Get().RecordLookup( true );
 		ForceUpdateLandscapeMesh( NewChunkLODIndex );
 	}
 	// Otherwise, we need to generate a new LOD variant before we can assign it to the mesh component. Prefer to do that async.
 	else if ( NewChunkLODIndex >= 0 && NewChunkLODIndex < OwnerChunk->NumChunkLandscapeLODs )
 	{
+		FChunkLandscapeMeshCache::Get().RecordLookup( false );
 		RebuildLandscapeMesh( NewChunkLODIndex, false );
 	}
 }
@@ -51,6 +178,7 @@ void FChunkLandscapeMeshManager::InvalidateLandscapeMesh()
 void FChunkLandscapeMeshManager::ForceUpdateLandscapeMesh( int32 NewMeshLODIndex )
 {
 	SCOPE_CYCLE_COUNTER( STAT_EditChunkLandscapeMeshComponent );
+	OWG_TRACE_CHUNK_SCOPE_INDEX( UpdateLandscapeMeshComponent, OwnerChunk->GetChunkCoord(), NewMeshLODIndex );
 	LandscapeLODMeshes.SetNum( OwnerChunk->NumChunkLandscapeLODs );
 
 	// Capture a copy of the current mesh before we swap it otu so we can return it to the pool
@@ -79,6 +207,13 @@ void FChunkLandscapeMeshManager::ForceUpdateLandscapeMesh( int32 NewMeshLODIndex
 	// Swap out the current mesh index and changelist with the new ones
 	CurrentLandscapeLODMesh.Key = NewMeshLODIndex;
 	CurrentLandscapeLODMesh.Value = LandscapeLODMeshes[ NewMeshLODIndex ].Value;
+
+	// The new mesh is now owned by the component and the old one is back in the cache. Update the cache last, since it can evict the meshes we have just swapped
+	UpdateCachedLODMesh( NewMeshLODIndex );
+	if ( CurrentLandscapeMeshLODAndChangelist.Key != NewMeshLODIndex )
+	{
+		UpdateCachedLODMesh( CurrentLandscapeMeshLODAndChangelist.Key );
+	}
 }
 
 void FChunkLandscapeMeshManager::AddReferencedObjects( FReferenceCollector& ReferenceCollector )
@@ -86,6 +221,16 @@ void FChunkLandscapeMeshManager::AddReferencedObjects( FReferenceCollector& Refe
 	ReferenceCollector.AddReferencedObject( OwnerChunk );
 }
 
+SIZE_T FChunkLandscapeMeshManager::GetAllocatedSize() const
+{
+	SIZE_T AllocatedSize = LandscapeLODMeshes.GetAllocatedSize();
+	for ( const TPair<UE::Geometry::FDynamicMesh3, int32>& LandscapeLODMesh : LandscapeLODMeshes )
+	{
+		AllocatedSize += LandscapeLODMesh.Key.GetByteCount();
+	}
+	return AllocatedSize;
+}
+
 void FChunkLandscapeMeshManager::OnLandscapeMeshLODRebuilt( int32 LODIndex, int32 ChangelistNumber, UE::Geometry::FDynamicMesh3& GeneratedMesh )
 {
 	// By the time this happens, we might already have a mesh that is more up to date than this task's generated one
@@ -112,30 +257,50 @@ void FChunkLandscapeMeshManager::OnLandscapeMeshLODRebuilt( int32 LODIndex, int3
 	{
 		ForceUpdateLandscapeMesh( LODIndex );
 	}
+	// Otherwise the mesh is not used right now, so it goes into the cache
+	else
+	{
+		UpdateCachedLODMesh( LODIndex );
+	}
 }
 
-void FChunkLandscapeMeshManager::GenerateLandscapeLODInternal( UE::Geometry::FDynamicMesh3& OutLandscapeMesh, int32 LODIndex, const FChunkData2D& HeightData, const FChunkData2D& NormalData, const FChunkData2D& BiomeMap )
+FSurfaceMeshSkirtSettings FChunkLandscapeMeshManager::GetLandscapeSkirtSettings() const
+{
+	FSurfaceMeshSkirtSettings SkirtSettings;
+	SkirtSettings.bGenerateSkirts = OwnerChunk->bGenerateLandscapeSkirts && OwnerChunk->NumChunkLandscapeLODs > 1;
+	SkirtSettings.MinSkirtDepth = OwnerChunk->LandscapeSkirtMinDepth;
+	// Neighbours are assumed to use the same chunk class, so they cannot use a coarser LOD than the last one we support
+	SkirtSettings.MaxNeighbourLODIndex = OwnerChunk->NumChunkLandscapeLODs - 1;
+	return SkirtSettings;
+}
+
+void FChunkLandscapeMeshManager::GenerateLandscapeLODInternal( UE::Geometry::FDynamicMesh3& OutLandscapeMesh, int32 LODIndex, const FChunkData2D& HeightData, const FChunkData2D& NormalData, const FChunkData2D& BiomeMap, const FSurfaceMeshSkirtSettings& SkirtSettings )
 {
 	// Only generate one particular LOD
-	SurfaceMeshGenerator::GenerateChunkSurfaceMesh( OutLandscapeMesh, FChunkCoord::ChunkSizeWorldUnits, HeightData, NormalData, BiomeMap, LODIndex );
+	SurfaceMeshGenerator::GenerateChunkSurfaceMesh( OutLandscapeMesh, FChunkCoord::ChunkSizeWorldUnits, HeightData, NormalData, BiomeMap, LODIndex, SkirtSettings );
 }
 
 /** Data for the async chunk landscape mesh generation task */
 class FAsyncLODGenerationTask : public FCustomStatIDGraphTaskBase
 {
 	TWeakObjectPtr<AOWGChunk> Chunk;
+	FChunkCoord ChunkCoord;
 	int32 LODIndex{INDEX_NONE};
 	FChunkData2D HeightmapData;
 	FChunkData2D NormalData;
 	FChunkData2D BiomeData;
+	FSurfaceMeshSkirtSettings SkirtSettings;
 	int32 ChangelistNumber{INDEX_NONE};
+	int32 ChunkRecycleCount{INDEX_NONE};
 public:
-	FAsyncLODGenerationTask( FChunkLandscapeMeshManager* MeshManager, const FChunkData2D& InHeightMapData, const FChunkData2D& InNormalData, const FChunkData2D& InBiomeData, int32 InLODIndex ) : FCustomStatIDGraphTaskBase( GET_STATID( STAT_AsyncChunkLandscapeLODs ) ), Chunk( MeshManager->OwnerChunk ), LODIndex( InLODIndex )
+	FAsyncLODGenerationTask( FChunkLandscapeMeshManager* MeshManager, const FChunkData2D& InHeightMapData, const FChunkData2D& InNormalData, const FChunkData2D& InBiomeData, int32 InLODIndex ) : FCustomStatIDGraphTaskBase( GET_STATID( STAT_AsyncChunkLandscapeLODs ) ), Chunk( MeshManager->OwnerChunk ), ChunkCoord( MeshManager->OwnerChunk->GetChunkCoord() ), LODIndex( InLODIndex )
 	{
 		HeightmapData = InHeightMapData;
 		NormalData = InNormalData;
 		BiomeData = InBiomeData;
+		SkirtSettings = MeshManager->GetLandscapeSkirtSettings();
 		ChangelistNumber = MeshManager->CurrentLandscapeChangeNumber;
+		ChunkRecycleCount = MeshManager->OwnerChunk->GetChunkRecycleCount();
 	}
 
 	static ESubsequentsMode::Type GetSubsequentsMode()
@@ -151,16 +316,21 @@ public:
 
 	void DoTask( ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent )
 	{
+		OWG_TRACE_CHUNK_SCOPE_INDEX( AsyncLandscapeLODGeneration, ChunkCoord, LODIndex );
+
 		TSharedPtr<UE::Geometry::FDynamicMesh3> LODMesh = MakeShared< UE::Geometry::FDynamicMesh3>();
-		FChunkLandscapeMeshManager::GenerateLandscapeLODInternal( *LODMesh, LODIndex, HeightmapData, NormalData, BiomeData );
+		FChunkLandscapeMeshManager::GenerateLandscapeLODInternal( *LODMesh, LODIndex, HeightmapData, NormalData, BiomeData, SkirtSettings );
 
 		const TWeakObjectPtr<AOWGChunk> WeakChunk = Chunk;
 		const int32 LocalLODIndex = LODIndex;
 		const int32 LocalChangelistNumber = ChangelistNumber;
+		const int32 LocalChunkRecycleCount = ChunkRecycleCount;
 		
-		AsyncTask( ENamedThreads::GameThread, [LODMesh, LocalLODIndex, LocalChangelistNumber, WeakChunk]
+		AsyncTask( ENamedThreads::GameThread, [LODMesh, LocalLODIndex, LocalChangelistNumber, LocalChunkRecycleCount, WeakChunk]
 		{
-			if ( const AOWGChunk* LoadedChunk = WeakChunk.Get() )
+			// Chunk actor might have been pooled and reused for a different chunk since the task has been started
+			const AOWGChunk* LoadedChunk = WeakChunk.Get();
+			if ( LoadedChunk && LoadedChunk->GetChunkRecycleCount() == LocalChunkRecycleCount )
 			{
 				LoadedChunk->GetLandscapeMeshManager()->OnLandscapeMeshLODRebuilt( LocalLODIndex, LocalChangelistNumber, *LODMesh );
 			}
@@ -183,13 +353,14 @@ void FChunkLandscapeMeshManager::RebuildLandscapeMeshLODAsync( int32 LODIndex )
 void FChunkLandscapeMeshManager::RebuildLandscapeMeshLODBlocking( int32 LODIndex )
 {
 	SCOPE_CYCLE_COUNTER( STAT_BlockingChunkLandscapeLODs );
+	OWG_TRACE_CHUNK_SCOPE_INDEX( BlockingLandscapeLODGeneration, OwnerChunk->GetChunkCoord(), LODIndex );
 	
 	const FChunkData2D& HeightmapData = OwnerChunk->ChunkData2D.FindChecked( ChunkDataID::SurfaceHeightmap );
 	const FChunkData2D& NormalData = OwnerChunk->ChunkData2D.FindChecked( ChunkDataID::SurfaceNormal );
 	const FChunkData2D& BiomeData = OwnerChunk->ChunkData2D.FindChecked( ChunkDataID::BiomeMap );
 
 	UE::Geometry::FDynamicMesh3 LODMesh;
-	GenerateLandscapeLODInternal( LODMesh, LODIndex, HeightmapData, NormalData, BiomeData );
+	GenerateLandscapeLODInternal( LODMesh, LODIndex, HeightmapData, NormalData, BiomeData, GetLandscapeSkirtSettings() );
 	OnLandscapeMeshLODRebuilt( LODIndex, CurrentLandscapeChangeNumber, LODMesh );
 }
 
@@ -0,0 +1,49 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "Partition/ChunkLandscapeTransaction.h"
+#include "OWGBlueprintFunctionLibrary.h"
+
+DECLARE_CYCLE_STAT( TEXT("Chunk Landscape Transaction Commit"), STAT_ChunkLandscapeTransactionCommit, STATGROUP_Game );
+
+FChunkLandscapeTransaction::FChunkLandscapeTransaction( const UObject* InWorldContext ) : WorldContext( InWorldContext )
+{
+}
+
+FChunkLandscapeTransaction::~FChunkLandscapeTransaction()
+{
+	Commit();
+}
+
+void FChunkLandscapeTransaction::ModifyLandscape( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, const FChunkLandscapeModification& LandscapeModification, float MinWeight )
+{
+	TArray<AOWGChunk*> LoadedChunks;
+	const FVector BrushExtents = FVector( FVector2d( Brush->GetBrushExtents() ), 0.0f );
+	UOWGBlueprintFunctionLibrary::GetLoadedChunksInBoundingBox( WorldContext.Get(), WorldLocation, BrushExtents, LoadedChunks );
+
+	for ( AOWGChunk* LoadedChunk : LoadedChunks )
+	{
+		FChunkLandscapeDirtyRegion DirtyRegion;
+		LoadedChunk->ApplyLandscapeModification( WorldLocation, Brush, LandscapeModification, MinWeight, DirtyRegion );
+
+		// Chunks that the brush only touched with it's bounding box but did not actually modify do not need to be recalculated
+		if ( !DirtyRegion.IsEmpty() )
+		{
+			DirtyChunks.FindOrAdd( LoadedChunk ) += DirtyRegion;
+		}
+	}
+}
+
+void FChunkLandscapeTransaction::Commit()
+{
+	SCOPE_CYCLE_COUNTER( STAT_ChunkLandscapeTransactionCommit );
+
+	for ( const TPair<TWeakObjectPtr<AOWGChunk>, FChunkLandscapeDirtyRegion>& Pair : DirtyChunks )
+	{
+		// Chunk might have been unloaded between the modification and the commit
+		if ( AOWGChunk* Chunk = Pair.Key.Get() )
+		{
+			Chunk->CommitLandscapeModifications( Pair.Value );
+		}
+	}
+	DirtyChunks.Reset();
+}
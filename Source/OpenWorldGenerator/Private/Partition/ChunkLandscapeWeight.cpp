@@ -1,8 +1,167 @@
 ﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
 
 #include "Partition/ChunkLandscapeWeight.h"
+#include "Partition/ChunkData2D.h"
 #include "Rendering/OWGChunkLandscapeLayer.h"
 
+namespace ChunkLandscapeWeightInternal
+{
+	/** Number of fractional bits used for the bilinear interpolation factors of each axis */
+	static constexpr int32 FractionBits = 8;
+	static constexpr uint32 FractionOne = 1 << FractionBits;
+	/** Accumulated layer weight corresponding to the normalized weight of 1. Both axis factors and the per-point normalization contribute FractionBits each */
+	static constexpr int32 AccumulatorOneBits = FractionBits * 3;
+
+	/** Per-layer weights of the sample blended from the adjacent points in fixed point */
+	struct FBlendedWeightAccumulator
+	{
+		uint32 LayerWeights[FChunkLandscapeWeight::MaxWeightMapLayers];
+		uint32 PresentLayersMask{0};
+	};
+
+	/**
+	 * Blends the weights of the points adjacent to the normalized position into the accumulator.
+	 * Each point's contribution is scaled by it's bilinear factor divided by the total weight of the point, which normalizes the weights of the point with a single integer division.
+	 * Maximum accumulated value per layer is 1 << AccumulatorOneBits, so it can never overflow.
+	 */
+	static FORCEINLINE void BlendAdjacentWeights( const FChunkData2D& WeightMap, const FVector2f& NormalizedPosition, FBlendedWeightAccumulator& OutAccumulator )
+	{
+		const int32 SurfaceResolutionXY = WeightMap.GetSurfaceResolutionXY();
+		const FVector2D GridPosition( NormalizedPosition.X * ( SurfaceResolutionXY - 1 ), NormalizedPosition.Y * ( SurfaceResolutionXY - 1 ) );
+		int32 PosX = FMath::TruncToInt32( GridPosition.X );
+		int32 PosY = FMath::TruncToInt32( GridPosition.Y );
+		uint32 FractionX = (uint32) FMath::Clamp( FMath::RoundToInt32( FMath::Frac( GridPosition.X ) * FractionOne ), 0, FractionOne );
+		uint32 FractionY = (uint32) FMath::Clamp( FMath::RoundToInt32( FMath::Frac( GridPosition.Y ) * FractionOne ), 0, FractionOne );
+
+		// Snap the fractions to the closest point when interpolation is not allowed, which will give the closest point the full weight
+		if ( !WeightMap.IsInterpolationAllowed() )
+		{
+			FractionX = FractionX > FractionOne / 2 ? FractionOne : 0;
+			FractionY = FractionY > FractionOne / 2 ? FractionOne : 0;
+		}
+		// Last column and last row imply fraction of 0, which we can remap to the pre-last column/row with the fraction of 1
+		if ( PosX >= SurfaceResolutionXY - 1 )
+		{
+			PosX = SurfaceResolutionXY - 2;
+			FractionX = FractionOne;
+		}
+		if ( PosY >= SurfaceResolutionXY - 1 )
+		{
+			PosY = SurfaceResolutionXY - 2;
+			FractionY = FractionOne;
+		}
+
+		const FChunkLandscapeWeight* WeightMapData = WeightMap.GetDataPtr<FChunkLandscapeWeight>();
+		const FChunkLandscapeWeight* AdjacentWeights[4] = {
+			&WeightMapData[ PosY * SurfaceResolutionXY + PosX ],
+			&WeightMapData[ PosY * SurfaceResolutionXY + PosX + 1 ],
+			&WeightMapData[ ( PosY + 1 ) * SurfaceResolutionXY + PosX ],
+			&WeightMapData[ ( PosY + 1 ) * SurfaceResolutionXY + PosX + 1 ],
+		};
+		const uint32 AdjacentFactors[4] = {
+			( FractionOne - FractionX ) * ( FractionOne - FractionY ),
+			FractionX * ( FractionOne - FractionY ),
+			( FractionOne - FractionX ) * FractionY,
+			FractionX * FractionY,
+		};
+
+		FMemory::Memzero( OutAccumulator.LayerWeights, sizeof(OutAccumulator.LayerWeights) );
+		OutAccumulator.PresentLayersMask = 0;
+
+		for ( int32 AdjacentIndex = 0; AdjacentIndex < 4; AdjacentIndex++ )
+		{
+			const FChunkLandscapeWeight& AdjacentWeight = *AdjacentWeights[ AdjacentIndex ];
+			const uint32 TotalWeight = AdjacentWeight.GetTotalWeight();
+			if ( TotalWeight == 0 || AdjacentFactors[ AdjacentIndex ] == 0 )
+			{
+				continue;
+			}
+			const uint32 PointScale = ( AdjacentFactors[ AdjacentIndex ] << FractionBits ) / TotalWeight;
+
+			for ( int32 EntryIndex = 0; EntryIndex < FChunkLandscapeWeight::MaxLayersPerPoint; EntryIndex++ )
+			{
+				// Unused entries have zero weight, so they do not contribute anything. Only the mask needs to skip them
+				const int32 LayerIndex = AdjacentWeight.GetEntryLayerIndex( EntryIndex );
+				OutAccumulator.LayerWeights[ LayerIndex ] += AdjacentWeight.EntryWeights[ EntryIndex ] * PointScale;
+				OutAccumulator.PresentLayersMask |= AdjacentWeight.EntryWeights[ EntryIndex ] != 0 ? ( 1u << LayerIndex ) : 0u;
+			}
+		}
+	}
+}
+
+FChunkLandscapeWeight FChunkLandscapeWeightSampler::SampleInterpolated( const FChunkData2D& WeightMap, const FVector2f& NormalizedPosition )
+{
+	using namespace ChunkLandscapeWeightInternal;
+	FBlendedWeightAccumulator Accumulator;
+	BlendAdjacentWeights( WeightMap, NormalizedPosition, Accumulator );
+
+	// Quantize the normalized weights back to the valid value range once
+	FChunkLandscapeWeight ResultWeight;
+	for ( uint32 LayersMask = Accumulator.PresentLayersMask; LayersMask != 0; LayersMask &= LayersMask - 1 )
+	{
+		const int32 LayerIndex = FMath::CountTrailingZeros( LayersMask );
+		const uint64 QuantizedWeight = ( (uint64) Accumulator.LayerWeights[ LayerIndex ] * 255 + ( 1ull << ( AccumulatorOneBits - 1 ) ) ) >> AccumulatorOneBits;
+		ResultWeight.SetAbsoluteWeight( LayerIndex, (uint8) FMath::Min<uint64>( QuantizedWeight, 255 ) );
+	}
+	return ResultWeight;
+}
+
+int32 FChunkLandscapeWeightSampler::SampleLayerWithLargestContribution( const FChunkData2D& WeightMap, const FVector2f& NormalizedPosition )
+{
+	using namespace ChunkLandscapeWeightInternal;
+	FBlendedWeightAccumulator Accumulator;
+	BlendAdjacentWeights( WeightMap, NormalizedPosition, Accumulator );
+
+	// Layers are visited in ascending order, so ties are resolved towards the lowest layer index
+	int32 LargestContributionLayer = 0;
+	uint32 LargestContributionValue = 0;
+	for ( uint32 LayersMask = Accumulator.PresentLayersMask; LayersMask != 0; LayersMask &= LayersMask - 1 )
+	{
+		const int32 LayerIndex = FMath::CountTrailingZeros( LayersMask );
+		if ( Accumulator.LayerWeights[ LayerIndex ] > LargestContributionValue )
+		{
+			LargestContributionLayer = LayerIndex;
+			LargestContributionValue = Accumulator.LayerWeights[ LayerIndex ];
+		}
+	}
+	return LargestContributionLayer;
+}
+
+float FChunkLandscapeWeightSampler::SampleNormalizedWeight( const FChunkData2D& WeightMap, const FVector2f& NormalizedPosition, int32 LayerIndex )
+{
+	using namespace ChunkLandscapeWeightInternal;
+	FBlendedWeightAccumulator Accumulator;
+	BlendAdjacentWeights( WeightMap, NormalizedPosition, Accumulator );
+
+	// Adjacent points without any weights do not contribute to the total, so re-normalize against the accumulated total instead of assuming it is one
+	uint32 TotalAccumulatedWeight = 0;
+	for ( uint32 LayersMask = Accumulator.PresentLayersMask; LayersMask != 0; LayersMask &= LayersMask - 1 )
+	{
+		TotalAccumulatedWeight += Accumulator.LayerWeights[ FMath::CountTrailingZeros( LayersMask ) ];
+	}
+	return TotalAccumulatedWeight == 0 ? 0.0f : Accumulator.LayerWeights[ LayerIndex ] * 1.0f / TotalAccumulatedWeight;
+}
+
+void FChunkLandscapeWeight::ConvertLegacyDenseWeightMap( FChunkData2D& InOutWeightMap )
+{
+	// Legacy weights were stored as a dense array of weights for every layer
+	constexpr int32 LegacyDataElementSize = MaxWeightMapLayers * sizeof(uint8);
+	if ( InOutWeightMap.IsEmpty() || InOutWeightMap.GetDataElementSize() != LegacyDataElementSize )
+	{
+		return;
+	}
+
+	FChunkData2D ConvertedWeightMap = FChunkData2D::CreateUninitialized<FChunkLandscapeWeight>( InOutWeightMap.GetSurfaceResolutionXY() );
+	const uint8* LegacyWeightsData = static_cast<const uint8*>( InOutWeightMap.GetRawDataPtr() );
+	FChunkLandscapeWeight* ConvertedWeightsData = ConvertedWeightMap.GetMutableDataPtr<FChunkLandscapeWeight>();
+
+	for ( int32 ElementIndex = 0; ElementIndex < InOutWeightMap.GetSurfaceElementCount(); ElementIndex++ )
+	{
+		ConvertedWeightsData[ ElementIndex ] = FromAbsoluteWeights( LegacyWeightsData + ElementIndex * LegacyDataElementSize );
+	}
+	InOutWeightMap = MoveTemp( ConvertedWeightMap );
+}
+
 UOWGChunkLandscapeLayer* FChunkLandscapeWeightMapDescriptor::GetLayerDescriptor( int32 InLayerIndex ) const
 {
 	return LandscapeLayers.IsValidIndex( InLayerIndex ) ? LandscapeLayers[ InLayerIndex ] : nullptr;
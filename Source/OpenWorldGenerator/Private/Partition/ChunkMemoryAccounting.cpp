@@ -0,0 +1,163 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "Partition/ChunkMemoryAccounting.h"
+#include "OpenWorldGeneratorSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "Partition/OWGChunk.h"
+
+DECLARE_MEMORY_STAT( TEXT("Chunk Memory: Chunk Data"), STAT_ChunkMemoryChunkData, STATGROUP_Game );
+DECLARE_MEMORY_STAT( TEXT("Chunk Memory: Noise Data"), STAT_ChunkMemoryNoiseData, STATGROUP_Game );
+DECLARE_MEMORY_STAT( TEXT("Chunk Memory: Landscape Mesh"), STAT_ChunkMemoryLandscapeMesh, STATGROUP_Game );
+DECLARE_MEMORY_STAT( TEXT("Chunk Memory: Weight Map Textures"), STAT_ChunkMemoryWeightMapTextures, STATGROUP_Game );
+DECLARE_MEMORY_STAT( TEXT("Chunk Memory: Grass"), STAT_ChunkMemoryGrass, STATGROUP_Game );
+DECLARE_MEMORY_STAT( TEXT("Chunk Memory: Collision"), STAT_ChunkMemoryCollision, STATGROUP_Game );
+DECLARE_MEMORY_STAT( TEXT("Chunk Memory: Total"), STAT_ChunkMemoryTotal, STATGROUP_Game );
+
+static TAutoConsoleVariable CVarChunkMemoryAccountingInterval(
+	TEXT("owg.ChunkMemoryAccountingInterval"),
+	1.0f,
+	TEXT("Interval in seconds between recalculating the memory used by the loaded chunks and enforcing the chunk memory budgets. Negative value disables the memory accounting. Default is 1 second"),
+	ECVF_Default
+);
+
+namespace ChunkMemoryInternal
+{
+	/** Returns true if the memory of the given category can be reduced by switching the chunks to coarser LODs */
+	static bool IsRenderingCategory( EChunkMemoryCategory Category )
+	{
+		return Category == EChunkMemoryCategory::LandscapeMesh || Category == EChunkMemoryCategory::WeightMapTextures || Category == EChunkMemoryCategory::Grass;
+	}
+
+	/** Returns true if the chunk uses memory of any category that is over budget, and unloading it would help getting back within the budget */
+	static bool ContributesToOverBudgetCategory( const FChunkMemoryUsage& ChunkMemoryUsage, const FChunkMemoryUsage& TotalMemoryUsage, const TMap<EChunkMemoryCategory, float>& BudgetsMB )
+	{
+		for ( const TPair<EChunkMemoryCategory, float>& Pair : BudgetsMB )
+		{
+			if ( Pair.Key < EChunkMemoryCategory::Num && ChunkMemoryUsage.Get( Pair.Key ) > 0 && TotalMemoryUsage.Get( Pair.Key ) > Pair.Value * 1024.0f * 1024.0f )
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+int64 FChunkMemoryUsage::GetTotal() const
+{
+	int64 TotalBytes = 0;
+	for ( int32 CategoryIndex = 0; CategoryIndex < NumCategories; CategoryIndex++ )
+	{
+		TotalBytes += CategoryBytes[ CategoryIndex ];
+	}
+	return TotalBytes;
+}
+
+FChunkMemoryUsage& FChunkMemoryUsage::operator+=( const FChunkMemoryUsage& Other )
+{
+	for ( int32 CategoryIndex = 0; CategoryIndex < NumCategories; CategoryIndex++ )
+	{
+		CategoryBytes[ CategoryIndex ] += Other.CategoryBytes[ CategoryIndex ];
+	}
+	return *this;
+}
+
+FChunkMemoryUsage& FChunkMemoryUsage::operator-=( const FChunkMemoryUsage& Other )
+{
+	for ( int32 CategoryIndex = 0; CategoryIndex < NumCategories; CategoryIndex++ )
+	{
+		CategoryBytes[ CategoryIndex ] -= Other.CategoryBytes[ CategoryIndex ];
+	}
+	return *this;
+}
+
+void FChunkMemoryUsage::UpdateStats() const
+{
+	SET_MEMORY_STAT( STAT_ChunkMemoryChunkData, Get( EChunkMemoryCategory::ChunkData ) );
+	SET_MEMORY_STAT( STAT_ChunkMemoryNoiseData, Get( EChunkMemoryCategory::NoiseData ) );
+	SET_MEMORY_STAT( STAT_ChunkMemoryLandscapeMesh, Get( EChunkMemoryCategory::LandscapeMesh ) );
+	SET_MEMORY_STAT( STAT_ChunkMemoryWeightMapTextures, Get( EChunkMemoryCategory::WeightMapTextures ) );
+	SET_MEMORY_STAT( STAT_ChunkMemoryGrass, Get( EChunkMemoryCategory::Grass ) );
+	SET_MEMORY_STAT( STAT_ChunkMemoryCollision, Get( EChunkMemoryCategory::Collision ) );
+	SET_MEMORY_STAT( STAT_ChunkMemoryTotal, GetTotal() );
+}
+
+FString FChunkMemoryUsage::GetCategoryName( EChunkMemoryCategory Category )
+{
+	return StaticEnum<EChunkMemoryCategory>()->GetNameStringByValue( (int64) Category );
+}
+
+float FChunkMemoryBudgets::GetAccountingInterval()
+{
+	return CVarChunkMemoryAccountingInterval.GetValueOnGameThread();
+}
+
+bool FChunkMemoryBudgets::IsOverBudget( const FChunkMemoryUsage& MemoryUsage, float BudgetFraction, bool bRenderingCategoriesOnly )
+{
+	for ( const TPair<EChunkMemoryCategory, float>& Pair : UOpenWorldGeneratorSettings::Get()->ChunkMemoryBudgetsMB )
+	{
+		if ( Pair.Key < EChunkMemoryCategory::Num && ( !bRenderingCategoriesOnly || ChunkMemoryInternal::IsRenderingCategory( Pair.Key ) ) &&
+			MemoryUsage.Get( Pair.Key ) > Pair.Value * BudgetFraction * 1024.0f * 1024.0f )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FChunkMemoryBudgets::SelectIdleChunksToUnload( const TArray<TPair<AOWGChunk*, FChunkMemoryUsage>>& PerChunkMemoryUsage, FChunkMemoryUsage& InOutRemainingMemoryUsage, TArray<AOWGChunk*>& OutChunksToUnload )
+{
+	if ( !IsOverBudget( InOutRemainingMemoryUsage, 1.0f, false ) )
+	{
+		return;
+	}
+
+	// Unload the chunks that have been idle for the longest first, they would be unloaded soon anyway
+	TArray<TPair<AOWGChunk*, FChunkMemoryUsage>> IdleChunks;
+	for ( const TPair<AOWGChunk*, FChunkMemoryUsage>& Pair : PerChunkMemoryUsage )
+	{
+		if ( Pair.Key->IsChunkIdle() && !Pair.Key->ShouldDeferChunkUnloading() )
+		{
+			IdleChunks.Add( Pair );
+		}
+	}
+	IdleChunks.Sort( []( const TPair<AOWGChunk*, FChunkMemoryUsage>& A, const TPair<AOWGChunk*, FChunkMemoryUsage>& B )
+	{
+		return A.Key->ElapsedIdleTime > B.Key->ElapsedIdleTime;
+	} );
+
+	const TMap<EChunkMemoryCategory, float>& MemoryBudgetsMB = UOpenWorldGeneratorSettings::Get()->ChunkMemoryBudgetsMB;
+	for ( const TPair<AOWGChunk*, FChunkMemoryUsage>& Pair : IdleChunks )
+	{
+		if ( !IsOverBudget( InOutRemainingMemoryUsage, 1.0f, false ) )
+		{
+			break;
+		}
+		if ( ChunkMemoryInternal::ContributesToOverBudgetCategory( Pair.Value, InOutRemainingMemoryUsage, MemoryBudgetsMB ) )
+		{
+			OutChunksToUnload.Add( Pair.Key );
+			InOutRemainingMemoryUsage -= Pair.Value;
+		}
+	}
+}
+
+int32 FChunkMemoryBudgets::UpdateLODBias( int32 CurrentLODBias, int32 MaxLODBias, const FChunkMemoryUsage& RemainingMemoryUsage )
+{
+	if ( IsOverBudget( RemainingMemoryUsage, 1.0f, true ) )
+	{
+		return FMath::Min( CurrentLODBias + 1, MaxLODBias );
+	}
+	if ( !IsOverBudget( RemainingMemoryUsage, LODBiasRecoveryBudgetFraction, true ) )
+	{
+		return FMath::Max( CurrentLODBias - 1, 0 );
+	}
+	return CurrentLODBias;
+}
+
+int32 FChunkMemoryBudgets::ApplyLODBias( int32 RequestedChunkLOD, int32 LODBias, int32 NumChunkLODs )
+{
+	if ( RequestedChunkLOD > 0 && LODBias > 0 )
+	{
+		return FMath::Max( RequestedChunkLOD, FMath::Min( RequestedChunkLOD + LODBias, NumChunkLODs - 1 ) );
+	}
+	return RequestedChunkLOD;
+}
@@ -4,6 +4,7 @@
 #include "DisplayDebugHelpers.h"
 #include "DrawDebugHelpers.h"
 #include "OpenWorldGeneratorSubsystem.h"
+#include "OWGTrace.h"
 #include "Algo/Unique.h"
 #include "Async/Async.h"
 #include "Components/BrushComponent.h"
@@ -12,24 +13,30 @@
 #include "Engine/World.h"
 #include "GameFramework/HUD.h"
 #include "GameFramework/Pawn.h"
+#include "Hash/CityHash.h"
 #include "Generation/OWGChunkGenerator.h"
 #include "Generation/OWGNoiseGenerator.h"
 #include "Generation/OWGWorldGeneratorConfiguration.h"
 #include "Materials/MaterialInstanceDynamic.h"
 #include "Net/UnrealNetwork.h"
+#include "Partition/ChunkGenerationSnapshot.h"
 #include "Partition/ChunkHeightfieldCollisionComponent.h"
 #include "Partition/ChunkLandscapeMaterialManager.h"
 #include "Partition/ChunkLandscapeMeshManager.h"
 #include "Partition/ChunkLandscapeWeight.h"
+#include "Partition/OWGChunkDataReplicationComponent.h"
 #include "Partition/OWGChunkManagerInterface.h"
 #include "Partition/OWGChunkSerialization.h"
 #include "Partition/TerraformingBrush.h"
+#include "Rendering/ChunkLandscapeGrassSubsystem.h"
 #include "Rendering/ChunkTextureManager.h"
 #include "Rendering/OWGChunkLandscapeLayer.h"
 
 DECLARE_CYCLE_STAT( TEXT("Chunk Landscape Point Sample"), STAT_ChunkLandscapePointSample, STATGROUP_Game );
 DECLARE_CYCLE_STAT( TEXT("Chunk Get Landscape Metrics"), STAT_ChunkGetLandscapeMetrics, STATGROUP_Game );
+DECLARE_CYCLE_STAT( TEXT("Chunk Landscape Line Trace"), STAT_ChunkLandscapeLineTrace, STATGROUP_Game );
 DECLARE_CYCLE_STAT( TEXT("Chunk Modify Landscape"), STAT_ChunkModifyLandscape, STATGROUP_Game );
+DECLARE_CYCLE_STAT( TEXT("Chunk Commit Landscape Modifications"), STAT_ChunkCommitLandscapeModifications, STATGROUP_Game );
 DECLARE_CYCLE_STAT( TEXT("Chunk Process Chunk Generation"), STAT_ProcessChunkGeneration, STATGROUP_Game );
 DECLARE_CYCLE_STAT( TEXT("Generate Noise For Chunk"), STAT_GenerateNoiseForChunk, STATGROUP_Game );
 
@@ -45,6 +52,62 @@ static TAutoConsoleVariable CVarChunkVisualizeLandscapeEditBounds(
 	TEXT("True to visualize bounds of landscape modifications to the chunk. Useful for investigating issues where brushes do not return correct extents for landscape modification.")
 );
 
+static TAutoConsoleVariable CVarMaxTrackedReplicatedDataModifications(
+	TEXT("owg.MaxTrackedReplicatedDataModifications"),
+	64,
+	TEXT("Maximum number of landscape modifications tracked per chunk to replicate them to the clients as deltas. Clients that are further behind receive the full snapshot of the chunk data instead.")
+);
+
+namespace ChunkDataReplicationInternal
+{
+	/** Serializes the grid points covered by the chunk space bounds. Bounds are converted to the grid points the same way the partial surface data updates do */
+	static void SerializeGridRegion( FArchive& Ar, FChunkData2D& GridData, const FBox2f& Bounds )
+	{
+		if ( Bounds.bIsValid )
+		{
+			const float GridCellSize = FChunkCoord::ChunkSizeWorldUnits / ( GridData.GetSurfaceResolutionXY() - 1 );
+			constexpr float GridOriginOffset = FChunkCoord::ChunkSizeWorldUnits / 2.0f;
+
+			const int32 StartX = FMath::FloorToInt32( ( Bounds.Min.X + GridOriginOffset ) / GridCellSize );
+			const int32 StartY = FMath::FloorToInt32( ( Bounds.Min.Y + GridOriginOffset ) / GridCellSize );
+			const int32 EndX = FMath::CeilToInt32( ( Bounds.Max.X + GridOriginOffset ) / GridCellSize );
+			const int32 EndY = FMath::CeilToInt32( ( Bounds.Max.Y + GridOriginOffset ) / GridCellSize );
+
+			GridData.SerializeRegion( Ar, StartX, StartY, EndX, EndY );
+		}
+	}
+
+	/** Appends the path names of the objects to the hash. Object pointers are different between the server and the client, but the paths of the assets are the same */
+	template<typename T>
+	static uint64 HashObjectPaths( const TArray<T*>& Objects, uint64 Seed )
+	{
+		FString ObjectPaths;
+		for ( const T* Object : Objects )
+		{
+			ObjectPaths.Append( GetPathNameSafe( Object ) ).AppendChar( TEXT(';') );
+		}
+		return CityHash64WithSeed( reinterpret_cast<const char*>( *ObjectPaths ), ObjectPaths.Len() * sizeof(TCHAR), Seed );
+	}
+}
+
+namespace ChunkGenerationInternal
+{
+	/** Returns the name of the trace scope running the chunk generators of the given stage, so that each stage shows up as a separate timer in Insights */
+	static const TCHAR* GetGenerationStageTraceName( EChunkGeneratorStage Stage )
+	{
+		static const TArray<FString> StageTraceNames = []()
+		{
+			TArray<FString> TraceNames;
+			for ( int32 StageIndex = 0; StageIndex <= (int32) EChunkGeneratorStage::Latest; StageIndex++ )
+			{
+				TraceNames.Add( FString::Printf( TEXT("RunChunkGenerator_%s"), *StaticEnum<EChunkGeneratorStage>()->GetNameStringByValue( StageIndex ) ) );
+			}
+			return TraceNames;
+		}();
+		return StageTraceNames.IsValidIndex( (int32) Stage ) ? *StageTraceNames[ (int32) Stage ] : TEXT("RunChunkGenerator");
+	}
+}
+
 FChunkLandscapePointSampler::FChunkLandscapePointSampler( const AOWGChunk* Chunk )
 {
 	check( Chunk->IsChunkInitialized() );
@@ -169,7 +232,7 @@ FChunkLandscapePoint FChunkLandscapePointSampler::SamplePointInterpolated_Local(
 	const float PointHeight = HeightMapData->GetInterpolatedElementAt<float>( NormalizedPosition );
 	const FVector3f PointNormal = NormalMapData->GetInterpolatedElementAt<FVector3f>( NormalizedPosition );
 	const float PointSteepness = SteepnessData->GetInterpolatedElementAt<float>( NormalizedPosition );
-	const FChunkLandscapeWeight PointWeight = WeightMapData->GetInterpolatedElementAt<FChunkLandscapeWeight>( NormalizedPosition );
+	const FChunkLandscapeWeight PointWeight = FChunkLandscapeWeightSampler::SampleInterpolated( *WeightMapData, NormalizedPosition );
 
 	const FVector PointLocation( ChunkLocalPosition.X, ChunkLocalPosition.Y, PointHeight );
 	const FQuat PointRotation = FRotationMatrix::MakeFromZ( FVector( PointNormal ) ).ToQuat();
@@ -248,7 +311,93 @@ void FChunkLandscapePointSampler::PopulatePointLayerWeights( FChunkLandscapePoin
 	}
 }
 
-AOWGChunk::AOWGChunk() : NumChunkLandscapeLODs( 4 )
+FChunkLandscapeTracer::FChunkLandscapeTracer( const UObject* WorldContext, const FBox& WorldBounds )
+{
+	check( IsInGameThread() );
+
+	if ( const UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = UOpenWorldGeneratorSubsystem::Get( WorldContext ) )
+	{
+		const FChunkCoord MinChunkCoord = FChunkCoord::FromWorldLocation( WorldBounds.Min );
+		const FChunkCoord MaxChunkCoord = FChunkCoord::FromWorldLocation( WorldBounds.Max );
+
+		for ( int32 ChunkX = MinChunkCoord.PosX; ChunkX <= MaxChunkCoord.PosX; ChunkX++ )
+		{
+			for ( int32 ChunkY = MinChunkCoord.PosY; ChunkY <= MaxChunkCoord.PosY; ChunkY++ )
+			{
+				const FChunkCoord ThisChunkCoord( ChunkX, ChunkY );
+				const TScriptInterface<IOWGChunkManagerInterface> ChunkManager = OpenWorldGeneratorSubsystem->GetChunkManager();
+				AOWGChunk* LoadedChunk = ChunkManager ? ChunkManager->FindChunk( ThisChunkCoord ) : nullptr;
+				if ( LoadedChunk && LoadedChunk->IsChunkInitialized() )
+				{
+					AddChunkLandscapeData( ThisChunkCoord, LoadedChunk->GetChunkLandscapeSourceData() );
+				}
+			}
+		}
+	}
+}
+
+void FChunkLandscapeTracer::AddChunkLandscapeData( const FChunkCoord& ChunkCoord, const TSharedRef<FCachedChunkLandscapeData>& LandscapeData )
+{
+	ChunkLandscapeData.Add( ChunkCoord, LandscapeData );
+}
+
+bool FChunkLandscapeTracer::LineTrace( const FVector& TraceStart, const FVector& TraceEnd, FChunkLandscapeTraceHit& OutHit ) const
+{
+	SCOPE_CYCLE_COUNTER( STAT_ChunkLandscapeLineTrace );
+	constexpr double ChunkSize = FChunkCoord::ChunkSizeWorldUnits;
+
+	// Walk the chunks the segment passes through in order, so that the first chunk with a hit contains the closest hit
+	const FChunkCoord StartChunkCoord = FChunkCoord::FromWorldLocation( TraceStart );
+	const FChunkCoord EndChunkCoord = FChunkCoord::FromWorldLocation( TraceEnd );
+	const FVector TraceDelta = TraceEnd - TraceStart;
+
+	const int32 StepX = TraceDelta.X > 0.0 ? 1 : -1;
+	const int32 StepY = TraceDelta.Y > 0.0 ? 1 : -1;
+	// Time at which the segment crosses the next chunk border across each axis, and the time it takes to cross the entire chunk
+	double NextBorderTimeX = FMath::IsNearlyZero( TraceDelta.X ) ? UE_BIG_NUMBER : ( ( StartChunkCoord.PosX + ( StepX > 0 ? 1 : 0 ) ) * ChunkSize - TraceStart.X ) / TraceDelta.X;
+	double NextBorderTimeY = FMath::IsNearlyZero( TraceDelta.Y ) ? UE_BIG_NUMBER : ( ( StartChunkCoord.PosY + ( StepY > 0 ? 1 : 0 ) ) * ChunkSize - TraceStart.Y ) / TraceDelta.Y;
+	const double ChunkCrossTimeX = FMath::IsNearlyZero( TraceDelta.X ) ? UE_BIG_NUMBER : ChunkSize / FMath::Abs( TraceDelta.X );
+	const double ChunkCrossTimeY = FMath::IsNearlyZero( TraceDelta.Y ) ? UE_BIG_NUMBER : ChunkSize / FMath::Abs( TraceDelta.Y );
+
+	FChunkCoord CurrentChunkCoord = StartChunkCoord;
+	const int32 MaxChunksToVisit = FMath::Abs( EndChunkCoord.PosX - StartChunkCoord.PosX ) + FMath::Abs( EndChunkCoord.PosY - StartChunkCoord.PosY ) + 1;
+
+	for ( int32 ChunkIndex = 0; ChunkIndex < MaxChunksToVisit; ChunkIndex++ )
+	{
+		if ( const TSharedRef<FCachedChunkLandscapeData>* LandscapeData = ChunkLandscapeData.Find( CurrentChunkCoord ) )
+		{
+			const FTransform& ChunkToWorld = (*LandscapeData)->ChunkToWorld;
+			const FVector LocalTraceStart = ChunkToWorld.InverseTransformPosition( TraceStart );
+			const FVector LocalTraceEnd = ChunkToWorld.InverseTransformPosition( TraceEnd );
+
+			double HitTime = 0.0;
+			FVector LocalHitNormal;
+			if ( (*LandscapeData)->HeightPyramid.LineTrace_Local( (*LandscapeData)->HeightMapData, LocalTraceStart, LocalTraceEnd, HitTime, LocalHitNormal ) )
+			{
+				OutHit.Location = TraceStart + TraceDelta * HitTime;
+				OutHit.Normal = ChunkToWorld.TransformVectorNoScale( LocalHitNormal );
+				OutHit.Distance = TraceDelta.Size() * HitTime;
+				OutHit.ChunkCoord = CurrentChunkCoord;
+				return true;
+			}
+		}
+
+		// Advance to the next chunk across the axis which border we cross first
+		if ( NextBorderTimeX < NextBorderTimeY )
+		{
+			CurrentChunkCoord.PosX += StepX;
+			NextBorderTimeX += ChunkCrossTimeX;
+		}
+		else
+		{
+			CurrentChunkCoord.PosY += StepY;
+			NextBorderTimeY += ChunkCrossTimeY;
+		}
+	}
+	return false;
+}
+
+AOWGChunk::AOWGChunk() : NumChunkLandscapeLODs( 4 ), bGenerateLandscapeSkirts( true ), LandscapeSkirtMinDepth( 50.0f )
 {
 	PrimaryActorTick.bCanEverTick = false;
 
@@ -289,6 +438,11 @@ FChunkLandscapeMetrics FChunkLandscapeMetrics::Merge( const UObject* WorldContex
 	// Sum up all metrics in the list to get the average
 	for ( const FChunkLandscapeMetrics& SubMetrics : AllMetrics )
 	{
+		// Skip metrics from chunks that the brush did not actually cover, their min/max points are zeroed out and would skew the result
+		if ( SubMetrics.NumberOfPoints == 0 )
+		{
+			continue;
+		}
 		const float MetricsWeight = SubMetrics.NumberOfPoints / ( ResultMetrics.NumberOfPoints * 1.0f );
 		ResultMetrics.MiddleHeightPoint += SubMetrics.MiddleHeightPoint * MetricsWeight;
 
@@ -328,7 +482,7 @@ void AOWGChunk::GetLifetimeReplicatedProps( TArray<FLifetimeProperty>& OutLifeti
 {
 	Super::GetLifetimeReplicatedProps( OutLifetimeProps );
 
-	// TODO @open-world-generator: Replicate NoiseData and ChunkData2D
+	// Landscape data is too large for the property replication, it is sent to the clients by UOWGChunkDataReplicationComponent instead
 	DOREPLIFETIME( ThisClass, ChunkCoord );
 }
 
@@ -341,13 +495,34 @@ void AOWGChunk::PostActorCreated()
 	{
 		const UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = UOpenWorldGeneratorSubsystem::Get( GetWorld() );
 		check( OpenWorldGeneratorSubsystem );
-	
-		WorldGeneratorDefinition = OpenWorldGeneratorSubsystem->GetWorldGeneratorDefinition();
-		WorldSeed = OpenWorldGeneratorSubsystem->GetWorldSeed();
-		check( WorldGeneratorDefinition );
 
 		LandscapeMeshManager = MakeUnique<FChunkLandscapeMeshManager>( this );
 		LandscapeMaterialManager = MakeUnique<FChunkLandscapeMaterialManager>( this, OpenWorldGeneratorSubsystem->GetChunkTextureManager() );
+
+		// Chunks replicated to the client can arrive before the world parameters. Their initialization is deferred until the client chunk manager adopts them
+		if ( OpenWorldGeneratorSubsystem->GetWorldGeneratorDefinition() )
+		{
+			InitializeWorldParameters();
+		}
+		else
+		{
+			check( GetNetMode() == NM_Client );
+		}
+	}
+}
+
+void AOWGChunk::InitializeWorldParameters()
+{
+	const UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = UOpenWorldGeneratorSubsystem::Get( GetWorld() );
+	check( OpenWorldGeneratorSubsystem );
+
+	WorldGeneratorDefinition = OpenWorldGeneratorSubsystem->GetWorldGeneratorDefinition();
+	WorldSeed = OpenWorldGeneratorSubsystem->GetWorldSeed();
+	check( WorldGeneratorDefinition );
+
+	if ( PCGComponent )
+	{
+		PCGComponent->Seed = WorldSeed;
 	}
 }
 
@@ -383,6 +558,20 @@ void AOWGChunk::BeginPlay()
 	}
 
 	// Register the chunk in the subsystem's chunk manager
+	RegisterInChunkManager();
+
+	// Let the replication components of the local players know about the chunk replicated from the server
+	if ( !HasAuthority() )
+	{
+		UOWGChunkDataReplicationComponent::RegisterReplicatedChunk( this );
+	}
+}
+
+void AOWGChunk::RegisterInChunkManager()
+{
+	const UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = UOpenWorldGeneratorSubsystem::Get( GetWorld() );
+	check( OpenWorldGeneratorSubsystem );
+
 	if ( const TScriptInterface<IOWGChunkManagerInterface> ChunkManager = OpenWorldGeneratorSubsystem->GetChunkManager() )
 	{
 		ChunkManager->NotifyChunkBegunPlay( this );
@@ -415,6 +604,10 @@ void AOWGChunk::EndPlay( const EEndPlayReason::Type EndPlayReason )
 			ChunkManager->NotifyChunkDestroyed( this );
 		}
 	}
+	if ( !HasAuthority() )
+	{
+		UOWGChunkDataReplicationComponent::UnregisterReplicatedChunk( this );
+	}
 
 	// Release textures back to the pool
 	LandscapeMaterialManager->ReleaseTextures();
@@ -446,6 +639,15 @@ void AOWGChunk::Serialize( FArchive& Ar )
 	Ar << NoiseData;
 	// Serialize generic 2D chunk data
 	Ar << ChunkData2D;
+
+	// Convert the weight map saved with the dense layer weights
+	if ( Ar.IsLoading() && Ar.CustomVer( FOpenWorldGeneratorVersion::GUID ) < FOpenWorldGeneratorVersion::SparseLandscapeWeights )
+	{
+		if ( FChunkData2D* WeightMapData = ChunkData2D.Find( ChunkDataID::SurfaceWeights ) )
+		{
+			FChunkLandscapeWeight::ConvertLegacyDenseWeightMap( *WeightMapData );
+		}
+	}
 	// Serialize weight map descriptor
 	Ar << WeightMapDescriptor;
 	// Serialize biome palette
@@ -484,8 +686,26 @@ void AOWGChunk::SetupChunk( UOWGRegionContainer* InOwnerContainer, const FChunkC
 	OwnerContainer = InOwnerContainer;
 }
 
+void AOWGChunk::SetupClientChunk( const FChunkCoord& InChunkCoord )
+{
+	check( GetNetMode() == NM_Client );
+	ChunkCoord = InChunkCoord;
+	OwnerContainer = nullptr;
+}
+
 void AOWGChunk::OnChunkLoaded()
 {
+	// Height pyramid is not serialized, so rebuild it from the loaded heightmap
+	if ( const FChunkData2D* HeightMapData = ChunkData2D.Find( ChunkDataID::SurfaceHeightmap ) )
+	{
+		HeightPyramid.Build( *HeightMapData );
+	}
+
+	// Loaded data is the snapshot the clients can verify their locally generated data against. It will only match if the chunk has not been terraformed
+	if ( IsChunkInitialized() )
+	{
+		ReplicatedDataSnapshotHash = ComputeReplicatedDataHash();
+	}
 }
 
 void AOWGChunk::OnChunkAboutToBeUnloaded()
@@ -503,6 +723,129 @@ bool AOWGChunk::ShouldDeferChunkUnloading() const
 	return CurrentGeneratorInstance && !CurrentGeneratorInstance->CanPersistChunkGenerator();
 }
 
+void AOWGChunk::ResetChunkForPooling()
+{
+	OWG_TRACE_CHUNK_SCOPE( ResetChunkForPooling, ChunkCoord );
+	check( !bIsPooled );
+
+	UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = UOpenWorldGeneratorSubsystem::Get( GetWorld() );
+	check( OpenWorldGeneratorSubsystem );
+
+	// Un-register from the chunk manager like EndPlay would. The owner region has already removed the chunk from the loaded chunks at this point
+	if ( const TScriptInterface<IOWGChunkManagerInterface> ChunkManager = OpenWorldGeneratorSubsystem->GetChunkManager() )
+	{
+		ChunkManager->NotifyChunkDestroyed( this );
+	}
+
+	// Grass components are attached to the chunk, so they need to be destroyed before the chunk is moved to the new location
+	if ( UChunkLandscapeGrassSubsystem* GrassSubsystem = GetWorld()->GetSubsystem<UChunkLandscapeGrassSubsystem>() )
+	{
+		GrassSubsystem->DestroyChunkGrass( ChunkCoord );
+	}
+
+	// Release textures back to the pool and destroy actors that are associated with the chunk
+	LandscapeMaterialManager->ReleaseTextures();
+
+	TArray<AActor*> ReferencedActors;
+	CollectActorReferences( ReferencedActors );
+
+	for ( AActor* ReferencedActor : ReferencedActors )
+	{
+		if ( ReferencedActor )
+		{
+			ReferencedActor->Destroy();
+		}
+	}
+
+	// Managers keep the state of the previous chunk, so re-create them from scratch. Results of the async tasks they have started are discarded based on the recycle count
+	LandscapeMeshManager = MakeUnique<FChunkLandscapeMeshManager>( this );
+	LandscapeMaterialManager = MakeUnique<FChunkLandscapeMaterialManager>( this, OpenWorldGeneratorSubsystem->GetChunkTextureManager() );
+	ChunkRecycleCount++;
+
+	// Drop the chunk data and the transient state
+	NoiseData.Empty();
+	ChunkData2D.Empty();
+	WeightMapDescriptor = FChunkLandscapeWeightMapDescriptor();
+	BiomePalette = FChunkBiomePalette();
+	HeightPyramid = FChunkHeightPyramid();
+	CachedLandscapeData.Reset();
+	CachedBiomeData.Reset();
+	GrassSourceDataChangelistNumber++;
+	ReplicatedDataChangelist = 0;
+	ReplicatedDataSnapshotChangelist = 0;
+	ReplicatedDataSnapshotHash = 0;
+	ReplicatedDataModifications.Empty();
+
+	ElapsedIdleTime = 0.0f;
+	bPendingToBeUnloaded = false;
+	DistanceToClosestStreamingSource = -1.0f;
+	CurrentChunkLOD = INDEX_NONE;
+	CurrentStageChunkGenerators = FChunkGeneratorBiomeMapping();
+	OwnerContainer = nullptr;
+
+	// Return the generator that was still running back to the pool before the property reset drops the reference to it
+	if ( CurrentGeneratorInstance )
+	{
+		OpenWorldGeneratorSubsystem->ReleaseChunkGenerator( CurrentGeneratorInstance );
+		CurrentGeneratorInstance = nullptr;
+	}
+	ResetPropertiesToClassDefaults();
+
+	// Clear the landscape mesh and the collision, and unregister the components until the chunk is reused. Unregistered components are not rendered and do not collide
+	if ( LandscapeMeshComponent )
+	{
+		LandscapeMeshComponent->GetDynamicMesh()->Reset();
+		LandscapeMeshComponent->EmptyOverrideMaterials();
+	}
+	HeightFieldCollisionComponent->ReleaseCollisionData();
+	UnregisterAllComponents();
+
+	// Stop replicating the chunk so the clients destroy their copy of it. It will be replicated again as a new actor once the chunk is reused
+	if ( GetIsReplicated() )
+	{
+		SetReplicates( false );
+	}
+	bIsPooled = true;
+}
+
+void AOWGChunk::ReactivatePooledChunk()
+{
+	OWG_TRACE_CHUNK_SCOPE( ReactivatePooledChunk, ChunkCoord );
+	check( bIsPooled );
+	bIsPooled = false;
+
+	// Move the chunk to the new location while the components are still unregistered, and register them again. This will also create the collision if the chunk has been loaded
+	SetActorLocation( ChunkCoord.ToOriginWorldLocation() );
+	RegisterAllComponents();
+
+	if ( GetClass()->GetDefaultObject<AActor>()->GetIsReplicated() )
+	{
+		SetReplicates( true );
+	}
+	RegisterInChunkManager();
+}
+
+void AOWGChunk::ResetPropertiesToClassDefaults()
+{
+	const AOWGChunk* ChunkDefaults = GetClass()->GetDefaultObject<AOWGChunk>();
+
+	for ( TFieldIterator<FProperty> PropertyIt( GetClass() ); PropertyIt; ++PropertyIt )
+	{
+		const FProperty* Property = *PropertyIt;
+
+		// Only reset the properties declared by the chunk classes. Transient state is reset explicitly, and components are kept as they are
+		if ( !Property->GetOwnerClass()->IsChildOf( AOWGChunk::StaticClass() ) || Property->HasAnyPropertyFlags( CPF_Transient | CPF_InstancedReference | CPF_ContainsInstancedReference ) )
+		{
+			continue;
+		}
+		if ( const FObjectPropertyBase* ObjectProperty = CastField<FObjectPropertyBase>( Property ); ObjectProperty && ObjectProperty->PropertyClass->IsChildOf( UActorComponent::StaticClass() ) )
+		{
+			continue;
+		}
+		Property->CopyCompleteValue_InContainer( this, ChunkDefaults );
+	}
+}
+
 void AOWGChunk::OnChunkCreated()
 {
 	// Generate noise data for this chunk
@@ -557,117 +900,282 @@ void AOWGChunk::GetLandscapePoints( const FVector& WorldLocation, const FPolymor
 	check( false );
 }
 
+FChunkLandscapeBrushGrid FChunkLandscapeBrushGrid::Render( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, int32 GridResolutionXY )
+{
+	FChunkLandscapeBrushGrid BrushGrid;
+	BrushGrid.OriginChunkCoord = FChunkCoord::FromWorldLocation( WorldLocation );
+	BrushGrid.GridResolutionXY = GridResolutionXY;
+
+	// Chunks are never rotated or scaled, so the chunk local position is just an offset from the chunk origin
+	const FVector ChunkLocalOrigin = WorldLocation - BrushGrid.OriginChunkCoord.ToOriginWorldLocation();
+	constexpr float GridOriginOffset = FChunkCoord::ChunkSizeWorldUnits / 2.0f;
+	const float GridCellSize = FChunkCoord::ChunkSizeWorldUnits / ( GridResolutionXY - 1 );
+
+	Brush.RenderBrushToSizedGrid( FVector2f( ChunkLocalOrigin.X, ChunkLocalOrigin.Y ), GridOriginOffset, GridCellSize, BrushGrid.GridStartXY, BrushGrid.GridSizeXY, BrushGrid.Weights, &BrushGrid.BrushBounds );
+	return BrushGrid;
+}
+
 FChunkLandscapeMetrics AOWGChunk::GetLandscapeMetrics( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, bool bIncludeWeights, float MinWeight )
 {
-	check( false );
+	if ( !IsChunkInitialized() )
+	{
+		return FChunkLandscapeMetrics{};
+	}
+	const FChunkData2D& HeightMapData = ChunkData2D.FindChecked( ChunkDataID::SurfaceHeightmap );
+	const FChunkLandscapeBrushGrid BrushGrid = FChunkLandscapeBrushGrid::Render( WorldLocation, Brush, HeightMapData.GetSurfaceResolutionXY() );
+	return GetLandscapeMetricsFromBrushGrid( BrushGrid, bIncludeWeights, MinWeight );
+}
+
+FChunkLandscapeMetrics AOWGChunk::GetLandscapeMetricsFromBrushGrid( const FChunkLandscapeBrushGrid& BrushGrid, bool bIncludeWeights, float MinWeight ) const
+{
 	SCOPE_CYCLE_COUNTER( STAT_ChunkGetLandscapeMetrics );
 
 	const FChunkData2D& HeightMapData = ChunkData2D.FindChecked( ChunkDataID::SurfaceHeightmap );
 	const FChunkData2D& SteepnessData = ChunkData2D.FindChecked( ChunkDataID::SurfaceSteepness );
-	const FChunkData2D* SurfaceWeightMap = ChunkData2D.Find( ChunkDataID::SurfaceWeights );
-
-	const FTransform ChunkTransform = GetActorTransform();
-	const FVector ChunkLocalOrigin = ChunkTransform.InverseTransformPosition( WorldLocation );
+	const FChunkData2D* SurfaceWeightMap = bIncludeWeights ? ChunkData2D.Find( ChunkDataID::SurfaceWeights ) : nullptr;
 
 	const int32 ChunkDataSize = HeightMapData.GetSurfaceResolutionXY();
-	constexpr float GridOriginOffset = FChunkCoord::ChunkSizeWorldUnits / 2.0f;
-	const float GridCellSize = FChunkCoord::ChunkSizeWorldUnits / ( ChunkDataSize - 1 );
+	check( BrushGrid.GridResolutionXY == ChunkDataSize );
 
-	FIntPoint GridStartXY;
-	FIntVector2 GridSizeXY;
-	TArray<float> BrushPointWeights;
-	FBox2f BrushBounds;
-	Brush->RenderBrushToSizedGrid( FVector2f( ChunkLocalOrigin.X, ChunkLocalOrigin.Y ), GridOriginOffset, GridCellSize, GridStartXY, GridSizeXY, BrushPointWeights, &BrushBounds );
+	const FIntPoint GridStartXY = BrushGrid.GetGridStartForChunk( ChunkCoord );
+	const FIntVector2 GridSizeXY = BrushGrid.GridSizeXY;
+
+	const int32 StartX = FMath::Max( GridStartXY.X, 0 );
+	const int32 EndX = FMath::Min( GridStartXY.X + GridSizeXY.X, ChunkDataSize );
+	const int32 StartY = FMath::Max( GridStartXY.Y, 0 );
+	const int32 EndY = FMath::Min( GridStartXY.Y + GridSizeXY.Y, ChunkDataSize );
 
-	// Sample points along the grid to build the metric
 	FChunkLandscapeMetrics ResultMetrics;
-	int32 AverageWeightMapLayerWeights[FChunkLandscapeWeight::MaxWeightMapLayers] {};
+	if ( StartX >= EndX || StartY >= EndY )
+	{
+		return ResultMetrics;
+	}
 
-	ResultMetrics.MinimumHeightPoint.Z = UE_BIG_NUMBER;
-	ResultMetrics.MaximumHeightPoint.Z = -UE_BIG_NUMBER;
-	
-	const int32 NumLayers = WeightMapDescriptor.GetNumLayers();
+	const float* HeightMapPtr = HeightMapData.GetDataPtr<float>();
+	const float* SteepnessPtr = SteepnessData.GetDataPtr<float>();
+	const float* BrushWeightsPtr = BrushGrid.Weights.GetData();
 
-	// Sample landscape at each point
-	for ( int32 ChunkDataX = FMath::Max( GridStartXY.X, 0 ); ChunkDataX < FMath::Min( GridStartXY.X + GridSizeXY.X, ChunkDataSize ); ChunkDataX++ )
+	// Weight map might have a different resolution than the heightmap, in which case we sample the closest weight map point instead
+	const FChunkLandscapeWeight* WeightMapPtr = SurfaceWeightMap ? SurfaceWeightMap->GetDataPtr<FChunkLandscapeWeight>() : nullptr;
+	const bool bWeightMapMatchesHeightMap = SurfaceWeightMap && SurfaceWeightMap->GetSurfaceResolutionXY() == ChunkDataSize;
+	const int32 NumLayers = WeightMapDescriptor.GetNumLayers();
+	uint32 TotalWeightMapLayerWeights[FChunkLandscapeWeight::MaxWeightMapLayers] {};
+
+	const VectorRegister4Float MinWeightVector = VectorSetFloat1( MinWeight );
+	const VectorRegister4Float ZeroVector = VectorZeroFloat();
+	const VectorRegister4Float LaneOffsetVector = MakeVectorRegisterFloat( 0.0f, 1.0f, 2.0f, 3.0f );
+	const VectorRegister4Float PositiveBigNumberVector = VectorSetFloat1( UE_BIG_NUMBER );
+	const VectorRegister4Float NegativeBigNumberVector = VectorSetFloat1( -UE_BIG_NUMBER );
+
+	// Per-lane accumulators. Positions are accumulated as grid indices, and converted to the chunk local space once at the end
+	VectorRegister4Float PositionXAccumulator = VectorZeroFloat();
+	VectorRegister4Float HeightAccumulator = VectorZeroFloat();
+	VectorRegister4Float MaxSteepnessAccumulator = VectorZeroFloat();
+
+	double SumPositionY = 0.0;
+	float MinimumHeight = UE_BIG_NUMBER;
+	float MaximumHeight = -UE_BIG_NUMBER;
+	int32 MinimumHeightRow = INDEX_NONE;
+	int32 MaximumHeightRow = INDEX_NONE;
+
+	const auto AccumulatePointWeights = [&]( int32 ChunkDataX, int32 ChunkDataY )
 	{
-		for ( int32 ChunkDataY = FMath::Max( GridStartXY.Y, 0 ); ChunkDataY < FMath::Min( GridStartXY.Y + GridSizeXY.Y, ChunkDataSize ); ChunkDataY++ )
+		const FChunkLandscapeWeight* PointWeight;
+		if ( bWeightMapMatchesHeightMap )
+		{
+			PointWeight = &WeightMapPtr[ ChunkDataY * ChunkDataSize + ChunkDataX ];
+		}
+		else
+		{
+			const FIntVector2 WeightMapPoint = SurfaceWeightMap->ChunkLocalPositionToPoint( HeightMapData.PointToChunkLocalPosition( ChunkDataX, ChunkDataY, 0.0f ) );
+			PointWeight = &WeightMapPtr[ WeightMapPoint.Y * SurfaceWeightMap->GetSurfaceResolutionXY() + WeightMapPoint.X ];
+		}
+		// Unused entries have zero weight, so they can be accumulated without checking
+		for ( int32 EntryIndex = 0; EntryIndex < FChunkLandscapeWeight::MaxLayersPerPoint; EntryIndex++ )
 		{
-			const int32 BrushX = ChunkDataX - GridStartXY.X;
-			const int32 BrushY = ChunkDataY - GridStartXY.Y;
+			TotalWeightMapLayerWeights[ PointWeight->GetEntryLayerIndex( EntryIndex ) ] += PointWeight->EntryWeights[ EntryIndex ];
+		}
+	};
 
-			// Filter out positions that are below the minimum weight
-			const float PointWeight = BrushPointWeights[ GridSizeXY.X * BrushY + BrushX ];
-			if ( PointWeight == 0.0f || PointWeight < MinWeight )
+	// Go row by row, since the chunk data and the brush weights are laid out row by row in memory
+	for ( int32 ChunkDataY = StartY; ChunkDataY < EndY; ChunkDataY++ )
+	{
+		const float* RowBrushWeights = BrushWeightsPtr + GridSizeXY.X * ( ChunkDataY - GridStartXY.Y );
+		const float* RowHeights = HeightMapPtr + ChunkDataSize * ChunkDataY;
+		const float* RowSteepness = SteepnessPtr + ChunkDataSize * ChunkDataY;
+
+		VectorRegister4Float RowNumPoints = VectorZeroFloat();
+		VectorRegister4Float RowMinHeight = PositiveBigNumberVector;
+		VectorRegister4Float RowMaxHeight = NegativeBigNumberVector;
+
+		int32 ChunkDataX = StartX;
+		for ( ; ChunkDataX + 4 <= EndX; ChunkDataX += 4 )
+		{
+			const VectorRegister4Float BrushWeights = VectorLoad( RowBrushWeights + ( ChunkDataX - GridStartXY.X ) );
+			const VectorRegister4Float PointMask = VectorBitwiseAnd( VectorCompareGT( BrushWeights, ZeroVector ), VectorCompareGE( BrushWeights, MinWeightVector ) );
+			const int32 PointMaskBits = VectorMaskBits( PointMask );
+			if ( PointMaskBits == 0 )
 			{
 				continue;
 			}
 
-			// Calculate height and steepness at the given point
-			const float PointHeight = HeightMapData.GetElementAt<float>( ChunkDataX, ChunkDataY );
-			const float PointSteepness = SteepnessData.GetElementAt<float>( ChunkDataX, ChunkDataY );
-			
-			const FVector PointWorldLocation = ChunkTransform.TransformPosition( FVector( ChunkDataX, ChunkDataY, PointHeight ) );
-			
-			ResultMetrics.NumberOfPoints++;
-			ResultMetrics.MiddleHeightPoint += PointWorldLocation;
+			const VectorRegister4Float Heights = VectorLoad( RowHeights + ChunkDataX );
+			const VectorRegister4Float Steepness = VectorLoad( RowSteepness + ChunkDataX );
+			const VectorRegister4Float PositionX = VectorAdd( VectorSetFloat1( ChunkDataX ), LaneOffsetVector );
 
-			if ( ResultMetrics.MinimumHeightPoint.Z > PointWorldLocation.Z )
-			{
-				ResultMetrics.MinimumHeightPoint = PointWorldLocation;
-			}
-			if ( ResultMetrics.MaximumHeightPoint.Z < PointWorldLocation.Z )
+			RowNumPoints = VectorAdd( RowNumPoints, VectorSelect( PointMask, GlobalVectorConstants::FloatOne, ZeroVector ) );
+			PositionXAccumulator = VectorAdd( PositionXAccumulator, VectorSelect( PointMask, PositionX, ZeroVector ) );
+			HeightAccumulator = VectorAdd( HeightAccumulator, VectorSelect( PointMask, Heights, ZeroVector ) );
+			MaxSteepnessAccumulator = VectorMax( MaxSteepnessAccumulator, VectorSelect( PointMask, Steepness, ZeroVector ) );
+			RowMinHeight = VectorMin( RowMinHeight, VectorSelect( PointMask, Heights, PositiveBigNumberVector ) );
+			RowMaxHeight = VectorMax( RowMaxHeight, VectorSelect( PointMask, Heights, NegativeBigNumberVector ) );
+
+			if ( WeightMapPtr )
 			{
-				ResultMetrics.MaximumHeightPoint = PointWorldLocation;
+				for ( int32 LaneIndex = 0; LaneIndex < 4; LaneIndex++ )
+				{
+					if ( PointMaskBits & ( 1 << LaneIndex ) )
+					{
+						AccumulatePointWeights( ChunkDataX + LaneIndex, ChunkDataY );
+					}
+				}
 			}
-			if ( ResultMetrics.MaximumSteepness < PointSteepness )
+		}
+
+		// Reduce the per-lane row values into scalars
+		float RowNumPointsLanes[4];
+		float RowMinHeightLanes[4];
+		float RowMaxHeightLanes[4];
+		VectorStore( RowNumPoints, RowNumPointsLanes );
+		VectorStore( RowMinHeight, RowMinHeightLanes );
+		VectorStore( RowMaxHeight, RowMaxHeightLanes );
+
+		int32 RowPointCount = FMath::RoundToInt32( RowNumPointsLanes[0] + RowNumPointsLanes[1] + RowNumPointsLanes[2] + RowNumPointsLanes[3] );
+		float RowMinimumHeight = FMath::Min( FMath::Min( RowMinHeightLanes[0], RowMinHeightLanes[1] ), FMath::Min( RowMinHeightLanes[2], RowMinHeightLanes[3] ) );
+		float RowMaximumHeight = FMath::Max( FMath::Max( RowMaxHeightLanes[0], RowMaxHeightLanes[1] ), FMath::Max( RowMaxHeightLanes[2], RowMaxHeightLanes[3] ) );
+		float RowTailSteepness = 0.0f;
+		float RowTailPositionX = 0.0f;
+		float RowTailHeight = 0.0f;
+
+		// Process the remainder of the row that does not fit into the vector width
+		for ( ; ChunkDataX < EndX; ChunkDataX++ )
+		{
+			const float PointWeight = RowBrushWeights[ ChunkDataX - GridStartXY.X ];
+			if ( PointWeight == 0.0f || PointWeight < MinWeight )
 			{
-				ResultMetrics.MaximumSteepness = PointSteepness;
+				continue;
 			}
+			const float PointHeight = RowHeights[ ChunkDataX ];
+
+			RowPointCount++;
+			RowTailPositionX += ChunkDataX;
+			RowTailHeight += PointHeight;
+			RowTailSteepness = FMath::Max( RowTailSteepness, RowSteepness[ ChunkDataX ] );
+			RowMinimumHeight = FMath::Min( RowMinimumHeight, PointHeight );
+			RowMaximumHeight = FMath::Max( RowMaximumHeight, PointHeight );
 
-			// Calculate average weight map layers if we have been asked to
-			if ( SurfaceWeightMap && bIncludeWeights )
+			if ( WeightMapPtr )
 			{
-				const FChunkLandscapeWeight Weight = SurfaceWeightMap->GetElementAt<FChunkLandscapeWeight>( ChunkDataX, ChunkDataY );
-				for ( int32 LayerIndex = 0; LayerIndex < NumLayers; LayerIndex++ )
-				{
-					AverageWeightMapLayerWeights[ LayerIndex ] += Weight.LayerWeights[ LayerIndex ];
-				}
+				AccumulatePointWeights( ChunkDataX, ChunkDataY );
 			}
 		}
+
+		if ( RowPointCount == 0 )
+		{
+			continue;
+		}
+		PositionXAccumulator = VectorAdd( PositionXAccumulator, MakeVectorRegisterFloat( RowTailPositionX, 0.0f, 0.0f, 0.0f ) );
+		HeightAccumulator = VectorAdd( HeightAccumulator, MakeVectorRegisterFloat( RowTailHeight, 0.0f, 0.0f, 0.0f ) );
+		MaxSteepnessAccumulator = VectorMax( MaxSteepnessAccumulator, VectorSetFloat1( RowTailSteepness ) );
+
+		ResultMetrics.NumberOfPoints += RowPointCount;
+		SumPositionY += static_cast<double>( RowPointCount ) * ChunkDataY;
+
+		// Only remember the row with the extreme height, the exact point within the row is resolved once at the end
+		if ( RowMinimumHeight < MinimumHeight )
+		{
+			MinimumHeight = RowMinimumHeight;
+			MinimumHeightRow = ChunkDataY;
+		}
+		if ( RowMaximumHeight > MaximumHeight )
+		{
+			MaximumHeight = RowMaximumHeight;
+			MaximumHeightRow = ChunkDataY;
+		}
 	}
 
-	// Divide average values by the number of points sampled
-	if ( ResultMetrics.NumberOfPoints > 0 )
+	if ( ResultMetrics.NumberOfPoints == 0 )
 	{
-		ResultMetrics.MiddleHeightPoint /= ResultMetrics.NumberOfPoints;
-		ResultMetrics.MaximumSteepnessAbsolute = WorldGeneratorDefinition->MaxLandscapeSteepness * ResultMetrics.MaximumSteepness;
+		return ResultMetrics;
+	}
+
+	float PositionXLanes[4];
+	float HeightLanes[4];
+	float MaxSteepnessLanes[4];
+	VectorStore( PositionXAccumulator, PositionXLanes );
+	VectorStore( HeightAccumulator, HeightLanes );
+	VectorStore( MaxSteepnessAccumulator, MaxSteepnessLanes );
+
+	const double SumPositionX = static_cast<double>( PositionXLanes[0] ) + PositionXLanes[1] + PositionXLanes[2] + PositionXLanes[3];
+	const double SumHeight = static_cast<double>( HeightLanes[0] ) + HeightLanes[1] + HeightLanes[2] + HeightLanes[3];
+	ResultMetrics.MaximumSteepness = FMath::Max( FMath::Max( MaxSteepnessLanes[0], MaxSteepnessLanes[1] ), FMath::Max( MaxSteepnessLanes[2], MaxSteepnessLanes[3] ) );
+	ResultMetrics.MaximumSteepnessAbsolute = WorldGeneratorDefinition->MaxLandscapeSteepness * ResultMetrics.MaximumSteepness;
+
+	// Middle point is calculated in the grid space, and converted to the chunk local space by the same linear mapping the heightmap uses
+	const float GridCellSize = FChunkCoord::ChunkSizeWorldUnits / ( ChunkDataSize - 1.0f );
+	constexpr float GridOriginOffset = FChunkCoord::ChunkSizeWorldUnits / 2.0f;
+	const FVector MiddlePointLocal(
+		SumPositionX / ResultMetrics.NumberOfPoints * GridCellSize - GridOriginOffset,
+		SumPositionY / ResultMetrics.NumberOfPoints * GridCellSize - GridOriginOffset,
+		SumHeight / ResultMetrics.NumberOfPoints );
+
+	const FTransform ChunkTransform = GetActorTransform();
+	ResultMetrics.MiddleHeightPoint = ChunkTransform.TransformPosition( MiddlePointLocal );
 
-		// Average out the weights
-		if ( SurfaceWeightMap && bIncludeWeights )
+	// Find the exact points with the extreme heights in the rows we have recorded
+	const auto FindPointInRow = [&]( int32 ChunkDataY, float PointHeight )
+	{
+		const float* RowBrushWeights = BrushWeightsPtr + GridSizeXY.X * ( ChunkDataY - GridStartXY.Y );
+		const float* RowHeights = HeightMapPtr + ChunkDataSize * ChunkDataY;
+
+		for ( int32 ChunkDataX = StartX; ChunkDataX < EndX; ChunkDataX++ )
 		{
-			int32 TotalLayerWeights = 0;
-			for ( int32 LayerIndex = 0; LayerIndex < NumLayers; LayerIndex++ )
+			const float PointWeight = RowBrushWeights[ ChunkDataX - GridStartXY.X ];
+			if ( PointWeight != 0.0f && PointWeight >= MinWeight && RowHeights[ ChunkDataX ] == PointHeight )
 			{
-				AverageWeightMapLayerWeights[ LayerIndex ] /= ResultMetrics.NumberOfPoints;
-				TotalLayerWeights += AverageWeightMapLayerWeights[ LayerIndex ];
+				return ChunkTransform.TransformPosition( HeightMapData.PointToChunkLocalPosition( ChunkDataX, ChunkDataY, PointHeight ) );
 			}
+		}
+		checkNoEntry();
+		return FVector::ZeroVector;
+	};
+	ResultMetrics.MinimumHeightPoint = FindPointInRow( MinimumHeightRow, MinimumHeight );
+	ResultMetrics.MaximumHeightPoint = FindPointInRow( MaximumHeightRow, MaximumHeight );
+
+	// Average out the weights. Only the relative weight of the layers matters, so there is no need to divide by the number of points
+	if ( WeightMapPtr )
+	{
+		uint64 TotalLayerWeights = 0;
+		for ( int32 LayerIndex = 0; LayerIndex < NumLayers; LayerIndex++ )
+		{
+			TotalLayerWeights += TotalWeightMapLayerWeights[ LayerIndex ];
+		}
+		if ( TotalLayerWeights > 0 )
+		{
 			for ( int32 LayerIndex = 0; LayerIndex < NumLayers; LayerIndex++ )
 			{
-				const float RelativeWeight = AverageWeightMapLayerWeights[ LayerIndex ] * 1.0f / TotalLayerWeights;
-				ResultMetrics.AverageWeights.Add( WeightMapDescriptor.GetLayerDescriptor( LayerIndex ), RelativeWeight );
+				if ( TotalWeightMapLayerWeights[ LayerIndex ] != 0 )
+				{
+					const float RelativeWeight = TotalWeightMapLayerWeights[ LayerIndex ] * 1.0 / TotalLayerWeights;
+					ResultMetrics.AverageWeights.Add( WeightMapDescriptor.GetLayerDescriptor( LayerIndex ), RelativeWeight );
+				}
 			}
 		}
 	}
-	else
-	{
-		ResultMetrics.MinimumHeightPoint = FVector::ZeroVector;
-		ResultMetrics.MaximumHeightPoint = FVector::ZeroVector;
-	}
 	return ResultMetrics;
 }
 
-void AOWGChunk::ModifyLandscapeHeightsInternal( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, float NewLandscapeHeight, float MinWeight )
+bool AOWGChunk::ModifyLandscapeHeightsInternal( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, float NewLandscapeHeight, float MinWeight, FBox2f& InOutDirtyBounds )
 {
 	FChunkData2D& HeightMapData = ChunkData2D.FindChecked( ChunkDataID::SurfaceHeightmap );
 
@@ -682,53 +1190,41 @@ void AOWGChunk::ModifyLandscapeHeightsInternal( const FVector& WorldLocation, co
 	FIntVector2 GridSizeXY;
 	TArray<float> BrushPointWeights;
 	FBox2f BrushBounds;
-	Brush->RenderBrushToSizedGrid( FVector2f( ChunkLocalOrigin.X, ChunkLocalOrigin.Y ), GridOriginOffset, GridCellSize, GridStartXY, GridSizeXY, BrushPointWeights, &BrushBounds );
+	Brush.RenderBrushToSizedGrid( FVector2f( ChunkLocalOrigin.X, ChunkLocalOrigin.Y ), GridOriginOffset, GridCellSize, GridStartXY, GridSizeXY, BrushPointWeights, &BrushBounds );
 
 	int32 PointsModified = 0;
 
-	// Modify the landscape at each given point.
-	for ( int32 ChunkDataX = FMath::Max( GridStartXY.X, 0 ); ChunkDataX < FMath::Min( GridStartXY.X + GridSizeXY.X, ChunkDataSize ); ChunkDataX++ )
+	// Modify the landscape at each given point. Go row by row, since both the height map and the brush weights are laid out row by row in memory
+	const TChunkData2DView<float> HeightMapView( HeightMapData );
+	HeightMapView.ForEachRowInRect( GridStartXY.X, GridStartXY.Y, GridStartXY.X + GridSizeXY.X - 1, GridStartXY.Y + GridSizeXY.Y - 1, [&]( int32 ChunkDataY, int32 StartX, TArrayView<float> RowHeights )
 	{
-		for ( int32 ChunkDataY = FMath::Max( GridStartXY.Y, 0 ); ChunkDataY < FMath::Min( GridStartXY.Y + GridSizeXY.Y, ChunkDataSize ); ChunkDataY++ )
-		{
-			const int32 BrushX = ChunkDataX - GridStartXY.X;
-			const int32 BrushY = ChunkDataY - GridStartXY.Y;
+		const float* RowBrushWeights = &BrushPointWeights[ GridSizeXY.X * ( ChunkDataY - GridStartXY.Y ) + ( StartX - GridStartXY.X ) ];
 
- 			// Filter out positions that are below the minimum weight
-			const float PointWeight = BrushPointWeights[ GridSizeXY.X * BrushY + BrushX ];
+		for ( int32 SpanIndex = 0; SpanIndex < RowHeights.Num(); SpanIndex++ )
+		{
+			// Filter out positions that are below the minimum weight
+			const float PointWeight = RowBrushWeights[ SpanIndex ];
 			if ( PointWeight == 0.0f || PointWeight < MinWeight )
 			{
 				continue;
 			}
 
 			// Update the height map value at the position!
-			const float CurrentHeight = HeightMapData.GetElementAt<float>( ChunkDataX, ChunkDataY );
-			const float NewPointHeight = FMath::InterpSinInOut( CurrentHeight, NewLandscapeHeight, PointWeight );
-			HeightMapData.SetElementAt<float>( ChunkDataX, ChunkDataY, NewPointHeight );
+			RowHeights[ SpanIndex ] = FMath::InterpSinInOut( RowHeights[ SpanIndex ], NewLandscapeHeight, PointWeight );
 			PointsModified++;
 		}
-	}
+	} );
 
-	// Perform partial update of the layers and weights at the given location
+	// Surface data for the modified area will be recalculated when the modification is committed
 	if ( PointsModified > 0 )
 	{
-		PartialRecalculateSurfaceData( BrushBounds );
-
-		if ( CVarChunkVisualizeLandscapeEditBounds.GetValueOnGameThread() )
-		{
-			// Debug drawing of update area
-			const FVector2f LocalCenter = BrushBounds.GetCenter();
-			const FChunkLandscapePoint ChunkLandscapePoint = GetLandscapePoint( WorldLocation );
-		
-			const FVector BoxExtents = FVector( BrushBounds.GetExtent().X, BrushBounds.GetExtent().Y, 300.0f );
-			const FVector BoxCenter = GetActorLocation() + FVector( LocalCenter.X, LocalCenter.Y, ChunkLandscapePoint.Transform.GetLocation().Z );
-
-			DrawDebugSolidBox( GetWorld(), BoxCenter, BoxExtents, FColor::Blue, false, 30.0f );			
-		}
+		InOutDirtyBounds += BrushBounds;
+		return true;
 	}
+	return false;
 }
 
-void AOWGChunk::ModifyLandscapeWeightsInternal( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, const FChunkLandscapeWeight& NewLandscapeWeight, float MinWeight )
+bool AOWGChunk::ModifyLandscapeWeightsInternal( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, const FChunkLandscapeWeight& NewLandscapeWeight, float MinWeight, FBox2f& InOutDirtyBounds )
 {
 	FChunkData2D& WeightMapData = ChunkData2D.FindChecked( ChunkDataID::SurfaceWeights );
 
@@ -743,43 +1239,49 @@ void AOWGChunk::ModifyLandscapeWeightsInternal( const FVector& WorldLocation, co
 	FIntVector2 GridSizeXY;
 	TArray<float> BrushPointWeights;
 	FBox2f BrushBounds;
-	Brush->RenderBrushToSizedGrid( FVector2f( ChunkLocalOrigin.X, ChunkLocalOrigin.Y ), GridOriginOffset, GridCellSize, GridStartXY, GridSizeXY, BrushPointWeights, &BrushBounds );
+	Brush.RenderBrushToSizedGrid( FVector2f( ChunkLocalOrigin.X, ChunkLocalOrigin.Y ), GridOriginOffset, GridCellSize, GridStartXY, GridSizeXY, BrushPointWeights, &BrushBounds );
 
 	int32 PointsModified = 0;
 
-	// Modify the landscape at each given point.
-	for ( int32 ChunkDataX = FMath::Max( GridStartXY.X, 0 ); ChunkDataX < FMath::Min( GridStartXY.X + GridSizeXY.X, ChunkDataSize ); ChunkDataX++ )
+	// Modify the landscape at each given point. Go row by row, since both the weight map and the brush weights are laid out row by row in memory
+	const TChunkData2DView<FChunkLandscapeWeight> WeightMapView( WeightMapData );
+	WeightMapView.ForEachRowInRect( GridStartXY.X, GridStartXY.Y, GridStartXY.X + GridSizeXY.X - 1, GridStartXY.Y + GridSizeXY.Y - 1, [&]( int32 ChunkDataY, int32 StartX, TArrayView<FChunkLandscapeWeight> RowWeights )
 	{
-		for ( int32 ChunkDataY = FMath::Max( GridStartXY.Y, 0 ); ChunkDataY < FMath::Min( GridStartXY.Y + GridSizeXY.Y, ChunkDataSize ); ChunkDataY++ )
-		{
-			const int32 BrushX = ChunkDataX - GridStartXY.X;
-			const int32 BrushY = ChunkDataY - GridStartXY.Y;
+		const float* RowBrushWeights = &BrushPointWeights[ GridSizeXY.X * ( ChunkDataY - GridStartXY.Y ) + ( StartX - GridStartXY.X ) ];
 
+		for ( int32 SpanIndex = 0; SpanIndex < RowWeights.Num(); SpanIndex++ )
+		{
 			// Filter out positions that are below the minimum weight
-			const float PointWeight = BrushPointWeights[ GridSizeXY.X * BrushY + BrushX ];
+			const float PointWeight = RowBrushWeights[ SpanIndex ];
 			if ( PointWeight == 0.0f || PointWeight < MinWeight )
 			{
 				continue;
 			}
 
 			// Update the weight map value at the position!
-			const FChunkLandscapeWeight CurrentWeight = WeightMapData.GetElementAt<FChunkLandscapeWeight>( ChunkDataX, ChunkDataY );
-			const FChunkLandscapeWeight NewPointHeight = FMath::Lerp( CurrentWeight, NewLandscapeWeight, PointWeight );
-			WeightMapData.SetElementAt<FChunkLandscapeWeight>( ChunkDataX, ChunkDataY, NewPointHeight );
+			RowWeights[ SpanIndex ] = FMath::Lerp( RowWeights[ SpanIndex ], NewLandscapeWeight, PointWeight );
 			PointsModified++;
 		}
-	}
+	} );
 
-	// Perform partial update of the layers and weights at the given location
+	// Weight map textures for the modified area will be updated when the modification is committed
 	if ( PointsModified > 0 )
 	{
-		PartialUpdateWeightMap( BrushBounds );
+		InOutDirtyBounds += BrushBounds;
+		return true;
 	}
+	return false;
 }
 
 void AOWGChunk::ModifyLandscape( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, const FChunkLandscapeModification& LandscapeModification, float MinWeight )
 {
-	check( false );
+	FChunkLandscapeDirtyRegion DirtyRegion;
+	ApplyLandscapeModification( WorldLocation, Brush, LandscapeModification, MinWeight, DirtyRegion );
+	CommitLandscapeModifications( DirtyRegion );
+}
+
+void AOWGChunk::ApplyLandscapeModification( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, const FChunkLandscapeModification& LandscapeModification, float MinWeight, FChunkLandscapeDirtyRegion& InOutDirtyRegion )
+{
 	SCOPE_CYCLE_COUNTER( STAT_ChunkModifyLandscape );
 
 	// Landscape modifications that do not overlap with the chunk bounding box are pointless
@@ -800,7 +1302,7 @@ void AOWGChunk::ModifyLandscape( const FVector& WorldLocation, const FPolymorphi
 	// Modify heights if we are asked to do so
 	if ( LandscapeModification.bModifyHeight && ChunkData2D.Contains( ChunkDataID::SurfaceHeightmap ) )
 	{
-		ModifyLandscapeHeightsInternal( WorldLocation, Brush, LandscapeModification.NewHeight, MinWeight );
+		ModifyLandscapeHeightsInternal( WorldLocation, Brush, LandscapeModification.NewHeight, MinWeight, InOutDirtyRegion.HeightMapBounds );
 	}
 
 	// Modify weight map if we have weights
@@ -813,11 +1315,188 @@ void AOWGChunk::ModifyLandscape( const FVector& WorldLocation, const FPolymorphi
 			const int32 LayerIndex = WeightMapDescriptor.FindOrCreateLayer( LayerWeightPair.Key );
 			if ( LayerIndex != INDEX_NONE )
 			{
-				NewLandscapeWeight.LayerWeights[ LayerIndex ] = (uint8) FMath::Clamp( FMath::RoundToInt32( LayerWeightPair.Value * 255.0f ), 0, 255 );
+				NewLandscapeWeight.SetAbsoluteWeight( LayerIndex, (uint8) FMath::Clamp( FMath::RoundToInt32( LayerWeightPair.Value * 255.0f ), 0, 255 ) );
+			}
+		}
+		ModifyLandscapeWeightsInternal( WorldLocation, Brush, NewLandscapeWeight, MinWeight, InOutDirtyRegion.WeightMapBounds );
+	}
+}
+
+void AOWGChunk::CommitLandscapeModifications( const FChunkLandscapeDirtyRegion& DirtyRegion )
+{
+	SCOPE_CYCLE_COUNTER( STAT_ChunkCommitLandscapeModifications );
+
+	// Perform a single partial update of the surface data over the union of all modified areas
+	if ( DirtyRegion.HeightMapBounds.bIsValid )
+	{
+		PartialRecalculateSurfaceData( DirtyRegion.HeightMapBounds );
+
+		if ( CVarChunkVisualizeLandscapeEditBounds.GetValueOnGameThread() )
+		{
+			// Debug drawing of update area
+			const FVector2f LocalCenter = DirtyRegion.HeightMapBounds.GetCenter();
+			const FVector BoxCenterNoHeight = GetActorLocation() + FVector( LocalCenter.X, LocalCenter.Y, 0.0f );
+			const FChunkLandscapePoint ChunkLandscapePoint = GetLandscapePoint( BoxCenterNoHeight );
+		
+			const FVector BoxExtents = FVector( DirtyRegion.HeightMapBounds.GetExtent().X, DirtyRegion.HeightMapBounds.GetExtent().Y, 300.0f );
+			const FVector BoxCenter = BoxCenterNoHeight + FVector( 0.0f, 0.0f, ChunkLandscapePoint.Transform.GetLocation().Z );
+
+			DrawDebugSolidBox( GetWorld(), BoxCenter, BoxExtents, FColor::Blue, false, 30.0f );			
+		}
+	}
+	if ( DirtyRegion.WeightMapBounds.bIsValid )
+	{
+		PartialUpdateWeightMap( DirtyRegion.WeightMapBounds );
+	}
+
+	// Track the modified area so that it can be replicated to the clients that already have the previous version of the data.
+	// Chunks generated locally on the client have authority over themselves too, but their changelists are dictated by the server
+	if ( GetNetMode() != NM_Client && !DirtyRegion.IsEmpty() )
+	{
+		ReplicatedDataChangelist++;
+		ReplicatedDataModifications.Add( FChunkReplicatedDataModification{ ReplicatedDataChangelist, DirtyRegion } );
+
+		// Clients that are behind the oldest tracked modification will receive the full snapshot of the data
+		const int32 NumModificationsToDrop = ReplicatedDataModifications.Num() - FMath::Max( CVarMaxTrackedReplicatedDataModifications.GetValueOnGameThread(), 1 );
+		if ( NumModificationsToDrop > 0 )
+		{
+			ReplicatedDataSnapshotChangelist = ReplicatedDataModifications[ NumModificationsToDrop - 1 ].Changelist;
+			ReplicatedDataSnapshotHash = 0;
+			ReplicatedDataModifications.RemoveAt( 0, NumModificationsToDrop );
+		}
+	}
+}
+
+bool AOWGChunk::WriteReplicatedChunkData( FArchive& Ar, int32 BaseChangelist )
+{
+	check( Ar.IsSaving() );
+
+	FChunkData2D* HeightMapData = ChunkData2D.Find( ChunkDataID::SurfaceHeightmap );
+	FChunkData2D* WeightMapData = ChunkData2D.Find( ChunkDataID::SurfaceWeights );
+	FChunkData2D* BiomeMapData = ChunkData2D.Find( ChunkDataID::BiomeMap );
+	if ( HeightMapData == nullptr || WeightMapData == nullptr || BiomeMapData == nullptr )
+	{
+		return false;
+	}
+
+	// We can only write the delta if all of the modifications since the base changelist are still tracked
+	bool bFullSnapshot = BaseChangelist == INDEX_NONE || BaseChangelist < ReplicatedDataSnapshotChangelist || BaseChangelist > ReplicatedDataChangelist;
+	Ar << bFullSnapshot;
+	Ar << BaseChangelist;
+	Ar << ReplicatedDataChangelist;
+
+	// Weight map descriptor is tiny and can gain new layers with any weight map modification, so it is always written
+	Ar << WeightMapDescriptor;
+
+	if ( bFullSnapshot )
+	{
+		Ar << BiomePalette;
+		Ar << *HeightMapData;
+		Ar << *WeightMapData;
+		Ar << *BiomeMapData;
+	}
+	else
+	{
+		FChunkLandscapeDirtyRegion DirtyRegion;
+		for ( const FChunkReplicatedDataModification& Modification : ReplicatedDataModifications )
+		{
+			if ( Modification.Changelist > BaseChangelist )
+			{
+				DirtyRegion += Modification.DirtyRegion;
 			}
 		}
-		ModifyLandscapeWeightsInternal( WorldLocation, Brush, NewLandscapeWeight, MinWeight );
+		Ar << DirtyRegion.HeightMapBounds;
+		Ar << DirtyRegion.WeightMapBounds;
+
+		ChunkDataReplicationInternal::SerializeGridRegion( Ar, *HeightMapData, DirtyRegion.HeightMapBounds );
+		ChunkDataReplicationInternal::SerializeGridRegion( Ar, *WeightMapData, DirtyRegion.WeightMapBounds );
+	}
+	return true;
+}
+
+bool AOWGChunk::ApplyReplicatedChunkData( FArchive& Ar )
+{
+	check( Ar.IsLoading() );
+
+	bool bFullSnapshot = false;
+	int32 BaseChangelist = INDEX_NONE;
+	int32 NewChangelist = INDEX_NONE;
+	Ar << bFullSnapshot;
+	Ar << BaseChangelist;
+	Ar << NewChangelist;
+
+	// Deltas can only be applied on top of the data they have been written against
+	if ( !bFullSnapshot && ( BaseChangelist != ReplicatedDataChangelist || !IsChunkInitialized() ) )
+	{
+		return false;
+	}
+	Ar << WeightMapDescriptor;
+
+	FChunkLandscapeDirtyRegion DirtyRegion;
+	if ( bFullSnapshot )
+	{
+		Ar << BiomePalette;
+		Ar << ChunkData2D.FindOrAdd( ChunkDataID::SurfaceHeightmap );
+		Ar << ChunkData2D.FindOrAdd( ChunkDataID::SurfaceWeights );
+		Ar << ChunkData2D.FindOrAdd( ChunkDataID::BiomeMap );
+		CachedBiomeData.Reset();
+
+		const FVector2f ChunkExtents( FChunkCoord::ChunkSizeWorldUnits / 2.0f );
+		DirtyRegion.HeightMapBounds = FBox2f( -ChunkExtents, ChunkExtents );
+		DirtyRegion.WeightMapBounds = FBox2f( -ChunkExtents, ChunkExtents );
+		ReplicatedDataSnapshotChangelist = NewChangelist;
+		ReplicatedDataSnapshotHash = 0;
+	}
+	else
+	{
+		Ar << DirtyRegion.HeightMapBounds;
+		Ar << DirtyRegion.WeightMapBounds;
+
+		ChunkDataReplicationInternal::SerializeGridRegion( Ar, ChunkData2D.FindChecked( ChunkDataID::SurfaceHeightmap ), DirtyRegion.HeightMapBounds );
+		ChunkDataReplicationInternal::SerializeGridRegion( Ar, ChunkData2D.FindChecked( ChunkDataID::SurfaceWeights ), DirtyRegion.WeightMapBounds );
+	}
+	ReplicatedDataChangelist = NewChangelist;
+
+	// Recalculate the derived data the same way the server does after the modification
+	CommitLandscapeModifications( DirtyRegion );
+	return true;
+}
+
+void AOWGChunk::InvalidateReplicatedChunkData()
+{
+	// Data has been replaced entirely, so the clients that have the previous version of it need the full snapshot
+	ReplicatedDataChangelist++;
+	ReplicatedDataSnapshotChangelist = ReplicatedDataChangelist;
+	ReplicatedDataModifications.Empty();
+
+	// Biome palette is initialized before the landscape, so the hash is only known once both of them are
+	ReplicatedDataSnapshotHash = IsChunkInitialized() ? ComputeReplicatedDataHash() : 0;
+}
+
+void AOWGChunk::AdoptVerifiedReplicatedDataSnapshot( int32 SnapshotChangelist )
+{
+	check( IsChunkInitialized() );
+	ReplicatedDataChangelist = SnapshotChangelist;
+	ReplicatedDataSnapshotChangelist = SnapshotChangelist;
+	ReplicatedDataModifications.Empty();
+}
+
+uint64 AOWGChunk::ComputeReplicatedDataHash() const
+{
+	uint64 DataHash = 0;
+	for ( const FName ChunkDataID : { ChunkDataID::SurfaceHeightmap, ChunkDataID::SurfaceWeights, ChunkDataID::BiomeMap } )
+	{
+		if ( const FChunkData2D* GridData = ChunkData2D.Find( ChunkDataID ) )
+		{
+			const uint64 GridHash = GridData->ComputeDataHash();
+			DataHash = CityHash64WithSeed( reinterpret_cast<const char*>( &GridHash ), sizeof(GridHash), DataHash );
+		}
 	}
+	DataHash = ChunkDataReplicationInternal::HashObjectPaths( BiomePalette.GetAllBiomes(), DataHash );
+	DataHash = ChunkDataReplicationInternal::HashObjectPaths( WeightMapDescriptor.GetAllLayers(), DataHash );
+
+	// 0 is reserved for the unknown hash
+	return DataHash != 0 ? DataHash : 1;
 }
 
 TArray<UOWGChunkLandscapeLayer*> AOWGChunk::GetLandscapeLayers() const
@@ -876,6 +1555,7 @@ const FChunkData2D* AOWGChunk::FindRawChunkData( FName ChunkDataID ) const
 void AOWGChunk::GenerateNoiseForChunk()
 {
 	SCOPE_CYCLE_COUNTER( STAT_GenerateNoiseForChunk );
+	OWG_TRACE_CHUNK_SCOPE( GenerateNoiseForChunk, ChunkCoord );
 
 	// Generate noise for each identifier
 	for ( const TPair<UOWGNoiseIdentifier*, UOWGNoiseGenerator*>& Pair : WorldGeneratorDefinition->NoiseGenerators )
@@ -883,7 +1563,7 @@ void AOWGChunk::GenerateNoiseForChunk()
 		if ( Pair.Key && Pair.Value && !NoiseData.Contains( Pair.Key ) )
 		{
 			// Allocate space for one additional row/column so we can seamlessly interpolate noise from adjacent chunks
-			FChunkData2D NewNoiseData = FChunkData2D::Create<float>( WorldGeneratorDefinition->NoiseResolutionXY, true );
+			FChunkData2D NewNoiseData = FChunkData2D::CreateUninitialized<float>( WorldGeneratorDefinition->NoiseResolutionXY, true );
 			Pair.Value->GenerateNoise( WorldSeed, ChunkCoord, NewNoiseData.GetSurfaceResolutionXY(), NewNoiseData.GetMutableDataPtr<float>() );
 
 			NoiseData.Emplace( Pair.Key, MoveTemp( NewNoiseData ) );
@@ -894,6 +1574,7 @@ void AOWGChunk::GenerateNoiseForChunk()
 bool AOWGChunk::ProcessChunkGeneration()
 {
 	SCOPE_CYCLE_COUNTER( STAT_ProcessChunkGeneration );
+	OWG_TRACE_CHUNK_SCOPE( ProcessChunkGeneration, ChunkCoord );
 
 	// Generate each stage from the current one until we reach the start of the target stage
 	while ( CurrentGenerationStage <= TargetGenerationStage )
@@ -915,10 +1596,12 @@ bool AOWGChunk::ProcessChunkGeneration()
 				}
 				check( GeneratorType );
 
-				CurrentGeneratorInstance = NewObject<UOWGChunkGenerator>( this, GeneratorType );
+				CurrentGeneratorInstance = UOpenWorldGeneratorSubsystem::Get( GetWorld() )->AcquireChunkGenerator( this, GeneratorType );
 				check( CurrentGeneratorInstance );
 				CurrentGeneratorInstance->TargetBiomes = CurrentStageChunkGenerators.GeneratorInstigatorBiomes.FindOrAdd( GeneratorType );
 			}
+			OWG_TRACE_CHUNK_SCOPE_TEXT( ChunkGenerationInternal::GetGenerationStageTraceName( CurrentGenerationStage ), ChunkCoord );
+
 			// Abort the execution if the current generator is waiting for some condition
 			if ( !CurrentGeneratorInstance->AdvanceChunkGeneration() )
 			{
@@ -928,9 +1611,8 @@ bool AOWGChunk::ProcessChunkGeneration()
 			// The generator returned false, that means it's done and we can advance to the next one
 			CurrentGeneratorInstance->EndChunkGeneration();
 
-			// Destroy the generator so that the save system does not try to save it
-			CurrentGeneratorInstance->SetFlags( RF_Transient );
-			CurrentGeneratorInstance->MarkAsGarbage();
+			// Return the generator to the pool so it can be reused by other chunks. This also makes sure that the save system does not try to save it
+			UOpenWorldGeneratorSubsystem::Get( GetWorld() )->ReleaseChunkGenerator( CurrentGeneratorInstance );
 			CurrentGeneratorInstance = nullptr;
 
 			// Advance the index
@@ -1018,6 +1700,81 @@ void AOWGChunk::DrawDebugHUD( AHUD* HUD, UCanvas* Canvas, const FDebugDisplayInf
 
 		DisplayDebugManager.DrawString( FString::Printf( TEXT("Biome: %s"), *GetNameSafe( Biome ) ) );
 	}
+
+	const FChunkMemoryUsage MemoryUsage = GetMemoryUsage();
+	TArray<FString> MemoryUsageEntries;
+	for ( int32 CategoryIndex = 0; CategoryIndex < FChunkMemoryUsage::NumCategories; CategoryIndex++ )
+	{
+		const EChunkMemoryCategory Category = (EChunkMemoryCategory) CategoryIndex;
+		MemoryUsageEntries.Add( FString::Printf( TEXT("%s: %.2fKB"), *FChunkMemoryUsage::GetCategoryName( Category ), MemoryUsage.Get( Category ) / 1024.0f ) );
+	}
+	DisplayDebugManager.DrawString( FString::Printf( TEXT("Memory: %.2fMB (%s)"), MemoryUsage.GetTotal() / ( 1024.0f * 1024.0f ), *FString::Join( MemoryUsageEntries, TEXT("; ") ) ) );
+}
+
+void AOWGChunk::CaptureGenerationSnapshot( FChunkGenerationSnapshot& OutSnapshot ) const
+{
+	OutSnapshot.ChunkCoord = ChunkCoord;
+	OutSnapshot.Grids.Empty( ChunkData2D.Num() + NoiseData.Num() );
+
+	for ( const TPair<FName, FChunkData2D>& Pair : ChunkData2D )
+	{
+		OutSnapshot.Grids.Add( Pair.Key, Pair.Value );
+	}
+	for ( const TPair<UOWGNoiseIdentifier*, FChunkData2D>& Pair : NoiseData )
+	{
+		OutSnapshot.Grids.Add( Pair.Key->GetFName(), Pair.Value );
+	}
+
+	// Palettes and layers are recorded by the asset paths, since the object pointers are different between the runs
+	OutSnapshot.BiomePalette.Reset();
+	for ( const UOWGBiome* Biome : BiomePalette.GetAllBiomes() )
+	{
+		OutSnapshot.BiomePalette.Add( GetPathNameSafe( Biome ) );
+	}
+	OutSnapshot.WeightMapLayers.Reset();
+	for ( const UOWGChunkLandscapeLayer* LandscapeLayer : WeightMapDescriptor.GetAllLayers() )
+	{
+		OutSnapshot.WeightMapLayers.Add( GetPathNameSafe( LandscapeLayer ) );
+	}
+}
+
+FChunkMemoryUsage AOWGChunk::GetMemoryUsage() const
+{
+	FChunkMemoryUsage MemoryUsage;
+
+	for ( const TPair<FName, FChunkData2D>& Pair : ChunkData2D )
+	{
+		MemoryUsage.Add( EChunkMemoryCategory::ChunkData, Pair.Value.GetAllocatedSize() );
+	}
+	MemoryUsage.Add( EChunkMemoryCategory::ChunkData, HeightPyramid.GetAllocatedSize() );
+
+	for ( const TPair<UOWGNoiseIdentifier*, FChunkData2D>& Pair : NoiseData )
+	{
+		MemoryUsage.Add( EChunkMemoryCategory::NoiseData, Pair.Value.GetAllocatedSize() );
+	}
+
+	if ( LandscapeMeshManager )
+	{
+		MemoryUsage.Add( EChunkMemoryCategory::LandscapeMesh, LandscapeMeshManager->GetAllocatedSize() );
+	}
+	if ( LandscapeMeshComponent && LandscapeMeshComponent->GetMesh() )
+	{
+		// The mesh for the currently active LOD is moved into the mesh component, so it is not accounted for by the mesh manager
+		MemoryUsage.Add( EChunkMemoryCategory::LandscapeMesh, LandscapeMeshComponent->GetMesh()->GetByteCount() );
+	}
+	if ( LandscapeMaterialManager )
+	{
+		MemoryUsage.Add( EChunkMemoryCategory::WeightMapTextures, LandscapeMaterialManager->GetWeightMapTextureMemory() );
+	}
+	if ( const UChunkLandscapeGrassSubsystem* GrassSubsystem = GetWorld() ? GetWorld()->GetSubsystem<UChunkLandscapeGrassSubsystem>() : nullptr )
+	{
+		MemoryUsage.Add( EChunkMemoryCategory::Grass, GrassSubsystem->GetChunkGrassAllocatedSize( ChunkCoord ) );
+	}
+	if ( HeightFieldCollisionComponent )
+	{
+		MemoryUsage.Add( EChunkMemoryCategory::Collision, HeightFieldCollisionComponent->GetCollisionAllocatedSize() );
+	}
+	return MemoryUsage;
 }
 
 void AOWGChunk::PartialRecalculateSurfaceData( const FBox2f& UpdateVolume )
@@ -1042,6 +1799,9 @@ void AOWGChunk::PartialRecalculateSurfaceData( const FBox2f& UpdateVolume )
 		// Update normals only for the chanced cells
 		PartialUpdateSurfaceNormal( StartX, StartY, EndX, EndY );
 
+		// Update height ranges of the affected cells across all levels of the height pyramid
+		HeightPyramid.PartialUpdate( ChunkData2D.FindChecked( ChunkDataID::SurfaceHeightmap ), StartX, StartY, EndX, EndY );
+
 		// Update or create height field collision for affected cells
 		HeightFieldCollisionComponent->PartialUpdateOrCreateHeightField( StartX, StartY, EndX, EndY );
 
@@ -1098,20 +1858,29 @@ void AOWGChunk::PartialUpdateSurfaceGradient( int32 StartX, int32 StartY, int32
 	// dx = f(x+1) - f(x)
 	// dy = f(y+1) - f(y)
 	// steepness = sqrt(dx^2+dy^2)
-	for ( int32 PosX = FMath::Max( StartX, 0 ); PosX < FMath::Min( EndX + 1, ResolutionXY - 1 ); PosX++ )
+	const TChunkData2DView<const float> HeightmapView( SurfaceHeightmapData );
+	const TChunkData2DView<FVector2f> GradientView( SurfaceGradientData );
+	const TChunkData2DView<float> SteepnessView( SurfaceSteepnessData );
+
+	SteepnessView.ForEachRowInRect( StartX, StartY, FMath::Min( EndX, ResolutionXY - 2 ), FMath::Min( EndY, ResolutionXY - 2 ), [&]( int32 PosY, int32 RowStartX, TArrayView<float> RowSteepness )
 	{
-		for ( int32 PosY = FMath::Max( StartY, 0 ); PosY < FMath::Min( EndY + 1, ResolutionXY - 1 ); PosY++ )
+		// Rows are at most ResolutionXY - 2 long, so the next row and column are always in bounds
+		const float* RowHeightsY0 = &HeightmapView( RowStartX, PosY );
+		const float* RowHeightsYP = &HeightmapView( RowStartX, PosY + 1 );
+		FVector2f* RowGradients = &GradientView( RowStartX, PosY );
+
+		for ( int32 SpanIndex = 0; SpanIndex < RowSteepness.Num(); SpanIndex++ )
 		{
-			const float X0Y0 = SurfaceHeightmapData.GetElementAt<float>( PosX, PosY );
-			const float XPY0 = SurfaceHeightmapData.GetElementAt<float>( PosX + 1, PosY );
-			const float X0YP = SurfaceHeightmapData.GetElementAt<float>( PosX, PosY + 1 );
+			const float X0Y0 = RowHeightsY0[ SpanIndex ];
+			const float XPY0 = RowHeightsY0[ SpanIndex + 1 ];
+			const float X0YP = RowHeightsYP[ SpanIndex ];
 
 			// Calculate the points now
 			const FVector2f ResultGradient( XPY0 - X0Y0, X0Y0 - X0YP );
-			SurfaceGradientData.SetElementAt( PosX, PosY, ResultGradient.GetSafeNormal() );
-			SurfaceSteepnessData.SetElementAt( PosX, PosY, FMath::Min( ResultGradient.Size() / MaxSurfaceSteepness, 1.0f ) );
+			RowGradients[ SpanIndex ] = ResultGradient.GetSafeNormal();
+			RowSteepness[ SpanIndex ] = FMath::Min( ResultGradient.Size() / MaxSurfaceSteepness, 1.0f );
 		}
-	}
+	} );
 
 	// Do backwards differencing for the cells at the X+Y+ border. We do not strife to provide accurate data for that particular corner though, as it technically belongs to another chunk.
 	// dx = f(x) - f(x-1)
@@ -1215,6 +1984,7 @@ void AOWGChunk::InitializeChunkBiomePalette( FChunkBiomePalette&& InBiomePalette
 
 	BiomePalette = InBiomePalette;
 	ChunkData2D.Emplace( ChunkDataID::BiomeMap, MoveTemp( InBiomeMap ) );
+	InvalidateReplicatedChunkData();
 }
 
 void AOWGChunk::InitializeChunkLandscape( FChunkLandscapeWeightMapDescriptor&& InWeightMapDescriptor, FChunkData2D&& InHeightMap, FChunkData2D&& InWeightMap )
@@ -1227,6 +1997,7 @@ void AOWGChunk::InitializeChunkLandscape( FChunkLandscapeWeightMapDescriptor&& I
 
 	const FVector2f ChunkExtents( FChunkCoord::ChunkSizeWorldUnits / 2.0f );
 	PartialRecalculateSurfaceData( FBox2f( -ChunkExtents, ChunkExtents ) );
+	InvalidateReplicatedChunkData();
 }
 
 TSharedRef<FCachedChunkLandscapeData> AOWGChunk::GetChunkLandscapeSourceData()
@@ -1241,6 +2012,7 @@ TSharedRef<FCachedChunkLandscapeData> AOWGChunk::GetChunkLandscapeSourceData()
 		CachedLandscapeData->SteepnessData = ChunkData2D.FindChecked( ChunkDataID::SurfaceSteepness );
 		CachedLandscapeData->WeightMapData = ChunkData2D.FindChecked( ChunkDataID::SurfaceWeights );
 		CachedLandscapeData->WeightMapDescriptor = *GetWeightMapDescriptor();
+		CachedLandscapeData->HeightPyramid = HeightPyramid;
 		CachedLandscapeData->ChangelistNumber = GrassSourceDataChangelistNumber;
 	}
 	return CachedLandscapeData.ToSharedRef();
@@ -0,0 +1,533 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "Partition/OWGChunkDataReplicationComponent.h"
+#include "EngineUtils.h"
+#include "OpenWorldGeneratorModule.h"
+#include "OpenWorldGeneratorSubsystem.h"
+#include "OWGTrace.h"
+#include "Engine/ActorChannel.h"
+#include "Engine/NetConnection.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/Compression.h"
+#include "Partition/OWGChunk.h"
+#include "Partition/OWGChunkManagerInterface.h"
+#include "Partition/OWGClientChunkManager.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+
+DECLARE_DWORD_COUNTER_STAT( TEXT("Chunk Data Bytes Sent"), STAT_ChunkDataBytesSent, STATGROUP_Game );
+DECLARE_CYCLE_STAT( TEXT("Chunk Data Replication"), STAT_ChunkDataReplication, STATGROUP_Game );
+
+static TAutoConsoleVariable CVarChunkDataReplicationBandwidth(
+	TEXT("owg.ChunkDataReplicationBandwidth"),
+	32768,
+	TEXT("Maximum number of bytes of the compressed chunk data sent to a single client per second. 0 disables the chunk data replication"),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable CVarChunkDataReplicationRadius(
+	TEXT("owg.ChunkDataReplicationRadius"),
+	76800.0f,
+	TEXT("Radius around the player view point, in world units, in which the chunk data is replicated to the client"),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable CVarVerifyClientChunkData(
+	TEXT("owg.VerifyClientChunkData"),
+	true,
+	TEXT("Whenever the server should verify the chunk data regenerated by the clients by it's hash, and only send the snapshot of the chunk data when it does not match. 1 = verify (default); 0 = always send the snapshot"),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable CVarChunkDataReplicationFragmentSize(
+	TEXT("owg.ChunkDataReplicationFragmentSize"),
+	1536,
+	TEXT("Maximum number of bytes sent in a single chunk data RPC. Must stay below net.MaxRepArraySize"),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable CVarChunkDataReplicationMaxReliableBunches(
+	TEXT("owg.ChunkDataReplicationMaxReliableBunches"),
+	64,
+	TEXT("Maximum number of unacknowledged reliable bunches on the player controller channel at which the chunk data RPCs are still sent. Clamped to half of the reliable buffer size to leave room for the other reliable RPCs"),
+	ECVF_Default
+);
+
+namespace ChunkDataReplicationInternal
+{
+	// Compression format to use for the chunk data payloads. Same as the one used by the region files
+	static const FName PayloadCompressionFormat = NAME_LZ4;
+	// Maximum amount of time worth of the bandwidth budget that can be accumulated while idle, in seconds
+	static constexpr float MaxBandwidthBurstTime = 0.25f;
+	// Interval at which the client attempts to apply the payloads of the chunks that were not available yet, in seconds
+	static constexpr float PendingPayloadsRetryInterval = 0.5f;
+	// Approximate number of bytes taken by the verification request, counted against the bandwidth budget
+	static constexpr int32 VerificationRequestSize = 24;
+}
+
+UOWGChunkDataReplicationComponent::UOWGChunkDataReplicationComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	SetIsReplicatedByDefault( true );
+}
+
+void UOWGChunkDataReplicationComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Chunks replicated before the component itself have already begun play, so pick them up once. The chunks replicated after will register themselves
+	if ( !GetOwner()->HasAuthority() )
+	{
+		for ( AOWGChunk* Chunk : TActorRange<AOWGChunk>( GetWorld() ) )
+		{
+			if ( Chunk->HasActorBegunPlay() && !Chunk->HasAuthority() )
+			{
+				ReplicatedChunks.Add( Chunk->GetChunkCoord(), Chunk );
+			}
+		}
+	}
+}
+
+void UOWGChunkDataReplicationComponent::RegisterReplicatedChunk( AOWGChunk* Chunk )
+{
+	check( Chunk );
+	for ( FConstPlayerControllerIterator It = Chunk->GetWorld()->GetPlayerControllerIterator(); It; ++It )
+	{
+		const APlayerController* PlayerController = It->Get();
+		if ( PlayerController && PlayerController->IsLocalController() )
+		{
+			if ( UOWGChunkDataReplicationComponent* ReplicationComponent = PlayerController->FindComponentByClass<UOWGChunkDataReplicationComponent>() )
+			{
+				ReplicationComponent->ReplicatedChunks.Add( Chunk->GetChunkCoord(), Chunk );
+			}
+		}
+	}
+}
+
+void UOWGChunkDataReplicationComponent::UnregisterReplicatedChunk( AOWGChunk* Chunk )
+{
+	check( Chunk );
+	for ( FConstPlayerControllerIterator It = Chunk->GetWorld()->GetPlayerControllerIterator(); It; ++It )
+	{
+		const APlayerController* PlayerController = It->Get();
+		if ( PlayerController && PlayerController->IsLocalController() )
+		{
+			UOWGChunkDataReplicationComponent* ReplicationComponent = PlayerController->FindComponentByClass<UOWGChunkDataReplicationComponent>();
+			const TWeakObjectPtr<AOWGChunk>* RegisteredChunk = ReplicationComponent ? ReplicationComponent->ReplicatedChunks.Find( Chunk->GetChunkCoord() ) : nullptr;
+
+			// Another chunk actor might have been registered at the same coordinate already
+			if ( RegisteredChunk && RegisteredChunk->Get() == Chunk )
+			{
+				ReplicationComponent->ReplicatedChunks.Remove( Chunk->GetChunkCoord() );
+			}
+		}
+	}
+}
+
+void UOWGChunkDataReplicationComponent::TickComponent( float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction )
+{
+	Super::TickComponent( DeltaTime, TickType, ThisTickFunction );
+
+	if ( GetOwner()->HasAuthority() )
+	{
+		TickServerReplication( DeltaTime );
+	}
+	else
+	{
+		PendingPayloadsRetryTime -= DeltaTime;
+		if ( PendingPayloadsRetryTime <= 0.0f )
+		{
+			PendingPayloadsRetryTime = ChunkDataReplicationInternal::PendingPayloadsRetryInterval;
+			TickClientPendingChunks();
+		}
+	}
+}
+
+void UOWGChunkDataReplicationComponent::TickClientPendingChunks()
+{
+	TArray<FChunkCoord> PendingChunkCoords;
+	PendingVerifications.GenerateKeyArray( PendingChunkCoords );
+	for ( const FChunkCoord& ChunkCoord : PendingChunkCoords )
+	{
+		const FPendingChunkVerification PendingVerification = PendingVerifications.FindChecked( ChunkCoord );
+		if ( VerifyClientChunkData( ChunkCoord, PendingVerification.SnapshotChangelist, PendingVerification.SnapshotHash ) )
+		{
+			PendingVerifications.Remove( ChunkCoord );
+		}
+	}
+
+	ReceivedPayloads.GenerateKeyArray( PendingChunkCoords );
+	for ( const FChunkCoord& ChunkCoord : PendingChunkCoords )
+	{
+		ApplyReceivedPayloads( ChunkCoord );
+	}
+
+	// Chunks regenerated after being unloaded on the client no longer have the data received from the server, so it needs to be sent again
+	for ( TMap<FChunkCoord, TWeakObjectPtr<AOWGChunk>>::TIterator It = SynchronizedChunks.CreateIterator(); It; ++It )
+	{
+		if ( !It.Value().IsValid() )
+		{
+			ServerRequestChunkDataSnapshot( It.Key() );
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void UOWGChunkDataReplicationComponent::TickServerReplication( float DeltaTime )
+{
+	SCOPE_CYCLE_COUNTER( STAT_ChunkDataReplication );
+	OWG_TRACE_SCOPE( UOWGChunkDataReplicationComponent::TickServerReplication );
+
+	const APlayerController* PlayerController = Cast<APlayerController>( GetOwner() );
+	const UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = UOpenWorldGeneratorSubsystem::Get( this );
+	const float Bandwidth = CVarChunkDataReplicationBandwidth.GetValueOnGameThread();
+
+	if ( PlayerController == nullptr || OpenWorldGeneratorSubsystem == nullptr || !OpenWorldGeneratorSubsystem->GetChunkManager() )
+	{
+		return;
+	}
+
+	// Clients need the world parameters to regenerate the chunks before anything else
+	if ( !bWorldParametersSent )
+	{
+		ClientReceiveWorldParameters( TSoftObjectPtr<UOWGWorldGeneratorConfiguration>( OpenWorldGeneratorSubsystem->GetWorldGeneratorDefinition() ), OpenWorldGeneratorSubsystem->GetWorldSeed() );
+		bWorldParametersSent = true;
+	}
+	if ( Bandwidth <= 0.0f )
+	{
+		return;
+	}
+	BandwidthAllowance = FMath::Min( BandwidthAllowance + DeltaTime * Bandwidth, Bandwidth * ChunkDataReplicationInternal::MaxBandwidthBurstTime );
+
+	// Finish sending the payloads that are already queued first, so that they arrive in the order they have been written in
+	SendPendingFragments();
+	if ( !PendingFragments.IsEmpty() )
+	{
+		return;
+	}
+
+	// Collect the loaded chunks in range of the player, closest first
+	FVector PlayerViewPointLocation{};
+	FRotator PlayerViewPointRotation{};
+	PlayerController->GetPlayerViewPoint( PlayerViewPointLocation, PlayerViewPointRotation );
+
+	const float ReplicationRadius = CVarChunkDataReplicationRadius.GetValueOnGameThread();
+	const FChunkCoord MinChunkCoord = FChunkCoord::FromWorldLocation( PlayerViewPointLocation - FVector( ReplicationRadius, ReplicationRadius, 0.0f ) );
+	const FChunkCoord MaxChunkCoord = FChunkCoord::FromWorldLocation( PlayerViewPointLocation + FVector( ReplicationRadius, ReplicationRadius, 0.0f ) );
+	const TScriptInterface<IOWGChunkManagerInterface> ChunkManager = OpenWorldGeneratorSubsystem->GetChunkManager();
+
+	TArray<TPair<double, AOWGChunk*>> ChunksInRange;
+	for ( int32 PosX = MinChunkCoord.PosX; PosX <= MaxChunkCoord.PosX; PosX++ )
+	{
+		for ( int32 PosY = MinChunkCoord.PosY; PosY <= MaxChunkCoord.PosY; PosY++ )
+		{
+			AOWGChunk* Chunk = ChunkManager->FindChunk( FChunkCoord( PosX, PosY ) );
+			const double DistanceSquared = Chunk ? FVector::DistSquared2D( Chunk->GetActorLocation(), PlayerViewPointLocation ) : 0.0;
+
+			if ( Chunk != nullptr && !Chunk->IsChunkPooled() && DistanceSquared <= FMath::Square( ReplicationRadius ) )
+			{
+				ChunksInRange.Add( { DistanceSquared, Chunk } );
+			}
+		}
+	}
+	ChunksInRange.Sort( []( const TPair<double, AOWGChunk*>& A, const TPair<double, AOWGChunk*>& B ) { return A.Key < B.Key; } );
+
+	// Forget the chunks that are no longer in range, so that they are sent again as a snapshot once they become relevant again
+	TSet<FChunkCoord> ChunkCoordsInRange;
+	for ( const TPair<double, AOWGChunk*>& Pair : ChunksInRange )
+	{
+		ChunkCoordsInRange.Add( Pair.Value->GetChunkCoord() );
+	}
+	for ( TMap<FChunkCoord, FSentChunkState>::TIterator It = SentChunks.CreateIterator(); It; ++It )
+	{
+		if ( !ChunkCoordsInRange.Contains( It.Key() ) )
+		{
+			ClientForgetChunkData( It.Key() );
+			It.RemoveCurrent();
+		}
+	}
+
+	// Send the chunks that have changed since the last time they have been sent, as long as we have the budget for it
+	const bool bVerifyClientChunkData = CVarVerifyClientChunkData.GetValueOnGameThread();
+	for ( const TPair<double, AOWGChunk*>& Pair : ChunksInRange )
+	{
+		if ( BandwidthAllowance <= 0.0f || !PendingFragments.IsEmpty() || !HasReliableBufferCapacity() )
+		{
+			break;
+		}
+		AOWGChunk* Chunk = Pair.Value;
+		FSentChunkState& SentChunkState = SentChunks.FindOrAdd( Chunk->GetChunkCoord() );
+
+		if ( SentChunkState.Chunk != Chunk || SentChunkState.ChunkRecycleCount != Chunk->GetChunkRecycleCount() )
+		{
+			SentChunkState = FSentChunkState{ Chunk, Chunk->GetChunkRecycleCount(), INDEX_NONE };
+		}
+
+		// Ask the client to verify it's regenerated data before sending the snapshot the first time, and wait for the answer
+		if ( SentChunkState.Changelist == INDEX_NONE && !SentChunkState.bVerificationAttempted && bVerifyClientChunkData && Chunk->GetReplicatedDataSnapshotHash() != 0 )
+		{
+			SentChunkState.VerificationChangelist = Chunk->GetReplicatedDataSnapshotChangelist();
+			SentChunkState.VerificationHash = Chunk->GetReplicatedDataSnapshotHash();
+			SentChunkState.bVerificationAttempted = true;
+
+			ClientVerifyChunkData( Chunk->GetChunkCoord(), SentChunkState.VerificationChangelist, SentChunkState.VerificationHash );
+			BandwidthAllowance -= ChunkDataReplicationInternal::VerificationRequestSize;
+			continue;
+		}
+		if ( SentChunkState.VerificationChangelist != INDEX_NONE )
+		{
+			continue;
+		}
+		if ( SentChunkState.Changelist != Chunk->GetReplicatedDataChangelist() && QueueChunkDataPayload( Chunk, SentChunkState.Changelist ) )
+		{
+			SentChunkState.Changelist = Chunk->GetReplicatedDataChangelist();
+			SendPendingFragments();
+		}
+	}
+}
+
+bool UOWGChunkDataReplicationComponent::QueueChunkDataPayload( AOWGChunk* Chunk, int32 BaseChangelist )
+{
+	// Object references are written as paths since the client resolves them on it's own
+	TArray<uint8> UncompressedData;
+	FMemoryWriter MemoryWriter( UncompressedData );
+	FObjectAndNameAsStringProxyArchive PayloadWriter( MemoryWriter, false );
+
+	if ( !Chunk->WriteReplicatedChunkData( PayloadWriter, BaseChangelist ) )
+	{
+		return false;
+	}
+
+	// Compress the payload
+	const FName CompressionFormat = ChunkDataReplicationInternal::PayloadCompressionFormat;
+	TArray<uint8> CompressedData;
+	CompressedData.AddUninitialized( FCompression::CompressMemoryBound( CompressionFormat, UncompressedData.Num() ) );
+
+	int32 CompressedSize = CompressedData.Num();
+	const bool bCompressionSuccess = FCompression::CompressMemory( CompressionFormat, CompressedData.GetData(), CompressedSize, UncompressedData.GetData(), UncompressedData.Num() );
+	checkf( bCompressionSuccess, TEXT("Failed to compress chunk data using Compression Format '%s'"), *CompressionFormat.ToString() );
+
+	// Split the payload into the fragments
+	const int32 FragmentSize = FMath::Max( CVarChunkDataReplicationFragmentSize.GetValueOnGameThread(), 64 );
+	const int32 NumFragments = FMath::Max( FMath::DivideAndRoundUp( CompressedSize, FragmentSize ), 1 );
+	check( NumFragments <= MAX_uint16 );
+
+	for ( int32 FragmentIndex = 0; FragmentIndex < NumFragments; FragmentIndex++ )
+	{
+		FChunkDataReplicationFragment& Fragment = PendingFragments.AddDefaulted_GetRef();
+		Fragment.ChunkCoord = Chunk->GetChunkCoord();
+		Fragment.FragmentIndex = FragmentIndex;
+		Fragment.NumFragments = NumFragments;
+		Fragment.UncompressedSize = FragmentIndex == 0 ? UncompressedData.Num() : 0;
+
+		const int32 FragmentOffset = FragmentIndex * FragmentSize;
+		Fragment.CompressedData.Append( CompressedData.GetData() + FragmentOffset, FMath::Min( FragmentSize, CompressedSize - FragmentOffset ) );
+	}
+	return true;
+}
+
+void UOWGChunkDataReplicationComponent::SendPendingFragments()
+{
+	// The bandwidth budget alone does not prevent the reliable buffer from overflowing on a slow connection, which would close it, so also wait for the previous fragments to be acknowledged
+	int32 NumFragmentsSent = 0;
+	while ( NumFragmentsSent < PendingFragments.Num() && BandwidthAllowance > 0.0f && HasReliableBufferCapacity() )
+	{
+		const FChunkDataReplicationFragment& Fragment = PendingFragments[ NumFragmentsSent++ ];
+		ClientReceiveChunkDataFragment( Fragment );
+
+		BandwidthAllowance -= Fragment.CompressedData.Num();
+		INC_DWORD_STAT_BY( STAT_ChunkDataBytesSent, Fragment.CompressedData.Num() );
+	}
+	PendingFragments.RemoveAt( 0, NumFragmentsSent );
+}
+
+bool UOWGChunkDataReplicationComponent::HasReliableBufferCapacity() const
+{
+	UNetConnection* NetConnection = GetOwner()->GetNetConnection();
+	const UActorChannel* ActorChannel = NetConnection ? NetConnection->FindActorChannelRef( GetOwner() ) : nullptr;
+	if ( ActorChannel == nullptr )
+	{
+		return false;
+	}
+	const int32 MaxReliableBunches = FMath::Clamp( CVarChunkDataReplicationMaxReliableBunches.GetValueOnGameThread(), 1, RELIABLE_BUFFER / 2 );
+	return ActorChannel->NumOutRec < MaxReliableBunches;
+}
+
+void UOWGChunkDataReplicationComponent::ClientReceiveChunkDataFragment_Implementation( const FChunkDataReplicationFragment& Fragment )
+{
+	TArray<FReceivedChunkPayload>& Payloads = ReceivedPayloads.FindOrAdd( Fragment.ChunkCoord );
+
+	// Reliable RPCs arrive in order, so the first fragment starts a new payload and the rest are appended to it
+	if ( Fragment.FragmentIndex == 0 )
+	{
+		Payloads.AddDefaulted_GetRef().UncompressedSize = Fragment.UncompressedSize;
+	}
+	if ( !ensure( !Payloads.IsEmpty() && !Payloads.Last().bComplete ) )
+	{
+		return;
+	}
+
+	FReceivedChunkPayload& Payload = Payloads.Last();
+	Payload.CompressedData.Append( Fragment.CompressedData );
+	Payload.bComplete = Fragment.FragmentIndex + 1 == Fragment.NumFragments;
+
+	if ( Payload.bComplete )
+	{
+		ApplyReceivedPayloads( Fragment.ChunkCoord );
+	}
+}
+
+void UOWGChunkDataReplicationComponent::ClientForgetChunkData_Implementation( const FChunkCoord& ChunkCoord )
+{
+	ReceivedPayloads.Remove( ChunkCoord );
+	PendingVerifications.Remove( ChunkCoord );
+	SynchronizedChunks.Remove( ChunkCoord );
+}
+
+void UOWGChunkDataReplicationComponent::ServerRequestChunkDataSnapshot_Implementation( const FChunkCoord& ChunkCoord )
+{
+	if ( FSentChunkState* SentChunkState = SentChunks.Find( ChunkCoord ) )
+	{
+		SentChunkState->Changelist = INDEX_NONE;
+		SentChunkState->VerificationChangelist = INDEX_NONE;
+
+		// Client has dropped it's data for the chunk, so the data it regenerates can be verified again instead of sending the snapshot right away
+		SentChunkState->bVerificationAttempted = false;
+	}
+}
+
+void UOWGChunkDataReplicationComponent::ClientReceiveWorldParameters_Implementation( const TSoftObjectPtr<UOWGWorldGeneratorConfiguration>& WorldGenerator, int32 WorldSeed )
+{
+	UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = UOpenWorldGeneratorSubsystem::Get( this );
+	if ( OpenWorldGeneratorSubsystem == nullptr )
+	{
+		return;
+	}
+
+	// World generator might not be loaded on the client yet, so it is sent as a path
+	if ( UOWGWorldGeneratorConfiguration* LoadedWorldGenerator = WorldGenerator.LoadSynchronous() )
+	{
+		OpenWorldGeneratorSubsystem->InitializeClientWorldParameters( LoadedWorldGenerator, WorldSeed );
+	}
+	else
+	{
+		UE_LOG( LogOpenWorldGenerator, Error, TEXT("Failed to load World Generator '%s' received from the server. Chunks will not be generated on the client"), *WorldGenerator.ToString() );
+	}
+}
+
+void UOWGChunkDataReplicationComponent::ClientVerifyChunkData_Implementation( const FChunkCoord& ChunkCoord, int32 SnapshotChangelist, uint64 SnapshotHash )
+{
+	PendingVerifications.Remove( ChunkCoord );
+	if ( !VerifyClientChunkData( ChunkCoord, SnapshotChangelist, SnapshotHash ) )
+	{
+		PendingVerifications.Add( ChunkCoord, FPendingChunkVerification{ SnapshotChangelist, SnapshotHash } );
+	}
+}
+
+bool UOWGChunkDataReplicationComponent::VerifyClientChunkData( const FChunkCoord& ChunkCoord, int32 SnapshotChangelist, uint64 SnapshotHash )
+{
+	// Without the client chunk manager the chunks are not regenerated on the client at all, so the snapshot is needed
+	const UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = UOpenWorldGeneratorSubsystem::Get( this );
+	if ( OpenWorldGeneratorSubsystem == nullptr || !OpenWorldGeneratorSubsystem->GetChunkManager() )
+	{
+		ServerChunkDataVerified( ChunkCoord, SnapshotChangelist, SnapshotHash, false );
+		return true;
+	}
+
+	AOWGChunk* Chunk = FindClientChunk( ChunkCoord );
+	if ( Chunk == nullptr )
+	{
+		return false;
+	}
+
+	// Chunk data is only comparable to the server snapshot if the client has not received any data for the chunk yet
+	const bool bDataMatches = !SynchronizedChunks.Contains( ChunkCoord ) && Chunk->GetReplicatedDataSnapshotHash() == SnapshotHash;
+	if ( bDataMatches )
+	{
+		Chunk->AdoptVerifiedReplicatedDataSnapshot( SnapshotChangelist );
+		SynchronizedChunks.Add( ChunkCoord, Chunk );
+	}
+	UE_LOG( LogOpenWorldGenerator, Verbose, TEXT("Verified client data of Chunk %d,%d against the server snapshot: %s"), ChunkCoord.PosX, ChunkCoord.PosY, bDataMatches ? TEXT("Match") : TEXT("Mismatch") );
+
+	ServerChunkDataVerified( ChunkCoord, SnapshotChangelist, SnapshotHash, bDataMatches );
+	return true;
+}
+
+void UOWGChunkDataReplicationComponent::ServerChunkDataVerified_Implementation( const FChunkCoord& ChunkCoord, int32 SnapshotChangelist, uint64 SnapshotHash, bool bDataMatches )
+{
+	FSentChunkState* SentChunkState = SentChunks.Find( ChunkCoord );
+
+	// Discard the answers to the verifications that are no longer relevant because the chunk has been forgotten or reloaded since
+	if ( SentChunkState == nullptr || SentChunkState->VerificationChangelist != SnapshotChangelist || SentChunkState->VerificationHash != SnapshotHash )
+	{
+		return;
+	}
+	SentChunkState->VerificationChangelist = INDEX_NONE;
+
+	// Client has the snapshot already, so only the modifications made since it need to be sent. Otherwise the full snapshot will be sent
+	if ( bDataMatches )
+	{
+		SentChunkState->Changelist = SnapshotChangelist;
+	}
+}
+
+void UOWGChunkDataReplicationComponent::ApplyReceivedPayloads( const FChunkCoord& ChunkCoord )
+{
+	TArray<FReceivedChunkPayload>* Payloads = ReceivedPayloads.Find( ChunkCoord );
+	AOWGChunk* Chunk = Payloads ? FindClientChunk( ChunkCoord ) : nullptr;
+	if ( Chunk == nullptr )
+	{
+		return;
+	}
+
+	while ( !Payloads->IsEmpty() && ( *Payloads )[ 0 ].bComplete )
+	{
+		const FReceivedChunkPayload Payload = MoveTemp( ( *Payloads )[ 0 ] );
+		Payloads->RemoveAt( 0 );
+
+		TArray<uint8> UncompressedData;
+		UncompressedData.AddUninitialized( Payload.UncompressedSize );
+
+		const FName CompressionFormat = ChunkDataReplicationInternal::PayloadCompressionFormat;
+		bool bPayloadApplied = FCompression::UncompressMemory( CompressionFormat, UncompressedData.GetData(), UncompressedData.Num(), Payload.CompressedData.GetData(), Payload.CompressedData.Num() );
+
+		if ( bPayloadApplied )
+		{
+			FMemoryReader MemoryReader( UncompressedData );
+			FObjectAndNameAsStringProxyArchive PayloadReader( MemoryReader, true );
+			bPayloadApplied = Chunk->ApplyReplicatedChunkData( PayloadReader ) && !PayloadReader.IsError();
+		}
+
+		// The rest of the payloads are deltas on top of this one, so drop them and ask for a snapshot
+		if ( !bPayloadApplied )
+		{
+			UE_LOG( LogOpenWorldGenerator, Verbose, TEXT("Failed to apply replicated data to Chunk %d,%d, requesting the full snapshot"), ChunkCoord.PosX, ChunkCoord.PosY );
+			Payloads->Empty();
+			ServerRequestChunkDataSnapshot( ChunkCoord );
+			break;
+		}
+		SynchronizedChunks.Add( ChunkCoord, Chunk );
+	}
+	if ( Payloads->IsEmpty() )
+	{
+		ReceivedPayloads.Remove( ChunkCoord );
+	}
+}
+
+AOWGChunk* UOWGChunkDataReplicationComponent::FindClientChunk( const FChunkCoord& ChunkCoord ) const
+{
+	// Use the chunk manager if there is one on the client, otherwise look through the chunk actors replicated to the client
+	if ( const UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = UOpenWorldGeneratorSubsystem::Get( this ) )
+	{
+		if ( const TScriptInterface<IOWGChunkManagerInterface> ChunkManager = OpenWorldGeneratorSubsystem->GetChunkManager() )
+		{
+			// Generation would overwrite the data received from the server, so wait until the chunk has finished generating
+			AOWGChunk* Chunk = ChunkManager->FindChunk( ChunkCoord );
+			return Chunk && UOWGClientChunkManager::IsChunkGenerationFinished( Chunk ) ? Chunk : nullptr;
+		}
+	}
+	const TWeakObjectPtr<AOWGChunk>* ReplicatedChunk = ReplicatedChunks.Find( ChunkCoord );
+	return ReplicatedChunk ? ReplicatedChunk->Get() : nullptr;
+}
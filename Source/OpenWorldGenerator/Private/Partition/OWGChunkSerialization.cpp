@@ -2,7 +2,9 @@
 
 #include "Partition/OWGChunkSerialization.h"
 #include "Misc/EngineVersion.h"
+#include "OWGTrace.h"
 #include "Partition/OWGChunk.h"
+#include "Partition/OWGRegionContainer.h"
 #include "Engine/World.h"
 #include "Serialization/MemoryReader.h"
 #include "Serialization/MemoryWriter.h"
@@ -13,6 +15,33 @@ DEFINE_LOG_CATEGORY( LogChunkSerialization );
 const FGuid FOpenWorldGeneratorVersion::GUID( 0x62E62C6A, 0x9DDD11EE, 0x8C900242, 0xAC120002 );
 static FCustomVersionRegistration GOWGVersionRegistration( FOpenWorldGeneratorVersion::GUID, FOpenWorldGeneratorVersion::LatestVersion, TEXT("Open World Generator Version") );
 
+namespace ChunkSerializationInternal
+{
+	/** Serializes the names as the indices into the shared name map. Used to serialize the shared import map, which references the names the same way the chunk data does */
+	class FSharedNameMapArchive : public FArchiveProxy
+	{
+		FChunkSharedSerializationTables& SharedTables;
+	public:
+		FSharedNameMapArchive( FArchive& InnerArchive, FChunkSharedSerializationTables& InSharedTables ) : FArchiveProxy( InnerArchive ), SharedTables( InSharedTables )
+		{
+		}
+
+		virtual FArchive& operator<<( FName& Value ) override
+		{
+			int32 NameIndex = IsSaving() ? SharedTables.FindOrAddName( Value ) : INDEX_NONE;
+			int32 NameNumber = Value.GetNumber();
+			*this << NameIndex;
+			*this << NameNumber;
+
+			if ( IsLoading() && !SharedTables.GetName( NameIndex, NameNumber, Value ) )
+			{
+				SetError();
+			}
+			return *this;
+		}
+	};
+}
+
 void FChunkPackageSummary::SetToLatest()
 {
 	ChunkPackageVersion = EChunkPackageVersion::Latest;
@@ -103,9 +132,132 @@ FArchive& operator<<( FArchive& Ar, FChunkObjectExport& ObjectExport )
 	return Ar;
 }
 
+int32 FChunkSharedSerializationTables::FindOrAddName( FName Name )
+{
+	// Name map never contains name numbers, they are serialized separately - so strip one
+	const FName NameWithoutNumber = FName( Name, 0 );
+
+	if ( const int32* ExistingNameIndex = NameLookupMap.Find( NameWithoutNumber ) )
+	{
+		return *ExistingNameIndex;
+	}
+	const int32 NewNameIndex = NameMap.Add( NameWithoutNumber );
+	NameLookupMap.Add( NameWithoutNumber, NewNameIndex );
+	return NewNameIndex;
+}
+
+bool FChunkSharedSerializationTables::GetName( int32 NameIndex, int32 NameNumber, FName& OutName ) const
+{
+	if ( !NameMap.IsValidIndex( NameIndex ) )
+	{
+		return false;
+	}
+	OutName = FName( NameMap[ NameIndex ], NameNumber );
+	return true;
+}
+
+int32 FChunkSharedSerializationTables::FindImport( const UObject* Object ) const
+{
+	const int32* ExistingImportIndex = ImportIndexMap.Find( FObjectKey( Object ) );
+	return ExistingImportIndex ? *ExistingImportIndex : INDEX_NONE;
+}
+
+int32 FChunkSharedSerializationTables::AddImport( UObject* Object )
+{
+	const int32 NewImportIndex = ImportMap.Add( FChunkObjectImport( Object ) );
+	ImportIndexMap.Add( FObjectKey( Object ), NewImportIndex );
+	ResolvedImports.Add( Object );
+
+	// Resolved objects are only referenced weakly by the shared tables, do not keep a raw pointer to it that could outlive the object
+	ImportMap[ NewImportIndex ].XObject = nullptr;
+	return NewImportIndex;
+}
+
+UObject* FChunkSharedSerializationTables::FindResolvedImport( int32 ImportIndex ) const
+{
+	return ResolvedImports.IsValidIndex( ImportIndex ) ? ResolvedImports[ ImportIndex ].Get() : nullptr;
+}
+
+void FChunkSharedSerializationTables::SetResolvedImport( int32 ImportIndex, UObject* Object )
+{
+	check( ImportMap.IsValidIndex( ImportIndex ) );
+	ResolvedImports[ ImportIndex ] = Object;
+
+	// Make sure the chunks saved after this one reference the existing import instead of adding the same object again
+	if ( Object != nullptr )
+	{
+		ImportIndexMap.FindOrAdd( FObjectKey( Object ), ImportIndex );
+	}
+}
+
+void FChunkSharedSerializationTables::Serialize( FArchive& Ar )
+{
+	if ( Ar.IsSaving() )
+	{
+		// Imports can add new names to the name map, so they are written first, and then placed after the name map
+		TArray<uint8> ImportMapData;
+		FMemoryWriter ImportMapWriter( ImportMapData, true );
+		ChunkSerializationInternal::FSharedNameMapArchive ImportMapArchive( ImportMapWriter, *this );
+
+		int32 NumImports = ImportMap.Num();
+		ImportMapArchive << NumImports;
+		for ( int32 i = 0; i < ImportMap.Num(); i++ )
+		{
+			ImportMapArchive << ImportMap[i];
+		}
+
+		// Serialize name map in a compact format used by the linker
+		int32 NameMapCount = NameMap.Num();
+		Ar << NameMapCount;
+
+		for ( int32 i = 0; i < NameMap.Num(); i++ )
+		{
+			NameMap[i].GetDisplayNameEntry()->Write( Ar );
+		}
+		Ar.Serialize( ImportMapData.GetData(), ImportMapData.Num() );
+	}
+	else if ( Ar.IsLoading() )
+	{
+		check( NameMap.IsEmpty() && ImportMap.IsEmpty() );
+
+		// Serialize name map in a compact format used by the linker
+		int32 NameMapCount = 0;
+		Ar << NameMapCount;
+
+		for ( int32 i = 0; i < NameMapCount; i++ )
+		{
+			FNameEntrySerialized NameEntry( ENAME_LinkerConstructor );
+			Ar << NameEntry;
+
+			const FName ResultName( NameEntry );
+			NameMap.Add( ResultName );
+			NameLookupMap.Add( ResultName, i );
+		}
+
+		// Imports are resolved lazily by the first chunk referencing them
+		ChunkSerializationInternal::FSharedNameMapArchive ImportMapArchive( Ar, *this );
+		int32 NumImports = 0;
+		ImportMapArchive << NumImports;
+
+		for ( int32 i = 0; i < NumImports; i++ )
+		{
+			ImportMapArchive << ImportMap.AddDefaulted_GetRef();
+		}
+		ResolvedImports.SetNum( ImportMap.Num() );
+
+		if ( ImportMapArchive.IsError() )
+		{
+			Ar.SetError();
+		}
+	}
+}
+
 FChunkSerializationContext::FChunkSerializationContext( FArchive& Ar, AOWGChunk* InChunk ) : FArchiveProxy( Ar ),
 	RegionContainer( InChunk->GetOwnerRegionContainer() ), ChunkCoord( InChunk->GetChunkCoord() ), ChunkObject( InChunk )
 {
+	// Chunks are always saved with the name and import tables of their region
+	check( RegionContainer );
+	SharedTables = &RegionContainer->GetSharedSerializationTables();
 }
 
 FChunkSerializationContext::FChunkSerializationContext( FArchive& Ar, UOWGRegionContainer* InRegionContainer, FChunkCoord InChunkCoord ) : FArchiveProxy( Ar ),
@@ -126,6 +278,12 @@ void FChunkSerializationContext::SerializePackageSummary()
 		PackageSummary.SetToLatest();
 	}
 	*this << PackageSummary;
+
+	// Chunks saved before the region shared tables have been introduced have their own name map and import map
+	if ( IsLoading() && PackageSummary.ChunkPackageVersion >= EChunkPackageVersion::RegionSharedTables )
+	{
+		SharedTables = &RegionContainer->GetSharedSerializationTables();
+	}
 }
 
 void FChunkSerializationContext::SerializeCustomVersions()
@@ -156,6 +314,11 @@ void FChunkSerializationContext::SerializeCustomVersions()
 
 void FChunkSerializationContext::SerializeNameMap()
 {
+	// Shared name map is serialized by the region container
+	if ( SharedTables != nullptr )
+	{
+		return;
+	}
 	if ( IsSaving() )
 	{
 		PackageSummary.NameMapOffset = Tell();
@@ -198,7 +361,14 @@ FArchive& FChunkSerializationContext::operator<<( FName& Value )
 		// Name map never contains name numbers, they are serialized separately - so strip one
 		const FName NameWithoutNumber = FName( Value, 0 );
 		int32 NameNumber = Value.GetNumber();
-		
+
+		if ( SharedTables != nullptr )
+		{
+			int32 SharedNameIndex = SharedTables->FindOrAddName( NameWithoutNumber );
+			*this << SharedNameIndex;
+			*this << NameNumber;
+			return *this;
+		}
 		if ( int32* ExistingNameIndex = NameLookupMap.Find( NameWithoutNumber ) )
 		{
 			*this << *ExistingNameIndex;
@@ -220,6 +390,11 @@ FArchive& FChunkSerializationContext::operator<<( FName& Value )
 		*this << NameNumber;
 
 		// Names in the name map are never numbered, so we need to construct a new name with a correct number
+		if ( SharedTables != nullptr )
+		{
+			verify( SharedTables->GetName( NameMapIndex, NameNumber, Value ) );
+			return *this;
+		}
 		check( NameMap.IsValidIndex( NameMapIndex ) );
 		Value = FName( NameMap[ NameMapIndex ], NameNumber );
 		return *this;
@@ -227,27 +402,53 @@ FArchive& FChunkSerializationContext::operator<<( FName& Value )
 	return *this;
 }
 
+FChunkObjectImport& FChunkSerializationContext::GetImportEntry( int32 ImportIndex )
+{
+	if ( SharedTables != nullptr )
+	{
+		check( SharedTables->IsValidImportIndex( ImportIndex ) );
+		return SharedTables->GetImport( ImportIndex );
+	}
+	check( ImportMap.IsValidIndex( ImportIndex ) );
+	return ImportMap[ ImportIndex ];
+}
+
 int32 FChunkSerializationContext::WriteImport( UObject* Object )
 {
-	if ( const int32* ExistingImportIndex = ImportIndexMap.Find( Object ) )
+	int32 NewImportIndex = INDEX_NONE;
+	if ( SharedTables != nullptr )
+	{
+		// Objects imported by any chunk of the region before are referenced by their existing import
+		const int32 ExistingImportIndex = SharedTables->FindImport( Object );
+		if ( ExistingImportIndex != INDEX_NONE )
+		{
+			return ExistingImportIndex;
+		}
+		NewImportIndex = SharedTables->AddImport( Object );
+	}
+	else
 	{
-		return *ExistingImportIndex;
+		if ( const int32* ExistingImportIndex = ImportIndexMap.Find( Object ) )
+		{
+			return *ExistingImportIndex;
+		}
+		NewImportIndex = ImportMap.Add( FChunkObjectImport( Object ) );
+		ImportIndexMap.Add( Object, NewImportIndex );
 	}
-	const int32 NewImportIndex = ImportMap.Add( FChunkObjectImport( Object ) );
-	ImportIndexMap.Add( Object, NewImportIndex );
+	const EChunkObjectFlags ImportObjectFlags = GetImportEntry( NewImportIndex ).ChunkObjectFlags;
 
 	// Sanity check map package references
-	const bool bIsMapPackage = EnumHasAnyFlags( ImportMap[ NewImportIndex ].ChunkObjectFlags, EChunkObjectFlags::MapPackage );
+	const bool bIsMapPackage = EnumHasAnyFlags( ImportObjectFlags, EChunkObjectFlags::MapPackage );
 	checkf( !bIsMapPackage || Object == RegionContainer->GetWorld(), TEXT("Cannot Import MapPackage '%s' that is different from the current World '%s'"),
 		*Object->GetPackage()->GetName(), *RegionContainer->GetWorld()->GetPackage()->GetName() );
 
 	// Sanity check chunk object references. We should never attempt to import objects from other chunks
-	const bool bIsChunkReference = EnumHasAnyFlags( ImportMap[ NewImportIndex ].ChunkObjectFlags, EChunkObjectFlags::Chunk );
+	const bool bIsChunkReference = EnumHasAnyFlags( ImportObjectFlags, EChunkObjectFlags::Chunk );
 	checkf( !bIsChunkReference, TEXT("Illegal reference to external Chunk object '%s' while serializing Chunk '%s'"),
 		*Object->GetName(), *ChunkObject->GetName() );
 
 	// Sanity check region container references. We should never attempt to import region containers other than our own.
-	const bool bIsRegionContainer = EnumHasAnyFlags( ImportMap[ NewImportIndex ].ChunkObjectFlags, EChunkObjectFlags::RegionContainer );
+	const bool bIsRegionContainer = EnumHasAnyFlags( ImportObjectFlags, EChunkObjectFlags::RegionContainer );
 	checkf( !bIsRegionContainer || Object == RegionContainer, TEXT("Cannot Import Region Container '%s' that is different from the current Chunk's Region Container '%s'"),
 		*Object->GetName(), *RegionContainer->GetName() );
 
@@ -259,15 +460,36 @@ int32 FChunkSerializationContext::WriteImport( UObject* Object )
 	// Serialize outer once we've added ourselves to the map, unless we're a map package
 	if ( !bIsMapPackage )
 	{
-		ImportMap[ NewImportIndex ].OuterIndex = WriteObject( Object->GetOuter() );
+		const int32 OuterIndex = WriteObject( Object->GetOuter() );
+
+		// Shared imports are used by other chunks as well, so they can never reference the exports of this chunk
+		checkf( SharedTables == nullptr || OuterIndex <= 0, TEXT("Import '%s' has Outer exported by Chunk '%s'"), *Object->GetPathName(), *ChunkObject->GetName() );
+		GetImportEntry( NewImportIndex ).OuterIndex = OuterIndex;
 	}
 	return NewImportIndex;
 }
 
 UObject* FChunkSerializationContext::ResolveImport( int32 ImportIndex )
 {
-	check( ImportMap.IsValidIndex( ImportIndex ) );
-	FChunkObjectImport& ObjectImport = ImportMap[ ImportIndex ];
+	// Shared imports are only resolved once for all of the chunks in the region, as long as the resolved object stays alive
+	if ( SharedTables != nullptr )
+	{
+		if ( UObject* ResolvedImport = SharedTables->FindResolvedImport( ImportIndex ) )
+		{
+			return ResolvedImport;
+		}
+		FChunkObjectImport& SharedObjectImport = GetImportEntry( ImportIndex );
+		if ( !ensure( !SharedObjectImport.bCurrentlyResolving ) )
+		{
+			return nullptr;
+		}
+		UObject* ResolvedImport = CreateImport( SharedObjectImport );
+		SharedObjectImport.XObject = nullptr;
+		SharedTables->SetResolvedImport( ImportIndex, ResolvedImport );
+		return ResolvedImport;
+	}
+
+	FChunkObjectImport& ObjectImport = GetImportEntry( ImportIndex );
 
 	// We do not support circular dependency resolution
 	if ( ObjectImport.XObject || !ensure( !ObjectImport.bCurrentlyResolving ) )
@@ -429,6 +651,17 @@ UObject* FChunkSerializationContext::CreateExport( FChunkObjectExport& ObjectExp
 		return nullptr;
 	}
 
+	// Reuse a pooled chunk actor for the chunk itself if there is one. It is reset to the class defaults, so we can deserialize into it as if it was freshly spawned
+	if ( &ObjectExport == &ExportMap[ PackageSummary.ChunkExportIndex ] && ExportClass->IsChildOf( AOWGChunk::StaticClass() ) )
+	{
+		if ( AOWGChunk* PooledChunk = RegionContainer->AcquirePooledChunk( ExportClass, ObjectExport.ObjectName ) )
+		{
+			ObjectExport.XObject = PooledChunk;
+			ObjectExport.bNeedsFinishSpawning = true;
+			return ObjectExport.XObject;
+		}
+	}
+
 	// Attempt to spawn the actor into the world first if the class represents an actor
 	if ( ExportClass->IsChildOf( AActor::StaticClass() ) )
 	{
@@ -552,6 +785,11 @@ FArchive& FChunkSerializationContext::operator<<( UObject*& Value )
 
 void FChunkSerializationContext::SerializeImportMap()
 {
+	// Shared import map is serialized by the region container
+	if ( SharedTables != nullptr )
+	{
+		return;
+	}
 	if ( IsSaving() )
 	{
 		PackageSummary.ImportMapOffset = Tell();
@@ -671,17 +909,27 @@ void FChunkSerializationContext::DispatchFinishSpawnOnExports()
 		AActor* Actor = Cast<AActor>( ObjectExport.XObject );
 		if ( Actor != nullptr && ObjectExport.bNeedsFinishSpawning )
 		{
-			Actor->FinishSpawning( ObjectExport.ActorTransform, false );
+			// Pooled chunks have already finished spawning before, so they are reactivated instead
+			AOWGChunk* Chunk = Cast<AOWGChunk>( Actor );
+			if ( Chunk != nullptr && Chunk->IsChunkPooled() )
+			{
+				Chunk->ReactivatePooledChunk();
+			}
+			else
+			{
+				Actor->FinishSpawning( ObjectExport.ActorTransform, false );
+			}
 			ObjectExport.bNeedsFinishSpawning = false;
 		}
 	}
 }
 
-AOWGChunk* FChunkSerializationContext::DeserializeChunk( UOWGRegionContainer* RegionContainer, FChunkCoord ChunkCoord, const TArray<uint8>& ChunkSerializedData, TFunctionRef<void(AOWGChunk*)> PostChunkLoaded )
+AOWGChunk* FChunkSerializationContext::DeserializeChunk( UOWGRegionContainer* RegionContainer, FChunkCoord ChunkCoord, FMemoryView ChunkSerializedData, TFunctionRef<void(AOWGChunk*)> PostChunkLoaded )
 {
-	// TRACE_CPUPROFILER_EVENT_SCOPE(FChunkSerializationContext::DeserializeChunk);
+	OWG_TRACE_CHUNK_SCOPE( DeserializeChunk, ChunkCoord );
 
-	FMemoryReader MemoryReader( ChunkSerializedData, true );
+	// Chunk data is read in place, it can be a part of a larger buffer holding the entire region
+	FMemoryReaderView MemoryReader( ChunkSerializedData, true );
 	FChunkSerializationContext SerializationContext( MemoryReader, RegionContainer, ChunkCoord );
 
 	AOWGChunk* LoadedChunk = SerializationContext.DoChunkDeserialize();
@@ -692,7 +940,7 @@ AOWGChunk* FChunkSerializationContext::DeserializeChunk( UOWGRegionContainer* Re
 
 void FChunkSerializationContext::SerializeChunk( AOWGChunk* Chunk, TArray<uint8>& OutChunkSerializedData )
 {
-	// TRACE_CPUPROFILER_EVENT_SCOPE(FChunkSerializationContext::SerializeChunk);
+	OWG_TRACE_CHUNK_SCOPE( SerializeChunk, Chunk->GetChunkCoord() );
 
 	FMemoryWriter MemoryWriter( OutChunkSerializedData, true );
 	FChunkSerializationContext SerializationContext( MemoryWriter, Chunk );
@@ -0,0 +1,299 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "Partition/OWGClientChunkManager.h"
+#include "OpenWorldGeneratorSettings.h"
+#include "OWGTrace.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "Generation/OWGChunkGenerator.h"
+#include "HAL/IConsoleManager.h"
+#include "Partition/OWGChunk.h"
+
+DEFINE_LOG_CATEGORY( LogClientChunkManager );
+
+static TAutoConsoleVariable CVarClientChunkGenerationStage(
+	TEXT("owg.ClientChunkGenerationStage"),
+	(int32) EChunkGeneratorStage::Surface,
+	TEXT("Last generation stage the clients run locally for the chunks around them. Later stages spawn actors that are replicated from the server instead. Default is 1 (Surface)"),
+	ECVF_Default
+);
+
+void UOWGClientChunkManager::Initialize()
+{
+}
+
+void UOWGClientChunkManager::BeginPlay()
+{
+	for ( const TSoftClassPtr<UObject>& StreamingProviderSoftClass : UOpenWorldGeneratorSettings::Get()->ChunkStreamingProviders )
+	{
+		const UClass* StreamingProviderClass = StreamingProviderSoftClass.LoadSynchronous();
+		if ( StreamingProviderClass != nullptr && StreamingProviderClass->ImplementsInterface( UOWGChunkStreamingProvider::StaticClass() ) )
+		{
+			UObject* StreamingProvider = NewObject<UObject>( this, StreamingProviderClass, NAME_None, RF_Transient );
+			RegisterStreamingProvider( StreamingProvider );
+		}
+	}
+
+	// Chunks replicated before the world parameters have been received have begun play without the chunk manager, so adopt them now
+	for ( AOWGChunk* Chunk : TActorRange<AOWGChunk>( GetWorld() ) )
+	{
+		if ( Chunk->HasActorBegunPlay() && !Chunk->HasAuthority() )
+		{
+			Chunk->RegisterInChunkManager();
+		}
+	}
+}
+
+void UOWGClientChunkManager::Tick( float DeltaTime )
+{
+	TickChunkStreaming( DeltaTime );
+	TickChunkGeneration();
+	TickChunkMemoryAccounting( DeltaTime );
+}
+
+void UOWGClientChunkManager::Deinitialize()
+{
+	// Chunks generated on the client are never saved, they are destroyed together with the world
+	LoadedChunks.Empty();
+	ChunksPendingGeneration.Empty();
+}
+
+void UOWGClientChunkManager::TickChunkStreaming( float DeltaTime )
+{
+	OWG_TRACE_SCOPE( UOWGClientChunkManager::TickChunkStreaming );
+
+	// Collect all streaming sources. On the client, the player streaming provider only sees the local players
+	TArray<FChunkStreamingSource> StreamingSources;
+	for ( const TScriptInterface<IOWGChunkStreamingProvider>& StreamingProvider : RegisteredStreamingProviders )
+	{
+		if ( StreamingProvider )
+		{
+			StreamingProvider->GetStreamingSources( StreamingSources );
+		}
+	}
+
+	TMap<FChunkCoord, FLoadedChunkInfo> ChunkToLoadToGeneratorStageMap;
+	for ( const FChunkStreamingSource& ChunkStreamingSource : StreamingSources )
+	{
+		ChunkStreamingSource.GetLoadedChunkCoords( ChunkToLoadToGeneratorStageMap );
+	}
+
+	// Generate the chunks that should be loaded, but never past the stages that are safe to run on the client
+	const EChunkGeneratorStage MaxClientGenerationStage = (EChunkGeneratorStage) FMath::Clamp( CVarClientChunkGenerationStage.GetValueOnGameThread(), (int32) EChunkGeneratorStage::Initial, (int32) EChunkGeneratorStage::Latest );
+
+	for ( const TPair<FChunkCoord, FLoadedChunkInfo>& Pair : ChunkToLoadToGeneratorStageMap )
+	{
+		if ( AOWGChunk* Chunk = LoadOrCreateChunk( Pair.Key ) )
+		{
+			Chunk->ElapsedIdleTime = 0.0f;
+			Chunk->bPendingToBeUnloaded = false;
+			Chunk->RequestChunkGeneration( FMath::Min( Pair.Value.GeneratorStage, MaxClientGenerationStage ) );
+			Chunk->RequestChunkLOD( FChunkMemoryBudgets::ApplyLODBias( Pair.Value.ChunkLOD, MemoryBudgetLODBias, Chunk->NumChunkLandscapeLODs ) );
+			Chunk->DistanceToClosestStreamingSource = Pair.Value.DistanceToChunk;
+		}
+	}
+
+	const float IdleTimeBeforeChunkUnload = UOpenWorldGeneratorSettings::Get()->ChunkUnloadIdleTime;
+
+	// Destroy the chunks that are no longer needed once they have been idle for long enough. There is nothing to save on the client
+	TArray<AOWGChunk*> ChunksToUnload;
+	for ( const TPair<FChunkCoord, TObjectPtr<AOWGChunk>>& Pair : LoadedChunks )
+	{
+		AOWGChunk* LoadedChunk = Pair.Value;
+		if ( ChunkToLoadToGeneratorStageMap.Contains( Pair.Key ) || !IsValid( LoadedChunk ) )
+		{
+			continue;
+		}
+		LoadedChunk->ElapsedIdleTime += DeltaTime;
+		LoadedChunk->DistanceToClosestStreamingSource = UE_BIG_NUMBER;
+		LoadedChunk->bPendingToBeUnloaded = LoadedChunk->ElapsedIdleTime >= IdleTimeBeforeChunkUnload;
+
+		// Chunks replicated from the server can only be destroyed by the server
+		if ( LoadedChunk->bPendingToBeUnloaded && !LoadedChunk->ShouldDeferChunkUnloading() && LoadedChunk->HasAuthority() )
+		{
+			ChunksToUnload.Add( LoadedChunk );
+		}
+	}
+
+	for ( AOWGChunk* ChunkToUnload : ChunksToUnload )
+	{
+		UE_LOG( LogClientChunkManager, Verbose, TEXT("Unloading client chunk '%s' at %d,%d because IdleTime has exceeded the threshold (%.2fs)"),
+			*ChunkToUnload->GetName(), ChunkToUnload->GetChunkCoord().PosX, ChunkToUnload->GetChunkCoord().PosY, IdleTimeBeforeChunkUnload );
+		UnloadChunk( ChunkToUnload );
+	}
+}
+
+void UOWGClientChunkManager::UnloadChunk( AOWGChunk* Chunk )
+{
+	Chunk->OnChunkAboutToBeUnloaded();
+	LoadedChunks.Remove( Chunk->GetChunkCoord() );
+	Chunk->Destroy();
+}
+
+void UOWGClientChunkManager::TickChunkGeneration()
+{
+	OWG_TRACE_SCOPE( UOWGClientChunkManager::TickChunkGeneration );
+
+	// Sort by distance to the player
+	ChunksPendingGeneration.StableSort( []( const AOWGChunk& A, const AOWGChunk& B )
+	{
+		return A.DistanceToClosestStreamingSource > B.DistanceToClosestStreamingSource;
+	} );
+
+	for ( int32 i = ChunksPendingGeneration.Num() - 1; i >= 0; i-- )
+	{
+		if ( !IsValid( ChunksPendingGeneration[ i ] ) || !ChunksPendingGeneration[ i ]->ProcessChunkGeneration() )
+		{
+			ChunksPendingGeneration.RemoveAt( i );
+		}
+	}
+}
+
+void UOWGClientChunkManager::TickChunkMemoryAccounting( float DeltaTime )
+{
+	const float AccountingInterval = FChunkMemoryBudgets::GetAccountingInterval();
+	TimeSinceLastMemoryAccounting += DeltaTime;
+
+	if ( AccountingInterval < 0.0f || TimeSinceLastMemoryAccounting < AccountingInterval )
+	{
+		return;
+	}
+	TimeSinceLastMemoryAccounting = 0.0f;
+	OWG_TRACE_SCOPE( UOWGClientChunkManager::TickChunkMemoryAccounting );
+
+	TArray<TPair<AOWGChunk*, FChunkMemoryUsage>> PerChunkMemoryUsage;
+	TotalChunkMemoryUsage = FChunkMemoryUsage();
+	int32 MaxLODBias = 0;
+
+	for ( const TPair<FChunkCoord, TObjectPtr<AOWGChunk>>& Pair : LoadedChunks )
+	{
+		if ( IsValid( Pair.Value ) )
+		{
+			const FChunkMemoryUsage ChunkMemoryUsage = Pair.Value->GetMemoryUsage();
+			TotalChunkMemoryUsage += ChunkMemoryUsage;
+			if ( Pair.Value->HasAuthority() )
+			{
+				PerChunkMemoryUsage.Add( { Pair.Value, ChunkMemoryUsage } );
+			}
+			MaxLODBias = FMath::Max( MaxLODBias, Pair.Value->NumChunkLandscapeLODs - 1 );
+		}
+	}
+	TotalChunkMemoryUsage.UpdateStats();
+
+	if ( UOpenWorldGeneratorSettings::Get()->ChunkMemoryBudgetsMB.IsEmpty() )
+	{
+		MemoryBudgetLODBias = 0;
+		return;
+	}
+
+	// Clients enforce the same budgets as the server on the chunks they generate locally. Idle chunks are simply destroyed since there is nothing to save
+	FChunkMemoryUsage RemainingMemoryUsage = TotalChunkMemoryUsage;
+	TArray<AOWGChunk*> ChunksToUnload;
+	FChunkMemoryBudgets::SelectIdleChunksToUnload( PerChunkMemoryUsage, RemainingMemoryUsage, ChunksToUnload );
+
+	for ( AOWGChunk* ChunkToUnload : ChunksToUnload )
+	{
+		UE_LOG( LogClientChunkManager, Log, TEXT("Unloading idle client chunk '%s' at %d,%d early because the chunk memory budget has been exceeded"),
+			*ChunkToUnload->GetName(), ChunkToUnload->GetChunkCoord().PosX, ChunkToUnload->GetChunkCoord().PosY );
+		UnloadChunk( ChunkToUnload );
+	}
+	MemoryBudgetLODBias = FChunkMemoryBudgets::UpdateLODBias( MemoryBudgetLODBias, MaxLODBias, RemainingMemoryUsage );
+}
+
+void UOWGClientChunkManager::RegisterStreamingProvider( const TScriptInterface<IOWGChunkStreamingProvider>& StreamingProvider )
+{
+	if ( StreamingProvider )
+	{
+		RegisteredStreamingProviders.Add( StreamingProvider );
+	}
+}
+
+void UOWGClientChunkManager::UnregisterStreamingProvider( const TScriptInterface<IOWGChunkStreamingProvider>& StreamingProvider )
+{
+	RegisteredStreamingProviders.Remove( StreamingProvider );
+}
+
+bool UOWGClientChunkManager::IsChunkGenerationFinished( const AOWGChunk* Chunk )
+{
+	return Chunk->GetCurrentGenerationStage() > Chunk->GetTargetGenerationStage() && Chunk->IsChunkInitialized();
+}
+
+AOWGChunk* UOWGClientChunkManager::FindChunk( const FChunkCoord& ChunkCoord ) const
+{
+	return LoadedChunks.FindRef( ChunkCoord );
+}
+
+EChunkExists UOWGClientChunkManager::DoesChunkExistSync( const FChunkCoord& ChunkCoord ) const
+{
+	// Only the server knows which chunks exist in the region files
+	return LoadedChunks.Contains( ChunkCoord ) ? EChunkExists::ChunkExists : EChunkExists::Unknown;
+}
+
+AOWGChunk* UOWGClientChunkManager::LoadChunk( const FChunkCoord& ChunkCoord )
+{
+	// Clients cannot load the chunks from the storage, so only the chunks that are already there can be returned
+	return FindChunk( ChunkCoord );
+}
+
+AOWGChunk* UOWGClientChunkManager::LoadOrCreateChunk( const FChunkCoord& ChunkCoord )
+{
+	if ( AOWGChunk* LoadedChunk = FindChunk( ChunkCoord ) )
+	{
+		return LoadedChunk;
+	}
+
+	FActorSpawnParameters SpawnParameters{};
+	SpawnParameters.Name = *FString::Printf( TEXT("OWGClientChunk_X%d_Y%d"), ChunkCoord.PosX, ChunkCoord.PosY );
+	SpawnParameters.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
+	SpawnParameters.ObjectFlags = RF_Transient;
+	SpawnParameters.bDeferConstruction = true;
+
+	UClass* ChunkClass = UOpenWorldGeneratorSettings::Get()->ChunkClass.LoadSynchronous();
+
+	AOWGChunk* NewChunk = GetWorld()->SpawnActor<AOWGChunk>( ChunkClass, ChunkCoord.ToOriginWorldLocation(), FRotator{}, SpawnParameters );
+	check( IsValid( NewChunk ) );
+	NewChunk->SetupClientChunk( ChunkCoord );
+	NewChunk->OnChunkCreated();
+
+	LoadedChunks.Add( ChunkCoord, NewChunk );
+	NewChunk->FinishSpawning( FTransform::Identity, true );
+
+	return NewChunk;
+}
+
+void UOWGClientChunkManager::NotifyChunkBegunPlay( AOWGChunk* Chunk )
+{
+	// Locally generated chunks are already registered when they are spawned
+	if ( Chunk->HasAuthority() )
+	{
+		return;
+	}
+
+	// Replicated chunk takes over the coordinate from the locally generated chunk, so that there are never two chunks at the same coordinate
+	if ( AOWGChunk* LocalChunk = FindChunk( Chunk->GetChunkCoord() ); LocalChunk && LocalChunk != Chunk )
+	{
+		UE_LOG( LogClientChunkManager, Verbose, TEXT("Replacing client chunk '%s' at %d,%d with the replicated chunk '%s'"),
+			*LocalChunk->GetName(), Chunk->GetChunkCoord().PosX, Chunk->GetChunkCoord().PosY, *Chunk->GetName() );
+		UnloadChunk( LocalChunk );
+	}
+	LoadedChunks.Add( Chunk->GetChunkCoord(), Chunk );
+
+	// Replicated chunk has no landscape data, so it is generated on the client like a locally spawned one
+	Chunk->InitializeWorldParameters();
+	Chunk->OnChunkCreated();
+}
+
+void UOWGClientChunkManager::NotifyChunkDestroyed( AOWGChunk* Chunk )
+{
+	// Chunks can be destroyed by the outside code, make sure we do not keep returning them
+	if ( const TObjectPtr<AOWGChunk>* LoadedChunk = LoadedChunks.Find( Chunk->GetChunkCoord() ); LoadedChunk && *LoadedChunk == Chunk )
+	{
+		LoadedChunks.Remove( Chunk->GetChunkCoord() );
+	}
+}
+
+void UOWGClientChunkManager::RequestChunkGeneration( AOWGChunk* Chunk )
+{
+	check( Chunk );
+	ChunksPendingGeneration.AddUnique( Chunk );
+}
@@ -2,9 +2,11 @@
 
 #include "Partition/OWGRegionContainer.h"
 #include "OpenWorldGeneratorSettings.h"
+#include "OWGTrace.h"
 #include "Engine/World.h"
 #include "Partition/OWGChunk.h"
 #include "Partition/OWGChunkSerialization.h"
+#include "Partition/OWGServerChunkManager.h"
 #include "Serialization/MemoryReader.h"
 #include "Serialization/MemoryWriter.h"
 
@@ -34,10 +36,10 @@ AOWGChunk* UOWGRegionContainer::LoadChunk( FChunkCoord ChunkCoord )
 		return LoadedChunk;
 	}
 
-	if ( const TArray<uint8>* SerializedData = SerializedChunkData.Find( ChunkCoord ) )
+	if ( const FSharedBuffer* SerializedData = SerializedChunkData.Find( ChunkCoord ) )
 	{
 		// Add chunk to the LoadedChunks array before we dispatch BeginPlay on it so that it is fully initialized by the time all the relevant actors are fully spawned
-		AOWGChunk* LoadedChunk = FChunkSerializationContext::DeserializeChunk( this, ChunkCoord, *SerializedData, [this, ChunkCoord]( AOWGChunk* TempChunk )
+		AOWGChunk* LoadedChunk = FChunkSerializationContext::DeserializeChunk( this, ChunkCoord, SerializedData->GetView(), [this, ChunkCoord]( AOWGChunk* TempChunk )
 		{
 			check( IsValid( TempChunk ) );
 			LoadedChunks.Add( ChunkCoord, TempChunk );
@@ -67,7 +69,20 @@ AOWGChunk* UOWGRegionContainer::LoadOrCreateChunk( FChunkCoord ChunkCoord )
 		SpawnParameters.bDeferConstruction = true;
 
 		const UOpenWorldGeneratorSettings* OpenWorldGeneratorSettings = UOpenWorldGeneratorSettings::Get();
-		AOWGChunk* NewChunk = GetWorld()->SpawnActor<AOWGChunk>( OpenWorldGeneratorSettings->ChunkClass.LoadSynchronous(), ChunkCoord.ToOriginWorldLocation(), FRotator{}, SpawnParameters );
+		UClass* ChunkClass = OpenWorldGeneratorSettings->ChunkClass.LoadSynchronous();
+
+		// Reuse a pooled chunk actor if there is one. It has already begun play, so it is reactivated instead of finishing spawning
+		if ( AOWGChunk* PooledChunk = AcquirePooledChunk( ChunkClass, SpawnParameters.Name ) )
+		{
+			PooledChunk->SetupChunk( this, ChunkCoord );
+			PooledChunk->OnChunkCreated();
+
+			LoadedChunks.Add( ChunkCoord, PooledChunk );
+			PooledChunk->ReactivatePooledChunk();
+			return PooledChunk;
+		}
+
+		AOWGChunk* NewChunk = GetWorld()->SpawnActor<AOWGChunk>( ChunkClass, ChunkCoord.ToOriginWorldLocation(), FRotator{}, SpawnParameters );
 		NewChunk->SetupChunk( this, ChunkCoord );
 		NewChunk->OnChunkCreated();
 
@@ -87,16 +102,39 @@ void UOWGRegionContainer::UnloadChunk( FChunkCoord ChunkCoord )
 	{
 		// Notify the chunk that we are about to serialize and then immediately unload it
 		LoadedChunk->OnChunkAboutToBeUnloaded();
+		if ( FOWGRegionProxyData::IsFarFieldProxyEnabled() )
+		{
+			RegionProxy.UpdateFromChunk( LoadedChunk );
+		}
 
 		// Serialize the chunk
 		TArray<uint8> SerializedData;
 		FChunkSerializationContext::SerializeChunk( LoadedChunk, SerializedData );
 
-		// Add data to the serialized data array, destroy and remove chunk
-		SerializedChunkData.Add( ChunkCoord, MoveTemp( SerializedData ) );
-		LoadedChunk->Destroy();
-		LoadedChunks.Remove( ChunkCoord );
+		// Add data to the serialized data array, and either return the chunk into the pool or destroy it
+		SerializedChunkData.Add( ChunkCoord, MakeSharedBufferFromArray( MoveTemp( SerializedData ) ) );
+
+		UOWGServerChunkManager* ServerChunkManager = GetTypedOuter<UOWGServerChunkManager>();
+		if ( ServerChunkManager && ServerChunkManager->CanReleaseChunkToPool() )
+		{
+			LoadedChunks.Remove( ChunkCoord );
+			ServerChunkManager->ReleaseChunkToPool( LoadedChunk );
+		}
+		else
+		{
+			LoadedChunk->Destroy();
+			LoadedChunks.Remove( ChunkCoord );
+		}
+	}
+}
+
+AOWGChunk* UOWGRegionContainer::AcquirePooledChunk( const UClass* ChunkClass, FName ChunkName ) const
+{
+	if ( UOWGServerChunkManager* ServerChunkManager = GetTypedOuter<UOWGServerChunkManager>() )
+	{
+		return ServerChunkManager->AcquirePooledChunk( ChunkClass, ChunkName );
 	}
+	return nullptr;
 }
 
 bool UOWGRegionContainer::ChunkExists( FChunkCoord ChunkCoord ) const
@@ -116,6 +154,24 @@ TArray<FChunkCoord> UOWGRegionContainer::GetLoadedChunkCoords() const
 	return AllChunkCommands;
 }
 
+const FOWGRegionProxyData& UOWGRegionContainer::UpdateRegionProxy()
+{
+	if ( !FOWGRegionProxyData::IsFarFieldProxyEnabled() )
+	{
+		return RegionProxy;
+	}
+	for ( const TPair<FChunkCoord, TObjectPtr<AOWGChunk>>& Pair : LoadedChunks )
+	{
+		RegionProxy.UpdateFromChunk( Pair.Value );
+	}
+	return RegionProxy;
+}
+
+void UOWGRegionContainer::SetRegionProxy( FOWGRegionProxyData&& InRegionProxy )
+{
+	RegionProxy = MoveTemp( InRegionProxy );
+}
+
 void UOWGRegionContainer::NotifyChunkDestroyed( const AOWGChunk* Chunk )
 {
 	const FChunkCoord ChunkCoord = Chunk->GetChunkCoord();
@@ -128,6 +184,8 @@ void UOWGRegionContainer::NotifyChunkDestroyed( const AOWGChunk* Chunk )
 
 void UOWGRegionContainer::SerializeRegionContainerToFile(FArchive& Ar)
 {
+	OWG_TRACE_CHUNK_SCOPE( SerializeRegionContainerToFile, RegionCoord );
+
 	TArray<uint8> SerializedUncompressedData;
 	FMemoryWriter InnerWriter( SerializedUncompressedData, true );
 
@@ -154,13 +212,17 @@ void UOWGRegionContainer::SerializeRegionContainerToFile(FArchive& Ar)
 			InnerWriter << ChunkSerializedDataSize;
 			InnerWriter.Serialize( SerializedData.GetData(), ChunkSerializedDataSize );
 		}
-		else if ( TArray<uint8>* SerializedData = SerializedChunkData.Find( ChunkCoord ) )
+		else if ( const FSharedBuffer* SerializedData = SerializedChunkData.Find( ChunkCoord ) )
 		{
-			int32 ChunkSerializedDataSize = SerializedData->Num();
+			int32 ChunkSerializedDataSize = static_cast<int32>( SerializedData->GetSize() );
 			InnerWriter << ChunkSerializedDataSize;
-			InnerWriter.Serialize( SerializedData->GetData(), ChunkSerializedDataSize );
+			InnerWriter.Serialize( const_cast<void*>( SerializedData->GetData() ), ChunkSerializedDataSize );
 		}
 	}
+
+	// Shared tables are written after the chunks, since serializing the loaded chunks can add new entries to them
+	SharedSerializationTables.Serialize( InnerWriter );
+
 	FString CompressionFormat = RegionFileFormatConstants::RegionCompressionFormat.ToString();
 
 	// Compress data
@@ -276,13 +338,18 @@ void UOWGRegionContainer::LoadRegionContainerFromFile(FArchive& Ar)
 	CompressedData.AddZeroed( CompressedSize );
 	Ar.Serialize( CompressedData.GetData(), CompressedSize );
 
-	TArray<uint8> UncompressedData;
-	UncompressedData.AddZeroed( UncompressedSize );
+	// Decompress the region into a single buffer. Chunk blobs reference it directly instead of being copied out of it, so the chunk data is only copied once when the chunk is loaded
+	FUniqueBuffer UncompressedData = FUniqueBuffer::Alloc( UncompressedSize );
 
 	const bool bDecompressionSuccess = FCompression::UncompressMemory( *CompressionFormat, UncompressedData.GetData(), UncompressedSize, CompressedData.GetData(), CompressedSize );
-	checkf( bDecompressionSuccess, TEXT("Failed to decompress Region file using Compression Format '%s'"), *CompressionFormat );
+	if ( !bDecompressionSuccess )
+	{
+		UE_LOG( LogChunkSerialization, Warning,	TEXT("Refusing to load region container file for Region '%s' because it failed to decompress using Compression Format '%s'"), *GetName(), *CompressionFormat );
+		return;
+	}
 
-	FMemoryReader InnerReader( UncompressedData );
+	const FSharedBuffer RegionData = UncompressedData.MoveToShared();
+	FMemoryReaderView InnerReader( RegionData.GetView() );
 
 	// Deserialize chunk blobs from the decompressed data
 	for ( int32 i = 0; i < ChunkCount; i++ )
@@ -290,11 +357,23 @@ void UOWGRegionContainer::LoadRegionContainerFromFile(FArchive& Ar)
 		FChunkCoord ChunkCoord = AllChunkCoords[i];
 		int32 ChunkSerializedDataSize = 0;
 		InnerReader << ChunkSerializedDataSize;
-		
-		TArray<uint8> SerializedChunkDataArray;
-		SerializedChunkDataArray.AddZeroed( ChunkSerializedDataSize );
-		InnerReader.Serialize( SerializedChunkDataArray.GetData(), ChunkSerializedDataSize );
 
-		SerializedChunkData.Add( ChunkCoord, MoveTemp( SerializedChunkDataArray ) );
+		const int64 ChunkSerializedDataOffset = InnerReader.Tell();
+		if ( InnerReader.IsError() || ChunkSerializedDataSize < 0 || ChunkSerializedDataOffset + ChunkSerializedDataSize > InnerReader.TotalSize() )
+		{
+			// Chunks read so far reference the shared serialization tables stored after the chunk data, so none of them can be loaded without them
+			UE_LOG( LogChunkSerialization, Warning,	TEXT("Refusing to load region container file for Region '%s' because it is truncated at Chunk %d,%d"), *GetName(), ChunkCoord.PosX, ChunkCoord.PosY );
+			SerializedChunkData.Reset();
+			return;
+		}
+		InnerReader.Seek( ChunkSerializedDataOffset + ChunkSerializedDataSize );
+
+		SerializedChunkData.Add( ChunkCoord, FSharedBuffer::MakeView( RegionData.GetView().Mid( ChunkSerializedDataOffset, ChunkSerializedDataSize ), RegionData ) );
+	}
+
+	// Older region files only contain the chunks with their own name and import maps
+	if ( RegionContainerVersion >= ERegionContainerVersion::SharedSerializationTables )
+	{
+		SharedSerializationTables.Serialize( InnerReader );
 	}
 }
@@ -0,0 +1,231 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "Partition/OWGRegionProxy.h"
+#include "OpenWorldGeneratorSettings.h"
+#include "OWGTrace.h"
+#include "Components/DynamicMeshComponent.h"
+#include "DynamicMesh/MeshNormals.h"
+#include "Partition/ChunkLandscapeWeight.h"
+#include "Partition/OWGChunk.h"
+#include "Rendering/OWGChunkLandscapeLayer.h"
+
+DECLARE_CYCLE_STAT( TEXT("Update Region Proxy From Chunk"), STAT_UpdateRegionProxyFromChunk, STATGROUP_Game );
+DECLARE_CYCLE_STAT( TEXT("Generate Region Proxy Mesh"), STAT_GenerateRegionProxyMesh, STATGROUP_Game );
+
+namespace RegionProxyFileFormatConstants
+{
+	// Magic number used in region proxy files. Open World Generator Region Proxy = "OWGP" in ASCII
+	static constexpr int32 RegionProxyFileFormatMagic = 0x5047574F;
+}
+
+namespace RegionProxyInternal
+{
+	/** Last change number assigned to any region proxy. Shared between all proxies so that a proxy replaced with a different one never ends up with the same change number */
+	static int32 LastRegionProxyChangeNumber = 0;
+}
+
+FOWGRegionProxyData::FOWGRegionProxyData()
+{
+	ChangeNumber = ++RegionProxyInternal::LastRegionProxyChangeNumber;
+}
+
+bool FOWGRegionProxyData::IsFarFieldProxyEnabled()
+{
+	return UOpenWorldGeneratorSettings::Get()->FarFieldProxyDistance > 0.0f;
+}
+
+void FOWGRegionProxyData::AllocateProxyData()
+{
+	Heights.SetNumZeroed( ResolutionXY * ResolutionXY );
+	Colors.SetNumZeroed( ResolutionXY * ResolutionXY );
+	GeneratedChunks.Init( false, FChunkCoord::ChunksPerRegion * FChunkCoord::ChunksPerRegion );
+}
+
+void FOWGRegionProxyData::UpdateFromChunk( const AOWGChunk* Chunk )
+{
+	SCOPE_CYCLE_COUNTER( STAT_UpdateRegionProxyFromChunk );
+
+	const FChunkData2D* HeightMapData = Chunk->FindRawChunkData( ChunkDataID::SurfaceHeightmap );
+	const FChunkData2D* WeightMapData = Chunk->FindRawChunkData( ChunkDataID::SurfaceWeights );
+	if ( HeightMapData == nullptr || WeightMapData == nullptr || HeightMapData->IsEmpty() || WeightMapData->IsEmpty() )
+	{
+		return;
+	}
+
+	const TChunkData2DView<const float> HeightMap( *HeightMapData );
+	const TChunkData2DView<const FChunkLandscapeWeight> WeightMap( *WeightMapData );
+	const FChunkLandscapeWeightMapDescriptor* WeightMapDescriptor = Chunk->GetWeightMapDescriptor();
+
+	// Resolve the layer colors once, the proxy only needs the color of each point blended by the layer weights
+	TArray<FLinearColor, TInlineAllocator<FChunkLandscapeWeight::MaxWeightMapLayers>> LayerColors;
+	for ( int32 LayerIndex = 0; LayerIndex < WeightMapDescriptor->GetNumLayers(); LayerIndex++ )
+	{
+		const UOWGChunkLandscapeLayer* LandscapeLayer = WeightMapDescriptor->GetLayerDescriptor( LayerIndex );
+		LayerColors.Add( LandscapeLayer ? LandscapeLayer->FarFieldColor : FLinearColor::Gray );
+	}
+
+	if ( Heights.IsEmpty() )
+	{
+		AllocateProxyData();
+	}
+
+	const FChunkCoord ChunkCoord = Chunk->GetChunkCoord();
+	const FChunkCoord RegionCoord = ChunkCoord.ToRegionCoord();
+	const int32 ChunkOffsetX = ChunkCoord.PosX - RegionCoord.PosX * FChunkCoord::ChunksPerRegion;
+	const int32 ChunkOffsetY = ChunkCoord.PosY - RegionCoord.PosY * FChunkCoord::ChunksPerRegion;
+	const float ChunkHeightOffset = Chunk->GetActorLocation().Z;
+
+	for ( int32 PointY = 0; PointY <= QuadsPerChunk; PointY++ )
+	{
+		for ( int32 PointX = 0; PointX <= QuadsPerChunk; PointX++ )
+		{
+			// Sample the closest grid points directly. Chunk edges hold the same data as the edges of their neighbours, so the shared proxy points match
+			const int32 HeightMapX = FMath::RoundToInt32( PointX * ( HeightMap.GetSurfaceResolutionXY() - 1 ) / (float) QuadsPerChunk );
+			const int32 HeightMapY = FMath::RoundToInt32( PointY * ( HeightMap.GetSurfaceResolutionXY() - 1 ) / (float) QuadsPerChunk );
+			const int32 WeightMapX = FMath::RoundToInt32( PointX * ( WeightMap.GetSurfaceResolutionXY() - 1 ) / (float) QuadsPerChunk );
+			const int32 WeightMapY = FMath::RoundToInt32( PointY * ( WeightMap.GetSurfaceResolutionXY() - 1 ) / (float) QuadsPerChunk );
+
+			float NormalizedWeights[FChunkLandscapeWeight::MaxWeightMapLayers];
+			WeightMap( WeightMapX, WeightMapY ).GetNormalizedWeights( NormalizedWeights );
+
+			FLinearColor PointColor = FLinearColor::Transparent;
+			for ( int32 LayerIndex = 0; LayerIndex < LayerColors.Num(); LayerIndex++ )
+			{
+				PointColor += LayerColors[ LayerIndex ] * NormalizedWeights[ LayerIndex ];
+			}
+
+			const int32 ProxyPointIndex = ( ChunkOffsetY * QuadsPerChunk + PointY ) * ResolutionXY + ChunkOffsetX * QuadsPerChunk + PointX;
+			Heights[ ProxyPointIndex ] = ChunkHeightOffset + HeightMap( HeightMapX, HeightMapY );
+			Colors[ ProxyPointIndex ] = PointColor.ToFColor( true );
+		}
+	}
+
+	GeneratedChunks[ GetChunkMaskIndex( ChunkCoord ) ] = true;
+	ChangeNumber = ++RegionProxyInternal::LastRegionProxyChangeNumber;
+}
+
+void FOWGRegionProxyData::GenerateProxyMesh( UE::Geometry::FDynamicMesh3& OutProxyMesh, const TBitArray<>& HiddenChunks ) const
+{
+	SCOPE_CYCLE_COUNTER( STAT_GenerateRegionProxyMesh );
+	OWG_TRACE_SCOPE( FOWGRegionProxyData::GenerateProxyMesh );
+
+	OutProxyMesh.Clear();
+	OutProxyMesh.EnableVertexNormals( FVector3f::UpVector );
+	OutProxyMesh.EnableAttributes();
+	OutProxyMesh.Attributes()->EnablePrimaryColors();
+	UE::Geometry::FDynamicMeshColorOverlay* ColorOverlay = OutProxyMesh.Attributes()->PrimaryColors();
+
+	// Vertices are only created for the points used by at least one visible quad
+	TArray<int32> PointVertexIndices;
+	PointVertexIndices.Init( INDEX_NONE, ResolutionXY * ResolutionXY );
+	TArray<int32> PointColorIndices;
+	PointColorIndices.Init( INDEX_NONE, ResolutionXY * ResolutionXY );
+
+	const float QuadSize = FChunkCoord::ChunkSizeWorldUnits / (float) QuadsPerChunk;
+	const auto GetOrCreatePointVertex = [&]( int32 PointX, int32 PointY ) -> int32
+	{
+		const int32 PointIndex = PointY * ResolutionXY + PointX;
+		if ( PointVertexIndices[ PointIndex ] == INDEX_NONE )
+		{
+			PointVertexIndices[ PointIndex ] = OutProxyMesh.AppendVertex( FVector3d( PointX * QuadSize, PointY * QuadSize, Heights[ PointIndex ] ) );
+			PointColorIndices[ PointIndex ] = ColorOverlay->AppendElement( FVector4f( FLinearColor( Colors[ PointIndex ] ) ) );
+		}
+		return PointIndex;
+	};
+	const auto AppendProxyTriangle = [&]( int32 PointIndexA, int32 PointIndexB, int32 PointIndexC )
+	{
+		const int32 TriangleId = OutProxyMesh.AppendTriangle( UE::Geometry::FIndex3i( PointVertexIndices[ PointIndexA ], PointVertexIndices[ PointIndexB ], PointVertexIndices[ PointIndexC ] ) );
+		ColorOverlay->SetTriangle( TriangleId, UE::Geometry::FIndex3i( PointColorIndices[ PointIndexA ], PointColorIndices[ PointIndexB ], PointColorIndices[ PointIndexC ] ) );
+	};
+
+	for ( int32 ChunkIndex = 0; ChunkIndex < GeneratedChunks.Num(); ChunkIndex++ )
+	{
+		if ( !GeneratedChunks[ ChunkIndex ] || ( HiddenChunks.IsValidIndex( ChunkIndex ) && HiddenChunks[ ChunkIndex ] ) )
+		{
+			continue;
+		}
+		const int32 ChunkStartX = ( ChunkIndex % FChunkCoord::ChunksPerRegion ) * QuadsPerChunk;
+		const int32 ChunkStartY = ( ChunkIndex / FChunkCoord::ChunksPerRegion ) * QuadsPerChunk;
+
+		for ( int32 PointY = ChunkStartY; PointY < ChunkStartY + QuadsPerChunk; PointY++ )
+		{
+			for ( int32 PointX = ChunkStartX; PointX < ChunkStartX + QuadsPerChunk; PointX++ )
+			{
+				const int32 PointX0Y0 = GetOrCreatePointVertex( PointX, PointY );
+				const int32 PointXPY0 = GetOrCreatePointVertex( PointX + 1, PointY );
+				const int32 PointX0YP = GetOrCreatePointVertex( PointX, PointY + 1 );
+				const int32 PointXPYP = GetOrCreatePointVertex( PointX + 1, PointY + 1 );
+
+				// Same triangle layout and winding as the chunk landscape mesh
+				AppendProxyTriangle( PointX0YP, PointXPY0, PointX0Y0 );
+				AppendProxyTriangle( PointXPY0, PointX0YP, PointXPYP );
+			}
+		}
+	}
+	UE::Geometry::FMeshNormals::QuickComputeVertexNormals( OutProxyMesh );
+}
+
+bool FOWGRegionProxyData::Serialize( FArchive& Ar )
+{
+	int32 FileFormatMagic = RegionProxyFileFormatConstants::RegionProxyFileFormatMagic;
+	Ar << FileFormatMagic;
+	ERegionProxyVersion RegionProxyVersion = ERegionProxyVersion::Latest;
+	Ar << RegionProxyVersion;
+
+	if ( Ar.IsError() || FileFormatMagic != RegionProxyFileFormatConstants::RegionProxyFileFormatMagic || RegionProxyVersion > ERegionProxyVersion::Latest )
+	{
+		return false;
+	}
+
+	// Resolution is part of the file so that proxies written with a different resolution are discarded instead of being read incorrectly
+	int32 SerializedResolutionXY = ResolutionXY;
+	Ar << SerializedResolutionXY;
+	if ( SerializedResolutionXY != ResolutionXY )
+	{
+		return false;
+	}
+
+	Ar << Heights;
+	Ar << Colors;
+	Ar << GeneratedChunks;
+
+	if ( Ar.IsLoading() )
+	{
+		// Discard the data if it is corrupted, the proxy will be rebuilt by the chunks
+		if ( Ar.IsError() || Heights.Num() != ResolutionXY * ResolutionXY || Colors.Num() != ResolutionXY * ResolutionXY || GeneratedChunks.Num() != FChunkCoord::ChunksPerRegion * FChunkCoord::ChunksPerRegion )
+		{
+			*this = FOWGRegionProxyData();
+			return false;
+		}
+		ChangeNumber = ++RegionProxyInternal::LastRegionProxyChangeNumber;
+	}
+	return !Ar.IsError();
+}
+
+AOWGRegionProxyActor::AOWGRegionProxyActor()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	SetReplicates( false );
+	SetCanBeDamaged( false );
+
+	ProxyMeshComponent = CreateDefaultSubobject<UDynamicMeshComponent>( TEXT("ProxyMeshComponent") );
+	ProxyMeshComponent->SetCollisionEnabled( ECollisionEnabled::NoCollision );
+	ProxyMeshComponent->SetCastShadow( false );
+	RootComponent = ProxyMeshComponent;
+}
+
+void AOWGRegionProxyActor::UpdateProxyMesh( const FOWGRegionProxyData& ProxyData, const TBitArray<>& HiddenChunks, UMaterialInterface* ProxyMaterial )
+{
+	if ( BuiltChangeNumber == ProxyData.GetChangeNumber() && BuiltHiddenChunks == HiddenChunks )
+	{
+		return;
+	}
+	BuiltChangeNumber = ProxyData.GetChangeNumber();
+	BuiltHiddenChunks = HiddenChunks;
+
+	ProxyMeshComponent->EditMesh( [&]( UE::Geometry::FDynamicMesh3& DynamicMesh )
+	{
+		ProxyData.GenerateProxyMesh( DynamicMesh, HiddenChunks );
+	} );
+	ProxyMeshComponent->SetMaterial( 0, ProxyMaterial );
+}
@@ -7,18 +7,27 @@
 #include "Misc/Paths.h"
 #include "OpenWorldGeneratorSettings.h"
 #include "OpenWorldGeneratorSubsystem.h"
+#include "OWGTrace.h"
 #include "Engine/Canvas.h"
 #include "GameFramework/HUD.h"
+#include "GameFramework/PlayerController.h"
 #include "Generation/OWGNoiseGenerator.h"
 #include "Generation/OWGWorldGeneratorConfiguration.h"
 #include "HAL/IConsoleManager.h"
 #include "Misc/App.h"
 #include "Partition/OWGChunk.h"
+#include "Partition/OWGChunkDataReplicationComponent.h"
 #include "Partition/OWGRegionContainer.h"
+#include "Partition/OWGRegionProxy.h"
+#include "Engine/World.h"
+#include "Materials/MaterialInterface.h"
 #include "Serialization/ObjectAndNameAsStringProxyArchive.h"
 
 DEFINE_LOG_CATEGORY( LogServerChunkManager );
 
+DECLARE_CYCLE_STAT( TEXT("Chunk Memory Accounting"), STAT_ChunkMemoryAccounting, STATGROUP_Game );
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT("Pooled Chunk Actors"), STAT_PooledChunkActors, STATGROUP_Game );
+
 static TAutoConsoleVariable CVarFreezeServerChunkStreaming(
 	TEXT("owg.FreezeServerChunkStreaming"),
 	false,
@@ -26,6 +35,50 @@ static TAutoConsoleVariable CVarFreezeServerChunkStreaming(
 	ECVF_Cheat
 );
 
+static TAutoConsoleVariable CVarFarFieldProxyUpdateInterval(
+	TEXT("owg.FarFieldProxyUpdateInterval"),
+	0.5f,
+	TEXT("Interval in seconds between updating the set of the far-field region proxies around the streaming sources. Default is 0.5 seconds"),
+	ECVF_Default
+);
+
+static FAutoConsoleCommandWithWorldAndArgs DumpChunkMemoryCommand(
+	TEXT("owg.DumpChunkMemory"),
+	TEXT("Logs the memory used by the loaded chunks per category, followed by the chunks using the most memory. Usage: owg.DumpChunkMemory [NumTopChunks]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic( []( const TArray<FString>& Args, UWorld* World )
+	{
+		const UOpenWorldGeneratorSubsystem* Subsystem = UOpenWorldGeneratorSubsystem::Get( World );
+		if ( const UOWGServerChunkManager* ChunkManager = Subsystem ? Cast<UOWGServerChunkManager>( Subsystem->GetChunkManager().GetObject() ) : nullptr )
+		{
+			const int32 NumTopChunks = Args.IsEmpty() ? 10 : FCString::Atoi( *Args[ 0 ] );
+			ChunkManager->DumpChunkMemoryUsage( NumTopChunks );
+		}
+	} )
+);
+
+namespace RegionFileInternal
+{
+	/** Writes into a temporary file first and then replaces the target file with it, so an interrupted write does not leave a corrupted file behind */
+	static bool WriteFileAtomically( const FString& Filename, const TCHAR* FileKind, TFunctionRef<void( FArchive& )> WriteFunction )
+	{
+		const FString TempFilename = Filename + TEXT(".tmp");
+
+		if ( FArchive* WriterArchive = IFileManager::Get().CreateFileWriter( *TempFilename ) )
+		{
+			WriteFunction( *WriterArchive );
+			const bool bWriteSucceeded = WriterArchive->Close();
+			delete WriterArchive;
+
+			if ( bWriteSucceeded && IFileManager::Get().Move( *Filename, *TempFilename, true, true ) )
+			{
+				return true;
+			}
+		}
+		UE_LOG( LogServerChunkManager, Error, TEXT("Failed to write %s '%s'"), FileKind, *Filename );
+		return false;
+	}
+}
+
 namespace OpenWorldGeneratorSaveGame
 {
 	static const TCHAR* SaveGameExtension = TEXT("owgsav");
@@ -54,25 +107,52 @@ void UOWGServerChunkManager::Tick( float DeltaTime )
 	if ( !CVarFreezeServerChunkStreaming.GetValueOnGameThread() )
 	{
 		TickChunkStreaming( DeltaTime );
+		TickFarFieldProxies( DeltaTime );
 	}
 	TickChunkGeneration();
+	TickChunkMemoryAccounting( DeltaTime );
+	TickChunkDataReplication();
 }
 
 void UOWGServerChunkManager::Deinitialize()
 {
 	// Write all regions to the region files
 	// TODO @open-world-generator: We should periodically write these files in background, and also cleanup regions that have been unloaded for a while
-	if (!RegionFolderLocation.IsEmpty())
+	for (const TPair<FChunkCoord, UOWGRegionContainer*>& LoadedRegion : LoadedRegions)
+	{
+		SaveRegionContainer(LoadedRegion.Key);
+	}
+
+	// Pooled chunk actors are destroyed together with the world
+	DEC_DWORD_STAT_BY( STAT_PooledChunkActors, PooledChunks.Num() );
+	PooledChunks.Empty();
+}
+
+bool UOWGServerChunkManager::SaveRegionContainer( const FChunkCoord& RegionCoord ) const
+{
+	const TObjectPtr<UOWGRegionContainer>* RegionContainer = LoadedRegions.Find( RegionCoord );
+	if ( RegionFolderLocation.IsEmpty() || RegionContainer == nullptr )
+	{
+		return false;
+	}
+
+	const bool bRegionWritten = RegionFileInternal::WriteFileAtomically( GetFilenameForRegionCoord( RegionCoord ), TEXT("region file"), [&]( FArchive& Ar )
 	{
-		for (const TPair<FChunkCoord, UOWGRegionContainer*>& LoadedRegion : LoadedRegions)
+		( *RegionContainer )->SerializeRegionContainerToFile( Ar );
+	} );
+
+	// Write the far-field proxy next to the region file, updated with the chunks that are currently loaded
+	FOWGRegionProxyData RegionProxy = ( *RegionContainer )->UpdateRegionProxy();
+	if ( !RegionProxy.IsEmpty() )
+	{
+		RegionFileInternal::WriteFileAtomically( GetFilenameForRegionProxy( RegionCoord ), TEXT("region proxy file"), [&]( FArchive& Ar )
 		{
-			const FString RegionFilename = GetFilenameForRegionCoord(LoadedRegion.Key);
-			if (FArchive* WriterArchive = IFileManager::Get().CreateFileWriter(*RegionFilename))
-			{
-				LoadedRegion.Value->SerializeRegionContainerToFile(*WriterArchive);
-			}
-		}
+			RegionProxy.Serialize( Ar );
+		} );
+		// Drop the cached proxy of the region, it is read again from the new file once the region is unloaded
+		FarFieldProxyDataCache.Remove( RegionCoord );
 	}
+	return bRegionWritten;
 }
 
 void UOWGServerChunkManager::RequestChunkGeneration( AOWGChunk* Chunk )
@@ -83,7 +163,7 @@ void UOWGServerChunkManager::RequestChunkGeneration( AOWGChunk* Chunk )
 
 void UOWGServerChunkManager::TickChunkGeneration()
 {
-	// TRACE_CPUPROFILER_EVENT_SCOPE(UOWGServerChunkManager::TickChunkGeneration);
+	OWG_TRACE_SCOPE( UOWGServerChunkManager::TickChunkGeneration );
 
 	// Sort by distance to the player
 	ChunksPendingGeneration.StableSort( []( const AOWGChunk& A, const AOWGChunk& B )
@@ -182,6 +262,25 @@ void UOWGServerChunkManager::DrawDebugHUD( AHUD* HUD, UCanvas* Canvas, const FDe
 		DisplayDebugManager.DrawString( FString::Printf( TEXT("Chunk: %d,%d (%s)"), PlayerChunkCoord.PosX, PlayerChunkCoord.PosY, *GetNameSafe( LoadedChunk ) ) );
 		DisplayDebugManager.DrawString( FString::Printf( TEXT("Region: %d,%d"), RegionCoord.PosX, RegionCoord.PosY ) );
 
+		const TMap<EChunkMemoryCategory, float>& MemoryBudgetsMB = UOpenWorldGeneratorSettings::Get()->ChunkMemoryBudgetsMB;
+		TArray<FString> MemoryUsageEntries;
+		for ( int32 CategoryIndex = 0; CategoryIndex < FChunkMemoryUsage::NumCategories; CategoryIndex++ )
+		{
+			const EChunkMemoryCategory Category = (EChunkMemoryCategory) CategoryIndex;
+			const float CategoryMemoryMB = TotalChunkMemoryUsage.Get( Category ) / ( 1024.0f * 1024.0f );
+
+			if ( const float* CategoryBudgetMB = MemoryBudgetsMB.Find( Category ) )
+			{
+				MemoryUsageEntries.Add( FString::Printf( TEXT("%s: %.2f/%.2fMB"), *FChunkMemoryUsage::GetCategoryName( Category ), CategoryMemoryMB, *CategoryBudgetMB ) );
+			}
+			else
+			{
+				MemoryUsageEntries.Add( FString::Printf( TEXT("%s: %.2fMB"), *FChunkMemoryUsage::GetCategoryName( Category ), CategoryMemoryMB ) );
+			}
+		}
+		DisplayDebugManager.DrawString( FString::Printf( TEXT("Loaded Chunks Memory: %.2fMB (LOD Bias: %d)"), TotalChunkMemoryUsage.GetTotal() / ( 1024.0f * 1024.0f ), MemoryBudgetLODBias ) );
+		DisplayDebugManager.DrawString( FString::Join( MemoryUsageEntries, TEXT("; ") ) );
+
 		if ( LoadedChunk != nullptr )
 		{
 			LoadedChunk->DrawDebugHUD( HUD, Canvas, DisplayInfo );
@@ -189,19 +288,24 @@ void UOWGServerChunkManager::DrawDebugHUD( AHUD* HUD, UCanvas* Canvas, const FDe
 	}
 }
 
-void UOWGServerChunkManager::TickChunkStreaming( float DeltaTime )
+void UOWGServerChunkManager::GatherStreamingSources( TArray<FChunkStreamingSource>& OutStreamingSources ) const
 {
-	// TRACE_CPUPROFILER_EVENT_SCOPE(UOWGServerChunkManager::TickChunkStreaming);
-	
-	// Collect all streaming sources
-	TArray<FChunkStreamingSource> StreamingSources;
 	for ( const TScriptInterface<IOWGChunkStreamingProvider>& StreamingProvider : RegisteredStreamingProviders )
 	{
 		if ( StreamingProvider )
 		{
-			StreamingProvider->GetStreamingSources( StreamingSources );
+			StreamingProvider->GetStreamingSources( OutStreamingSources );
 		}
 	}
+}
+
+void UOWGServerChunkManager::TickChunkStreaming( float DeltaTime )
+{
+	OWG_TRACE_SCOPE( UOWGServerChunkManager::TickChunkStreaming );
+	
+	// Collect all streaming sources
+	TArray<FChunkStreamingSource> StreamingSources;
+	GatherStreamingSources( StreamingSources );
 
 	// Generate a list of chunks we want loaded
 	TMap<FChunkCoord, FLoadedChunkInfo> ChunkToLoadToGeneratorStageMap;
@@ -265,7 +369,8 @@ void UOWGServerChunkManager::TickChunkStreaming( float DeltaTime )
 		Chunk->ElapsedIdleTime = 0.0f;
 		Chunk->bPendingToBeUnloaded = false;
 		Chunk->RequestChunkGeneration( LoadedChunkInfo.GeneratorStage );
-		Chunk->RequestChunkLOD( LoadedChunkInfo.ChunkLOD );
+		// Chunks closest to the streaming sources always keep their LOD, the rest are biased towards the coarser LODs when the rendering memory is over budget
+		Chunk->RequestChunkLOD( FChunkMemoryBudgets::ApplyLODBias( LoadedChunkInfo.ChunkLOD, MemoryBudgetLODBias, Chunk->NumChunkLandscapeLODs ) );
 		Chunk->DistanceToClosestStreamingSource = LoadedChunkInfo.DistanceToChunk;
 	}
 
@@ -295,6 +400,300 @@ void UOWGServerChunkManager::TickChunkStreaming( float DeltaTime )
 	}
 }
 
+void UOWGServerChunkManager::TickFarFieldProxies( float DeltaTime )
+{
+	// Proxies are purely visual, so there is nothing to do if the world cannot be rendered, or if there are no region files to build them from
+	const UOpenWorldGeneratorSettings* OpenWorldGeneratorSettings = UOpenWorldGeneratorSettings::Get();
+	const float FarFieldProxyDistance = OpenWorldGeneratorSettings->FarFieldProxyDistance;
+	if ( FarFieldProxyDistance <= 0.0f || !FApp::CanEverRender() || RegionFolderLocation.IsEmpty() )
+	{
+		DestroyFarFieldProxies();
+		return;
+	}
+
+	// Proxies only cover the regions beyond the streaming distance, so they do not need to follow the streaming sources every frame
+	TimeSinceLastFarFieldProxyUpdate += DeltaTime;
+	if ( TimeSinceLastFarFieldProxyUpdate < CVarFarFieldProxyUpdateInterval.GetValueOnGameThread() )
+	{
+		return;
+	}
+	TimeSinceLastFarFieldProxyUpdate = 0.0f;
+	OWG_TRACE_SCOPE( UOWGServerChunkManager::TickFarFieldProxies );
+
+	TArray<FChunkStreamingSource> StreamingSources;
+	GatherStreamingSources( StreamingSources );
+
+	// Collect the regions within the far-field distance of the radius streaming sources. Box sources are used for the gameplay areas and do not view the horizon
+	constexpr double RegionSize = (double) FChunkCoord::ChunkSizeWorldUnits * FChunkCoord::ChunksPerRegion;
+	TSet<FChunkCoord> RegionsInRange;
+	for ( const FChunkStreamingSource& StreamingSource : StreamingSources )
+	{
+		if ( !StreamingSource.bIsRadiusSource )
+		{
+			continue;
+		}
+		const FVector2D SourceLocation( StreamingSource.BoxSphereBounds.Origin );
+		const FChunkCoord MinRegionCoord = FChunkCoord::FromWorldLocation( FVector( SourceLocation - FVector2D( FarFieldProxyDistance ), 0.0f ) ).ToRegionCoord();
+		const FChunkCoord MaxRegionCoord = FChunkCoord::FromWorldLocation( FVector( SourceLocation + FVector2D( FarFieldProxyDistance ), 0.0f ) ).ToRegionCoord();
+
+		for ( int32 RegionX = MinRegionCoord.PosX; RegionX <= MaxRegionCoord.PosX; RegionX++ )
+		{
+			for ( int32 RegionY = MinRegionCoord.PosY; RegionY <= MaxRegionCoord.PosY; RegionY++ )
+			{
+				const FBox2D RegionBounds( FVector2D( RegionX * RegionSize, RegionY * RegionSize ), FVector2D( ( RegionX + 1 ) * RegionSize, ( RegionY + 1 ) * RegionSize ) );
+				if ( RegionBounds.ComputeSquaredDistanceToPoint( SourceLocation ) <= FMath::Square( FarFieldProxyDistance ) )
+				{
+					RegionsInRange.Add( FChunkCoord( RegionX, RegionY ) );
+				}
+			}
+		}
+	}
+
+	// Drop the proxies of the regions that are no longer in range
+	for ( TMap<FChunkCoord, TObjectPtr<AOWGRegionProxyActor>>::TIterator It( RegionProxyActors ); It; ++It )
+	{
+		if ( !RegionsInRange.Contains( It.Key() ) )
+		{
+			if ( IsValid( It.Value() ) )
+			{
+				It.Value()->Destroy();
+			}
+			It.RemoveCurrent();
+		}
+	}
+	for ( TMap<FChunkCoord, TSharedPtr<FOWGRegionProxyData>>::TIterator It( FarFieldProxyDataCache ); It; ++It )
+	{
+		if ( !RegionsInRange.Contains( It.Key() ) )
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	if ( !RegionsInRange.IsEmpty() && !bFarFieldProxyMaterialResolved )
+	{
+		FarFieldProxyMaterial = OpenWorldGeneratorSettings->FarFieldProxyMaterial.LoadSynchronous();
+		bFarFieldProxyMaterialResolved = true;
+	}
+
+	for ( const FChunkCoord& RegionCoord : RegionsInRange )
+	{
+		// Loaded chunks render themselves, so they are cut out of the proxy of the loaded region
+		const FOWGRegionProxyData* RegionProxy = nullptr;
+		TBitArray<> HiddenChunks( false, FChunkCoord::ChunksPerRegion * FChunkCoord::ChunksPerRegion );
+
+		if ( const TObjectPtr<UOWGRegionContainer>* RegionContainer = LoadedRegions.Find( RegionCoord ) )
+		{
+			RegionProxy = &( *RegionContainer )->GetRegionProxy();
+			for ( const FChunkCoord& LoadedChunkCoord : ( *RegionContainer )->GetLoadedChunkCoords() )
+			{
+				HiddenChunks[ FOWGRegionProxyData::GetChunkMaskIndex( LoadedChunkCoord ) ] = true;
+			}
+		}
+		else
+		{
+			RegionProxy = FindOrLoadFarFieldProxyData( RegionCoord );
+		}
+
+		TObjectPtr<AOWGRegionProxyActor>& RegionProxyActor = RegionProxyActors.FindOrAdd( RegionCoord );
+		if ( RegionProxy == nullptr || RegionProxy->IsEmpty() )
+		{
+			if ( IsValid( RegionProxyActor ) )
+			{
+				RegionProxyActor->Destroy();
+			}
+			RegionProxyActors.Remove( RegionCoord );
+			continue;
+		}
+
+		if ( !IsValid( RegionProxyActor ) )
+		{
+			FActorSpawnParameters SpawnParameters{};
+			SpawnParameters.ObjectFlags |= RF_Transient;
+			RegionProxyActor = GetWorld()->SpawnActor<AOWGRegionProxyActor>( AOWGRegionProxyActor::StaticClass(), FOWGRegionProxyData::GetRegionCornerWorldLocation( RegionCoord ), FRotator::ZeroRotator, SpawnParameters );
+		}
+		if ( RegionProxyActor )
+		{
+			RegionProxyActor->UpdateProxyMesh( *RegionProxy, HiddenChunks, FarFieldProxyMaterial );
+		}
+	}
+}
+
+void UOWGServerChunkManager::DestroyFarFieldProxies()
+{
+	for ( const TPair<FChunkCoord, TObjectPtr<AOWGRegionProxyActor>>& Pair : RegionProxyActors )
+	{
+		if ( IsValid( Pair.Value ) )
+		{
+			Pair.Value->Destroy();
+		}
+	}
+	RegionProxyActors.Empty();
+	FarFieldProxyDataCache.Empty();
+	TimeSinceLastFarFieldProxyUpdate = FLT_MAX;
+}
+
+const FOWGRegionProxyData* UOWGServerChunkManager::FindOrLoadFarFieldProxyData( const FChunkCoord& RegionCoord )
+{
+	if ( const TSharedPtr<FOWGRegionProxyData>* CachedRegionProxy = FarFieldProxyDataCache.Find( RegionCoord ) )
+	{
+		return CachedRegionProxy->Get();
+	}
+
+	TSharedPtr<FOWGRegionProxyData> RegionProxy = MakeShared<FOWGRegionProxyData>();
+	if ( !LoadRegionProxyFromFile( RegionCoord, *RegionProxy ) )
+	{
+		RegionProxy.Reset();
+	}
+	FarFieldProxyDataCache.Add( RegionCoord, RegionProxy );
+	return RegionProxy.Get();
+}
+
+bool UOWGServerChunkManager::LoadRegionProxyFromFile( const FChunkCoord& RegionCoord, FOWGRegionProxyData& OutRegionProxy ) const
+{
+	const TUniquePtr<FArchive> RegionProxyReader( IFileManager::Get().CreateFileReader( *GetFilenameForRegionProxy( RegionCoord ), FILEREAD_Silent ) );
+	if ( RegionProxyReader.IsValid() )
+	{
+		OWG_TRACE_CHUNK_SCOPE( LoadRegionProxyFromFile, RegionCoord );
+		return OutRegionProxy.Serialize( *RegionProxyReader );
+	}
+	return false;
+}
+
+void UOWGServerChunkManager::TickChunkDataReplication()
+{
+	// Remote players receive the chunk data through the replication component on their player controller. Local players share the chunks with the server
+	for ( FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It )
+	{
+		APlayerController* PlayerController = It->Get();
+		if ( PlayerController != nullptr && !PlayerController->IsLocalController() && PlayerController->FindComponentByClass<UOWGChunkDataReplicationComponent>() == nullptr )
+		{
+			UOWGChunkDataReplicationComponent* ReplicationComponent = NewObject<UOWGChunkDataReplicationComponent>( PlayerController, TEXT("ChunkDataReplicationComponent") );
+			ReplicationComponent->SetIsReplicated( true );
+			ReplicationComponent->RegisterComponent();
+		}
+	}
+}
+
+void UOWGServerChunkManager::TickChunkMemoryAccounting( float DeltaTime )
+{
+	const float AccountingInterval = FChunkMemoryBudgets::GetAccountingInterval();
+	TimeSinceLastMemoryAccounting += DeltaTime;
+
+	if ( AccountingInterval < 0.0f || TimeSinceLastMemoryAccounting < AccountingInterval )
+	{
+		return;
+	}
+	TimeSinceLastMemoryAccounting = 0.0f;
+	SCOPE_CYCLE_COUNTER( STAT_ChunkMemoryAccounting );
+	OWG_TRACE_SCOPE( UOWGServerChunkManager::TickChunkMemoryAccounting );
+
+	TArray<TPair<AOWGChunk*, FChunkMemoryUsage>> PerChunkMemoryUsage;
+	TotalChunkMemoryUsage = FChunkMemoryUsage();
+
+	for ( const TPair<FChunkCoord, TObjectPtr<UOWGRegionContainer>>& Pair : LoadedRegions )
+	{
+		for ( const FChunkCoord& ChunkCoord : Pair.Value->GetLoadedChunkCoords() )
+		{
+			if ( AOWGChunk* LoadedChunk = Pair.Value->FindChunk( ChunkCoord ) )
+			{
+				const FChunkMemoryUsage ChunkMemoryUsage = LoadedChunk->GetMemoryUsage();
+				TotalChunkMemoryUsage += ChunkMemoryUsage;
+				PerChunkMemoryUsage.Add( { LoadedChunk, ChunkMemoryUsage } );
+			}
+		}
+	}
+	TotalChunkMemoryUsage.UpdateStats();
+
+	// Budgets are not enforced while streaming is frozen since that would result in the chunks being unloaded
+	if ( !CVarFreezeServerChunkStreaming.GetValueOnGameThread() )
+	{
+		EnforceChunkMemoryBudgets( PerChunkMemoryUsage );
+	}
+}
+
+void UOWGServerChunkManager::EnforceChunkMemoryBudgets( const TArray<TPair<AOWGChunk*, FChunkMemoryUsage>>& PerChunkMemoryUsage )
+{
+	if ( UOpenWorldGeneratorSettings::Get()->ChunkMemoryBudgetsMB.IsEmpty() )
+	{
+		MemoryBudgetLODBias = 0;
+		return;
+	}
+
+	// Gather the maximum LOD bias before unloading anything, since the unloaded chunks are destroyed or returned into the pool
+	int32 MaxLODBias = 0;
+	for ( const TPair<AOWGChunk*, FChunkMemoryUsage>& Pair : PerChunkMemoryUsage )
+	{
+		MaxLODBias = FMath::Max( MaxLODBias, Pair.Key->NumChunkLandscapeLODs - 1 );
+	}
+
+	FChunkMemoryUsage RemainingMemoryUsage = TotalChunkMemoryUsage;
+	TArray<AOWGChunk*> ChunksToUnload;
+	FChunkMemoryBudgets::SelectIdleChunksToUnload( PerChunkMemoryUsage, RemainingMemoryUsage, ChunksToUnload );
+
+	for ( AOWGChunk* ChunkToUnload : ChunksToUnload )
+	{
+		const FChunkCoord ChunkCoord = ChunkToUnload->GetChunkCoord();
+		UE_LOG( LogServerChunkManager, Log, TEXT("Unloading idle chunk '%s' at %d,%d early because the chunk memory budget has been exceeded"),
+			*ChunkToUnload->GetName(), ChunkCoord.PosX, ChunkCoord.PosY );
+
+		LoadedRegions.FindChecked( ChunkCoord.ToRegionCoord() )->UnloadChunk( ChunkCoord );
+	}
+
+	// If the rendering memory is still over budget, switch the distant chunks to the coarser LODs
+	MemoryBudgetLODBias = FChunkMemoryBudgets::UpdateLODBias( MemoryBudgetLODBias, MaxLODBias, RemainingMemoryUsage );
+}
+
+void UOWGServerChunkManager::DumpChunkMemoryUsage( int32 NumTopChunks ) const
+{
+	TArray<TPair<const AOWGChunk*, FChunkMemoryUsage>> PerChunkMemoryUsage;
+	FChunkMemoryUsage TotalMemoryUsage;
+
+	for ( const TPair<FChunkCoord, TObjectPtr<UOWGRegionContainer>>& Pair : LoadedRegions )
+	{
+		for ( const FChunkCoord& ChunkCoord : Pair.Value->GetLoadedChunkCoords() )
+		{
+			if ( const AOWGChunk* LoadedChunk = Pair.Value->FindChunk( ChunkCoord ) )
+			{
+				const FChunkMemoryUsage ChunkMemoryUsage = LoadedChunk->GetMemoryUsage();
+				TotalMemoryUsage += ChunkMemoryUsage;
+				PerChunkMemoryUsage.Add( { LoadedChunk, ChunkMemoryUsage } );
+			}
+		}
+	}
+
+	const TMap<EChunkMemoryCategory, float>& MemoryBudgetsMB = UOpenWorldGeneratorSettings::Get()->ChunkMemoryBudgetsMB;
+	UE_LOG( LogServerChunkManager, Display, TEXT("Memory used by %d loaded chunks: %.2fMB (LOD Bias: %d)"), PerChunkMemoryUsage.Num(), TotalMemoryUsage.GetTotal() / ( 1024.0f * 1024.0f ), MemoryBudgetLODBias );
+
+	for ( int32 CategoryIndex = 0; CategoryIndex < FChunkMemoryUsage::NumCategories; CategoryIndex++ )
+	{
+		const EChunkMemoryCategory Category = (EChunkMemoryCategory) CategoryIndex;
+		const float* CategoryBudgetMB = MemoryBudgetsMB.Find( Category );
+
+		UE_LOG( LogServerChunkManager, Display, TEXT("  %s: %.2fMB (Budget: %s)"), *FChunkMemoryUsage::GetCategoryName( Category ),
+			TotalMemoryUsage.Get( Category ) / ( 1024.0f * 1024.0f ), CategoryBudgetMB ? *FString::Printf( TEXT("%.2fMB"), *CategoryBudgetMB ) : TEXT("None") );
+	}
+
+	PerChunkMemoryUsage.Sort( []( const TPair<const AOWGChunk*, FChunkMemoryUsage>& A, const TPair<const AOWGChunk*, FChunkMemoryUsage>& B )
+	{
+		return A.Value.GetTotal() > B.Value.GetTotal();
+	} );
+
+	for ( int32 ChunkIndex = 0; ChunkIndex < FMath::Min( NumTopChunks, PerChunkMemoryUsage.Num() ); ChunkIndex++ )
+	{
+		const AOWGChunk* Chunk = PerChunkMemoryUsage[ ChunkIndex ].Key;
+		const FChunkMemoryUsage& ChunkMemoryUsage = PerChunkMemoryUsage[ ChunkIndex ].Value;
+
+		TArray<FString> MemoryUsageEntries;
+		for ( int32 CategoryIndex = 0; CategoryIndex < FChunkMemoryUsage::NumCategories; CategoryIndex++ )
+		{
+			const EChunkMemoryCategory Category = (EChunkMemoryCategory) CategoryIndex;
+			MemoryUsageEntries.Add( FString::Printf( TEXT("%s: %.2fKB"), *FChunkMemoryUsage::GetCategoryName( Category ), ChunkMemoryUsage.Get( Category ) / 1024.0f ) );
+		}
+		UE_LOG( LogServerChunkManager, Display, TEXT("  Chunk %d,%d (LOD %d): %.2fKB (%s)"), Chunk->GetChunkCoord().PosX, Chunk->GetChunkCoord().PosY, Chunk->GetCurrentChunkLOD(),
+			ChunkMemoryUsage.GetTotal() / 1024.0f, *FString::Join( MemoryUsageEntries, TEXT("; ") ) );
+	}
+}
+
 void UOWGServerChunkManager::RegisterStreamingProvider( const TScriptInterface<IOWGChunkStreamingProvider>& StreamingProvider )
 {
 	if ( StreamingProvider )
@@ -360,6 +759,11 @@ FString UOWGServerChunkManager::GetFilenameForRegionCoord(const FChunkCoord& Reg
 	return FPaths::Combine(RegionFolderLocation, FString::Printf(TEXT("%d_%d.owgr"), RegionCoord.PosX, RegionCoord.PosY));
 }
 
+FString UOWGServerChunkManager::GetFilenameForRegionProxy( const FChunkCoord& RegionCoord ) const
+{
+	return FPaths::Combine( RegionFolderLocation, FString::Printf( TEXT("%d_%d.owgp"), RegionCoord.PosX, RegionCoord.PosY ) );
+}
+
 AOWGChunk* UOWGServerChunkManager::LoadChunk( const FChunkCoord& ChunkCoord )
 {
 	if ( UOWGRegionContainer* RegionContainer = LoadRegionContainerSync( ChunkCoord.ToRegionCoord() ) )
@@ -392,9 +796,24 @@ UOWGRegionContainer* UOWGServerChunkManager::LoadRegionContainerSync(const FChun
 	{
 		if (FArchive* RegionFileReader = IFileManager::Get().CreateFileReader(*RegionFilename))
 		{
+			OWG_TRACE_CHUNK_SCOPE( LoadRegionContainerFromFile, RegionCoord );
 			UOWGRegionContainer* NewRegionContainer = NewObject<UOWGRegionContainer>(this);
 			NewRegionContainer->LoadRegionContainerFromFile(*RegionFileReader);
 
+			// Pick up the far-field proxy of the region, so the chunks that are not loaded keep contributing to it when the region is saved again
+			if ( TSharedPtr<FOWGRegionProxyData> CachedRegionProxy; FarFieldProxyDataCache.RemoveAndCopyValue( RegionCoord, CachedRegionProxy ) && CachedRegionProxy.IsValid() )
+			{
+				NewRegionContainer->SetRegionProxy( MoveTemp( *CachedRegionProxy ) );
+			}
+			else if ( FOWGRegionProxyData::IsFarFieldProxyEnabled() )
+			{
+				FOWGRegionProxyData RegionProxy;
+				if ( LoadRegionProxyFromFile( RegionCoord, RegionProxy ) )
+				{
+					NewRegionContainer->SetRegionProxy( MoveTemp( RegionProxy ) );
+				}
+			}
+
 			LoadedRegions.Add(RegionCoord, NewRegionContainer);
 			UnloadedRegionExistenceCache.Remove(RegionCoord);
 			return NewRegionContainer;
@@ -438,6 +857,100 @@ UOpenWorldGeneratorSubsystem* UOWGServerChunkManager::GetOwnerSubsystem() const
 	return CastChecked<UOpenWorldGeneratorSubsystem>( GetOuter() );
 }
 
+bool UOWGServerChunkManager::UnloadRegionContainer( const FChunkCoord& RegionCoord )
+{
+	const TObjectPtr<UOWGRegionContainer>* RegionContainer = LoadedRegions.Find( RegionCoord );
+	if ( RegionContainer == nullptr )
+	{
+		return false;
+	}
+
+	const TArray<FChunkCoord> LoadedChunkCoords = ( *RegionContainer )->GetLoadedChunkCoords();
+	for ( const FChunkCoord& ChunkCoord : LoadedChunkCoords )
+	{
+		const AOWGChunk* LoadedChunk = ( *RegionContainer )->FindChunk( ChunkCoord );
+		if ( LoadedChunk && LoadedChunk->ShouldDeferChunkUnloading() )
+		{
+			return false;
+		}
+	}
+	for ( const FChunkCoord& ChunkCoord : LoadedChunkCoords )
+	{
+		( *RegionContainer )->UnloadChunk( ChunkCoord );
+	}
+
+	// Keep the region loaded if it could not be written, otherwise the chunks that have just been unloaded would be lost
+	if ( !SaveRegionContainer( RegionCoord ) )
+	{
+		return false;
+	}
+	LoadedRegions.Remove( RegionCoord );
+	return true;
+}
+
+AOWGChunk* UOWGServerChunkManager::ReloadChunk( const FChunkCoord& ChunkCoord )
+{
+	if ( TObjectPtr<UOWGRegionContainer> const* RegionContainer = LoadedRegions.Find( ChunkCoord.ToRegionCoord() ) )
+	{
+		if ( ( *RegionContainer )->FindChunk( ChunkCoord ) != nullptr )
+		{
+			( *RegionContainer )->UnloadChunk( ChunkCoord );
+			return ( *RegionContainer )->LoadChunk( ChunkCoord );
+		}
+	}
+	return nullptr;
+}
+
+bool UOWGServerChunkManager::CanReleaseChunkToPool() const
+{
+	return PooledChunks.Num() < UOpenWorldGeneratorSettings::Get()->MaxPooledChunkActors;
+}
+
+void UOWGServerChunkManager::ReleaseChunkToPool( AOWGChunk* Chunk )
+{
+	check( IsValid( Chunk ) && !Chunk->IsChunkPooled() );
+
+	ChunksPendingGeneration.Remove( Chunk );
+	Chunk->ResetChunkForPooling();
+
+	PooledChunks.Add( Chunk );
+	INC_DWORD_STAT( STAT_PooledChunkActors );
+}
+
+AOWGChunk* UOWGServerChunkManager::AcquirePooledChunk( const UClass* ChunkClass, FName ChunkName )
+{
+	for ( int32 PooledChunkIndex = PooledChunks.Num() - 1; PooledChunkIndex >= 0; PooledChunkIndex-- )
+	{
+		AOWGChunk* PooledChunk = PooledChunks[ PooledChunkIndex ];
+
+		// Pooled chunks might have been destroyed by the outside code, in which case we just drop them
+		if ( !IsValid( PooledChunk ) )
+		{
+			PooledChunks.RemoveAtSwap( PooledChunkIndex );
+			DEC_DWORD_STAT( STAT_PooledChunkActors );
+			continue;
+		}
+		if ( PooledChunk->GetClass() == ChunkClass )
+		{
+			PooledChunks.RemoveAtSwap( PooledChunkIndex );
+			DEC_DWORD_STAT( STAT_PooledChunkActors );
+
+			// Rename the chunk so it's name matches the new chunk coordinate. The name might still be taken by another pooled chunk, in which case we need to make it unique like spawning would
+			if ( ChunkName != NAME_None && PooledChunk->GetFName() != ChunkName )
+			{
+				UObject* ChunkOuter = PooledChunk->GetOuter();
+				if ( StaticFindObjectFast( nullptr, ChunkOuter, ChunkName ) != nullptr )
+				{
+					ChunkName = MakeUniqueObjectName( ChunkOuter, ChunkClass, ChunkName );
+				}
+				PooledChunk->Rename( *ChunkName.ToString(), nullptr, REN_DontCreateRedirectors | REN_NonTransactional | REN_DoNotDirty | REN_ForceNoResetLoaders );
+			}
+			return PooledChunk;
+		}
+	}
+	return nullptr;
+}
+
 void UOWGServerChunkManager::SetRegionFolderPath(const FString& InRegionFolderPath)
 {
 	RegionFolderLocation = InRegionFolderPath;
@@ -1,6 +1,126 @@
 ﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
 
 #include "Partition/TerraformingBrush.h"
+#include "Math/VectorRegister.h"
+
+DECLARE_CYCLE_STAT( TEXT("Terraforming Brush Render"), STAT_TerraformingBrushRender, STATGROUP_Game );
+DECLARE_DWORD_COUNTER_STAT( TEXT("Terraforming Brush Stamp Cache Hits"), STAT_TerraformingBrushStampCacheHits, STATGROUP_Game );
+DECLARE_DWORD_COUNTER_STAT( TEXT("Terraforming Brush Stamp Cache Misses"), STAT_TerraformingBrushStampCacheMisses, STATGROUP_Game );
+
+static TAutoConsoleVariable CVarBrushStampCacheSize(
+	TEXT("owg.BrushStampCacheSize"),
+	32,
+	TEXT("Maximum number of rendered terraforming brushes to keep in the stamp cache. 0 disables the cache"),
+	FConsoleVariableDelegate::CreateLambda( []( IConsoleVariable* ) { FTerraformingBrushStampCache::Get().Reset(); } ),
+	ECVF_Default
+);
+
+static TAutoConsoleVariable CVarBrushStampOffsetSteps(
+	TEXT("owg.BrushStampOffsetSteps"),
+	16,
+	TEXT("Number of steps per grid cell the placement of the terraforming brushes relative to the grid is snapped to when the stamp cache is enabled. Brushes placed within the same step share the stamp cache entry. Higher values place the brushes more precisely, but reduce the cache hit rate"),
+	FConsoleVariableDelegate::CreateLambda( []( IConsoleVariable* ) { FTerraformingBrushStampCache::Get().Reset(); } ),
+	ECVF_Default
+);
+
+namespace TerraformingBrushInternal
+{
+	enum class EBrushShape : uint8
+	{
+		Box,
+		Ellipse
+	};
+
+	/**
+	 * Calculates the normalized distance from the brush center for each of the grid points, row by row and 4 points at a time.
+	 * Distance is 0 at the center of the brush and 1 at it's border, points outside of the brush are assigned a negative distance.
+	 */
+	static void RasterizeBrushDistances( EBrushShape BrushShape, const FVector2f& Extents, const FTransform2f& GridToLocal, int32 GridWidth, int32 GridHeight, TArray<float>& OutDistances )
+	{
+		OutDistances.SetNumUninitialized( GridWidth * GridHeight );
+
+		// Grid to local transform is affine, so the local position of each next point is obtained by adding a constant step to the previous one
+		const FVector2f GridOriginLocal = GridToLocal.TransformPoint( FVector2f::ZeroVector );
+		const FVector2f StepXLocal = GridToLocal.TransformPoint( FVector2f( 1.0f, 0.0f ) ) - GridOriginLocal;
+		const FVector2f StepYLocal = GridToLocal.TransformPoint( FVector2f( 0.0f, 1.0f ) ) - GridOriginLocal;
+
+		const VectorRegister4Float LaneIndices = MakeVectorRegisterFloat( 0.0f, 1.0f, 2.0f, 3.0f );
+		const VectorRegister4Float StepXLocalX = VectorSetFloat1( StepXLocal.X );
+		const VectorRegister4Float StepXLocalY = VectorSetFloat1( StepXLocal.Y );
+		const VectorRegister4Float ExtentsX = VectorSetFloat1( Extents.X );
+		const VectorRegister4Float ExtentsY = VectorSetFloat1( Extents.Y );
+		const VectorRegister4Float OutsideDistance = VectorSetFloat1( -1.0f );
+
+		for ( int32 GridY = 0; GridY < GridHeight; GridY++ )
+		{
+			const FVector2f RowStartLocal = GridOriginLocal + StepYLocal * GridY;
+			const VectorRegister4Float RowStartLocalX = VectorSetFloat1( RowStartLocal.X );
+			const VectorRegister4Float RowStartLocalY = VectorSetFloat1( RowStartLocal.Y );
+			float* RowDistances = OutDistances.GetData() + GridWidth * GridY;
+
+			int32 GridX = 0;
+			for ( ; GridX + 4 <= GridWidth; GridX += 4 )
+			{
+				const VectorRegister4Float PointIndices = VectorAdd( VectorSetFloat1( GridX ), LaneIndices );
+				const VectorRegister4Float NormalizedX = VectorDivide( VectorMultiplyAdd( PointIndices, StepXLocalX, RowStartLocalX ), ExtentsX );
+				const VectorRegister4Float NormalizedY = VectorDivide( VectorMultiplyAdd( PointIndices, StepXLocalY, RowStartLocalY ), ExtentsY );
+
+				VectorRegister4Float Distance;
+				if ( BrushShape == EBrushShape::Box )
+				{
+					Distance = VectorMax( VectorAbs( NormalizedX ), VectorAbs( NormalizedY ) );
+				}
+				else
+				{
+					Distance = VectorMultiplyAdd( NormalizedX, NormalizedX, VectorMultiply( NormalizedY, NormalizedY ) );
+				}
+				const VectorRegister4Float InsideMask = VectorCompareLE( Distance, GlobalVectorConstants::FloatOne );
+				VectorStore( VectorSelect( InsideMask, Distance, OutsideDistance ), RowDistances + GridX );
+			}
+
+			// Process the remainder of the row that does not fit into the vector width
+			for ( ; GridX < GridWidth; GridX++ )
+			{
+				const FVector2f LocalPos = RowStartLocal + StepXLocal * GridX;
+				const FVector2f NormalizedPos( LocalPos.X / Extents.X, LocalPos.Y / Extents.Y );
+
+				const float Distance = BrushShape == EBrushShape::Box ?
+					FMath::Max( FMath::Abs( NormalizedPos.X ), FMath::Abs( NormalizedPos.Y ) ) :
+					FMath::Square( NormalizedPos.X ) + FMath::Square( NormalizedPos.Y );
+				RowDistances[ GridX ] = Distance <= 1.0f ? Distance : -1.0f;
+			}
+		}
+	}
+
+	/** Converts the rasterized distances into the brush weights */
+	static void ApplyBrushFalloff( const FTerraformingBrushFalloffSettings& FalloffSettings, const TArray<float>& Distances, int32 GridWidth, int32 GridHeight, TArray<float>& OutWeights )
+	{
+		const FTerraformingBrushFalloffHelper FalloffHelper( FalloffSettings );
+
+		// Points are visited column by column because random falloff consumes the random stream in that order, and should produce the same pattern for the same seed
+		for ( int32 GridX = 0; GridX < GridWidth; GridX++ )
+		{
+			for ( int32 GridY = 0; GridY < GridHeight; GridY++ )
+			{
+				const float Distance = Distances[ GridWidth * GridY + GridX ];
+				if ( Distance >= 0.0f )
+				{
+					OutWeights[ GridWidth * GridY + GridX ] = FalloffHelper.Apply( Distance, 1.0f );
+				}
+			}
+		}
+	}
+}
+
+uint32 GetTypeHash( const FTerraformingBrushFalloffSettings& Settings )
+{
+	uint32 ResultHash = GetTypeHash( Settings.FalloffStart );
+	ResultHash = HashCombine( ResultHash, GetTypeHash( Settings.FalloffExponent ) );
+	ResultHash = HashCombine( ResultHash, GetTypeHash( Settings.RandomFalloffDistanceScale ) );
+	ResultHash = HashCombine( ResultHash, GetTypeHash( Settings.RandomFalloffChance ) );
+	ResultHash = HashCombine( ResultHash, GetTypeHash( Settings.RandomFalloffSeed ) );
+	return ResultHash;
+}
 
 FTerraformingBrushFalloffHelper::FTerraformingBrushFalloffHelper( const FTerraformingBrushFalloffSettings& InSettings ) : Settings( &InSettings )
 {
@@ -84,6 +204,48 @@ const FTerraformingBrush* FPolymorphicTerraformingBrush::operator->() const
 	return &EmptyBrush;
 }
 
+const UScriptStruct* FPolymorphicTerraformingBrush::GetBrushStruct() const
+{
+	return InnerBrush->IsValid() ? CastChecked<UScriptStruct>( InnerBrush->GetStruct() ) : nullptr;
+}
+
+void FPolymorphicTerraformingBrush::RenderBrushToSizedGrid( const FVector2f& Origin, float GridOriginOffset, float GridCellSize, FIntPoint& OutGridPosXY, FIntVector2& OutGridSizeXY, TArray<float>& OutWeights, FBox2f* OutBrushBounds ) const
+{
+	const FTerraformingBrush* Brush = operator->();
+
+	FVector2f GridOffset;
+	FBox2f BrushBounds;
+	Brush->CalculateSizedGridPlacement( Origin, GridOriginOffset, GridCellSize, OutGridPosXY, OutGridSizeXY, GridOffset, BrushBounds );
+	if ( OutBrushBounds )
+	{
+		*OutBrushBounds = BrushBounds;
+	}
+
+	// Render the brush with the exact placement if the stamp cache is disabled
+	if ( !FTerraformingBrushStampCache::IsEnabled() )
+	{
+		OutWeights.Reset();
+		OutWeights.SetNumZeroed( OutGridSizeXY.X * OutGridSizeXY.Y );
+		Brush->RenderBrushToPlacedGrid( GridOffset, GridCellSize, OutGridSizeXY, OutWeights );
+		return;
+	}
+
+	// Snap the placement of the brush relative to the grid, so the brushes applied at nearby locations share the cache entry.
+	// Brush is rendered with the snapped placement on a cache miss too, so the result does not depend on whenever the stamp has been cached or not
+	FTerraformingBrushStampCache& StampCache = FTerraformingBrushStampCache::Get();
+	const FIntPoint QuantizedGridOffset = FTerraformingBrushStampCache::QuantizeGridOffset( GridCellSize, GridOffset );
+	const uint32 BrushHash = Brush->GetRenderStateHash();
+
+	if ( !StampCache.FindStamp( *this, BrushHash, GridCellSize, QuantizedGridOffset, OutGridSizeXY, OutWeights ) )
+	{
+		OutWeights.Reset();
+		OutWeights.SetNumZeroed( OutGridSizeXY.X * OutGridSizeXY.Y );
+		Brush->RenderBrushToPlacedGrid( GridOffset, GridCellSize, OutGridSizeXY, OutWeights );
+
+		StampCache.AddStamp( *this, BrushHash, GridCellSize, QuantizedGridOffset, OutGridSizeXY, OutWeights );
+	}
+}
+
 FIntPoint FTerraformingPrecision::CalculateGridSize( const FVector2f& BrushExtents ) const
 {
 	if ( bIsFixedGridResolution || FMath::IsNearlyZero( GridResolution ) )
@@ -103,10 +265,23 @@ FVector2f FTerraformingBrush::GetBrushExtents() const
 
 void FTerraformingBrush::RenderBrushToSizedGrid( const FVector2f& Origin, float GridOriginOffset, float GridCellSize, FIntPoint& OutGridPosXY, FIntVector2& OutGridSizeXY, TArray<float>& OutWeights, FBox2f* OutBrushBounds ) const
 {
-	const FTransform2f BrushTransform = FTransform2f( FMatrix2x2f( FQuat2f( FMath::DegreesToRadians( Rotation ) ) ).Concatenate( FMatrix2x2f( Scale ) ) );
+	FVector2f GridOffset;
+	FBox2f BrushBounds;
+	CalculateSizedGridPlacement( Origin, GridOriginOffset, GridCellSize, OutGridPosXY, OutGridSizeXY, GridOffset, BrushBounds );
+
+	OutWeights.Reset();
+	OutWeights.SetNumZeroed( OutGridSizeXY.X * OutGridSizeXY.Y );
+	if ( OutBrushBounds )
+	{
+		*OutBrushBounds = BrushBounds;
+	}
+	RenderBrushToPlacedGrid( GridOffset, GridCellSize, OutGridSizeXY, OutWeights );
+}
 
+void FTerraformingBrush::CalculateSizedGridPlacement( const FVector2f& Origin, float GridOriginOffset, float GridCellSize, FIntPoint& OutGridPosXY, FIntVector2& OutGridSizeXY, FVector2f& OutGridOffset, FBox2f& OutBrushBounds ) const
+{
 	// We take the largest extent across the X/Y axis because extents per axis cannot be trusted when rotation is involved
-	const FVector2f BrushExtents = FVector2f( BrushTransform.TransformVector( GetRawExtents() ).GetAbsMax() );
+	const FVector2f BrushExtents = GetBrushExtents();
 	const FBox2f BrushBounds( Origin - BrushExtents, Origin + BrushExtents );
 
 	const int32 GridStartX = FMath::FloorToInt32( ( BrushBounds.Min.X + GridOriginOffset ) / GridCellSize );
@@ -117,19 +292,27 @@ void FTerraformingBrush::RenderBrushToSizedGrid( const FVector2f& Origin, float
 
 	OutGridPosXY = FIntPoint( GridStartX, GridStartY );
 	OutGridSizeXY = FIntVector2( GridEndX - GridStartX + 1, GridEndY - GridStartY + 1 );
-	OutWeights.SetNumZeroed( OutGridSizeXY.X * OutGridSizeXY.Y );
-	if ( OutBrushBounds )
-	{
-		*OutBrushBounds = BrushBounds;
-	} 
+	OutBrushBounds = BrushBounds;
+
+	// Offset of the grid start in world units from the brush origin
+	OutGridOffset = FVector2f( GridStartX * GridCellSize, GridStartY * GridCellSize ) - FVector2f( GridOriginOffset ) - Origin;
+}
 
-	// Scale and translate from grid size to world units and offset it by grid start in world units, and then by grid origin in world space.
-	// Then, translate to the local origin by subtracting it from the world origin
+void FTerraformingBrush::RenderBrushToPlacedGrid( const FVector2f& GridOffset, float GridCellSize, const FIntVector2& GridSizeXY, TArray<float>& OutWeights ) const
+{
+	SCOPE_CYCLE_COUNTER( STAT_TerraformingBrushRender );
+	const FTransform2f BrushTransform = FTransform2f( FMatrix2x2f( FQuat2f( FMath::DegreesToRadians( Rotation ) ) ).Concatenate( FMatrix2x2f( Scale ) ) );
+
+	// Scale and translate from grid size to world units and offset it by grid start relative to the brush origin
 	// Then apply the inverse of brush transform to translate it from brush extents to original brush coordinates that are unscaled and un-rotated
-	const FTransform2f InverseBrushGridTransform = FTransform2f( FScale2f( GridCellSize ), FVector2f( GridStartX * GridCellSize, GridStartY * GridCellSize ) - FVector2f( GridOriginOffset ) - Origin )
-		.Concatenate( BrushTransform.Inverse() );
+	const FTransform2f InverseBrushGridTransform = FTransform2f( FScale2f( GridCellSize ), GridOffset ).Concatenate( BrushTransform.Inverse() );
 
-	RenderBrush( InverseBrushGridTransform, OutGridSizeXY.X, OutGridSizeXY.Y, OutWeights );
+	RenderBrush( InverseBrushGridTransform, GridSizeXY.X, GridSizeXY.Y, OutWeights );
+}
+
+uint32 FTerraformingBrush::GetRenderStateHash() const
+{
+	return HashCombine( GetTypeHash( Rotation ), GetTypeHash( Scale ) );
 }
 
 void FTerraformingBrush::RenderBrushToGrid( const FVector2f& GridOrigin, const FTerraformingPrecision& GridPrecision, FIntPoint& OutGridSize, TArray<float>& OutWeights, FVector2f& OutWorldExtents, FTransform2f& OutGridToWorld ) const
@@ -183,25 +366,18 @@ bool FBoxTerraformingBrush::RenderBrush( const FTransform2f& GridToLocal, int32
 		return false;
 	}
 
-	const FTerraformingBrushFalloffHelper FalloffHelper( FalloffSettings );
-
-	// Map grid coords to local coords and do checks
-	for ( int32 GridX = 0; GridX < GridWidth; GridX++ )
-	{
-		for ( int32 GridY = 0; GridY < GridHeight; GridY++ )
-		{
-			// Points inside of the box are below it's absolute extents on both axi
-			const FVector2f LocalPos = GridToLocal.TransformPoint( FVector2f( GridX, GridY ) );
-			if ( FMath::Abs( LocalPos.X ) <= Extents.X && FMath::Abs( LocalPos.Y ) <= Extents.Y )
-			{
-            	const float Distance = FMath::Max( FMath::Abs( LocalPos.X ) / Extents.X, FMath::Abs( LocalPos.Y ) / Extents.Y );
-				OutWeights[ GridWidth * GridY + GridX ] = FalloffHelper.Apply( Distance, 1.0f );
-			}
-		}
-	}
+	// Points inside of the box are below it's absolute extents on both axi
+	TArray<float> PointDistances;
+	TerraformingBrushInternal::RasterizeBrushDistances( TerraformingBrushInternal::EBrushShape::Box, Extents, GridToLocal, GridWidth, GridHeight, PointDistances );
+	TerraformingBrushInternal::ApplyBrushFalloff( FalloffSettings, PointDistances, GridWidth, GridHeight, OutWeights );
 	return true;
 }
 
+uint32 FBoxTerraformingBrush::GetRenderStateHash() const
+{
+	return HashCombine( HashCombine( Super::GetRenderStateHash(), GetTypeHash( Extents ) ), GetTypeHash( FalloffSettings ) );
+}
+
 FVector2f FEllipseTerraformingBrush::GetRawExtents() const
 {
 	return Extents;
@@ -215,21 +391,95 @@ bool FEllipseTerraformingBrush::RenderBrush( const FTransform2f& GridToLocal, in
 		return false;
 	}
 
-	const FTerraformingBrushFalloffHelper FalloffHelper( FalloffSettings );
+	// Points inside of the ellipse have the coefficient of 1 and below
+	TArray<float> PointDistances;
+	TerraformingBrushInternal::RasterizeBrushDistances( TerraformingBrushInternal::EBrushShape::Ellipse, Extents, GridToLocal, GridWidth, GridHeight, PointDistances );
+	TerraformingBrushInternal::ApplyBrushFalloff( FalloffSettings, PointDistances, GridWidth, GridHeight, OutWeights );
+	return true;
+}
+
+uint32 FEllipseTerraformingBrush::GetRenderStateHash() const
+{
+	return HashCombine( HashCombine( Super::GetRenderStateHash(), GetTypeHash( Extents ) ), GetTypeHash( FalloffSettings ) );
+}
+
+FTerraformingBrushStampCache& FTerraformingBrushStampCache::Get()
+{
+	static FTerraformingBrushStampCache StampCache;
+	return StampCache;
+}
+
+bool FTerraformingBrushStampCache::IsEnabled()
+{
+	return CVarBrushStampCacheSize.GetValueOnAnyThread() > 0;
+}
+
+FIntPoint FTerraformingBrushStampCache::QuantizeGridOffset( float GridCellSize, FVector2f& InOutGridOffset )
+{
+	const float StepSize = GridCellSize / FMath::Max( CVarBrushStampOffsetSteps.GetValueOnAnyThread(), 1 );
+	const FIntPoint QuantizedGridOffset( FMath::RoundToInt32( InOutGridOffset.X / StepSize ), FMath::RoundToInt32( InOutGridOffset.Y / StepSize ) );
+
+	InOutGridOffset = FVector2f( QuantizedGridOffset.X * StepSize, QuantizedGridOffset.Y * StepSize );
+	return QuantizedGridOffset;
+}
+
+bool FTerraformingBrushStampCache::FindStamp( const FPolymorphicTerraformingBrush& Brush, uint32 BrushHash, float GridCellSize, const FIntPoint& QuantizedGridOffset, const FIntVector2& GridSizeXY, TArray<float>& OutWeights )
+{
+	FScopeLock ScopeLock( &CacheCriticalSection );
+
+	for ( FStampEntry& Entry : Entries )
+	{
+		// Compare the cheap parts of the key first, and only do the full brush comparison if all of them match
+		if ( Entry.BrushHash == BrushHash && Entry.GridCellSize == GridCellSize && Entry.QuantizedGridOffset == QuantizedGridOffset && Entry.GridSizeXY == GridSizeXY &&
+			Entry.Brush.GetBrushStruct() == Brush.GetBrushStruct() && Entry.Brush.Identical( &Brush, PPF_None ) )
+		{
+			Entry.LastUsedCounter = ++UsageCounter;
+			OutWeights = Entry.Weights;
+			INC_DWORD_STAT( STAT_TerraformingBrushStampCacheHits );
+			return true;
+		}
+	}
+	INC_DWORD_STAT( STAT_TerraformingBrushStampCacheMisses );
+	return false;
+}
+
+void FTerraformingBrushStampCache::AddStamp( const FPolymorphicTerraformingBrush& Brush, uint32 BrushHash, float GridCellSize, const FIntPoint& QuantizedGridOffset, const FIntVector2& GridSizeXY, const TArray<float>& Weights )
+{
+	const int32 MaxCacheSize = CVarBrushStampCacheSize.GetValueOnAnyThread();
+	FScopeLock ScopeLock( &CacheCriticalSection );
 
-	// Map grid coords to local coords and do checks
-	for ( int32 GridX = 0; GridX < GridWidth; GridX++ )
+	if ( MaxCacheSize <= 0 )
 	{
-		for ( int32 GridY = 0; GridY < GridHeight; GridY++ )
+		Entries.Empty();
+		return;
+	}
+
+	// Evict least recently used entries until we have space for the new one
+	while ( Entries.Num() >= MaxCacheSize )
+	{
+		int32 LeastRecentlyUsedIndex = 0;
+		for ( int32 EntryIndex = 1; EntryIndex < Entries.Num(); EntryIndex++ )
 		{
-			// Points inside of the ellipse have the coefficient of 1 and below
-			const FVector2f LocalPos = GridToLocal.TransformPoint( FVector2f( GridX, GridY ) );
-			const float Coefficient = FMath::Square( LocalPos.X / Extents.X ) + FMath::Square( LocalPos.Y / Extents.Y );
-			if ( Coefficient <= 1.0f )
+			if ( Entries[ EntryIndex ].LastUsedCounter < Entries[ LeastRecentlyUsedIndex ].LastUsedCounter )
 			{
-				OutWeights[ GridWidth * GridY + GridX ] = FalloffHelper.Apply( Coefficient, 1.0f );
+				LeastRecentlyUsedIndex = EntryIndex;
 			}
 		}
+		Entries.RemoveAtSwap( LeastRecentlyUsedIndex );
 	}
-	return true;
+
+	FStampEntry& NewEntry = Entries.AddDefaulted_GetRef();
+	NewEntry.Brush = Brush;
+	NewEntry.BrushHash = BrushHash;
+	NewEntry.GridCellSize = GridCellSize;
+	NewEntry.QuantizedGridOffset = QuantizedGridOffset;
+	NewEntry.GridSizeXY = GridSizeXY;
+	NewEntry.Weights = Weights;
+	NewEntry.LastUsedCounter = ++UsageCounter;
+}
+
+void FTerraformingBrushStampCache::Reset()
+{
+	FScopeLock ScopeLock( &CacheCriticalSection );
+	Entries.Empty();
 }
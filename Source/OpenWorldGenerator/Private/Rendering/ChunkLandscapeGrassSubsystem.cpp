@@ -2,12 +2,14 @@
 
 #include "Rendering/ChunkLandscapeGrassSubsystem.h"
 #include "OpenWorldGeneratorSubsystem.h"
+#include "OWGTrace.h"
 #include "Engine/GameInstance.h"
 #include "Engine/InstancedStaticMesh.h"
 #include "Engine/StaticMesh.h"
 #include "Engine/World.h"
 #include "Math/Halton.h"
 #include "Partition/ChunkCoord.h"
+#include "Partition/ChunkLandscapeWeight.h"
 #include "Partition/OWGChunk.h"
 #include "Partition/OWGChunkManagerInterface.h"
 #include "Rendering/OWGChunkLandscapeLayer.h"
@@ -150,12 +152,32 @@ void UChunkLandscapeGrassSubsystem::AddReferencedObjects( UObject* InThis, FRefe
 	}
 }
 
+SIZE_T UChunkLandscapeGrassSubsystem::GetChunkGrassAllocatedSize( const FChunkCoord& ChunkCoord ) const
+{
+	SIZE_T AllocatedSize = 0;
+	if ( const FChunkLandscapeGrassData* ChunkGrassData = PerChunkComponents.Find( ChunkCoord ) )
+	{
+		for ( const TPair<TObjectPtr<UOWGChunkLandscapeLayer>, TArray<FChunkGrassMeshComponentData>>& Pair : ChunkGrassData->GrassStaticMeshComponents )
+		{
+			for ( const FChunkGrassMeshComponentData& ComponentData : Pair.Value )
+			{
+				if ( ComponentData.StaticMeshComponent )
+				{
+					AllocatedSize += ComponentData.StaticMeshComponent->GetResourceSizeBytes( EResourceSizeMode::Exclusive );
+				}
+			}
+		}
+	}
+	return AllocatedSize;
+}
+
 void UChunkLandscapeGrassSubsystem::UpdateChunkGrass( const TArray<FVector>& InCameraLocations )
 {
 	const UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = UOpenWorldGeneratorSubsystem::Get( GetWorld() );
 	if ( !OpenWorldGeneratorSubsystem ) return;
 
 	const TScriptInterface<IOWGChunkManagerInterface> ChunkManager = OpenWorldGeneratorSubsystem->GetChunkManager();
+	if ( !ChunkManager ) return;
 
 	const float LandscapeGrassRenderDistance = CVarChunkGrassBuildDistance.GetValueOnGameThread() * CVarChunkGrassCullDistanceScale.GetValueOnGameThread();
 	const float LandscapeGrassDensityScale = CVarChunkGrassDensityScale.GetValueOnGameThread();
@@ -318,6 +340,7 @@ void UChunkLandscapeGrassSubsystem::CleanupStaleChunkGrass()
 	if ( !OpenWorldGeneratorSubsystem ) return;
 
 	const TScriptInterface<IOWGChunkManagerInterface> ChunkManager = OpenWorldGeneratorSubsystem->GetChunkManager();
+	if ( !ChunkManager ) return;
 
 	const float DestroyTimeoutSeconds = CVarChunkGrassDestroyTimeout.GetValueOnGameThread();
 	const float WorldTimeSeconds = GetWorld()->TimeSeconds;
@@ -333,20 +356,28 @@ void UChunkLandscapeGrassSubsystem::CleanupStaleChunkGrass()
 		if ( LoadedChunk == nullptr || !LoadedChunk->IsChunkInitialized() || LoadedChunk->IsPendingToBeUnloaded() || bGrassDisabled ||
 			PerChunkComponents.FindChecked( ChunkCoord ).LastTimeUsed + DestroyTimeoutSeconds <= WorldTimeSeconds )
 		{
-			FChunkLandscapeGrassData ChunkLandscapeGrassData;
-			PerChunkComponents.RemoveAndCopyValue( ChunkCoord, ChunkLandscapeGrassData );
+			DestroyChunkGrass( ChunkCoord );
+		}
+	}
+}
 
-			for ( TPair<TObjectPtr<UOWGChunkLandscapeLayer>, TArray<FChunkGrassMeshComponentData>>& Pair : ChunkLandscapeGrassData.GrassStaticMeshComponents )
-			{
-				for ( FChunkGrassMeshComponentData& MeshComponentData : Pair.Value )
-				{
-					MeshComponentData.StaticMeshComponent->DestroyComponent();
-					MeshComponentData.StaticMeshComponent = nullptr;
-				}
-			}
-			ChunkLandscapeGrassData.ChunkUnloadedCounter->Increment();
+void UChunkLandscapeGrassSubsystem::DestroyChunkGrass( const FChunkCoord& ChunkCoord )
+{
+	FChunkLandscapeGrassData ChunkLandscapeGrassData;
+	if ( !PerChunkComponents.RemoveAndCopyValue( ChunkCoord, ChunkLandscapeGrassData ) )
+	{
+		return;
+	}
+
+	for ( TPair<TObjectPtr<UOWGChunkLandscapeLayer>, TArray<FChunkGrassMeshComponentData>>& Pair : ChunkLandscapeGrassData.GrassStaticMeshComponents )
+	{
+		for ( FChunkGrassMeshComponentData& MeshComponentData : Pair.Value )
+		{
+			MeshComponentData.StaticMeshComponent->DestroyComponent();
+			MeshComponentData.StaticMeshComponent = nullptr;
 		}
 	}
+	ChunkLandscapeGrassData.ChunkUnloadedCounter->Increment();
 }
 
 // Mostly copied from LandscapeGrass.cpp
@@ -402,6 +433,8 @@ FChunkLandscapeGrassBuildTask::FChunkLandscapeGrassBuildTask( const FChunkGrassM
 	ChunkWeightIndex = PendingRebuildData->ChunkWeightIndex;
 	GrassVariety = PendingRebuildData->GrassVariety;
 	ChunkGrassSourceData = PendingRebuildData->PendingRebuildSourceData;
+	HeightMapView = TChunkData2DView<const float>( ChunkGrassSourceData->HeightMapData );
+	NormalMapView = TChunkData2DView<const FVector3f>( ChunkGrassSourceData->NormalMapData );
 	HaltonBaseIndex = PendingRebuildData->BaseHamiltonIndex;
 	LocalToComponentRelative = ChunkGrassSourceData->ChunkToWorld.ToMatrixNoScale() * PendingRebuildData->StaticMeshComponent->GetComponentTransform().ToMatrixWithScale().Inverse();
 	DesiredInstancesPerLeaf = PendingRebuildData->StaticMeshComponent->DesiredInstancesPerLeaf();
@@ -426,6 +459,8 @@ int32 FChunkLandscapeGrassBuildTask::CalculateMaxInstancesSqrt( const FOWGLandsc
 
 void FChunkLandscapeGrassBuildTask::DoWork()
 {
+	OWG_TRACE_CHUNK_SCOPE_INDEX( GrassBuildTask, ChunkCoord, GrassVarietyIndex );
+
 	double StartTime = FPlatformTime::Seconds();
 	const bool bUsingRandomScale = IsUsingRandomScale();
 	const FVector DefaultScale = GetDefaultScale();
@@ -621,6 +656,7 @@ void FChunkLandscapeGrassBuildTask::CompleteOnGameThread( FChunkGrassMeshCompone
 			if ( NumBuiltInstances > 0)
 			{
 				SCOPE_CYCLE_COUNTER( STAT_ChunkLandscapeGrassAcceptPrebuiltTree );
+				OWG_TRACE_CHUNK_SCOPE( GrassAcceptPrebuiltTree, ChunkCoord );
 				UGrassInstancedStaticMeshComponent* GrassMeshComponent = FinishedRebuildData->StaticMeshComponent;
 
 				GrassMeshComponent->AcceptPrebuiltTree(ClusterTree, OutOcclusionLayerNum, NumBuiltInstances, &InstanceBuffer);
@@ -644,15 +680,14 @@ void FChunkLandscapeGrassBuildTask::SampleLandscapeAtLocationLocal( const FVecto
 {
 	const FVector2f UnitLocation = FChunkData2D::ChunkLocalPositionToNormalized( InLocation );
 	
-	const float Height = ChunkGrassSourceData->HeightMapData.GetInterpolatedElementAt<float>( UnitLocation );
+	const float Height = HeightMapView.GetInterpolatedElementAt( UnitLocation );
 	OutLocation = FVector( InLocation.X, InLocation.Y, Height );
 
-	const FChunkLandscapeWeight Weight = ChunkGrassSourceData->WeightMapData.GetInterpolatedElementAt<FChunkLandscapeWeight>( UnitLocation );
-	OutLayerWeight = Weight.GetNormalizedWeight( ChunkWeightIndex );
+	OutLayerWeight = FChunkLandscapeWeightSampler::SampleNormalizedWeight( ChunkGrassSourceData->WeightMapData, UnitLocation, ChunkWeightIndex );
 
 	if ( OutNormal )
 	{
-		const FVector3f Normal = ChunkGrassSourceData->NormalMapData.GetInterpolatedElementAt<FVector3f>( UnitLocation );
+		const FVector3f Normal = NormalMapView.GetInterpolatedElementAt( UnitLocation );
 		*OutNormal = FVector( Normal );
 	}
 }
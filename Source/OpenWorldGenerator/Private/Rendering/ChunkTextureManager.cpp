@@ -1,146 +1,431 @@
 ﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
 
 #include "Rendering/ChunkTextureManager.h"
+#include "Engine/Texture2DDynamic.h"
+#include "Materials/MaterialInstanceDynamic.h"
 #include "Partition/ChunkData2D.h"
 #include "Partition/ChunkLandscapeWeight.h"
+#include "RHICommandList.h"
 #include "TextureResource.h"
 
 DECLARE_CYCLE_STAT( TEXT("Chunk Weight Map Texture Update"), STAT_ChunkWeightMapTextureUpdate, STATGROUP_Game );
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT("Chunk Weight Map Atlas Slices Allocated"), STAT_ChunkWeightMapAtlasSlicesAllocated, STATGROUP_Game );
+DECLARE_MEMORY_STAT( TEXT("Chunk Weight Map Staging Memory"), STAT_ChunkWeightMapStagingMemory, STATGROUP_Game );
+DECLARE_DWORD_ACCUMULATOR_STAT( TEXT("Shared Landscape Material Instances"), STAT_SharedLandscapeMaterialInstances, STATGROUP_Game );
 
-UChunkTextureManager::UChunkTextureManager()
+static TAutoConsoleVariable CVarWeightMapAtlasSlices(
+	TEXT("owg.WeightMapAtlasSlices"),
+	64,
+	TEXT("Number of slices in each weight map texture array atlas. Only affects atlases created after the value is changed"),
+	ECVF_Default
+);
+
+namespace ChunkTextureManagerInternal
+{
+	/**
+	 * Packs the normalized weights of the layers into the texel data of the weight map textures, 4 layers per texture starting at the given texture index.
+	 * Makes a single row-major pass over the weight map, computing the normalization factor once per point and scattering only the layers present in the point.
+	 * Destination arrays must be zero-initialized, since the layers not present in the point are not written.
+	 * Range is inclusive and must be clamped to the texture size. Texel at StartX, StartY is written to the start of each destination array.
+	 */
+	static void PackWeightMapTexels( const FChunkData2D* WeightMap, int32 FirstTextureIndex, TConstArrayView<FColor*> TextureDataArrays, int32 DestStrideX, int32 StartX, int32 StartY, int32 EndX, int32 EndY )
+	{
+		const int32 WeightMapResolutionXY = WeightMap->GetSurfaceResolutionXY();
+		constexpr int32 NumChannelsPerTexture = 4;
+		check( ( FirstTextureIndex + TextureDataArrays.Num() ) * NumChannelsPerTexture <= FChunkLandscapeWeight::MaxWeightMapLayers );
+
+		// FColor is laid out as BGRA in memory, so layers map to the channels in reverse for the first three channels to end up with the layers in RGBA order
+		constexpr int32 LayerChannelByteOffsets[ NumChannelsPerTexture ] = { 2, 1, 0, 3 };
+		const FChunkLandscapeWeight* LandscapeWeightsData = WeightMap->GetDataPtr<FChunkLandscapeWeight>();
+
+		for ( int32 PosY = StartY; PosY <= EndY; PosY++ )
+		{
+			const FChunkLandscapeWeight* RowWeights = LandscapeWeightsData + WeightMapResolutionXY * PosY;
+			const int32 RowTextureDataIndex = ( PosY - StartY ) * DestStrideX - StartX;
+
+			for ( int32 PosX = StartX; PosX <= EndX; PosX++ )
+			{
+				const FChunkLandscapeWeight& LandscapeWeight = RowWeights[ PosX ];
+				const int32 TotalLayersWeight = LandscapeWeight.GetTotalWeight();
+
+				// Safety check against uninitialized landscape weights. We should never get these but try not to crash with 0 total weight
+				if ( TotalLayersWeight == 0 ) continue;
+
+				// Normalize the weights to the full channel range and round them to the nearest value
+				const float NormalizationFactor = 255.0f / TotalLayersWeight;
+
+				for ( int32 EntryIndex = 0; EntryIndex < FChunkLandscapeWeight::MaxLayersPerPoint; EntryIndex++ )
+				{
+					const int32 LayerIndex = LandscapeWeight.GetEntryLayerIndex( EntryIndex );
+					const int32 TextureIndex = LayerIndex / NumChannelsPerTexture - FirstTextureIndex;
+
+					// Skip unused entries and the layers that belong to the textures not being updated
+					if ( LandscapeWeight.EntryWeights[ EntryIndex ] == 0 || !TextureDataArrays.IsValidIndex( TextureIndex ) ) continue;
+
+					uint8* TexelBytes = reinterpret_cast<uint8*>( &TextureDataArrays[ TextureIndex ][ RowTextureDataIndex + PosX ] );
+					TexelBytes[ LayerChannelByteOffsets[ LayerIndex % NumChannelsPerTexture ] ] = (uint8) FMath::Min( FMath::TruncToInt32( LandscapeWeight.EntryWeights[ EntryIndex ] * NormalizationFactor + 0.5f ), 255 );
+				}
+			}
+		}
+	}
+
+	/** Transient texel data for the dirty region of a single texture, owned by the render command uploading it */
+	struct FWeightMapStagingBuffer
+	{
+		TArray<FColor> TexelData;
+
+		explicit FWeightMapStagingBuffer( int32 NumTexels )
+		{
+			// Zero initialize, the packing only writes the channels of the layers present in each point
+			TexelData.SetNumZeroed( NumTexels );
+			INC_MEMORY_STAT_BY( STAT_ChunkWeightMapStagingMemory, TexelData.GetAllocatedSize() );
+		}
+		~FWeightMapStagingBuffer()
+		{
+			DEC_MEMORY_STAT_BY( STAT_ChunkWeightMapStagingMemory, TexelData.GetAllocatedSize() );
+		}
+	};
+
+	/** Allocates the staging buffers for the given number of textures and packs the weight map region into them */
+	static void PackWeightMapStagingBuffers( const FChunkData2D* WeightMap, int32 FirstTextureIndex, int32 NumTextures, int32 StartX, int32 StartY, int32 EndX, int32 EndY, TArray<TSharedPtr<FWeightMapStagingBuffer>>& OutStagingBuffers )
+	{
+		const int32 RegionSizeX = EndX - StartX + 1;
+		const int32 RegionSizeY = EndY - StartY + 1;
+
+		TArray<FColor*, TInlineAllocator<FChunkLandscapeWeight::MaxWeightMapLayers / 4>> TexelDataArrays;
+		for ( int32 TextureIndex = 0; TextureIndex < NumTextures; TextureIndex++ )
+		{
+			const TSharedPtr<FWeightMapStagingBuffer>& StagingBuffer = OutStagingBuffers.Add_GetRef( MakeShared<FWeightMapStagingBuffer>( RegionSizeX * RegionSizeY ) );
+			TexelDataArrays.Add( StagingBuffer->TexelData.GetData() );
+		}
+		PackWeightMapTexels( WeightMap, FirstTextureIndex, TexelDataArrays, RegionSizeX, StartX, StartY, EndX, EndY );
+	}
+
+	/** Atlas slice written by the atlas update, with the atlas resolved to it's RHI texture so that it can be accessed on the render thread */
+	struct FWeightMapAtlasSliceUpload
+	{
+		TSharedPtr<FChunkWeightMapAtlasRHI, ESPMode::ThreadSafe> AtlasRHI;
+		int32 SliceIndex{INDEX_NONE};
+	};
+}
+
+/** Staging texture for the atlas slice updates. Kept in the copy destination state between the updates, and grown when an update does not fit into it */
+struct FChunkWeightMapAtlasStagingTexture
+{
+	FTextureRHIRef TextureRHI;
+	FIntPoint Size{ForceInitToZero};
+
+	/** Makes sure the texture is at least of the given size, re-creating it otherwise */
+	void Reserve( const FIntPoint& RequiredSize )
+	{
+		if ( Size.X < RequiredSize.X || Size.Y < RequiredSize.Y )
+		{
+			Size = FIntPoint( FMath::Max( Size.X, RequiredSize.X ), FMath::Max( Size.Y, RequiredSize.Y ) );
+
+			const FRHITextureCreateDesc StagingTextureDesc = FRHITextureCreateDesc::Create2D( TEXT("OWGWeightMapAtlasStaging"), Size.X, Size.Y, PF_B8G8R8A8 )
+				.SetInitialState( ERHIAccess::CopyDest );
+			TextureRHI = RHICreateTexture( StagingTextureDesc );
+		}
+	}
+};
+
+UChunkTextureManager::UChunkTextureManager() : AtlasStagingTexture( MakeShared<FChunkWeightMapAtlasStagingTexture, ESPMode::ThreadSafe>() )
 {
 }
 
 void UChunkTextureManager::ReleasePooledTextures()
 {
 	// Release pooled weight map textures
-	for ( UTexture2D* Texture : PooledWeightMapTextures )
+	for ( UTexture2DDynamic* Texture : PooledWeightMapTextures )
 	{
 		Texture->ReleaseResource();
 		Texture->MarkAsGarbage();
 	}
 	PooledWeightMapTextures.Empty();
+
+	// Release weight map atlases. All chunks should have released their slices by now
+	for ( UChunkWeightMapAtlasTexture* AtlasTexture : WeightMapAtlases )
+	{
+		AtlasTexture->ReleaseResource();
+		AtlasTexture->MarkAsGarbage();
+	}
+	WeightMapAtlases.Empty();
+	WeightMapAtlasFreeSlices.Empty();
+
+	// Release the staging texture along with the atlases, render thread is the only one accessing it so it has to be released there
+	ENQUEUE_RENDER_COMMAND( ReleaseChunkWeightMapAtlasStaging )( [StagingTexture = AtlasStagingTexture]( FRHICommandListImmediate& RHICmdList )
+	{
+		StagingTexture->TextureRHI.SafeRelease();
+		StagingTexture->Size = FIntPoint::ZeroValue;
+	} );
 }
 
-UTexture2D* UChunkTextureManager::CreateWeightMapTexture( const FChunkData2D* WeightMap, int32 TextureIndex )
+UTexture2DDynamic* UChunkTextureManager::CreateWeightMapTexture( const FChunkData2D* WeightMap, int32 TextureIndex )
 {
 	const int32 WeightMapResolutionXY = WeightMap->GetSurfaceResolutionXY();
 
-	// Generate the resulting texture array
-	UTexture2D* Texture = RetainSurfaceLayersTexture( WeightMapResolutionXY );
-	PartialUpdateWeightMap( Texture, TextureIndex, WeightMap, 0, 0, WeightMapResolutionXY, WeightMapResolutionXY, true );
+	// Retain the texture and upload the entire weight map to it. Dynamic textures have their render resource created immediately, so the upload can be enqueued right away
+	UTexture2DDynamic* Texture = RetainSurfaceLayersTexture( WeightMapResolutionXY );
+	PartialUpdateWeightMap( { Texture }, TextureIndex, WeightMap, 0, 0, WeightMapResolutionXY, WeightMapResolutionXY );
 	return Texture;
 }
 
-void UChunkTextureManager::PartialUpdateWeightMap( UTexture2D* WeightMapTexture, int32 TextureIndex, const FChunkData2D* WeightMap, int32 StartX, int32 StartY, int32 EndX, int32 EndY, bool bFullUpdate )
+void UChunkTextureManager::PartialUpdateWeightMap( TConstArrayView<UTexture2DDynamic*> WeightMapTextures, int32 FirstTextureIndex, const FChunkData2D* WeightMap, int32 StartX, int32 StartY, int32 EndX, int32 EndY )
 {
 	SCOPE_CYCLE_COUNTER( STAT_ChunkWeightMapTextureUpdate );
-	const int32 HeightmapResolutionXY = WeightMap->GetSurfaceResolutionXY();
-	constexpr int32 NumChannelsPerTexture = 4;
+	if ( WeightMapTextures.IsEmpty() )
+	{
+		return;
+	}
 
 	// TODO @open-world-generator: Support texture streaming for generated weight maps. Need to implement UTextureMipDataProviderFactory and add it to AssetUserData
-	FTexturePlatformData* PlatformData = WeightMapTexture->GetPlatformData();
-	FTexture2DMipMap* FirstMipMap = &PlatformData->Mips[0];
-
-	// Clamp the start/end of the texture to fit into the mip map data
-	const int32 ClampedStartX = FMath::Clamp( StartX, 0, FirstMipMap->SizeX - 1 );
-	const int32 ClampedStartY = FMath::Clamp( StartY, 0, FirstMipMap->SizeY - 1 );
-	const int32 ClampedEndX = FMath::Clamp( EndX, 0, FirstMipMap->SizeX - 1 );
-	const int32 ClampedEndY = FMath::Clamp( EndY, 0, FirstMipMap->SizeY - 1 );
-	
-	// Generate first mip map data by sampling weights data in each cell
-	const FChunkLandscapeWeight* LandscapeWeightsData = WeightMap->GetDataPtr<FChunkLandscapeWeight>();
-	FColor* TextureDataArray = static_cast< FColor* >(FirstMipMap->BulkData.Lock( LOCK_READ_WRITE ));
-
-	for ( int32 PosX = ClampedStartX; PosX <= ClampedEndX; PosX++ )
-	{
-		for ( int32 PosY = ClampedStartY; PosY <= ClampedEndY; PosY++ )
+	// All weight map textures of the chunk have the same size
+	const int32 TextureSizeX = WeightMapTextures[0]->SizeX;
+	const int32 TextureSizeY = WeightMapTextures[0]->SizeY;
+
+	// Clamp the start/end of the texture to fit into the texture
+	const int32 ClampedStartX = FMath::Clamp( StartX, 0, TextureSizeX - 1 );
+	const int32 ClampedStartY = FMath::Clamp( StartY, 0, TextureSizeY - 1 );
+	const int32 ClampedEndX = FMath::Clamp( EndX, 0, TextureSizeX - 1 );
+	const int32 ClampedEndY = FMath::Clamp( EndY, 0, TextureSizeY - 1 );
+
+	// Only the dirty region is packed, there is no CPU copy of the entire texture
+	TArray<TSharedPtr<ChunkTextureManagerInternal::FWeightMapStagingBuffer>> StagingBuffers;
+	ChunkTextureManagerInternal::PackWeightMapStagingBuffers( WeightMap, FirstTextureIndex, WeightMapTextures.Num(), ClampedStartX, ClampedStartY, ClampedEndX, ClampedEndY, StagingBuffers );
+
+	const FUpdateTextureRegion2D UpdateRegion( ClampedStartX, ClampedStartY, 0, 0, ClampedEndX - ClampedStartX + 1, ClampedEndY - ClampedStartY + 1 );
+
+	for ( int32 TextureIndex = 0; TextureIndex < WeightMapTextures.Num(); TextureIndex++ )
+	{
+		FTextureResource* TextureResource = WeightMapTextures[ TextureIndex ]->GetResource();
+		if ( TextureResource == nullptr )
 		{
-			const FChunkLandscapeWeight& LandscapeWeight = LandscapeWeightsData[ HeightmapResolutionXY * PosY + PosX ];
-			const int32 TotalLayersWeight = LandscapeWeight.GetTotalWeight();
-
-			// Safety check against uninitialized landscape weights. We should never get these but try not to crash with 0 total weight
-			if ( TotalLayersWeight == 0 ) continue;
-
-			// Calculate the index in the texture bulk data: The organization is Slice (Z) -> Row (Y) -> Column (X)
-			const int32 TextureDataIndex = PosY * FirstMipMap->SizeX + PosX;
-			FColor& TextureData = TextureDataArray[ TextureDataIndex ];
-
-			// Copy the data from the layers into the texture. Non-allocated layers are allowed to contain garbage, as they are not read by the material
-			// That implies that the capacity of layer weights is a multiple of channel size (which we check above)
-			TextureData.R = (uint8) FMath::DivideAndRoundNearest( LandscapeWeight.LayerWeights[ TextureIndex * NumChannelsPerTexture + 0 ] * 255, TotalLayersWeight );
-			TextureData.G = (uint8) FMath::DivideAndRoundNearest( LandscapeWeight.LayerWeights[ TextureIndex * NumChannelsPerTexture + 1 ] * 255, TotalLayersWeight );
-			TextureData.B = (uint8) FMath::DivideAndRoundNearest( LandscapeWeight.LayerWeights[ TextureIndex * NumChannelsPerTexture + 2 ] * 255, TotalLayersWeight );
-			TextureData.A = (uint8) FMath::DivideAndRoundNearest( LandscapeWeight.LayerWeights[ TextureIndex * NumChannelsPerTexture + 3 ] * 255, TotalLayersWeight );
+			continue;
 		}
+
+		// Upload the region on the render thread. Staging buffer is released once the command has been executed
+		ENQUEUE_RENDER_COMMAND( UpdateChunkWeightMapTexture )( [TextureResource, UpdateRegion, StagingBuffer = StagingBuffers[ TextureIndex ]]( FRHICommandListImmediate& RHICmdList )
+		{
+			if ( FRHITexture* TextureRHI = TextureResource->GetTextureRHI() )
+			{
+				RHICmdList.UpdateTexture2D( TextureRHI, 0, UpdateRegion, UpdateRegion.Width * sizeof(FColor), reinterpret_cast<const uint8*>( StagingBuffer->TexelData.GetData() ) );
+			}
+		} );
 	}
+}
 
-	// Allocate the buffer for UpdateTextureRegions if we are willing to make an update. We want an update if the render resource has already been created
-	FColor* TextureUpdateRegionBuffer = nullptr;
-	const FUpdateTextureRegion2D* UpdateTextureRegion2D = nullptr;
+void UChunkTextureManager::ReleaseSurfaceLayersTexture( UTexture2DDynamic* WeightMapTexture )
+{
+	check( IsInGameThread() );
 
-	if ( WeightMapTexture->GetResource() && !bFullUpdate )
+	// Add texture back to the pool
+	PooledWeightMapTextures.Add( WeightMapTexture );
+}
+
+UTexture2DDynamic* UChunkTextureManager::RetainSurfaceLayersTexture( int32 WeightMapResolutionXY )
+{
+	check( IsInGameThread() );
+
+	// Attempt to re-use texture from the pool first
+	if ( !PooledWeightMapTextures.IsEmpty() )
 	{
-		const int32 UpdateRegionSizeX = ClampedEndX - ClampedStartX + 1;
-		const int32 UpdateRegionSizeY = ClampedEndY - ClampedStartY + 1;
+		UTexture2DDynamic* RetainedTexture = PooledWeightMapTextures.Pop();
+		check( RetainedTexture->SizeX == WeightMapResolutionXY && RetainedTexture->SizeY == WeightMapResolutionXY );
 
-		TextureUpdateRegionBuffer = (FColor*) FMemory::Malloc( UpdateRegionSizeX * UpdateRegionSizeY * sizeof(FColor) );
-		UpdateTextureRegion2D = new FUpdateTextureRegion2D( ClampedStartX, ClampedStartY, 0, 0, UpdateRegionSizeX, UpdateRegionSizeY );
+		return RetainedTexture;
+	}
+
+	// Create a new texture if we found to retain one from the pool. Dynamic textures only exist on the GPU and do not keep the CPU copy of their data
+	UTexture2DDynamic* NewTexture = UTexture2DDynamic::Create( WeightMapResolutionXY, WeightMapResolutionXY, FTexture2DDynamicCreateInfo( PF_B8G8R8A8 ) );
+	NewTexture->Rename( *FName( TEXT("OWGWeightMapTexture"), SurfaceLayersTextureCounter++ ).ToString(), nullptr, REN_DontCreateRedirectors | REN_NonTransactional );
+	return NewTexture;
+}
 
-		// Copy the data from the global mip map buffer to the local update buffer with limited size
-		for ( int32 LocalX = 0; LocalX < UpdateRegionSizeX; LocalX++ )
+FChunkWeightMapAtlasSlice UChunkTextureManager::CreateWeightMapAtlasSlice( const FChunkData2D* WeightMap, int32 TextureIndex )
+{
+	check( IsInGameThread() );
+	const int32 WeightMapResolutionXY = WeightMap->GetSurfaceResolutionXY();
+
+	// Find an atlas of matching resolution that still has free slices
+	FChunkWeightMapAtlasSlice AtlasSlice;
+	for ( int32 AtlasIndex = 0; AtlasIndex < WeightMapAtlases.Num(); AtlasIndex++ )
+	{
+		if ( WeightMapAtlases[ AtlasIndex ]->GetSliceSizeXY() == WeightMapResolutionXY && !WeightMapAtlasFreeSlices[ AtlasIndex ].IsEmpty() )
 		{
-			for ( int32 LocalY = 0; LocalY < UpdateRegionSizeY; LocalY++ )
-			{
-				const int32 TextureDataIndex = ( ClampedStartY + LocalY ) * FirstMipMap->SizeX + ( ClampedStartX + LocalX );
-				TextureUpdateRegionBuffer[ LocalY * UpdateRegionSizeX + LocalX ] = TextureDataArray[ TextureDataIndex ];
-			}
+			AtlasSlice.AtlasIndex = AtlasIndex;
+			AtlasSlice.SliceIndex = WeightMapAtlasFreeSlices[ AtlasIndex ].Pop();
+			break;
 		}
 	}
 
-	// Unlock the mip data now that we have finished potentially making a partial copy for UpdateTextureRegions
-	FirstMipMap->BulkData.Unlock();
+	// Create a new atlas if all existing ones are full
+	if ( !AtlasSlice.IsValid() )
+	{
+		const int32 NumSlices = FMath::Max( CVarWeightMapAtlasSlices.GetValueOnGameThread(), 1 );
+		const FName TextureName( TEXT("OWGWeightMapAtlas"), WeightMapAtlases.Num() );
+
+		// Atlas has no initial data, slices are populated by the update below when they are allocated
+		UChunkWeightMapAtlasTexture* AtlasTexture = UChunkWeightMapAtlasTexture::Create( this, TextureName, WeightMapResolutionXY, NumSlices );
+		AtlasSlice.AtlasIndex = WeightMapAtlases.Add( AtlasTexture );
+		TArray<int32>& FreeSlices = WeightMapAtlasFreeSlices.AddDefaulted_GetRef();
+
+		// Slices are popped from the back, so keep them in reverse order to allocate from the start of the atlas
+		for ( int32 SliceIndex = NumSlices - 1; SliceIndex > 0; SliceIndex-- )
+		{
+			FreeSlices.Add( SliceIndex );
+		}
+		AtlasSlice.SliceIndex = 0;
+	}
+
+	INC_DWORD_STAT( STAT_ChunkWeightMapAtlasSlicesAllocated );
+	PartialUpdateWeightMapAtlasSlices( { AtlasSlice }, TextureIndex, WeightMap, 0, 0, WeightMapResolutionXY, WeightMapResolutionXY );
+	return AtlasSlice;
+}
 
-	// Create resource for the texture if we are doing a full update
-	if ( bFullUpdate )
+void UChunkTextureManager::PartialUpdateWeightMapAtlasSlices( TConstArrayView<FChunkWeightMapAtlasSlice> AtlasSlices, int32 FirstTextureIndex, const FChunkData2D* WeightMap, int32 StartX, int32 StartY, int32 EndX, int32 EndY )
+{
+	SCOPE_CYCLE_COUNTER( STAT_ChunkWeightMapTextureUpdate );
+	if ( AtlasSlices.IsEmpty() )
 	{
-		WeightMapTexture->UpdateResource();
+		return;
 	}
 
-	// Call UpdateTextureRegions if we have valid data for it. It is an asynchronous operation so we will need to free the buffers once it's done
-	if ( TextureUpdateRegionBuffer && UpdateTextureRegion2D )
+	// Slices of the same chunk always live in the atlases of the same size
+	const int32 SliceSizeXY = WeightMapAtlases[ AtlasSlices[0].AtlasIndex ]->GetSliceSizeXY();
+
+	// Clamp the start/end of the texture to fit into the slice
+	const int32 ClampedStartX = FMath::Clamp( StartX, 0, SliceSizeXY - 1 );
+	const int32 ClampedStartY = FMath::Clamp( StartY, 0, SliceSizeXY - 1 );
+	const int32 ClampedEndX = FMath::Clamp( EndX, 0, SliceSizeXY - 1 );
+	const int32 ClampedEndY = FMath::Clamp( EndY, 0, SliceSizeXY - 1 );
+
+	const FIntPoint RegionStart( ClampedStartX, ClampedStartY );
+	const FIntPoint RegionSize( ClampedEndX - ClampedStartX + 1, ClampedEndY - ClampedStartY + 1 );
+
+	// Pack the regions of all slices side by side into a single staging buffer, so that they can be uploaded at once
+	const int32 StagingSizeX = RegionSize.X * AtlasSlices.Num();
+	const TSharedPtr<ChunkTextureManagerInternal::FWeightMapStagingBuffer> StagingBuffer = MakeShared<ChunkTextureManagerInternal::FWeightMapStagingBuffer>( StagingSizeX * RegionSize.Y );
+
+	TArray<FColor*, TInlineAllocator<FChunkLandscapeWeight::MaxWeightMapLayers / 4>> TexelDataArrays;
+	TArray<ChunkTextureManagerInternal::FWeightMapAtlasSliceUpload, TInlineAllocator<FChunkLandscapeWeight::MaxWeightMapLayers / 4>> SliceUploads;
+	for ( int32 SliceArrayIndex = 0; SliceArrayIndex < AtlasSlices.Num(); SliceArrayIndex++ )
 	{
-		WeightMapTexture->UpdateTextureRegions( 0, 1, UpdateTextureRegion2D, UpdateTextureRegion2D->Width * sizeof(FColor), sizeof(FColor), (uint8*) TextureUpdateRegionBuffer, [](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
-		{
-			// SrcData was allocated via FMemory::Malloc, region descriptor was allocated via new (single new, not vector new)
-			FMemory::Free( SrcData );
-			delete Regions;
-		});
+		const FChunkWeightMapAtlasSlice& AtlasSlice = AtlasSlices[ SliceArrayIndex ];
+		check( AtlasSlice.IsValid() );
+
+		TexelDataArrays.Add( StagingBuffer->TexelData.GetData() + SliceArrayIndex * RegionSize.X );
+		SliceUploads.Add( { WeightMapAtlases[ AtlasSlice.AtlasIndex ]->GetAtlasRHI(), AtlasSlice.SliceIndex } );
 	}
+	ChunkTextureManagerInternal::PackWeightMapTexels( WeightMap, FirstTextureIndex, TexelDataArrays, StagingSizeX, ClampedStartX, ClampedStartY, ClampedEndX, ClampedEndY );
+
+	// Texture arrays cannot be updated with a sub-region directly, so upload the regions to the staging texture and copy each of them into it's slice on the GPU
+	ENQUEUE_RENDER_COMMAND( UpdateChunkWeightMapAtlasSlices )( [StagingTexture = AtlasStagingTexture, SliceUploads = MoveTemp( SliceUploads ), RegionStart, RegionSize, StagingBuffer]( FRHICommandListImmediate& RHICmdList )
+	{
+		const FIntPoint StagingSize( RegionSize.X * SliceUploads.Num(), RegionSize.Y );
+		StagingTexture->Reserve( StagingSize );
+
+		const FUpdateTextureRegion2D UpdateRegion( 0, 0, 0, 0, StagingSize.X, StagingSize.Y );
+		RHICmdList.UpdateTexture2D( StagingTexture->TextureRHI, 0, UpdateRegion, StagingSize.X * sizeof(FColor), reinterpret_cast<const uint8*>( StagingBuffer->TexelData.GetData() ) );
+
+		// Transition the atlases from whatever state they are currently in. Multiple slices can live in the same atlas, so only transition each atlas once
+		TArray<FRHITransitionInfo, TInlineAllocator<FChunkLandscapeWeight::MaxWeightMapLayers / 4 + 1>> Transitions;
+		Transitions.Emplace( StagingTexture->TextureRHI, ERHIAccess::CopyDest, ERHIAccess::CopySrc );
+		for ( const ChunkTextureManagerInternal::FWeightMapAtlasSliceUpload& SliceUpload : SliceUploads )
+		{
+			FChunkWeightMapAtlasRHI& AtlasRHI = *SliceUpload.AtlasRHI;
+			if ( AtlasRHI.TextureRHI.IsValid() && AtlasRHI.CurrentAccess != ERHIAccess::CopyDest )
+			{
+				Transitions.Emplace( AtlasRHI.TextureRHI, AtlasRHI.CurrentAccess, ERHIAccess::CopyDest );
+				AtlasRHI.CurrentAccess = ERHIAccess::CopyDest;
+			}
+		}
+		RHICmdList.Transition( Transitions );
+
+		for ( int32 SliceArrayIndex = 0; SliceArrayIndex < SliceUploads.Num(); SliceArrayIndex++ )
+		{
+			const ChunkTextureManagerInternal::FWeightMapAtlasSliceUpload& SliceUpload = SliceUploads[ SliceArrayIndex ];
+			if ( SliceUpload.AtlasRHI->TextureRHI.IsValid() )
+			{
+				FRHICopyTextureInfo CopyInfo;
+				CopyInfo.Size = FIntVector( RegionSize.X, RegionSize.Y, 1 );
+				CopyInfo.SourcePosition = FIntVector( SliceArrayIndex * RegionSize.X, 0, 0 );
+				CopyInfo.DestPosition = FIntVector( RegionStart.X, RegionStart.Y, 0 );
+				CopyInfo.DestSliceIndex = SliceUpload.SliceIndex;
+				RHICmdList.CopyTexture( StagingTexture->TextureRHI, SliceUpload.AtlasRHI->TextureRHI, CopyInfo );
+			}
+		}
+
+		// Return the atlases to be readable by the shaders, and the staging texture back to the state the next update expects it in
+		Transitions.Reset();
+		Transitions.Emplace( StagingTexture->TextureRHI, ERHIAccess::CopySrc, ERHIAccess::CopyDest );
+		for ( const ChunkTextureManagerInternal::FWeightMapAtlasSliceUpload& SliceUpload : SliceUploads )
+		{
+			FChunkWeightMapAtlasRHI& AtlasRHI = *SliceUpload.AtlasRHI;
+			if ( AtlasRHI.TextureRHI.IsValid() && AtlasRHI.CurrentAccess == ERHIAccess::CopyDest )
+			{
+				Transitions.Emplace( AtlasRHI.TextureRHI, ERHIAccess::CopyDest, ERHIAccess::SRVMask );
+				AtlasRHI.CurrentAccess = ERHIAccess::SRVMask;
+			}
+		}
+		RHICmdList.Transition( Transitions );
+	} );
 }
 
-void UChunkTextureManager::ReleaseSurfaceLayersTexture( UTexture2D* WeightMapTexture )
+void UChunkTextureManager::ReleaseWeightMapAtlasSlice( const FChunkWeightMapAtlasSlice& AtlasSlice )
 {
 	check( IsInGameThread() );
 
-	// Add texture back to the pool
-	PooledWeightMapTextures.Add( WeightMapTexture );
+	if ( AtlasSlice.IsValid() && WeightMapAtlasFreeSlices.IsValidIndex( AtlasSlice.AtlasIndex ) )
+	{
+		WeightMapAtlasFreeSlices[ AtlasSlice.AtlasIndex ].Add( AtlasSlice.SliceIndex );
+		DEC_DWORD_STAT( STAT_ChunkWeightMapAtlasSlicesAllocated );
+	}
 }
 
-UTexture2D* UChunkTextureManager::RetainSurfaceLayersTexture( int32 WeightMapResolutionXY )
+UChunkWeightMapAtlasTexture* UChunkTextureManager::GetWeightMapAtlasTexture( const FChunkWeightMapAtlasSlice& AtlasSlice ) const
+{
+	return WeightMapAtlases.IsValidIndex( AtlasSlice.AtlasIndex ) ? WeightMapAtlases[ AtlasSlice.AtlasIndex ].Get() : nullptr;
+}
+
+UMaterialInstanceDynamic* UChunkTextureManager::AcquireSharedLandscapeMaterial( const FSharedLandscapeMaterialKey& MaterialKey, TFunctionRef<UMaterialInstanceDynamic*()> CreateMaterialInstance )
 {
 	check( IsInGameThread() );
 
-	// Attempt to re-use texture from the pool first
-	if ( !PooledWeightMapTextures.IsEmpty() )
+	FSharedLandscapeMaterialInstance& SharedMaterial = SharedLandscapeMaterials.FindOrAdd( MaterialKey );
+	if ( SharedMaterial.MaterialInstance == nullptr )
 	{
-		UTexture2D* RetainedTexture = PooledWeightMapTextures.Pop();
-		check( RetainedTexture->GetSizeX() == WeightMapResolutionXY && RetainedTexture->GetSizeY() == WeightMapResolutionXY );
+		SharedMaterial.MaterialInstance = CreateMaterialInstance();
+		INC_DWORD_STAT( STAT_SharedLandscapeMaterialInstances );
+	}
+	SharedMaterial.ReferenceCount++;
+	return SharedMaterial.MaterialInstance;
+}
 
-		return RetainedTexture;
+void UChunkTextureManager::ReleaseSharedLandscapeMaterial( const FSharedLandscapeMaterialKey& MaterialKey )
+{
+	check( IsInGameThread() );
+
+	if ( FSharedLandscapeMaterialInstance* SharedMaterial = SharedLandscapeMaterials.Find( MaterialKey ) )
+	{
+		if ( --SharedMaterial->ReferenceCount <= 0 )
+		{
+			if ( SharedMaterial->MaterialInstance != nullptr )
+			{
+				SharedMaterial->MaterialInstance->MarkAsGarbage();
+			}
+			SharedLandscapeMaterials.Remove( MaterialKey );
+			DEC_DWORD_STAT( STAT_SharedLandscapeMaterialInstances );
+		}
 	}
+}
 
-	// Create a new texture if we found to retain one from the pool
-	const FName TextureName( TEXT("OWGWeightMapTexture"), SurfaceLayersTextureCounter++ );
-	return UTexture2D::CreateTransient( WeightMapResolutionXY, WeightMapResolutionXY, PF_B8G8R8A8, TextureName );
+void UChunkTextureManager::AddReferencedObjects( UObject* InThis, FReferenceCollector& Collector )
+{
+	Super::AddReferencedObjects( InThis, Collector );
+
+	UChunkTextureManager* TextureManager = CastChecked<UChunkTextureManager>( InThis );
+	for ( TPair<FSharedLandscapeMaterialKey, FSharedLandscapeMaterialInstance>& Pair : TextureManager->SharedLandscapeMaterials )
+	{
+		Collector.AddReferencedObject( Pair.Value.MaterialInstance );
+	}
 }
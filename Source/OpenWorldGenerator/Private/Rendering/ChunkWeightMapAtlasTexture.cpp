@@ -0,0 +1,102 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "Rendering/ChunkWeightMapAtlasTexture.h"
+#include "TextureResource.h"
+#include "DeviceProfiles/DeviceProfile.h"
+#include "DeviceProfiles/DeviceProfileManager.h"
+
+/** Render resource of the weight map atlas. Does not have any initial data, and re-uses the RHI texture of the atlas if it has already been created */
+class FChunkWeightMapAtlasResource : public FTextureResource
+{
+public:
+	explicit FChunkWeightMapAtlasResource( const UChunkWeightMapAtlasTexture* Owner ) :
+		AtlasRHI( Owner->GetAtlasRHI() ), TextureReferenceRHI( Owner->TextureReference.TextureReferenceRHI ), TextureName( Owner->GetFName() ),
+		SliceSizeXY( Owner->GetSliceSizeXY() ), NumSlices( Owner->GetNumSlices() ), bSRGB( Owner->SRGB ),
+		SamplerFilter( (ESamplerFilter) UDeviceProfileManager::Get().GetActiveProfile()->GetTextureLODSettings()->GetSamplerFilter( Owner ) )
+	{
+	}
+
+	virtual uint32 GetSizeX() const override { return SliceSizeXY; }
+	virtual uint32 GetSizeY() const override { return SliceSizeXY; }
+	virtual uint32 GetSizeZ() const override { return NumSlices; }
+
+	virtual void InitRHI( FRHICommandListBase& RHICmdList ) override
+	{
+		// Atlas slices are sampled in the material using the UVs of the chunk, so they should never wrap around
+		const FSamplerStateInitializerRHI SamplerStateInitializer( SamplerFilter, AM_Clamp, AM_Clamp, AM_Clamp );
+		SamplerStateRHI = GetOrCreateSamplerState( SamplerStateInitializer );
+
+		// Only create the texture once, re-creating the render resource should not lose the contents of the slices
+		if ( !AtlasRHI->TextureRHI.IsValid() )
+		{
+			const FRHITextureCreateDesc TextureDesc = FRHITextureCreateDesc::Create2DArray( *TextureName.ToString(), SliceSizeXY, SliceSizeXY, NumSlices, PF_B8G8R8A8 )
+				.SetFlags( ETextureCreateFlags::ShaderResource | ( bSRGB ? ETextureCreateFlags::SRGB : ETextureCreateFlags::None ) )
+				.SetInitialState( ERHIAccess::SRVMask );
+			AtlasRHI->TextureRHI = RHICreateTexture( TextureDesc );
+			AtlasRHI->CurrentAccess = ERHIAccess::SRVMask;
+		}
+		TextureRHI = AtlasRHI->TextureRHI;
+		RHIUpdateTextureReference( TextureReferenceRHI, TextureRHI );
+	}
+
+	virtual void ReleaseRHI() override
+	{
+		// RHI texture is kept alive by the atlas, only drop the references of the resource to it
+		RHIUpdateTextureReference( TextureReferenceRHI, nullptr );
+		FTextureResource::ReleaseRHI();
+	}
+private:
+	TSharedPtr<FChunkWeightMapAtlasRHI, ESPMode::ThreadSafe> AtlasRHI;
+	FTextureReferenceRHIRef TextureReferenceRHI;
+	FName TextureName;
+	int32 SliceSizeXY;
+	int32 NumSlices;
+	bool bSRGB;
+	ESamplerFilter SamplerFilter;
+};
+
+UChunkWeightMapAtlasTexture* UChunkWeightMapAtlasTexture::Create( UObject* Outer, FName Name, int32 InSliceSizeXY, int32 InNumSlices )
+{
+	UChunkWeightMapAtlasTexture* NewTexture = NewObject<UChunkWeightMapAtlasTexture>( Outer, Name, RF_Transient );
+	NewTexture->SliceSizeXY = InSliceSizeXY;
+	NewTexture->NumSlices = InNumSlices;
+	NewTexture->NeverStream = true;
+	NewTexture->AtlasRHI = MakeShared<FChunkWeightMapAtlasRHI, ESPMode::ThreadSafe>();
+	NewTexture->UpdateResource();
+	return NewTexture;
+}
+
+FTextureResource* UChunkWeightMapAtlasTexture::CreateResource()
+{
+	return SliceSizeXY > 0 && NumSlices > 0 ? new FChunkWeightMapAtlasResource( this ) : nullptr;
+}
+
+EMaterialValueType UChunkWeightMapAtlasTexture::GetMaterialType() const
+{
+	return MCT_Texture2DArray;
+}
+
+float UChunkWeightMapAtlasTexture::GetSurfaceWidth() const
+{
+	return SliceSizeXY;
+}
+
+float UChunkWeightMapAtlasTexture::GetSurfaceHeight() const
+{
+	return SliceSizeXY;
+}
+
+float UChunkWeightMapAtlasTexture::GetSurfaceDepth() const
+{
+	return 0;
+}
+
+uint32 UChunkWeightMapAtlasTexture::GetSurfaceArraySize() const
+{
+	return NumSlices;
+}
+
+ETextureClass UChunkWeightMapAtlasTexture::GetTextureClass() const
+{
+	return ETextureClass::TwoDArray;
+}
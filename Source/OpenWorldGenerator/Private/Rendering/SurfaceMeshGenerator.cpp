@@ -21,25 +21,6 @@ THIRD_PARTY_INCLUDES_END
 #define SURFACE_DATA_INDEX(PointX, PointY, NumPoints, MeshScale) ( (NumPoints / 2) * (MeshScale) ) * ( (MeshScale) * (PointY) + (int32) ((PointY) >= (NumPoints / 2) / 2) * ((MeshScale) - 1) ) + ( (PointX) * (MeshScale) + (int32) ((PointX) >= (NumPoints / 2) / 2) * ((MeshScale) - 1) )
 #define MESH_POINT_INDEX(PointX, PointY, NumPoints) (NumPoints) * (PointY) + (PointX)
 
-struct FCheckedFloatArray
-{
-private:
-	const float* Data{};
-	int32 ElementCount{0};
-public:
-	explicit FCheckedFloatArray( const FChunkData2D& InData )
-	{
-		Data = InData.GetDataPtr<float>();
-		ElementCount = InData.GetSurfaceElementCount();
-	}
-
-	float operator[]( int32 ElementIndex ) const
-	{
-		check( ElementIndex >= 0 && ElementIndex < ElementCount );
-		return Data[ ElementIndex ];
-	}
-};
-
 class FIndexedFloatArrayGrid
 {
 	const float* Data{nullptr};
@@ -55,7 +36,53 @@ public:
 	}
 };
 
-void SurfaceMeshGenerator::GenerateChunkSurfaceMesh( UE::Geometry::FDynamicMesh3& DynamicMesh, float SurfaceSizeWorldUnits, const FChunkData2D& LandscapeHeightMap, const FChunkData2D& NormalMap, const FChunkData2D& BiomeMap, int32 LODIndex )
+void SurfaceMeshGenerator::CalculateEdgeHeightErrors( const FChunkData2D& LandscapeHeightMap, int32 LODIndex, float OutEdgeHeightErrors[4] )
+{
+	const TChunkData2DView<const float> HeightmapData( LandscapeHeightMap );
+	const int32 NumPointsOnLOD0 = HeightmapData.GetSurfaceResolutionXY();
+	const int32 MeshScale = 1 << LODIndex;
+
+	for ( int32 EdgeIndex = 0; EdgeIndex < 4; EdgeIndex++ )
+	{
+		OutEdgeHeightErrors[ EdgeIndex ] = 0.0f;
+
+		// LOD0 edge vertices lie exactly on the samples or between two adjacent samples, so it matches the heightmap exactly
+		if ( MeshScale == 1 )
+		{
+			continue;
+		}
+
+		const auto SampleEdgeHeight = [&]( int32 PointIndex )
+		{
+			switch ( EdgeIndex )
+			{
+				case 0: return HeightmapData( PointIndex, 0 );
+				case 1: return HeightmapData( PointIndex, NumPointsOnLOD0 - 1 );
+				case 2: return HeightmapData( 0, PointIndex );
+				default: return HeightmapData( NumPointsOnLOD0 - 1, PointIndex );
+			}
+		};
+
+		// The LOD edge interpolates between the samples at most MeshScale apart (with an extra shift at the middle of the surface), so the edge error
+		// is bounded by the height range of the samples in the window spanning two LOD segments
+		for ( int32 WindowStart = 0; WindowStart < NumPointsOnLOD0 - 1; WindowStart += MeshScale )
+		{
+			const int32 WindowEnd = FMath::Min( WindowStart + MeshScale * 2, NumPointsOnLOD0 - 1 );
+			float MinHeight = SampleEdgeHeight( WindowStart );
+			float MaxHeight = MinHeight;
+
+			for ( int32 PointIndex = WindowStart + 1; PointIndex <= WindowEnd; PointIndex++ )
+			{
+				const float PointHeight = SampleEdgeHeight( PointIndex );
+				MinHeight = FMath::Min( MinHeight, PointHeight );
+				MaxHeight = FMath::Max( MaxHeight, PointHeight );
+			}
+			OutEdgeHeightErrors[ EdgeIndex ] = FMath::Max( OutEdgeHeightErrors[ EdgeIndex ], MaxHeight - MinHeight );
+		}
+	}
+}
+
+void SurfaceMeshGenerator::GenerateChunkSurfaceMesh( UE::Geometry::FDynamicMesh3& DynamicMesh, float SurfaceSizeWorldUnits, const FChunkData2D& LandscapeHeightMap, const FChunkData2D& NormalMap, const FChunkData2D& BiomeMap, int32 LODIndex, const FSurfaceMeshSkirtSettings& SkirtSettings )
 {
 	DynamicMesh.Clear();
 
@@ -96,8 +123,9 @@ void SurfaceMeshGenerator::GenerateChunkSurfaceMesh( UE::Geometry::FDynamicMesh3
 	TArray<FHeightmapVertex> HeightMapVertices;
 	HeightMapVertices.AddZeroed( NumPoints * NumPoints );
 
-	const FCheckedFloatArray HeightmapData( LandscapeHeightMap ); // = LandscapeHeightMap.GetDataPtr<float>();
-	const FBiomePaletteIndex* BiomeMapData = BiomeMap.GetDataPtr<FBiomePaletteIndex>();
+	// Data indices are only validated in debug builds, the element sizes are validated once here
+	const TChunkData2DView<const float> HeightmapData( LandscapeHeightMap );
+	const TChunkData2DView<const FBiomePaletteIndex> BiomeMapData( BiomeMap );
 	
 	for ( int32 PointY = 0; PointY < NumPoints; PointY++ )
 	{
@@ -251,6 +279,72 @@ void SurfaceMeshGenerator::GenerateChunkSurfaceMesh( UE::Geometry::FDynamicMesh3
 	}
 
 	UE::Geometry::FMeshNormals::QuickComputeVertexNormals( DynamicMesh );
+
+	// Skirts are added after the normals have been calculated, so they do not affect the shading of the surface edges
+	if ( SkirtSettings.bGenerateSkirts )
+	{
+		// The crack against the neighbour is bounded by our edge error plus the edge error of the neighbour, which shares the same edge samples
+		float EdgeHeightErrors[4];
+		float NeighbourEdgeHeightErrors[4];
+		CalculateEdgeHeightErrors( LandscapeHeightMap, LODIndex, EdgeHeightErrors );
+		CalculateEdgeHeightErrors( LandscapeHeightMap, FMath::Max( SkirtSettings.MaxNeighbourLODIndex, LODIndex ), NeighbourEdgeHeightErrors );
+
+		// Edge points in the order matching the edge height errors. Points are ordered so that each pair of consecutive points
+		// has the same orientation as the boundary edge of the surface triangle, and the skirt triangles continue the surface winding
+		const auto GetEdgePoint = [NumPoints]( int32 EdgeIndex, int32 PointIndex ) -> FIntPoint
+		{
+			switch ( EdgeIndex )
+			{
+				case 0: return FIntPoint( NumPoints - 1 - PointIndex, 0 );
+				case 1: return FIntPoint( PointIndex, NumPoints - 1 );
+				case 2: return FIntPoint( 0, PointIndex );
+				default: return FIntPoint( NumPoints - 1, NumPoints - 1 - PointIndex );
+			}
+		};
+
+		const auto AppendSkirtTriangle = [&]( const FHeightmapVertex& Vertex0, const FHeightmapVertex& Vertex1, const FHeightmapVertex& Vertex2, FBiomePaletteIndex BiomeIndex )
+		{
+			const int32 TriangleId = DynamicMesh.AppendTriangle( UE::Geometry::FIndex3i( Vertex0.VertexIndex, Vertex1.VertexIndex, Vertex2.VertexIndex ) );
+			MaterialIDs->SetValue( TriangleId, (int32) BiomeIndex );
+			UVs->SetTriangle( TriangleId, UE::Geometry::FIndex3i( Vertex0.UVIndex, Vertex1.UVIndex, Vertex2.UVIndex ) );
+			Colors->SetTriangle( TriangleId, UE::Geometry::FIndex3i( Vertex0.VertexColorIndex, Vertex1.VertexColorIndex, Vertex2.VertexColorIndex ) );
+		};
+
+		TArray<FHeightmapVertex> SkirtVertices;
+		SkirtVertices.SetNumUninitialized( NumPoints );
+
+		for ( int32 EdgeIndex = 0; EdgeIndex < 4; EdgeIndex++ )
+		{
+			const float SkirtDepth = SkirtSettings.MinSkirtDepth + EdgeHeightErrors[ EdgeIndex ] + NeighbourEdgeHeightErrors[ EdgeIndex ];
+
+			for ( int32 PointIndex = 0; PointIndex < NumPoints; PointIndex++ )
+			{
+				const FIntPoint EdgePoint = GetEdgePoint( EdgeIndex, PointIndex );
+				const FHeightmapVertex& EdgeVertex = HeightMapVertices[ MESH_POINT_INDEX( EdgePoint.X, EdgePoint.Y, NumPoints ) ];
+				FHeightmapVertex& SkirtVertex = SkirtVertices[ PointIndex ];
+
+				SkirtVertex = EdgeVertex;
+				SkirtVertex.VertexIndex = DynamicMesh.AppendVertex( DynamicMesh.GetVertex( EdgeVertex.VertexIndex ) - FVector3d( 0.0f, 0.0f, SkirtDepth ) );
+				DynamicMesh.SetVertexNormal( SkirtVertex.VertexIndex, DynamicMesh.GetVertexNormal( EdgeVertex.VertexIndex ) );
+				SkirtVertex.UVIndex = UVs->AppendElement( UVs->GetElement( EdgeVertex.UVIndex ) );
+				SkirtVertex.VertexColorIndex = Colors->AppendElement( Colors->GetElement( EdgeVertex.VertexColorIndex ) );
+			}
+
+			for ( int32 PointIndex = 0; PointIndex + 1 < NumPoints; PointIndex++ )
+			{
+				const FIntPoint EdgePointA = GetEdgePoint( EdgeIndex, PointIndex );
+				const FIntPoint EdgePointB = GetEdgePoint( EdgeIndex, PointIndex + 1 );
+				const FHeightmapVertex& VertexA = HeightMapVertices[ MESH_POINT_INDEX( EdgePointA.X, EdgePointA.Y, NumPoints ) ];
+				const FHeightmapVertex& VertexB = HeightMapVertices[ MESH_POINT_INDEX( EdgePointB.X, EdgePointB.Y, NumPoints ) ];
+				const FHeightmapVertex& SkirtVertexA = SkirtVertices[ PointIndex ];
+				const FHeightmapVertex& SkirtVertexB = SkirtVertices[ PointIndex + 1 ];
+
+				// Boundary edge A->B is traversed as B->A by the skirt quad to keep the winding consistent with the surface
+				AppendSkirtTriangle( VertexB, VertexA, SkirtVertexA, VertexA.BiomeIndex );
+				AppendSkirtTriangle( VertexB, SkirtVertexA, SkirtVertexB, VertexA.BiomeIndex );
+			}
+		}
+	}
 }
 
 // TODO @open-world-generator: Clean this up. This is some prototyping code for later. First segment is Constructive Solid Geometry, second one is Marching Cubes with inline perlin noise.
@@ -0,0 +1,288 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "OpenWorldGeneratorSubsystem.h"
+#include "Algo/AllOf.h"
+#include "Commandlets/OWGPregenerateWorldCommandlet.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Partition/ChunkGenerationSnapshot.h"
+#include "Partition/OWGChunk.h"
+#include "Partition/OWGServerChunkManager.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace GenerationDeterminismTestInternal
+{
+	/** Name of the fixture file in the Tests folder of the plugin, and the section in it describing the chunks to generate */
+	static const TCHAR* FixtureFilename = TEXT("GenerationDeterminism.ini");
+	static const TCHAR* FixtureSection = TEXT("GenerationDeterminism");
+	/** Golden snapshots are re-recorded instead of verified when this is passed on the command line */
+	static const TCHAR* UpdateGoldenParam = TEXT("OWGUpdateGolden");
+
+	static constexpr uint32 GoldenFileMagic = 0x4447574F;
+	static constexpr int32 GoldenFileVersion = 1;
+	/** Upper bound on the delta time passed to the world tick */
+	static constexpr double MaxTickDeltaTime = 0.1;
+
+	static bool LoadGoldenSnapshots( const FString& GoldenFilename, TArray<FChunkGenerationSnapshot>& OutSnapshots )
+	{
+		TArray<uint8> GoldenFileData;
+		if ( !FFileHelper::LoadFileToArray( GoldenFileData, *GoldenFilename, FILEREAD_Silent ) )
+		{
+			return false;
+		}
+		FMemoryReader GoldenReader( GoldenFileData );
+
+		uint32 FileMagic = 0;
+		int32 FileVersion = 0;
+		GoldenReader << FileMagic;
+		GoldenReader << FileVersion;
+
+		if ( FileMagic != GoldenFileMagic || FileVersion != GoldenFileVersion )
+		{
+			return false;
+		}
+		GoldenReader << OutSnapshots;
+		return !GoldenReader.IsError();
+	}
+
+	static bool SaveGoldenSnapshots( const FString& GoldenFilename, TArray<FChunkGenerationSnapshot>& Snapshots )
+	{
+		TArray<uint8> GoldenFileData;
+		FMemoryWriter GoldenWriter( GoldenFileData );
+
+		uint32 FileMagic = GoldenFileMagic;
+		int32 FileVersion = GoldenFileVersion;
+		GoldenWriter << FileMagic;
+		GoldenWriter << FileVersion;
+		GoldenWriter << Snapshots;
+
+		return FFileHelper::SaveArrayToFile( GoldenFileData, *GoldenFilename );
+	}
+}
+
+/**
+ * Verifies that the world generation is deterministic. Generates the chunks described by the fixture for a fixed seed into a temporary region folder,
+ * and compares every chunk data grid, noise grid, biome palette and weight map layer list against the golden snapshots element by element.
+ * Every chunk is also reloaded from its serialized data and compared again, to verify that the serialization round-trips the generated data.
+ * Run with -OWGUpdateGolden to record the golden snapshots again after an intended change to the generation.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FOWGGenerationDeterminismTest, "OpenWorldGenerator.Generation.Determinism", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter )
+
+bool FOWGGenerationDeterminismTest::RunTest( const FString& Parameters )
+{
+	using namespace GenerationDeterminismTestInternal;
+
+	const FString FixtureDirectory = FPaths::Combine( IPluginManager::Get().FindPlugin( TEXT("OpenWorldGenerator") )->GetBaseDir(), TEXT("Tests") );
+	FConfigFile FixtureFile;
+	FixtureFile.Read( FPaths::Combine( FixtureDirectory, FixtureFilename ) );
+
+	FString MapName;
+	FString WorldGeneratorName;
+	FString GoldenFilename;
+	FString TargetStageName = TEXT("Decoration");
+	int32 WorldSeed = 0;
+	int32 Radius = 2;
+	int32 Timeout = 600;
+	TArray<FString> ToleranceEntries;
+
+	FixtureFile.GetString( FixtureSection, TEXT("Map"), MapName );
+	FixtureFile.GetString( FixtureSection, TEXT("WorldGenerator"), WorldGeneratorName );
+	FixtureFile.GetString( FixtureSection, TEXT("Golden"), GoldenFilename );
+	FixtureFile.GetString( FixtureSection, TEXT("Stage"), TargetStageName );
+	FixtureFile.GetInt( FixtureSection, TEXT("Seed"), WorldSeed );
+	FixtureFile.GetInt( FixtureSection, TEXT("Radius"), Radius );
+	FixtureFile.GetInt( FixtureSection, TEXT("Timeout"), Timeout );
+	FixtureFile.GetArray( FixtureSection, TEXT("Tolerances"), ToleranceEntries );
+
+	// The fixture depends on the project assets, so the test is skipped in projects that have not configured it instead of failing every test pass
+	if ( MapName.IsEmpty() || WorldGeneratorName.IsEmpty() || GoldenFilename.IsEmpty() )
+	{
+		AddWarning( FString::Printf( TEXT("Skipping, fixture '%s' does not specify the Map, WorldGenerator and Golden in the [%s] section"), *FPaths::Combine( FixtureDirectory, FixtureFilename ), FixtureSection ) );
+		return true;
+	}
+	GoldenFilename = FPaths::Combine( FixtureDirectory, GoldenFilename );
+
+	const bool bUpdateGolden = FParse::Param( FCommandLine::Get(), UpdateGoldenParam );
+	if ( !bUpdateGolden && !IFileManager::Get().FileExists( *GoldenFilename ) )
+	{
+		AddWarning( FString::Printf( TEXT("Skipping, golden file '%s' has not been recorded yet. Run with -%s to record it"), *GoldenFilename, UpdateGoldenParam ) );
+		return true;
+	}
+
+	const int64 TargetStageValue = StaticEnum<EChunkGeneratorStage>()->GetValueByNameString( TargetStageName );
+	if ( TargetStageValue == INDEX_NONE || TargetStageValue > (int64) EChunkGeneratorStage::Latest )
+	{
+		AddError( FString::Printf( TEXT("Invalid generation stage '%s'"), *TargetStageName ) );
+		return false;
+	}
+	const EChunkGeneratorStage TargetStage = (EChunkGeneratorStage) TargetStageValue;
+
+	// Tolerances are given as GridName:Value pairs, grids without one have to match exactly
+	TMap<FName, float> GridTolerances;
+	for ( const FString& ToleranceEntry : ToleranceEntries )
+	{
+		FString GridName, ToleranceValue;
+		if ( !ToleranceEntry.Split( TEXT(":"), &GridName, &ToleranceValue ) )
+		{
+			AddError( FString::Printf( TEXT("Invalid tolerance '%s', expected <GridName>:<Value>"), *ToleranceEntry ) );
+			return false;
+		}
+		GridTolerances.Add( FName( *GridName.TrimStartAndEnd() ), FCString::Atof( *ToleranceValue ) );
+	}
+
+	UOWGWorldGeneratorConfiguration* WorldGenerator = UOpenWorldGeneratorSubsystem::LoadWorldGeneratorPackageFromShortName( WorldGeneratorName );
+	if ( WorldGenerator == nullptr )
+	{
+		AddError( FString::Printf( TEXT("Failed to load world generator '%s'"), *WorldGeneratorName ) );
+		return false;
+	}
+
+	// Generate into an empty region folder, so none of the chunks are loaded from the previous runs
+	const FString RegionFolder = FPaths::ConvertRelativePathToFull( FPaths::Combine( FPaths::ProjectSavedDir(), TEXT("OWGGenerationDeterminism"), FGuid::NewGuid().ToString() ) );
+	IFileManager::Get().MakeDirectory( *RegionFolder, true );
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext( EWorldType::Game );
+	FString LoadMapError;
+	if ( !GEngine->LoadMap( WorldContext, FURL( *MapName ), nullptr, LoadMapError ) )
+	{
+		AddError( FString::Printf( TEXT("Failed to load map '%s': %s"), *MapName, *LoadMapError ) );
+		GEngine->DestroyWorldContext( WorldContext.World() );
+		IFileManager::Get().DeleteDirectory( *RegionFolder, false, true );
+		return false;
+	}
+	UWorld* World = WorldContext.World();
+
+	UOpenWorldGeneratorSubsystem* OpenWorldGeneratorSubsystem = World ? World->GetSubsystem<UOpenWorldGeneratorSubsystem>() : nullptr;
+	UOWGServerChunkManager* ChunkManager = OpenWorldGeneratorSubsystem ? Cast<UOWGServerChunkManager>( OpenWorldGeneratorSubsystem->GetChunkManager().GetObject() ) : nullptr;
+
+	TArray<FChunkGenerationSnapshot> GeneratedSnapshots;
+	if ( ChunkManager == nullptr )
+	{
+		AddError( FString::Printf( TEXT("Map '%s' does not have an open world generator server chunk manager. Make sure it uses a game mode implementing IInterface_OWGGameMode"), *MapName ) );
+	}
+	else
+	{
+		OpenWorldGeneratorSubsystem->OverrideWorldParameters( WorldGenerator, WorldSeed, RegionFolder );
+
+		UOWGPregenerationStreamingProvider* StreamingProvider = NewObject<UOWGPregenerationStreamingProvider>( ChunkManager );
+		StreamingProvider->TargetStage = TargetStage;
+		ChunkManager->RegisterStreamingProvider( StreamingProvider );
+
+		TArray<FChunkCoord> ChunksToVerify;
+		for ( int32 PosX = -Radius; PosX <= Radius; PosX++ )
+		{
+			for ( int32 PosY = -Radius; PosY <= Radius; PosY++ )
+			{
+				ChunksToVerify.Add( FChunkCoord( PosX, PosY ) );
+				StreamingProvider->ActiveChunks.Add( FChunkCoord( PosX, PosY ) );
+			}
+		}
+
+		// Tick the world until all of the chunks have advanced past the target stage
+		const double StartTime = FPlatformTime::Seconds();
+		double LastTickTime = StartTime;
+		bool bTimedOut = false;
+
+		while ( !Algo::AllOf( ChunksToVerify, [&]( const FChunkCoord& ChunkCoord )
+		{
+			const AOWGChunk* Chunk = ChunkManager->FindChunk( ChunkCoord );
+			return Chunk != nullptr && Chunk->GetCurrentGenerationStage() > TargetStage;
+		} ) )
+		{
+			const double CurrentTime = FPlatformTime::Seconds();
+			if ( CurrentTime - StartTime > Timeout || IsEngineExitRequested() )
+			{
+				bTimedOut = true;
+				break;
+			}
+			UOWGPregenerateWorldCommandlet::TickWorld( World, FMath::Min( CurrentTime - LastTickTime, MaxTickDeltaTime ) );
+			LastTickTime = CurrentTime;
+		}
+
+		if ( bTimedOut )
+		{
+			AddError( FString::Printf( TEXT("Chunks did not finish generating within %ds"), Timeout ) );
+		}
+		else
+		{
+			TArray<FString> Differences;
+			for ( const FChunkCoord& ChunkCoord : ChunksToVerify )
+			{
+				FChunkGenerationSnapshot& GeneratedSnapshot = GeneratedSnapshots.AddDefaulted_GetRef();
+				ChunkManager->FindChunk( ChunkCoord )->CaptureGenerationSnapshot( GeneratedSnapshot );
+
+				// Round-trip the chunk through the serialization, the loaded chunk should have exactly the same data
+				if ( const AOWGChunk* ReloadedChunk = ChunkManager->ReloadChunk( ChunkCoord ) )
+				{
+					FChunkGenerationSnapshot ReloadedSnapshot;
+					ReloadedChunk->CaptureGenerationSnapshot( ReloadedSnapshot );
+					ReloadedSnapshot.Compare( GeneratedSnapshot, {}, Differences );
+				}
+				else
+				{
+					Differences.Add( FString::Printf( TEXT("Chunk %d,%d could not be reloaded from its serialized data"), ChunkCoord.PosX, ChunkCoord.PosY ) );
+				}
+			}
+
+			if ( bUpdateGolden )
+			{
+				if ( !SaveGoldenSnapshots( GoldenFilename, GeneratedSnapshots ) )
+				{
+					AddError( FString::Printf( TEXT("Failed to write golden file '%s'"), *GoldenFilename ) );
+				}
+			}
+			else
+			{
+				TArray<FChunkGenerationSnapshot> GoldenSnapshots;
+				if ( !LoadGoldenSnapshots( GoldenFilename, GoldenSnapshots ) )
+				{
+					AddError( FString::Printf( TEXT("Failed to read golden file '%s'. Run with -%s to record it"), *GoldenFilename, UpdateGoldenParam ) );
+				}
+				else
+				{
+					for ( const FChunkGenerationSnapshot& GoldenSnapshot : GoldenSnapshots )
+					{
+						const FChunkGenerationSnapshot* GeneratedSnapshot = GeneratedSnapshots.FindByPredicate( [&]( const FChunkGenerationSnapshot& Snapshot ) { return Snapshot.ChunkCoord == GoldenSnapshot.ChunkCoord; } );
+						if ( GeneratedSnapshot == nullptr )
+						{
+							Differences.Add( FString::Printf( TEXT("Chunk %d,%d is in the golden file but has not been generated"), GoldenSnapshot.ChunkCoord.PosX, GoldenSnapshot.ChunkCoord.PosY ) );
+							continue;
+						}
+						GeneratedSnapshot->Compare( GoldenSnapshot, GridTolerances, Differences );
+					}
+					if ( GoldenSnapshots.Num() != GeneratedSnapshots.Num() )
+					{
+						Differences.Add( FString::Printf( TEXT("Golden file has %d chunks, but %d have been generated"), GoldenSnapshots.Num(), GeneratedSnapshots.Num() ) );
+					}
+				}
+			}
+
+			for ( const FString& Difference : Differences )
+			{
+				AddError( Difference );
+			}
+		}
+		ChunkManager->UnregisterStreamingProvider( StreamingProvider );
+	}
+
+	if ( World != nullptr )
+	{
+		World->DestroyWorld( false );
+	}
+	GEngine->DestroyWorldContext( World );
+	IFileManager::Get().DeleteDirectory( *RegionFolder, false, true );
+
+	return !HasAnyErrors();
+}
+
+#endif
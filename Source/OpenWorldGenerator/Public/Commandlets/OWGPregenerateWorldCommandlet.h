@@ -0,0 +1,54 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "Partition/OWGChunkStreamingProvider.h"
+#include "OWGPregenerateWorldCommandlet.generated.h"
+
+/** Streaming provider that keeps the chunks currently being pregenerated loaded, and requests them to be generated up to the target stage */
+UCLASS( Transient )
+class OPENWORLDGENERATOR_API UOWGPregenerationStreamingProvider : public UObject, public IOWGChunkStreamingProvider
+{
+	GENERATED_BODY()
+public:
+	// Begin IOWGChunkStreamingProvider interface
+	virtual void GetStreamingSources( TArray<FChunkStreamingSource>& OutStreamingSources ) const override;
+	// End IOWGChunkStreamingProvider interface
+
+	/** Chunks that are currently being generated */
+	TSet<FChunkCoord> ActiveChunks;
+	/** Stage up to which the active chunks should be generated */
+	EChunkGeneratorStage TargetStage{EChunkGeneratorStage::Decoration};
+};
+
+/**
+ * Pregenerates the chunks in the given radius around the center of the world and writes them into the region files.
+ * The map should use a game mode implementing IInterface_OWGGameMode, the world generator, the seed and the region folder are taken from the command line instead of the game mode.
+ * Completed regions are recorded in the region folder, so the pregeneration can be interrupted and resumed by running the commandlet with the same arguments again.
+ * Progress made for a different center, radius or stage is discarded, and pregenerating a different world generator or seed into the same region folder is refused.
+ *
+ * Usage: -run=OWGPregenerateWorld -Map=<Map> -WorldGenerator=<Generator> -Seed=<Seed> -RegionFolder=<Path> -Radius=<Chunks> [-CenterX=<Chunk> -CenterY=<Chunk>] [-Stage=Decoration] [-MaxConcurrentChunks=<Num>]
+ */
+UCLASS()
+class OPENWORLDGENERATOR_API UOWGPregenerateWorldCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UOWGPregenerateWorldCommandlet();
+
+	// Begin UCommandlet interface
+	virtual int32 Main( const FString& Params ) override;
+	// End UCommandlet interface
+
+	/** Ticks the world and the engine systems the chunk generation depends on */
+	static void TickWorld( UWorld* World, float DeltaTime );
+private:
+	/** Loads the list of regions completed by the previous runs, and the world and area parameters of the run that has completed them */
+	static TSet<FChunkCoord> LoadCompletedRegions( const FString& ProgressFilename, FString& OutWorldParameters, FString& OutAreaParameters );
+	/** Starts a new progress file for the run with the given parameters, discarding the regions completed by the previous runs */
+	static void ResetProgress( const FString& ProgressFilename, const FString& WorldParameters, const FString& AreaParameters );
+	/** Appends the completed region to the progress file */
+	static void MarkRegionCompleted( const FString& ProgressFilename, const FChunkCoord& RegionCoord );
+};
@@ -42,8 +42,12 @@ enum class EChunkGeneratorStage : uint8
  * If one cannot possibly achieve the persistence of the chunk generator state (for example, because the state is managed by an external subsystem),
  * the chunk generator should override CanPersistChunkGenerator and return false. Keep in mind that this will not prevent the chunk generator from being forcibly saved
  * if the serialization cannot be delayed (for example, when doing a global save on exit). In such cases, the generator can override NotifyAboutToUnloadChunk and do some last resort cleanup there
+ *
+ * Generator instances that have finished generating are returned to the generator pool and reused for the following chunks.
+ * Generators keeping any per-chunk state must reset it by overriding ResetGeneratorState, or disable bReuseGeneratorInstances.
+ * Idle pooled generators are outered to the world generator subsystem, so the generator is only guaranteed to be outered to a chunk while it is generating it
  */
-UCLASS( Blueprintable, Within = "OWGChunk", Abstract )
+UCLASS( Blueprintable, Abstract )
 class OPENWORLDGENERATOR_API UOWGChunkGenerator : public UObject
 {
 	GENERATED_BODY()
@@ -78,7 +82,28 @@ public:
 	UFUNCTION( BlueprintCallable, Category = "Chunk Generator" )
 	bool WaitForAdjacentChunkGeneration( EChunkGeneratorStage TargetStage, int32 Range = 1 );
 
+	/** Returns true if this generator instance can be returned to the generator pool once it has finished generating the chunk */
+	virtual bool CanReuseGeneratorInstance() const;
+
+	/** Called before the generator is returned to the generator pool. Generators with per-chunk state should reset it here so the next chunk starts from a clean state */
+	UFUNCTION( BlueprintNativeEvent, Category = "Chunk Generator" )
+	void ResetGeneratorState();
+
 	/** The biomes that resulted in this chunk generator being selected for generation. A list is a union of all biomes that have this chunk generator listed in their generators */
 	UPROPERTY( VisibleInstanceOnly, BlueprintReadOnly, Category = "Chunk Generator" )
 	TArray<UOWGBiome*> TargetBiomes;
+protected:
+	/** When true, the instances of this generator are reused for multiple chunks instead of allocating a new generator for each chunk. Disable if the generator is referenced externally after the generation has ended */
+	UPROPERTY( EditDefaultsOnly, AdvancedDisplay, Category = "Chunk Generator" )
+	bool bReuseGeneratorInstances{true};
+};
+
+/** Generator instances of a single class that have finished generating and can be reused */
+USTRUCT()
+struct OPENWORLDGENERATOR_API FChunkGeneratorPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY( Transient )
+	TArray<TObjectPtr<UOWGChunkGenerator>> Generators;
 };
@@ -79,6 +79,30 @@ public:
 	UFUNCTION( BlueprintCallable, Category = "Chunk|Landscape", meta = ( WorldContext = "WorldContext" ) )
 	static void ModifyWorldLandscape( const UObject* WorldContext, const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, const FChunkLandscapeModification& LandscapeModification, float MinWeight = 0.0f);
 
+	/**
+	 * Applies multiple terraforming brushes to the world landscape at once.
+	 * The surface data of each affected chunk is recalculated only once after all of the brushes have been applied, so this is much cheaper than
+	 * calling Modify World Landscape for each brush individually when a lot of brushes need to be applied in the same frame.
+	 *
+	 * @param WorldContext the world to operate on. Must be an object that is associated with a UWorld.
+	 * @param Stamps brushes to apply, in the order of application
+	 */
+	UFUNCTION( BlueprintCallable, Category = "Chunk|Landscape", meta = ( WorldContext = "WorldContext" ) )
+	static void ModifyWorldLandscapeBatch( const UObject* WorldContext, const TArray<FChunkLandscapeModificationStamp>& Stamps );
+
+	/**
+	 * Traces a segment against the landscape of the loaded chunks, without going through the physics scene.
+	 * If you are using C++ and need to run the trace outside of the game thread, consider using FChunkLandscapeTracer directly.
+	 *
+	 * @param WorldContext the world to operate on. Must be an object that is associated with a UWorld.
+	 * @param TraceStart start of the segment, in world space
+	 * @param TraceEnd end of the segment, in world space
+	 * @param OutHit the information about the closest hit, if there was one
+	 * @return true if the segment has hit the landscape
+	 */
+	UFUNCTION( BlueprintCallable, Category = "Chunk|Landscape", meta = ( WorldContext = "WorldContext" ) )
+	static bool LineTraceWorldLandscape( const UObject* WorldContext, const FVector& TraceStart, const FVector& TraceEnd, FChunkLandscapeTraceHit& OutHit );
+
 	/** Returns all loaded chunks contained inside the bounding box centered at the world location with the size provided in the box extents */
 	UFUNCTION( BlueprintCallable, Category = "Chunk", meta = ( WorldContext = "WorldContext" ) )
 	static void GetLoadedChunksInBoundingBox( const UObject* WorldContext, const FVector& WorldLocation, const FVector& BoxExtents, TArray<AOWGChunk*>& OutChunks );
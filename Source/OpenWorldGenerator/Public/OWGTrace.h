@@ -0,0 +1,56 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Partition/ChunkCoord.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+#if CPUPROFILERTRACE_ENABLED
+
+/** Trace channel for the world generation pipeline. Enable with -trace=cpu,owg or "trace.enable owg" to see chunk generation, streaming, serialization and LOD work in Insights */
+UE_TRACE_CHANNEL_EXTERN( OWGChannel, OPENWORLDGENERATOR_API );
+
+/**
+ * Traces a scope on the OWG channel under it's name, with a nested scope named after the chunk coordinate (and the index of the LOD, grass variety or similar the scope is working on),
+ * so that the work on different chunks can be told apart in the Insights timeline. The outer scope is a single timer shared by all chunks. Only traced when both the CPU and the OWG channels are enabled
+ */
+class OPENWORLDGENERATOR_API FOWGTraceChunkScope
+{
+public:
+	/** Begins the scope with the static name. Spec ID is the storage for the event type of the call site, registered on the first use */
+	FOWGTraceChunkScope( uint32& InOutSpecId, const TCHAR* StaticName, const FChunkCoord& ChunkCoord, int32 Index );
+	/** Begins the scope with the name picked at runtime. Every unique name becomes a separate timer, so it should come from a small fixed set, such as the generation stage names */
+	FOWGTraceChunkScope( const TCHAR* ScopeName, const FChunkCoord& ChunkCoord, int32 Index );
+	~FOWGTraceChunkScope();
+
+	FOWGTraceChunkScope( const FOWGTraceChunkScope& ) = delete;
+	FOWGTraceChunkScope& operator=( const FOWGTraceChunkScope& ) = delete;
+private:
+	void BeginChunkCoordEvent( const FChunkCoord& ChunkCoord, int32 Index );
+
+	bool bEventsBegun{false};
+};
+
+/** Traces the current scope on the OWG channel with the static name */
+#define OWG_TRACE_SCOPE( Name ) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL( Name, OWGChannel )
+
+/** Traces the current scope on the OWG channel with the static name, and the chunk coordinate and the index as a nested scope */
+#define OWG_TRACE_CHUNK_SCOPE_INDEX( Name, InChunkCoord, InIndex ) \
+	FOWGTraceChunkScope PREPROCESSOR_JOIN( OWGTraceChunkScope_, __LINE__ )( []() -> uint32& { static uint32 SpecId = 0; return SpecId; }(), TEXT( #Name ), InChunkCoord, InIndex )
+
+/** Traces the current scope on the OWG channel with the static name, and the chunk coordinate as a nested scope */
+#define OWG_TRACE_CHUNK_SCOPE( Name, InChunkCoord ) OWG_TRACE_CHUNK_SCOPE_INDEX( Name, InChunkCoord, INDEX_NONE )
+
+/** Traces the current scope on the OWG channel with the name picked at runtime from a small fixed set, and the chunk coordinate as a nested scope. The name is only evaluated when tracing is enabled */
+#define OWG_TRACE_CHUNK_SCOPE_TEXT( InName, InChunkCoord ) \
+	FOWGTraceChunkScope PREPROCESSOR_JOIN( OWGTraceChunkScope_, __LINE__ )( UE_TRACE_CHANNELEXPR_IS_ENABLED( OWGChannel | CpuChannel ) ? ( InName ) : nullptr, InChunkCoord, INDEX_NONE )
+
+#else
+
+#define OWG_TRACE_SCOPE( Name )
+#define OWG_TRACE_CHUNK_SCOPE_INDEX( Name, InChunkCoord, InIndex )
+#define OWG_TRACE_CHUNK_SCOPE( Name, InChunkCoord )
+#define OWG_TRACE_CHUNK_SCOPE_TEXT( InName, InChunkCoord )
+
+#endif
@@ -4,9 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "Engine/DeveloperSettings.h"
+#include "Partition/ChunkMemoryAccounting.h"
 #include "OpenWorldGeneratorSettings.generated.h"
 
 class AOWGChunk;
+class UMaterialInterface;
 class UOWGRegionContainer;
 class UOWGWorldGeneratorConfiguration;
 
@@ -35,7 +37,32 @@ public:
 	UPROPERTY( EditAnywhere, Config, Category = "Open World Generator|General" )
 	float ChunkUnloadIdleTime;
 
+	/**
+	 * Maximum number of unloaded chunk actors kept in the pool to be reused for the newly loaded chunks, instead of destroying them and spawning new ones. 0 disables the pooling.
+	 * Pooled chunks are reset to the class defaults, so chunk subclasses keeping state outside of the properties need to reset it in EndPlay-like fashion themselves.
+	 */
+	UPROPERTY( EditAnywhere, Config, Category = "Open World Generator|General", AdvancedDisplay, meta = ( ClampMin = 0 ) )
+	int32 MaxPooledChunkActors;
+
 	/** World generator that will be used by default unless an override was specified through the URL */
 	UPROPERTY( EditAnywhere, Config, Category = "Open World Generator|General" )
 	TSoftObjectPtr<UOWGWorldGeneratorConfiguration> DefaultWorldGenerator;
+
+	/**
+	 * Memory budgets for the loaded chunks, in megabytes, per memory category. Categories without a budget are not limited.
+	 * When a budget is exceeded, idle chunks are unloaded before their idle time elapses, and if the rendering categories are still over budget, distant chunks are switched to coarser LODs.
+	 */
+	UPROPERTY( EditAnywhere, Config, Category = "Open World Generator|Memory" )
+	TMap<EChunkMemoryCategory, float> ChunkMemoryBudgetsMB;
+
+	/**
+	 * Distance from the streaming sources up to which the regions are rendered using their far-field proxies, in world units. 0 disables the far-field proxies.
+	 * Proxies are built from the chunks that have been generated and saved, and are only rendered for the regions and chunks that are not loaded.
+	 */
+	UPROPERTY( EditAnywhere, Config, Category = "Open World Generator|Far Field", meta = ( ClampMin = 0.0f ) )
+	float FarFieldProxyDistance;
+
+	/** Material used for the far-field region proxies. Proxy meshes have the landscape layer colors in their vertex colors */
+	UPROPERTY( EditAnywhere, Config, Category = "Open World Generator|Far Field" )
+	TSoftObjectPtr<UMaterialInterface> FarFieldProxyMaterial;
 };
@@ -4,12 +4,15 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Info.h"
+#include "Generation/OWGChunkGenerator.h"
 #include "Generation/OWGWorldGeneratorConfiguration.h"
 #include "OpenWorldGeneratorSubsystem.generated.h"
 
 class UOWGWorldGeneratorConfiguration;
 class IOWGChunkManagerInterface;
 class UChunkTextureManager;
+class UOWGChunkGenerator;
+class AOWGChunk;
 
 /** Singleton instance holding data relevant for the open world generator */
 UCLASS( BlueprintType )
@@ -49,6 +52,24 @@ public:
 
 	/** Attempts to find and load a world generator package given the name */
 	static UOWGWorldGeneratorConfiguration* LoadWorldGeneratorPackageFromShortName( const FString& InWorldGeneratorName );
+
+	/**
+	 * Overrides the world generator, the seed and the region folder selected by the game mode for this world.
+	 * Must be called before any chunks have been created. Used to generate worlds independently of the game mode save data, for example by the pregeneration commandlet
+	 */
+	void OverrideWorldParameters( UOWGWorldGeneratorConfiguration* InWorldGenerator, int32 InWorldSeed, const FString& InRegionFolderPath );
+
+	/**
+	 * Sets up the world generator and the seed received from the server on the client, and creates the client chunk manager regenerating the chunks locally.
+	 * Clients do not have the game mode to pick the world parameters, so there is no chunk manager on the client until this is called. Does nothing if it has already been called
+	 */
+	void InitializeClientWorldParameters( UOWGWorldGeneratorConfiguration* InWorldGenerator, int32 InWorldSeed );
+
+	/** Returns a generator of the given class for the chunk. Reuses a pooled generator instance if there is one, and only allocates a new generator otherwise */
+	UOWGChunkGenerator* AcquireChunkGenerator( AOWGChunk* Chunk, TSubclassOf<UOWGChunkGenerator> GeneratorClass );
+
+	/** Returns a generator that has finished generating to the pool, or discards it if it cannot be reused or the pool for it's class is full */
+	void ReleaseChunkGenerator( UOWGChunkGenerator* ChunkGenerator );
 protected:
 
 	/** Chunk manager that actually manages the chunk I/O and loading/unloading */
@@ -58,6 +79,10 @@ protected:
 	UPROPERTY()
 	UChunkTextureManager* TextureManager;
 
+	/** Generator instances that have finished generating and can be reused for other chunks, per generator class */
+	UPROPERTY( Transient )
+	TMap<TSubclassOf<UOWGChunkGenerator>, FChunkGeneratorPool> PooledChunkGenerators;
+
 	/** World generator that has been selected for this world */
 	UPROPERTY()
 	UOWGWorldGeneratorConfiguration* WorldGeneratorDefinition;
@@ -42,9 +42,15 @@ class OPENWORLDGENERATOR_API FChunkData2D
 	int32 DataElementSize{0};	
 	int32 SurfaceResolutionXY{0};
 	bool bAllowInterpolation{true};
+
+	FORCEINLINE int32 GetTotalDataSize() const { return SurfaceResolutionXY * SurfaceResolutionXY * DataElementSize; }
+	/** Allocates the data block for the current resolution and element size from the pool */
+	void AllocateData();
+	/** Returns the data block back to the pool */
+	void FreeData();
 public:
 	explicit FChunkData2D();
-	FChunkData2D( int32 InSurfaceResolutionXY, int32 InDataElementSize, bool InAllowInterpolation );
+	FChunkData2D( int32 InSurfaceResolutionXY, int32 InDataElementSize, bool InAllowInterpolation, bool bZeroInitialize = true );
 	~FChunkData2D();
 
 	FChunkData2D( const FChunkData2D& InOther );
@@ -60,10 +66,35 @@ public:
 		return FChunkData2D( InSurfaceResolutionXY, sizeof(T), bAllowInterpolation );
 	}
 
+	/** Creates the data without zeroing it. Data storage is recycled between chunks, so the data will contain garbage and must be fully overwritten by the caller */
+	template<typename T>
+	static FChunkData2D CreateUninitialized( int32 InSurfaceResolutionXY, bool bAllowInterpolation = true )
+	{
+		static_assert( TIsPODType<T>::Value, "FChunkSurfaceData only supports POD types" );
+		return FChunkData2D( InSurfaceResolutionXY, sizeof(T), bAllowInterpolation, false );
+	}
+
+	/** Frees all of the data blocks currently held in the pool for re-use by the new chunk data */
+	static void TrimPooledMemory();
+
+	/** Frees the pooled data blocks and disables pooling. Called on module shutdown, blocks freed after that are returned directly to the allocator */
+	static void ShutdownPooledMemory();
+
 	FORCEINLINE bool IsEmpty() const { return SurfaceResolutionXY == 0; }
 	FORCEINLINE int32 GetSurfaceResolutionXY() const { return SurfaceResolutionXY; }
 	FORCEINLINE int32 GetSurfaceElementCount() const { return FMath::Square( SurfaceResolutionXY ); }
 	FORCEINLINE int32 GetDataElementSize() const { return DataElementSize; }
+	FORCEINLINE bool IsInterpolationAllowed() const { return bAllowInterpolation; }
+	FORCEINLINE SIZE_T GetAllocatedSize() const { return SurfaceDataPtr ? GetTotalDataSize() : 0; }
+
+	/** Computes a hash of the grid contents and dimensions. Used to check whenever the data of two grids is exactly the same without transferring it */
+	uint64 ComputeDataHash() const;
+
+	/**
+	 * Compares the grid against another one element by element, and returns the number of elements that are different. All elements are considered different if the dimensions do not match.
+	 * When a tolerance is provided, elements that are not bitwise equal are compared as arrays of floats, and are considered equal if no component differs by more than the tolerance
+	 */
+	int32 CountMismatchingElements( const FChunkData2D& Other, float FloatTolerance = 0.0f ) const;
 
 	FORCEINLINE const void* GetRawDataPtr() const { return SurfaceDataPtr; }
 	FORCEINLINE void* GetRawMutableDataPtr() { return SurfaceDataPtr; }
@@ -319,9 +350,136 @@ public:
 	/** Serializes this chunk data into/out of the archive */
 	void Serialize( FArchive& Ar );
 
+	/**
+	 * Serializes the raw elements of the given rectangle of the grid into/out of the archive. End coordinates are inclusive, and the rectangle is clamped to the grid.
+	 * Only the elements are serialized, so the grid must already have the same resolution and element size when loading
+	 */
+	void SerializeRegion( FArchive& Ar, int32 StartX, int32 StartY, int32 EndX, int32 EndY );
+
 	friend FArchive& operator<<( FArchive& Ar, FChunkData2D& ChunkData )
 	{
 		ChunkData.Serialize( Ar );
 		return Ar;
 	}
 };
+
+/**
+ * Typed view over the chunk data. Element size is validated once when the view is created, and the ranges are validated once per row or rectangle,
+ * so the per-element accessors do not perform any checks outside of checkSlow and the loops over the row spans can be vectorized by the compiler.
+ * Use TChunkData2DView<const T> to view the const chunk data.
+ */
+template<typename T>
+class TChunkData2DView
+{
+	using FChunkDataType = std::conditional_t<std::is_const_v<T>, const FChunkData2D, FChunkData2D>;
+	using FElementType = std::remove_const_t<T>;
+
+	T* DataPtr{nullptr};
+	int32 SurfaceResolutionXY{0};
+	bool bAllowInterpolation{true};
+public:
+	TChunkData2DView() = default;
+
+	explicit TChunkData2DView( FChunkDataType& InChunkData ) : SurfaceResolutionXY( InChunkData.GetSurfaceResolutionXY() ), bAllowInterpolation( InChunkData.IsInterpolationAllowed() )
+	{
+		static_assert( TIsPODType<FElementType>::Value, "FChunkSurfaceData only supports POD types" );
+		checkf( InChunkData.IsEmpty() || InChunkData.GetDataElementSize() == sizeof(FElementType), TEXT("TChunkData2DView used with invalid DataElementSize=%d sizeof(T)=%d"), InChunkData.GetDataElementSize(), sizeof(FElementType) );
+
+		if constexpr ( std::is_const_v<T> )
+		{
+			DataPtr = static_cast<T*>( InChunkData.GetRawDataPtr() );
+		}
+		else
+		{
+			DataPtr = static_cast<T*>( InChunkData.GetRawMutableDataPtr() );
+		}
+	}
+
+	FORCEINLINE bool IsEmpty() const { return SurfaceResolutionXY == 0; }
+	FORCEINLINE int32 GetSurfaceResolutionXY() const { return SurfaceResolutionXY; }
+	FORCEINLINE T* GetData() const { return DataPtr; }
+
+	/** Returns the element at the given position. Position is only validated in the debug builds */
+	FORCEINLINE T& operator()( int32 InPosX, int32 InPosY ) const
+	{
+		checkSlow( InPosX >= 0 && InPosX < SurfaceResolutionXY && InPosY >= 0 && InPosY < SurfaceResolutionXY );
+		return DataPtr[ InPosY * SurfaceResolutionXY + InPosX ];
+	}
+
+	/** Returns the element at the given index into the row-major data. Index is only validated in the debug builds */
+	FORCEINLINE T& operator[]( int32 InElementIndex ) const
+	{
+		checkSlow( InElementIndex >= 0 && InElementIndex < SurfaceResolutionXY * SurfaceResolutionXY );
+		return DataPtr[ InElementIndex ];
+	}
+
+	/** Returns the element at the given position, clamping the position to the border of the data */
+	FORCEINLINE T& GetClamped( int32 InPosX, int32 InPosY ) const
+	{
+		return (*this)( FMath::Clamp( InPosX, 0, SurfaceResolutionXY - 1 ), FMath::Clamp( InPosY, 0, SurfaceResolutionXY - 1 ) );
+	}
+
+	/** Returns the entire row of the data */
+	FORCEINLINE TArrayView<T> GetRow( int32 InPosY ) const
+	{
+#if SAFE_CHUNK_SURFACE_DATA
+		check( InPosY >= 0 && InPosY < SurfaceResolutionXY );
+#endif
+		return TArrayView<T>( DataPtr + InPosY * SurfaceResolutionXY, SurfaceResolutionXY );
+	}
+
+	/** Returns the span of the row between StartX and EndX, inclusive */
+	FORCEINLINE TArrayView<T> GetRowSpan( int32 InPosY, int32 InStartX, int32 InEndX ) const
+	{
+#if SAFE_CHUNK_SURFACE_DATA
+		check( InPosY >= 0 && InPosY < SurfaceResolutionXY );
+		check( InStartX >= 0 && InStartX <= InEndX + 1 && InEndX < SurfaceResolutionXY );
+#endif
+		return TArrayView<T>( DataPtr + InPosY * SurfaceResolutionXY + InStartX, InEndX - InStartX + 1 );
+	}
+
+	/**
+	 * Calls the callback for each row of the rectangle, clamped to the data bounds, with the span of the row inside the rectangle.
+	 * The range is inclusive. Callback signature is void( int32 PosY, int32 StartX, TArrayView<T> RowSpan )
+	 */
+	template<typename CallbackType>
+	FORCEINLINE void ForEachRowInRect( int32 InStartX, int32 InStartY, int32 InEndX, int32 InEndY, CallbackType&& Callback ) const
+	{
+		const int32 ClampedStartX = FMath::Max( InStartX, 0 );
+		const int32 ClampedStartY = FMath::Max( InStartY, 0 );
+		const int32 ClampedEndX = FMath::Min( InEndX, SurfaceResolutionXY - 1 );
+		const int32 ClampedEndY = FMath::Min( InEndY, SurfaceResolutionXY - 1 );
+
+		if ( ClampedStartX <= ClampedEndX )
+		{
+			for ( int32 PosY = ClampedStartY; PosY <= ClampedEndY; PosY++ )
+			{
+				Callback( PosY, ClampedStartX, TArrayView<T>( DataPtr + PosY * SurfaceResolutionXY + ClampedStartX, ClampedEndX - ClampedStartX + 1 ) );
+			}
+		}
+	}
+
+	/** Returns the value interpolated between the adjacent points, using the normalized coordinate in [0;1] range. Positions outside of the data are clamped to the border */
+	FElementType GetInterpolatedElementAt( const FVector2f& NormalizedPosition ) const
+	{
+		const FVector2f GridPosition( FMath::Clamp( NormalizedPosition.X, 0.0f, 1.0f ) * ( SurfaceResolutionXY - 1 ), FMath::Clamp( NormalizedPosition.Y, 0.0f, 1.0f ) * ( SurfaceResolutionXY - 1 ) );
+		const int32 PosX = FMath::Min( FMath::TruncToInt32( GridPosition.X ), SurfaceResolutionXY - 2 );
+		const int32 PosY = FMath::Min( FMath::TruncToInt32( GridPosition.Y ), SurfaceResolutionXY - 2 );
+		const float FractionX = GridPosition.X - PosX;
+		const float FractionY = GridPosition.Y - PosY;
+
+		const T* RowY0 = DataPtr + PosY * SurfaceResolutionXY + PosX;
+		const T* RowY1 = RowY0 + SurfaceResolutionXY;
+
+		// Return the closest element if interpolation is not allowed for this data
+		if ( !bAllowInterpolation )
+		{
+			const T* ClosestRow = FractionY <= 0.5f ? RowY0 : RowY1;
+			return FractionX <= 0.5f ? ClosestRow[0] : ClosestRow[1];
+		}
+
+		const FElementType LerpDataY0 = ChunkDataInternal::GetSafeNormal( FMath::Lerp( RowY0[0], RowY0[1], FractionX ) );
+		const FElementType LerpDataY1 = ChunkDataInternal::GetSafeNormal( FMath::Lerp( RowY1[0], RowY1[1], FractionX ) );
+		return ChunkDataInternal::GetSafeNormal( FMath::Lerp( LerpDataY0, LerpDataY1, FractionY ) );
+	}
+};
@@ -0,0 +1,34 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Partition/ChunkCoord.h"
+#include "Partition/ChunkData2D.h"
+
+/** Copy of the generated data of a single chunk, used to verify that the generation stays deterministic across code changes */
+struct OPENWORLDGENERATOR_API FChunkGenerationSnapshot
+{
+	/** Coordinate of the chunk the snapshot has been taken from */
+	FChunkCoord ChunkCoord;
+	/** Chunk data grids keyed by their chunk data ID, and noise grids keyed by the name of their noise identifier */
+	TMap<FName, FChunkData2D> Grids;
+	/** Asset paths of the biomes in the chunk's biome palette, in the palette order */
+	TArray<FString> BiomePalette;
+	/** Asset paths of the landscape layers in the chunk's weight map descriptor, in the descriptor order */
+	TArray<FString> WeightMapLayers;
+
+	void Serialize( FArchive& Ar );
+
+	/**
+	 * Compares this snapshot against the expected one grid by grid and element by element, and appends a description of every difference found.
+	 * Float grids can be given a tolerance by their name, grids without one have to match exactly. Returns true if the snapshots match
+	 */
+	bool Compare( const FChunkGenerationSnapshot& Expected, const TMap<FName, float>& GridTolerances, TArray<FString>& OutDifferences ) const;
+
+	friend FArchive& operator<<( FArchive& Ar, FChunkGenerationSnapshot& Snapshot )
+	{
+		Snapshot.Serialize( Ar );
+		return Ar;
+	}
+};
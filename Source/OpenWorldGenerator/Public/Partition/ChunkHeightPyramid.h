@@ -0,0 +1,69 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Interval.h"
+
+class FChunkData2D;
+
+/**
+ * Hierarchical min/max height pyramid built on top of the chunk heightmap.
+ * Level 0 stores the height range of each heightmap quad, and each next level stores the combined range of the 2x2 cells of the previous level, down to a single root cell.
+ * Allows rejecting large parts of the landscape quickly when tracing rays against it, without having to go through the physics scene.
+ * The pyramid is transient and is rebuilt from the heightmap when the chunk is loaded.
+ */
+class OPENWORLDGENERATOR_API FChunkHeightPyramid
+{
+	/** Height ranges of all cells of all levels, starting with level 0 */
+	TArray<FFloatInterval> Cells;
+	/** Offset of the first cell of each level in the Cells array */
+	TArray<int32> LevelOffsets;
+	/** Amount of cells across one axis for each level */
+	TArray<int32> LevelResolutions;
+	/** Resolution of the heightmap this pyramid has been built for */
+	int32 HeightMapResolutionXY{0};
+public:
+	FORCEINLINE bool IsEmpty() const { return HeightMapResolutionXY == 0; }
+	FORCEINLINE int32 GetNumLevels() const { return LevelResolutions.Num(); }
+	FORCEINLINE int32 GetLevelResolution( int32 Level ) const { return LevelResolutions[ Level ]; }
+
+	/** Returns the height range of the given cell of the given level */
+	FORCEINLINE FFloatInterval GetCellHeightRange( int32 Level, int32 CellX, int32 CellY ) const
+	{
+		checkSlow( CellX >= 0 && CellX < LevelResolutions[ Level ] && CellY >= 0 && CellY < LevelResolutions[ Level ] );
+		return Cells[ LevelOffsets[ Level ] + CellY * LevelResolutions[ Level ] + CellX ];
+	}
+
+	/** Returns the height range of the entire chunk */
+	FFloatInterval GetHeightRange() const;
+
+	/** Rebuilds the entire pyramid from the given heightmap */
+	void Build( const FChunkData2D& HeightMap );
+
+	/** Updates the pyramid for the given range of heightmap points. Falls back to the full rebuild if the pyramid has not been built for this heightmap yet */
+	void PartialUpdate( const FChunkData2D& HeightMap, int32 StartX, int32 StartY, int32 EndX, int32 EndY );
+
+	/**
+	 * Traces a segment against the landscape described by the heightmap this pyramid has been built for. Both the heightmap and the segment are in chunk local space.
+	 *
+	 * @param HeightMap heightmap the pyramid has been built from
+	 * @param TraceStart start of the segment, in chunk local space
+	 * @param TraceEnd end of the segment, in chunk local space
+	 * @param OutHitTime fraction of the segment at which the first hit occured, in [0;1] range
+	 * @param OutHitNormal normal of the landscape triangle that has been hit, in chunk local space
+	 * @return true if the segment hit the landscape
+	 */
+	bool LineTrace_Local( const FChunkData2D& HeightMap, const FVector& TraceStart, const FVector& TraceEnd, double& OutHitTime, FVector& OutHitNormal ) const;
+
+	/** Returns the amount of memory allocated by this pyramid */
+	SIZE_T GetAllocatedSize() const;
+private:
+	/** Recalculates the given range of cells of the given level from the level below, or from the heightmap for level 0. Range is inclusive */
+	void UpdateLevelCells( const FChunkData2D& HeightMap, int32 Level, int32 StartX, int32 StartY, int32 EndX, int32 EndY );
+
+	struct FTraceContext;
+	bool TraceNode_Recursive( const FTraceContext& Context, int32 Level, int32 NodeX, int32 NodeY, double& InOutHitTime, FVector& OutHitNormal ) const;
+	bool IntersectNodeBounds( const FTraceContext& Context, int32 Level, int32 NodeX, int32 NodeY, double& OutEntryTime ) const;
+	bool TraceQuadCell( const FTraceContext& Context, int32 CellX, int32 CellY, double& InOutHitTime, FVector& OutHitNormal ) const;
+};
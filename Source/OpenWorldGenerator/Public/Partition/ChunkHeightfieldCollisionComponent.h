@@ -54,6 +54,12 @@ public:
 
 	/** Performs a partial update of the height field, or creates a physics state if it has not been created yet */
 	void PartialUpdateOrCreateHeightField( int32 StartX, int32 StartY, int32 EndX, int32 EndY );
+
+	/** Destroys the physics state and releases the height field data, so that it is built again from the chunk data the next time the physics state is created */
+	void ReleaseCollisionData();
+
+	/** Returns the memory used by the height field and the cached navigation samples */
+	SIZE_T GetCollisionAllocatedSize() const;
 protected:
 	/** Updates collision data once the collision state has already been initialized and created. Should be called from the game thread without holding the Chaos lock. If collision is not initialized yet, does nothing */
 	void PartialUpdateCollisionData( int32 StartX, int32 StartY, int32 EndX, int32 EndY );
@@ -4,9 +4,10 @@
 
 #include "CoreMinimal.h"
 #include "MaterialTypes.h"
+#include "Rendering/ChunkTextureManager.h"
 #include "Generation/OWGWorldGeneratorConfiguration.h"
 
-class UTexture2D;
+class UTexture2DDynamic;
 class AOWGChunk;
 class UMaterialInstance;
 class UMaterialInstanceDynamic;
@@ -22,6 +23,9 @@ struct FLandscapeLayerParameterData
 {
 	FMaterialParameterInfo WeightMapTexture;
 	FMaterialParameterInfo WeightMapChannelMask;
+	FMaterialParameterInfo WeightMapTextureArray;
+	FMaterialParameterInfo WeightMapSliceIndex;
+	FMaterialParameterInfo WeightMapPrimitiveDataIndex;
 	FMaterialParameterInfo GrassColor;
 	bool bIsBackgroundLayer{false};
 
@@ -37,18 +41,34 @@ public:
 	UMaterialInstance* GetMaterialInstance( bool bCreate = true );
 
 	void ReleaseMaterialInstance();
-	void RebindTexturesToMaterialParameters();
+	/** Binds the current weight map textures to the material. Returns true if the material instance has been replaced with a different shared instance and needs to be re-applied to the mesh */
+	bool RebindTexturesToMaterialParameters();
 
 	void AddReferencedObjects( FReferenceCollector& ReferenceCollector );
 private:
 	void CreateNewMaterialInstance();
+
+	/** Populates the layer parameters from the material user data of the base material. Returns false if the material does not have valid user data */
+	bool PopulateLayerParameters( UMaterialInterface* InBaseMaterial );
+	/** Applies the weight map bindings to the given material instance. Shared instances receive the custom primitive data indices instead of the atlas slice indices */
+	void ApplyLayerParameters( UMaterialInstanceDynamic* TargetMaterialInstance, bool bIsSharedInstance ) const;
+
+	/** Creates the key of the shared material instance matching the current weight map layout of the chunk */
+	FSharedLandscapeMaterialKey MakeSharedMaterialKey() const;
+	/** Acquires the shared material instance for the given key from the texture manager */
+	UMaterialInstanceDynamic* AcquireSharedMaterialInstance( const FSharedLandscapeMaterialKey& MaterialKey ) const;
 protected:
 	FChunkLandscapeMaterialManager* ParentManager;
 
-	/** Dynamic material instances generated for the landscape (per biome) */
+	/** Dynamic material instances generated for the landscape (per biome), or the shared material instance if the instances are shared between the chunks */
 	TObjectPtr<UMaterialInstanceDynamic> MaterialInstance{};
 	/** Biome we are based on */
 	TObjectPtr<UOWGBiome> Biome;
+	/** Base material the material instance has been created from */
+	TObjectPtr<UMaterialInterface> BaseMaterial;
+
+	/** Key of the shared material instance we are currently using. Not valid if the material instance is owned by this chunk */
+	FSharedLandscapeMaterialKey SharedMaterialKey;
 
 	TMap<TObjectPtr<UOWGChunkLandscapeLayer>, FLandscapeLayerParameterData> LayerToBlendTextureNameAndChannelMaskParameters;
 };
@@ -65,15 +85,33 @@ public:
 
 	void ReleaseTextures();
 	void AddReferencedObjects( FReferenceCollector& ReferenceCollector );
+
+	/** Returns the GPU memory used by the weight map textures or atlas slices allocated for the chunk */
+	SIZE_T GetWeightMapTextureMemory() const;
 protected:
 	void RegenerateTextures();
 
+	/** Returns the number of weight map textures or atlas slices currently allocated for the chunk */
+	int32 GetNumWeightMapTextures() const;
+
+	/** Writes the atlas slice indices into the custom primitive data of the landscape mesh, for the shared material instances to read them */
+	void UpdateCustomPrimitiveData();
+
 	friend class FChunkBiomeLandscapeMaterial; 
 	/** The chunk owning this material manager */
 	TObjectPtr<AOWGChunk> OwnerChunk{};
 
 	/** Texture holding the weight map data for the chunk. Textures are automatically added as needed to support new layers and dynamically updated */ 
-	TArray<TObjectPtr<UTexture2D>> WeightMapTextures;
+	TArray<TObjectPtr<UTexture2DDynamic>> WeightMapTextures;
+
+	/** Slices of the weight map atlases holding the weight map data for the chunk, used instead of the weight map textures when atlases are enabled */
+	TArray<FChunkWeightMapAtlasSlice> WeightMapAtlasSlices;
+
+	/** True if this manager uses the weight map atlases instead of individual textures. Determined once on creation */
+	bool bUseWeightMapAtlas{false};
+
+	/** True if this manager uses the landscape material instances shared between the chunks. Determined once on creation, requires the weight map atlases */
+	bool bShareMaterialInstances{false};
 
 	TArray<FChunkBiomeLandscapeMaterial> PerBiomeMaterials;
 
@@ -9,11 +9,54 @@
 class FChunkData2D;
 class AOWGChunk;
 class FReferenceCollector;
+struct FSurfaceMeshSkirtSettings;
+
+class FChunkLandscapeMeshManager;
+
+/**
+ * Global cache of the inactive landscape LOD meshes of all chunks. Meshes of the LODs the chunks are not currently using are kept around to make LOD swaps instant,
+ * and the least recently used ones are evicted once their total size exceeds the budget set by owg.LandscapeMeshCacheBudgetMB. Only accessed from the game thread.
+ */
+class OPENWORLDGENERATOR_API FChunkLandscapeMeshCache : public FNoncopyable
+{
+public:
+	static FChunkLandscapeMeshCache& Get();
+
+	/** Updates the size of the cached mesh and marks it as the most recently used, or removes it from the cache if the size is zero. Evicts the least recently used meshes if the cache is over budget */
+	void UpdateCachedMesh( FChunkLandscapeMeshManager* MeshManager, int32 LODIndex, SIZE_T MeshSize );
+
+	/** Records a LOD swap that could or could not be served by the cached mesh */
+	void RecordLookup( bool bHit );
+
+	/** Evicts the least recently used meshes until the cache fits into the budget */
+	void Trim();
+
+	/** Logs the memory used by the cache, the hit rate and the number of evictions */
+	void DumpStats() const;
+
+	FORCEINLINE SIZE_T GetCachedMemory() const { return TotalCachedMemory; }
+private:
+	struct FCachedMeshEntry
+	{
+		SIZE_T MeshSize{0};
+		uint64 LastUseIndex{0};
+	};
+
+	/** All meshes currently in the cache, keyed by their owner mesh manager and LOD index */
+	TMap<TPair<FChunkLandscapeMeshManager*, int32>, FCachedMeshEntry> CachedMeshes;
+	SIZE_T TotalCachedMemory{0};
+	uint64 NextUseIndex{0};
+
+	uint64 NumHits{0};
+	uint64 NumMisses{0};
+	uint64 NumEvictions{0};
+};
 
 class OPENWORLDGENERATOR_API FChunkLandscapeMeshManager : public FNoncopyable
 {
 public:
 	explicit FChunkLandscapeMeshManager( AOWGChunk* InChunk );
+	~FChunkLandscapeMeshManager();
 	
 	/** Invalidates the currently generated landscape mesh and schedules it's regeneration in background */
 	void InvalidateLandscapeMesh();
@@ -28,21 +71,33 @@ public:
 	void ForceUpdateLandscapeMesh( int32 NewMeshLODIndex );
 
 	void AddReferencedObjects( FReferenceCollector& ReferenceCollector );
+
+	/** Returns the memory used by the generated landscape LOD meshes */
+	SIZE_T GetAllocatedSize() const;
 private:
 	friend class FAsyncLODGenerationTask;
+	friend class FChunkLandscapeMeshCache;
+
+	/** Updates the entry of the cached LOD mesh in the global mesh cache after it has been added, replaced or taken out */
+	void UpdateCachedLODMesh( int32 LODIndex );
+	/** Called by the global mesh cache to free the cached mesh of the given LOD. The mesh will be regenerated when the chunk switches to that LOD again */
+	void EvictCachedLODMesh( int32 LODIndex );
 
 	void RebuildLandscapeMeshLODAsync( int32 LODIndex );
 	void RebuildLandscapeMeshLODBlocking( int32 LODIndex );
 
 	void OnLandscapeMeshLODRebuilt( int32 LODIndex, int32 ChangelistNumber, UE::Geometry::FDynamicMesh3& GeneratedMesh );
 
+	/** Returns the skirt settings for the landscape meshes of the owner chunk */
+	FSurfaceMeshSkirtSettings GetLandscapeSkirtSettings() const;
+
 	/** Generates a landscape LOD mesh. Can be called off the main thread */
-	static void GenerateLandscapeLODInternal( UE::Geometry::FDynamicMesh3& OutLandscapeMesh, int32 LODIndex, const FChunkData2D& HeightData, const FChunkData2D& BiomeMap, const FChunkData2D& NormalData );
+	static void GenerateLandscapeLODInternal( UE::Geometry::FDynamicMesh3& OutLandscapeMesh, int32 LODIndex, const FChunkData2D& HeightData, const FChunkData2D& BiomeMap, const FChunkData2D& NormalData, const FSurfaceMeshSkirtSettings& SkirtSettings );
 protected:
 	/** The chunk owning this material manager */
 	TObjectPtr<AOWGChunk> OwnerChunk{};
 
-	/** Meshes used for rendering landscape at various distances, mapped to their current changelist number */
+	/** Meshes used for rendering landscape at various distances, mapped to their current changelist number. The mesh of the active LOD is moved into the mesh component, the rest are tracked by the global mesh cache */
 	TArray<TPair<UE::Geometry::FDynamicMesh3, int32>> LandscapeLODMeshes;
 
 	/** Async tasks currently generating LOD meshes. Can be waited on if needed */
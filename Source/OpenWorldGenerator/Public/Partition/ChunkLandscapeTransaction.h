@@ -0,0 +1,32 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Partition/OWGChunk.h"
+
+/**
+ * Batches landscape modifications across multiple chunks.
+ * Chunk data is modified immediately as brushes are added, but the derived data (gradients, normals, height pyramid, collision, meshes and weight map textures)
+ * is only recalculated once per chunk when the transaction is committed, over the union of all areas modified in that chunk.
+ * Since all chunks are modified before any of them are recalculated, the shared border points are consistent between the neighbours by the time the derived data is rebuilt.
+ * The transaction is committed automatically when it goes out of scope.
+ */
+class OPENWORLDGENERATOR_API FChunkLandscapeTransaction : public FNoncopyable
+{
+	TWeakObjectPtr<const UObject> WorldContext;
+	/** Chunks modified in this transaction, and the areas of them that have been modified */
+	TMap<TWeakObjectPtr<AOWGChunk>, FChunkLandscapeDirtyRegion> DirtyChunks;
+public:
+	explicit FChunkLandscapeTransaction( const UObject* InWorldContext );
+	~FChunkLandscapeTransaction();
+
+	/** Applies the modification to all of the loaded chunks overlapping the brush. Derived data of the chunks will be updated when the transaction is committed */
+	void ModifyLandscape( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, const FChunkLandscapeModification& LandscapeModification, float MinWeight = 0.0f );
+
+	/** Recalculates the derived data for all of the chunks modified in this transaction. The transaction can continue to be used after it has been committed */
+	void Commit();
+
+	/** Returns the number of chunks that have been modified since the last commit */
+	FORCEINLINE int32 GetNumDirtyChunks() const { return DirtyChunks.Num(); }
+};
@@ -6,27 +6,77 @@
 #include "UObject/Object.h"
 
 class UOWGChunkLandscapeLayer;
+class FChunkData2D;
 
-/** A singular weight map point for the chunk landscape */
+/**
+ * A singular weight map point for the chunk landscape.
+ * Weights are stored sparsely: each point holds up to MaxLayersPerPoint layers with the largest contributions, along with their indices.
+ * Layers that are not present in the point implicitly have zero weight. Unused entries always have zero weight and zero layer index.
+ */
 struct OPENWORLDGENERATOR_API FChunkLandscapeWeight
 {
 	static constexpr int32 MaxWeightMapLayers = 16;
+	static constexpr int32 MaxLayersPerPoint = 4;
+	static constexpr int32 LayerIndexBits = 4;
+	static_assert( MaxWeightMapLayers <= ( 1 << LayerIndexBits ), "Layer index bits must be able to hold any weight map layer index" );
 
-	/** Weights of all of the individual layers */
-	uint8 LayerWeights[MaxWeightMapLayers]{};
+	/** Weights of the layers present in this point */
+	uint8 EntryWeights[MaxLayersPerPoint]{};
+	/** Indices of the layers present in this point, LayerIndexBits per entry */
+	uint16 PackedLayerIndices{0};
+
+	/** Returns the index of the layer stored in the given entry */
+	FORCEINLINE int32 GetEntryLayerIndex( int32 EntryIndex ) const
+	{
+		return ( PackedLayerIndices >> ( EntryIndex * LayerIndexBits ) ) & ( ( 1 << LayerIndexBits ) - 1 );
+	}
+
+	/** Updates the layer index and the weight of the given entry */
+	FORCEINLINE void SetEntry( int32 EntryIndex, int32 LayerIndex, uint8 Weight )
+	{
+		const int32 EntryShift = EntryIndex * LayerIndexBits;
+		const uint16 EntryMask = (uint16) ( ( ( 1 << LayerIndexBits ) - 1 ) << EntryShift );
+
+		// Keep the unused entries fully zeroed so the identical weights are always bitwise identical
+		const int32 StoredLayerIndex = Weight == 0 ? 0 : LayerIndex;
+		PackedLayerIndices = (uint16) ( ( PackedLayerIndices & ~EntryMask ) | ( StoredLayerIndex << EntryShift ) );
+		EntryWeights[ EntryIndex ] = Weight;
+	}
+
+	/** Returns the index of the entry holding the given layer, or INDEX_NONE if the layer is not present in this point */
+	FORCEINLINE int32 FindLayerEntry( int32 LayerIndex ) const
+	{
+		for ( int32 EntryIndex = 0; EntryIndex < MaxLayersPerPoint; EntryIndex++ )
+		{
+			if ( EntryWeights[ EntryIndex ] != 0 && GetEntryLayerIndex( EntryIndex ) == LayerIndex )
+			{
+				return EntryIndex;
+			}
+		}
+		return INDEX_NONE;
+	}
+
+	/** Returns the absolute weight of the given layer */
+	FORCEINLINE uint8 GetAbsoluteWeight( int32 LayerIndex ) const
+	{
+		const int32 EntryIndex = FindLayerEntry( LayerIndex );
+		return EntryIndex != INDEX_NONE ? EntryWeights[ EntryIndex ] : 0;
+	}
 
 	/** Returns the index of the layer with the largest contribution */
 	FORCEINLINE_DEBUGGABLE int32 GetLayerWithLargestContribution() const
 	{
 		int32 LargestContributionLayer = 0;
-		uint8 LargestContributionValue = LayerWeights[ LargestContributionLayer ];
+		uint8 LargestContributionValue = 0;
 
-		for ( int32 LayerIndex = 1; LayerIndex < MaxWeightMapLayers; LayerIndex++ )
+		for ( int32 EntryIndex = 0; EntryIndex < MaxLayersPerPoint; EntryIndex++ )
 		{
-			if ( LayerWeights[ LayerIndex ] > LargestContributionValue )
+			// Ties are resolved towards the lowest layer index to not depend on the order of the entries
+			const int32 EntryLayerIndex = GetEntryLayerIndex( EntryIndex );
+			if ( EntryWeights[ EntryIndex ] > LargestContributionValue || ( EntryWeights[ EntryIndex ] == LargestContributionValue && LargestContributionValue != 0 && EntryLayerIndex < LargestContributionLayer ) )
 			{
-				LargestContributionLayer = LayerIndex;
-				LargestContributionValue = LayerWeights[ LayerIndex ];
+				LargestContributionLayer = EntryLayerIndex;
+				LargestContributionValue = EntryWeights[ EntryIndex ];
 			}
 		}
 		return LargestContributionLayer;
@@ -35,22 +85,39 @@ struct OPENWORLDGENERATOR_API FChunkLandscapeWeight
 	/** Returns the sum of all of the entries in the weight map */
 	FORCEINLINE_DEBUGGABLE int32 GetTotalWeight() const
 	{
-		// Undefined weights should always be zero, and therefore safe to add to the total weight
+		// Unused entries always have zero weight, and are therefore safe to add to the total weight
 		int32 ResultWeight = 0;
-		for ( int32 LayerIndex = 0; LayerIndex < MaxWeightMapLayers; LayerIndex++ )
+		for ( int32 EntryIndex = 0; EntryIndex < MaxLayersPerPoint; EntryIndex++ )
 		{
-			ResultWeight += LayerWeights[ LayerIndex ];
+			ResultWeight += EntryWeights[ EntryIndex ];
 		}
 		return ResultWeight;
 	}
 
-	/** Returns normalized weights for the defined layers in the weight map entry. OutNormalizedWeights should be an array with at least NumLayers entries */
+	/** Expands the weights into a dense array indexed by the layer index. OutLayerWeights should be an array with at least MaxWeightMapLayers entries */
+	FORCEINLINE_DEBUGGABLE void GetAbsoluteWeights( uint8* OutLayerWeights ) const
+	{
+		FMemory::Memzero( OutLayerWeights, MaxWeightMapLayers * sizeof(uint8) );
+		for ( int32 EntryIndex = 0; EntryIndex < MaxLayersPerPoint; EntryIndex++ )
+		{
+			OutLayerWeights[ GetEntryLayerIndex( EntryIndex ) ] += EntryWeights[ EntryIndex ];
+		}
+	}
+
+	/** Returns normalized weights for the defined layers in the weight map entry. OutNormalizedWeights should be an array with at least MaxWeightMapLayers entries */
 	FORCEINLINE_DEBUGGABLE void GetNormalizedWeights( float* OutNormalizedWeights ) const
 	{
 		const int32 TotalWeight = GetTotalWeight();
 		for ( int32 LayerIndex = 0; LayerIndex < MaxWeightMapLayers; LayerIndex++ )
 		{
-			OutNormalizedWeights[ LayerIndex ] = TotalWeight == 0 ? 0.0f : ( LayerWeights[ LayerIndex ] * 1.0f / TotalWeight );
+			OutNormalizedWeights[ LayerIndex ] = 0.0f;
+		}
+		if ( TotalWeight != 0 )
+		{
+			for ( int32 EntryIndex = 0; EntryIndex < MaxLayersPerPoint; EntryIndex++ )
+			{
+				OutNormalizedWeights[ GetEntryLayerIndex( EntryIndex ) ] += EntryWeights[ EntryIndex ] * 1.0f / TotalWeight;
+			}
 		}
 	}
 
@@ -58,42 +125,93 @@ struct OPENWORLDGENERATOR_API FChunkLandscapeWeight
 	FORCEINLINE_DEBUGGABLE float GetNormalizedWeight( int32 LayerIndex ) const
 	{
 		const int32 TotalWeight = GetTotalWeight();
-		return TotalWeight == 0 ? 0 : ( LayerWeights[ LayerIndex ] * 1.0f / TotalWeight );
+		return TotalWeight == 0 ? 0 : ( GetAbsoluteWeight( LayerIndex ) * 1.0f / TotalWeight );
 	}
 
 	/** Makes the given layer have the normalized weight value of NewWeight. NewWeight is a normalized absolute weight of this layer where 1 = full blend (no other layers) and 0 = no layer */
 	FORCEINLINE_DEBUGGABLE void SetNormalizedWeight( int32 LayerIndex, float NewWeight, int32 NumLayers )
 	{
+		check( LayerIndex < NumLayers );
+
 		// Calculate total weight excluding current layer, and the new weight value for the current layer
-		const int32 CurrentTotalWeight = GetTotalWeight() - LayerWeights[ LayerIndex ];
+		const int32 CurrentTotalWeight = GetTotalWeight() - GetAbsoluteWeight( LayerIndex );
 		const uint8 QuantizedNewWeightForCurrentLayer = (uint8) FMath::Clamp( FMath::RoundToInt32( NewWeight * 255.0f ), 0, 255 );
 
 		// New total weight should be able to be fully satisfied by one channel. That means, it should be 255 or less
 		constexpr int32 NewTotalWeight = 255;
 		const int32 QuantizedTotalWeightForOtherLayers = NewTotalWeight - QuantizedNewWeightForCurrentLayer;
 
-		// Go over every channel and adjust their absolute value
-		for ( int32 OtherLayerIndex = 0; OtherLayerIndex < NumLayers; OtherLayerIndex++ )
+		// Go over every other present layer and adjust their absolute value
+		for ( int32 EntryIndex = 0; EntryIndex < MaxLayersPerPoint; EntryIndex++ )
 		{
-			// Do not re-scale the layer that we have fixed
-			if ( OtherLayerIndex == LayerIndex )
+			const int32 OtherLayerIndex = GetEntryLayerIndex( EntryIndex );
+			if ( EntryWeights[ EntryIndex ] != 0 && OtherLayerIndex != LayerIndex && CurrentTotalWeight != 0 )
 			{
-				LayerWeights[OtherLayerIndex] = QuantizedNewWeightForCurrentLayer;
-				continue;
+				// Scale old relative weight to the new total weight
+				const float QuantizedNewWeight = EntryWeights[ EntryIndex ] * 1.0f / CurrentTotalWeight * QuantizedTotalWeightForOtherLayers;
+				SetEntry( EntryIndex, OtherLayerIndex, (uint8) FMath::Clamp( FMath::RoundToInt32( QuantizedNewWeight ), 0, 255 ) );
 			}
-			// Scale old relative weight to the new total weight
-			const float QuantizedNewWeight = LayerWeights[OtherLayerIndex] * 1.0f / CurrentTotalWeight * QuantizedTotalWeightForOtherLayers;
-			LayerWeights[OtherLayerIndex] = (uint8) FMath::Clamp( FMath::RoundToInt32( QuantizedNewWeight ), 0, 255 );
 		}
+		SetAbsoluteWeight( LayerIndex, QuantizedNewWeightForCurrentLayer );
 	}
 
-	/** Applies the absolute weight value to the given layer index */
+	/**
+	 * Applies the absolute weight value to the given layer index.
+	 * If all entries are already occupied by other layers, the layer with the smallest contribution is evicted, unless it contributes more than the new layer.
+	 */
 	FORCEINLINE_DEBUGGABLE void SetAbsoluteWeight( int32 LayerIndex, uint8 NewAbsoluteWeight )
 	{
-		LayerWeights[LayerIndex] = NewAbsoluteWeight;
+		checkSlow( LayerIndex >= 0 && LayerIndex < MaxWeightMapLayers );
+
+		// Update the existing entry if this layer is already present
+		const int32 ExistingEntryIndex = FindLayerEntry( LayerIndex );
+		if ( ExistingEntryIndex != INDEX_NONE )
+		{
+			SetEntry( ExistingEntryIndex, LayerIndex, NewAbsoluteWeight );
+			return;
+		}
+		if ( NewAbsoluteWeight == 0 )
+		{
+			return;
+		}
+
+		// Find the free entry, or the entry with the smallest weight otherwise
+		int32 SmallestEntryIndex = 0;
+		for ( int32 EntryIndex = 1; EntryIndex < MaxLayersPerPoint; EntryIndex++ )
+		{
+			if ( EntryWeights[ EntryIndex ] < EntryWeights[ SmallestEntryIndex ] )
+			{
+				SmallestEntryIndex = EntryIndex;
+			}
+		}
+		if ( EntryWeights[ SmallestEntryIndex ] < NewAbsoluteWeight )
+		{
+			SetEntry( SmallestEntryIndex, LayerIndex, NewAbsoluteWeight );
+		}
+	}
+
+	/** Creates a sparse weight from the dense array of weights indexed by the layer index, keeping the layers with the largest contributions */
+	static FORCEINLINE_DEBUGGABLE FChunkLandscapeWeight FromAbsoluteWeights( const uint8* LayerWeights )
+	{
+		FChunkLandscapeWeight ResultWeight;
+		for ( int32 LayerIndex = 0; LayerIndex < MaxWeightMapLayers; LayerIndex++ )
+		{
+			ResultWeight.SetAbsoluteWeight( LayerIndex, LayerWeights[ LayerIndex ] );
+		}
+		return ResultWeight;
+	}
+
+	/** Converts the weight map saved with the dense layer weights (before FOpenWorldGeneratorVersion::SparseLandscapeWeights) into the sparse representation */
+	static void ConvertLegacyDenseWeightMap( FChunkData2D& InOutWeightMap );
+
+	FORCEINLINE bool operator==( const FChunkLandscapeWeight& Other ) const
+	{
+		return PackedLayerIndices == Other.PackedLayerIndices && FMemory::Memcmp( EntryWeights, Other.EntryWeights, sizeof(EntryWeights) ) == 0;
 	}
 };
 
+static_assert( sizeof(FChunkLandscapeWeight) == 6, "FChunkLandscapeWeight is serialized as raw memory, changing it's size requires a new FOpenWorldGeneratorVersion" );
+
 /** Landscape weight is a POD type */
 template<>
 struct TIsPODType<FChunkLandscapeWeight> { enum { Value = true }; };
@@ -108,24 +226,55 @@ struct TCustomLerp<FChunkLandscapeWeight>
 	template<class U>
 	static FORCEINLINE_DEBUGGABLE FChunkLandscapeWeight Lerp(const FChunkLandscapeWeight& A, const FChunkLandscapeWeight& B, const U& Alpha)
 	{
-		// We need to normalize the weights first to be able to Lerp them
-		float NormalizedWeightsA[FChunkLandscapeWeight::MaxWeightMapLayers];
-		float NormalizedWeightsB[FChunkLandscapeWeight::MaxWeightMapLayers];
-
-		A.GetNormalizedWeights( NormalizedWeightsA );
-		B.GetNormalizedWeights( NormalizedWeightsB );
+		// We need to normalize the weights first to be able to Lerp them. Only layers present in either of the points can have non-zero weight in the result
+		const int32 TotalWeightA = A.GetTotalWeight();
+		const int32 TotalWeightB = B.GetTotalWeight();
+		const float NormalizationFactorA = TotalWeightA == 0 ? 0.0f : 1.0f / TotalWeightA;
+		const float NormalizationFactorB = TotalWeightB == 0 ? 0.0f : 1.0f / TotalWeightB;
 
 		// Lerp each layer weight separately and quantize them to our valid value range after that
 		FChunkLandscapeWeight ResultWeight;
-		for ( int32 LayerIndex = 0; LayerIndex < FChunkLandscapeWeight::MaxWeightMapLayers; LayerIndex++ )
+		const auto LerpLayerWeight = [&]( int32 LayerIndex )
+		{
+			const float InterpolatedWeight = FMath::Lerp( A.GetAbsoluteWeight( LayerIndex ) * NormalizationFactorA, B.GetAbsoluteWeight( LayerIndex ) * NormalizationFactorB, Alpha );
+			ResultWeight.SetAbsoluteWeight( LayerIndex, (uint8) FMath::Clamp( FMath::RoundToInt32( InterpolatedWeight * 255 ), 0, 255 ) );
+		};
+		for ( int32 EntryIndex = 0; EntryIndex < FChunkLandscapeWeight::MaxLayersPerPoint; EntryIndex++ )
+		{
+			if ( A.EntryWeights[ EntryIndex ] != 0 )
+			{
+				LerpLayerWeight( A.GetEntryLayerIndex( EntryIndex ) );
+			}
+		}
+		for ( int32 EntryIndex = 0; EntryIndex < FChunkLandscapeWeight::MaxLayersPerPoint; EntryIndex++ )
 		{
-			const float InterpolatedWeight = FMath::Lerp( NormalizedWeightsA[ LayerIndex ], NormalizedWeightsB[ LayerIndex ], Alpha );
-			ResultWeight.LayerWeights[ LayerIndex ] = (uint8) FMath::Clamp( FMath::RoundToInt32( InterpolatedWeight * 255 ), 0, 255 );
+			// Layers present in both points have already been interpolated
+			if ( B.EntryWeights[ EntryIndex ] != 0 && A.FindLayerEntry( B.GetEntryLayerIndex( EntryIndex ) ) == INDEX_NONE )
+			{
+				LerpLayerWeight( B.GetEntryLayerIndex( EntryIndex ) );
+			}
 		}
 		return ResultWeight;
 	}
 };
 
+/**
+ * Bilinear sampler for the landscape weight maps.
+ * Blends the integer weights of the four surrounding points directly with fixed-point arithmetic and normalizes the result once,
+ * instead of normalizing, interpolating and re-quantizing the weights three times like the generic GetInterpolatedElementAt does.
+ */
+struct OPENWORLDGENERATOR_API FChunkLandscapeWeightSampler
+{
+	/** Returns the weight interpolated between the adjacent points at the normalized position in [0;1] range */
+	static FChunkLandscapeWeight SampleInterpolated( const FChunkData2D& WeightMap, const FVector2f& NormalizedPosition );
+
+	/** Returns the index of the layer with the largest contribution at the normalized position. Cheaper than sampling the weight and calling GetLayerWithLargestContribution */
+	static int32 SampleLayerWithLargestContribution( const FChunkData2D& WeightMap, const FVector2f& NormalizedPosition );
+
+	/** Returns the normalized weight of a single layer at the normalized position. Cheaper than sampling the weight and calling GetNormalizedWeight */
+	static float SampleNormalizedWeight( const FChunkData2D& WeightMap, const FVector2f& NormalizedPosition, int32 LayerIndex );
+};
+
 /** A map of weights for the chunk and their layout in memory and on the textures */
 class OPENWORLDGENERATOR_API FChunkLandscapeWeightMapDescriptor
 {
@@ -0,0 +1,76 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ChunkMemoryAccounting.generated.h"
+
+class AOWGChunk;
+
+/** Categories of memory used by the loaded chunks */
+UENUM( BlueprintType )
+enum class EChunkMemoryCategory : uint8
+{
+	/** Surface data grids (heightmap, normals, gradients, weights, biome map) and the height pyramid */
+	ChunkData,
+	/** Noise data generated for the chunk */
+	NoiseData,
+	/** Generated landscape LOD meshes */
+	LandscapeMesh,
+	/** Weight map textures or weight map atlas slices */
+	WeightMapTextures,
+	/** Grass instances built for the chunk */
+	Grass,
+	/** Height field collision and the cached navigation samples */
+	Collision,
+	Num UMETA( Hidden )
+};
+
+/** Memory used by a single chunk, or by a number of chunks combined, split by category */
+struct OPENWORLDGENERATOR_API FChunkMemoryUsage
+{
+	static constexpr int32 NumCategories = (int32) EChunkMemoryCategory::Num;
+
+	/** Number of bytes used by each category */
+	int64 CategoryBytes[NumCategories]{};
+
+	FORCEINLINE int64 Get( EChunkMemoryCategory Category ) const { return CategoryBytes[ (int32) Category ]; }
+	FORCEINLINE void Add( EChunkMemoryCategory Category, int64 NumBytes ) { CategoryBytes[ (int32) Category ] += NumBytes; }
+
+	/** Returns the total number of bytes used across all categories */
+	int64 GetTotal() const;
+
+	FChunkMemoryUsage& operator+=( const FChunkMemoryUsage& Other );
+	FChunkMemoryUsage& operator-=( const FChunkMemoryUsage& Other );
+
+	/** Publishes this usage as the total memory used by the loaded chunks to the stats system */
+	void UpdateStats() const;
+
+	/** Returns the display name of the category */
+	static FString GetCategoryName( EChunkMemoryCategory Category );
+};
+
+/** Enforcement of the per-category chunk memory budgets from the settings, shared between the server and the client chunk managers */
+struct OPENWORLDGENERATOR_API FChunkMemoryBudgets
+{
+	/** Fraction of the budget the rendering memory needs to drop below before the memory budget LOD bias is reduced */
+	static constexpr float LODBiasRecoveryBudgetFraction = 0.75f;
+
+	/** Returns the interval in seconds between the memory accounting passes, or a negative value if the memory accounting is disabled */
+	static float GetAccountingInterval();
+
+	/** Returns true if any of the categories of the usage, optionally only the rendering ones, exceeds the given fraction of it's budget */
+	static bool IsOverBudget( const FChunkMemoryUsage& MemoryUsage, float BudgetFraction, bool bRenderingCategoriesOnly );
+
+	/**
+	 * Picks the idle chunks that should be unloaded early because the budget of a category they use memory of is exceeded, longest idle first.
+	 * Memory used by the picked chunks is subtracted from the remaining memory usage
+	 */
+	static void SelectIdleChunksToUnload( const TArray<TPair<AOWGChunk*, FChunkMemoryUsage>>& PerChunkMemoryUsage, FChunkMemoryUsage& InOutRemainingMemoryUsage, TArray<AOWGChunk*>& OutChunksToUnload );
+
+	/** Returns the new LOD bias for the distant chunks based on the memory remaining after the idle chunks have been unloaded. Recovers only once comfortably below the budget to avoid LOD flickering */
+	static int32 UpdateLODBias( int32 CurrentLODBias, int32 MaxLODBias, const FChunkMemoryUsage& RemainingMemoryUsage );
+
+	/** Applies the memory budget LOD bias to the LOD requested for the chunk. Chunks closest to the streaming sources (LOD 0) always keep their LOD */
+	static int32 ApplyLODBias( int32 RequestedChunkLOD, int32 LODBias, int32 NumChunkLODs );
+};
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "ChunkData2D.h"
+#include "ChunkHeightPyramid.h"
 #include "ChunkLandscapeWeight.h"
 #include "OWGRegionContainer.h"
 #include "PCGComponent.h"
@@ -14,9 +15,11 @@
 #include "Generation/OWGBiome.h"
 #include "Partition/ChunkLandscapeMaterialManager.h"
 #include "Partition/ChunkLandscapeMeshManager.h"
+#include "Partition/ChunkMemoryAccounting.h"
 #include "OWGChunk.generated.h"
 
 class UMaterialInstance;
+struct FChunkGenerationSnapshot;
 enum class EChunkGeneratorStage : uint8;
 
 class UOWGChunkGenerator;
@@ -98,6 +101,29 @@ struct OPENWORLDGENERATOR_API FChunkLandscapePoint
 	TMap<UOWGChunkLandscapeLayer*, float> LayerWeights;
 };
 
+/** Describes a result of tracing a segment against the chunk landscape */
+USTRUCT( BlueprintType )
+struct OPENWORLDGENERATOR_API FChunkLandscapeTraceHit
+{
+	GENERATED_BODY()
+
+	/** Location at which the segment has hit the landscape, in world space */
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Landscape Trace Hit" )
+	FVector Location{};
+
+	/** Normal of the landscape triangle that was hit, in world space */
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Landscape Trace Hit" )
+	FVector Normal{};
+
+	/** Distance from the start of the trace to the hit location, in world units */
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Landscape Trace Hit" )
+	float Distance{0.0f};
+
+	/** Coordinate of the chunk the hit landscape belongs to */
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Landscape Trace Hit" )
+	FChunkCoord ChunkCoord{};
+};
+
 /** Describes a modification of the chunk's landscape (height and, potentially, landscape layers weights) */
 USTRUCT( BlueprintType )
 struct OPENWORLDGENERATOR_API FChunkLandscapeModification
@@ -117,6 +143,54 @@ struct OPENWORLDGENERATOR_API FChunkLandscapeModification
 	TMap<UOWGChunkLandscapeLayer*, float> NewLayers;
 };
 
+/** A single brush stamp of a batched landscape modification */
+USTRUCT( BlueprintType )
+struct OPENWORLDGENERATOR_API FChunkLandscapeModificationStamp
+{
+	GENERATED_BODY()
+
+	/** Location of the origin of the brush, in world space. Z is not used */
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Landscape Modification" )
+	FVector WorldLocation{ForceInit};
+
+	/** The brush to apply to the landscape */
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Landscape Modification" )
+	FPolymorphicTerraformingBrush Brush;
+
+	/** The modification to apply to the area selected by the brush */
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Landscape Modification" )
+	FChunkLandscapeModification LandscapeModification;
+
+	/** Points with weight below that value will not be terraformed */
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Landscape Modification" )
+	float MinWeight{0.0f};
+};
+
+/** Area of the chunk landscape that has been modified, but the derived data for which has not been recalculated yet. In chunk local space */
+struct OPENWORLDGENERATOR_API FChunkLandscapeDirtyRegion
+{
+	FBox2f HeightMapBounds{ForceInit};
+	FBox2f WeightMapBounds{ForceInit};
+
+	FORCEINLINE bool IsEmpty() const { return !HeightMapBounds.bIsValid && !WeightMapBounds.bIsValid; }
+
+	FORCEINLINE FChunkLandscapeDirtyRegion& operator+=( const FChunkLandscapeDirtyRegion& Other )
+	{
+		HeightMapBounds += Other.HeightMapBounds;
+		WeightMapBounds += Other.WeightMapBounds;
+		return *this;
+	}
+};
+
+/** Landscape modification committed to the chunk, tracked so it can be replicated to the clients as a delta */
+struct OPENWORLDGENERATOR_API FChunkReplicatedDataModification
+{
+	/** Replicated data changelist produced by the modification */
+	int32 Changelist{0};
+	/** Area of the chunk data modified */
+	FChunkLandscapeDirtyRegion DirtyRegion;
+};
+
 USTRUCT()
 struct OPENWORLDGENERATOR_API FChunkGeneratorBiomeMapping
 {
@@ -139,6 +213,7 @@ struct OPENWORLDGENERATOR_API FCachedChunkLandscapeData
 	FChunkData2D SteepnessData;
 	FChunkData2D WeightMapData;
 	FChunkLandscapeWeightMapDescriptor WeightMapDescriptor;
+	FChunkHeightPyramid HeightPyramid;
 	int32 ChangelistNumber{0};
 };
 
@@ -154,6 +229,44 @@ struct OPENWORLDGENERATOR_API FCachedChunkBiomeData
 	FChunkData2D BiomeMap{};
 };
 
+/**
+ * Terraforming brush rendered to the landscape grid. Chunks are aligned to the world grid and share the same grid resolution, so the brush rendered once
+ * in the grid space of one chunk can be reused by all of the chunks it overlaps by offsetting the grid start.
+ */
+struct OPENWORLDGENERATOR_API FChunkLandscapeBrushGrid
+{
+	/** Coordinate of the chunk in which grid space the brush has been rendered */
+	FChunkCoord OriginChunkCoord{};
+	/** Resolution of the landscape grid the brush has been rendered for */
+	int32 GridResolutionXY{0};
+	/** Position of the first brush point in the grid space of the origin chunk */
+	FIntPoint GridStartXY{};
+	/** Amount of brush points across each axis */
+	FIntVector2 GridSizeXY{};
+	/** Weights of the brush points, row by row */
+	TArray<float> Weights;
+	/** Bounds of the brush, in the local space of the origin chunk */
+	FBox2f BrushBounds{};
+
+	/** Renders the brush at the given world location to the landscape grid of the given resolution */
+	static FChunkLandscapeBrushGrid Render( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, int32 GridResolutionXY );
+
+	/** Returns the position of the first brush point in the grid space of the given chunk */
+	FORCEINLINE FIntPoint GetGridStartForChunk( const FChunkCoord& ChunkCoord ) const
+	{
+		return FIntPoint(
+			GridStartXY.X - ( ChunkCoord.PosX - OriginChunkCoord.PosX ) * ( GridResolutionXY - 1 ),
+			GridStartXY.Y - ( ChunkCoord.PosY - OriginChunkCoord.PosY ) * ( GridResolutionXY - 1 ) );
+	}
+
+	/** Returns the bounds of the brush in the local space of the given chunk */
+	FORCEINLINE FBox2f GetBrushBoundsForChunk( const FChunkCoord& ChunkCoord ) const
+	{
+		const FVector2f ChunkOffset( ( ChunkCoord.PosX - OriginChunkCoord.PosX ) * FChunkCoord::ChunkSizeWorldUnits, ( ChunkCoord.PosY - OriginChunkCoord.PosY ) * FChunkCoord::ChunkSizeWorldUnits );
+		return BrushBounds.ShiftBy( -ChunkOffset );
+	}
+};
+
 /** Aids in sampling points from the chunk's landscape, using either cached off-main-thread data, or live data from the chunk */
 class OPENWORLDGENERATOR_API FChunkLandscapePointSampler
 {
@@ -208,6 +321,26 @@ private:
 	void PopulatePointLayerWeights( FChunkLandscapePoint& OutPoint, const FChunkLandscapeWeight& Weight ) const;
 };
 
+/**
+ * Traces segments against the landscape of multiple chunks using their height pyramids.
+ * Landscape data of the chunks is captured on construction, after that the traces do not touch the chunks or the physics scene and can be performed from any thread.
+ * Chunks that were not loaded or initialized at the time of capture are treated as empty space.
+ */
+class OPENWORLDGENERATOR_API FChunkLandscapeTracer
+{
+	TMap<FChunkCoord, TSharedRef<FCachedChunkLandscapeData>> ChunkLandscapeData;
+public:
+	FChunkLandscapeTracer() = default;
+	/** Captures the landscape data of all loaded chunks overlapping the given world bounds. Not safe to be called outside of game thread! */
+	FChunkLandscapeTracer( const UObject* WorldContext, const FBox& WorldBounds );
+
+	/** Adds landscape data of a single chunk to the tracer */
+	void AddChunkLandscapeData( const FChunkCoord& ChunkCoord, const TSharedRef<FCachedChunkLandscapeData>& LandscapeData );
+
+	/** Traces the segment against the captured landscape, walking the chunks along the way in order. Returns true and populates the hit if the landscape was hit */
+	bool LineTrace( const FVector& TraceStart, const FVector& TraceEnd, FChunkLandscapeTraceHit& OutHit ) const;
+};
+
 /**
  * Chunk is a unit of world generation and serialization
  */
@@ -317,6 +450,12 @@ public:
 	UFUNCTION( BlueprintCallable, Category = "Chunk|Landscape" )
 	FChunkLandscapeMetrics GetLandscapeMetrics( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, bool bIncludeWeights = true, float MinWeight = 0.0f ); 
 
+	/**
+	 * Calculates the landscape metrics for the points covered by the already rendered brush. Only reads the chunk data, so it is safe to call for multiple chunks in parallel
+	 * as long as the landscape of these chunks is not modified at the same time.
+	 */
+	FChunkLandscapeMetrics GetLandscapeMetricsFromBrushGrid( const FChunkLandscapeBrushGrid& BrushGrid, bool bIncludeWeights, float MinWeight ) const;
+
 	/**
 	 * Applies the given terraforming brush to the given world location with the provided rotation and scale.
 	 * Keep in mind that this function does not operate across the chunk boundaries and as such should only be used when the brush in question fully fits inside of the chunk
@@ -330,6 +469,41 @@ public:
 	UFUNCTION( BlueprintCallable, Category = "Chunk|Landscape" )
 	void ModifyLandscape( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, const FChunkLandscapeModification& LandscapeModification, float MinWeight = 0.0f);
 
+	/**
+	 * Applies the landscape modification to the chunk data without recalculating the derived data (normals, collision, meshes and so on).
+	 * Modified area is accumulated into the provided dirty region, which has to be passed to CommitLandscapeModifications afterwards.
+	 * Use FChunkLandscapeTransaction instead of calling this directly when applying many brushes at once.
+	 */
+	void ApplyLandscapeModification( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, const FChunkLandscapeModification& LandscapeModification, float MinWeight, FChunkLandscapeDirtyRegion& InOutDirtyRegion );
+
+	/** Recalculates the derived landscape data for the region modified by one or more calls to ApplyLandscapeModification */
+	void CommitLandscapeModifications( const FChunkLandscapeDirtyRegion& DirtyRegion );
+
+	/** Returns the changelist of the replicated landscape data. Incremented on the server every time the landscape data changes, and set to the changelist of the applied data on the client */
+	FORCEINLINE int32 GetReplicatedDataChangelist() const { return ReplicatedDataChangelist; }
+
+	/**
+	 * Writes the landscape data for a client that has already received the data up to the given changelist. Only the areas modified since then are written,
+	 * unless the base changelist is INDEX_NONE or the modifications since it are no longer tracked, in which case the full snapshot of the data is written.
+	 * Returns false if the chunk has no landscape data yet
+	 */
+	bool WriteReplicatedChunkData( FArchive& Ar, int32 BaseChangelist );
+
+	/** Applies the landscape data written by WriteReplicatedChunkData on the server. Returns false if the data is a delta against a changelist different from the one the chunk has */
+	bool ApplyReplicatedChunkData( FArchive& Ar );
+
+	/** Returns the changelist at which the landscape data has been last replaced entirely. Deltas can be written against this changelist or any later one */
+	FORCEINLINE int32 GetReplicatedDataSnapshotChangelist() const { return ReplicatedDataSnapshotChangelist; }
+
+	/**
+	 * Returns the hash of the landscape data as it was at the snapshot changelist, or 0 if it is not known. Chunks generated deterministically from the same
+	 * world generator and seed have identical hashes on the server and the client, so the client can skip receiving the snapshot when the hashes match
+	 */
+	FORCEINLINE uint64 GetReplicatedDataSnapshotHash() const { return ReplicatedDataSnapshotHash; }
+
+	/** Makes the chunk data on the client, verified to be identical to the server snapshot by it's hash, the base of the deltas received from the server afterwards */
+	void AdoptVerifiedReplicatedDataSnapshot( int32 SnapshotChangelist );
+
 	////////////////////////////////////////////////////////
 	// CHUNK UTILITY/ADVANCED FUNCTIONS
 	////////////////////////////////////////////////////////
@@ -370,10 +544,17 @@ public:
 
 	const FChunkBiomePalette* GetBiomePalette() const { return &BiomePalette; }
 	const FChunkLandscapeWeightMapDescriptor* GetWeightMapDescriptor() const { return &WeightMapDescriptor; }
+	const FChunkHeightPyramid* GetHeightPyramid() const { return &HeightPyramid; }
 
 	FORCEINLINE FChunkLandscapeMeshManager* GetLandscapeMeshManager() const { return LandscapeMeshManager.Get(); }
 	FORCEINLINE FChunkLandscapeMaterialManager* GetLandscapeMaterialManager() const { return LandscapeMaterialManager.Get(); }
 	FORCEINLINE int32 GetCurrentChunkLOD() const { return CurrentChunkLOD; }
+
+	/** Calculates the amount of memory currently used by this chunk, split by category */
+	FChunkMemoryUsage GetMemoryUsage() const;
+
+	/** Copies the generated data of this chunk into the snapshot: every chunk data grid, every noise grid, the biome palette and the weight map layers */
+	void CaptureGenerationSnapshot( FChunkGenerationSnapshot& OutSnapshot ) const;
 public:
 	/** Internal function to initialize the chunk's biome palette with the given values */
 	void InitializeChunkBiomePalette( FChunkBiomePalette&& InBiomePalette, FChunkData2D&& InBiomeMap );
@@ -390,13 +571,25 @@ public:
 	void PartialUpdateWeightMap( const FBox2f& UpdateVolume );
 
 	FORCEINLINE bool IsPendingToBeUnloaded() const { return bPendingToBeUnloaded; }
+
+	/** Returns true if the chunk actor is currently in the chunk actor pool, and is not representing any chunk */
+	FORCEINLINE bool IsChunkPooled() const { return bIsPooled; }
+	/** Returns the number of times this chunk actor has been returned into the chunk actor pool. Used to discard the results of async work started for the previous chunk */
+	FORCEINLINE int32 GetChunkRecycleCount() const { return ChunkRecycleCount; }
 protected:
 	friend class UOWGRegionContainer;
 	friend class FChunkSerializationContext;
 	friend class UOWGServerChunkManager;
+	friend class UOWGClientChunkManager;
+	friend struct FChunkMemoryBudgets;
 
 	/** Called before the chunk has begun play or has been added to the container to initialize it with basic data */
 	void SetupChunk( UOWGRegionContainer* InOwnerContainer, const FChunkCoord& InChunkCoord );
+	/** Called instead of SetupChunk for the chunks generated locally on the client. Such chunks are not owned by any region container and are never saved */
+	void SetupClientChunk( const FChunkCoord& InChunkCoord );
+
+	/** Picks up the world generator and the seed from the subsystem. Called when the chunk is created, or when the chunk replicated before the world parameters is adopted by the client chunk manager */
+	void InitializeWorldParameters();
 
 	/** Called after the chunk has been deserialized from the filesystem */
 	void OnChunkLoaded();
@@ -410,6 +603,21 @@ protected:
 	/** Called on an empty chunk right after it has been spawned into the world and added to the region container */
 	void OnChunkCreated();
 
+	/**
+	 * Called instead of destroying the chunk when it is returned into the chunk actor pool. Releases everything EndPlay would release,
+	 * unregisters the components and resets the chunk to the default state, so it can be setup again for a different chunk coordinate
+	 */
+	void ResetChunkForPooling();
+
+	/** Called once the pooled chunk has been setup for the new coordinate and added to the region container. Registers the components and notifies the chunk manager like BeginPlay would */
+	void ReactivatePooledChunk();
+
+	/** Resets the serialized properties declared by the chunk classes to the class defaults, so that the chunk can be deserialized into */
+	void ResetPropertiesToClassDefaults();
+
+	/** Registers the chunk in the chunk manager, and requests the generation if it has been requested before the chunk has begun play */
+	void RegisterInChunkManager();
+
 	/** Samples all predefined noise generators for this chunk */
 	void GenerateNoiseForChunk();
 
@@ -422,8 +630,14 @@ protected:
 	/** Collects references to other actors from this chunk. Called to determine which actors should be destroyed when the chunk is unloaded */
 	void CollectActorReferences( TArray<AActor*>& OutActorReferences ) const;
 
-	void ModifyLandscapeHeightsInternal( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, float NewLandscapeHeight, float MinWeight );
-	void ModifyLandscapeWeightsInternal( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, const FChunkLandscapeWeight& NewLandscapeWeight, float MinWeight );
+	/** Modify the chunk data inside of the brush and grow the dirty bounds by the brush bounds. Return true if any points have been modified */
+	bool ModifyLandscapeHeightsInternal( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, float NewLandscapeHeight, float MinWeight, FBox2f& InOutDirtyBounds );
+	bool ModifyLandscapeWeightsInternal( const FVector& WorldLocation, const FPolymorphicTerraformingBrush& Brush, const FChunkLandscapeWeight& NewLandscapeWeight, float MinWeight, FBox2f& InOutDirtyBounds );
+
+	/** Makes the clients receive the full snapshot of the replicated landscape data next time instead of a delta. Called when the data is replaced entirely */
+	void InvalidateReplicatedChunkData();
+	/** Computes the hash of the replicated landscape data: the height map, the weight map, the biome map, the weight map layers and the biome palette */
+	uint64 ComputeReplicatedDataHash() const;
 
 	/** Functions for partially updating various data across the chunk */
 	void PartialUpdateSurfaceGradient( int32 StartX, int32 StartY, int32 EndX, int32 EndY );
@@ -451,8 +665,10 @@ public:
 protected:
 	friend class UChunkHeightFieldCollisionComponent;
 	friend class UOWGServerChunkManager;
+	friend class UOWGClientChunkManager;
 	friend class FChunkLandscapeMeshManager;
 	friend class FChunkLandscapeMaterialManager;
+	friend struct FChunkMemoryBudgets;
 
 	/** Noise data for each noise identifier generated for this chunk */
 	TMap<TObjectPtr<UOWGNoiseIdentifier>, FChunkData2D> NoiseData;
@@ -472,6 +688,23 @@ protected:
 	/** Distance from the chunk to the closest streaming source. Used to prioritize chunk generation */
 	float DistanceToClosestStreamingSource{-1.0f};
 
+	/** True if the chunk actor is currently in the chunk actor pool */
+	bool bIsPooled{false};
+	/** Number of times this chunk actor has been returned into the chunk actor pool */
+	int32 ChunkRecycleCount{0};
+
+	/** Min/max height pyramid over the surface heightmap. Transient, rebuilt on load and updated together with the rest of the surface data */
+	FChunkHeightPyramid HeightPyramid;
+
+	/** Changelist of the replicated landscape data */
+	int32 ReplicatedDataChangelist{0};
+	/** Changelist at which the landscape data has been last replaced entirely. Deltas can only be written against this changelist or the later ones */
+	int32 ReplicatedDataSnapshotChangelist{0};
+	/** Hash of the landscape data at the snapshot changelist, or 0 if it is not known */
+	uint64 ReplicatedDataSnapshotHash{0};
+	/** Landscape modifications committed since the last snapshot changelist, oldest first. Only tracked on the server */
+	TArray<FChunkReplicatedDataModification> ReplicatedDataModifications;
+
 	int32 GrassSourceDataChangelistNumber{0};
 	TSharedPtr<FCachedChunkLandscapeData> CachedLandscapeData;
 	TSharedPtr<FCachedChunkBiomeData> CachedBiomeData;
@@ -493,6 +726,14 @@ public:
 	UPROPERTY( EditDefaultsOnly, Category = "Chunk|General" )
 	int32 NumChunkLandscapeLODs;
 
+	/** True if the landscape meshes should have skirts along the chunk edges, hiding the cracks between the neighbouring chunks using different LODs */
+	UPROPERTY( EditDefaultsOnly, Category = "Chunk|General" )
+	bool bGenerateLandscapeSkirts;
+
+	/** Minimum depth of the landscape skirts. Skirts are made deeper where the LOD meshes deviate from the heightmap along the chunk edge */
+	UPROPERTY( EditDefaultsOnly, Category = "Chunk|General", meta = ( EditCondition = "bGenerateLandscapeSkirts" ) )
+	float LandscapeSkirtMinDepth;
+
 protected:
 	/** Material manager for this landscape */
 	TUniquePtr<FChunkLandscapeMaterialManager> LandscapeMaterialManager;
@@ -0,0 +1,155 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Partition/ChunkCoord.h"
+#include "OWGChunkDataReplicationComponent.generated.h"
+
+class AOWGChunk;
+class UOWGWorldGeneratorConfiguration;
+
+/** Part of the compressed chunk data payload sent to the client. Payloads are split into fragments to stay within the size limits of a single RPC */
+USTRUCT()
+struct OPENWORLDGENERATOR_API FChunkDataReplicationFragment
+{
+	GENERATED_BODY()
+
+	/** Coordinate of the chunk the payload belongs to */
+	UPROPERTY()
+	FChunkCoord ChunkCoord;
+
+	/** Index of this fragment in the payload */
+	UPROPERTY()
+	uint16 FragmentIndex{0};
+
+	/** Total number of fragments in the payload */
+	UPROPERTY()
+	uint16 NumFragments{0};
+
+	/** Size of the payload data before compression. Only set on the first fragment */
+	UPROPERTY()
+	int32 UncompressedSize{0};
+
+	/** Part of the compressed payload data */
+	UPROPERTY()
+	TArray<uint8> CompressedData;
+};
+
+/**
+ * Replicates the landscape data of the chunks around the player to the owning client. Added to the remote player controllers by the server chunk manager.
+ * The client regenerates the chunks locally from the world parameters sent by this component, so the server first sends the hash of it's chunk data snapshot.
+ * If the data generated by the client matches it, only the landscape modifications made since the snapshot are sent. Otherwise the chunk is sent as
+ * a compressed snapshot of it's height map, weight map and biome map. Modifications made afterwards are sent as compressed deltas covering only the modified areas.
+ * The data sent to each client is limited by the per-connection bandwidth budget and the reliable buffer capacity of the connection, closest chunks first.
+ */
+UCLASS()
+class OPENWORLDGENERATOR_API UOWGChunkDataReplicationComponent : public UActorComponent
+{
+	GENERATED_BODY()
+public:
+	UOWGChunkDataReplicationComponent();
+
+	// Begin UActorComponent interface
+	virtual void BeginPlay() override;
+	virtual void TickComponent( float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction ) override;
+	// End UActorComponent interface
+
+	/** Registers the chunk replicated from the server with the components of the local players, so that the received data can be applied to it */
+	static void RegisterReplicatedChunk( AOWGChunk* Chunk );
+	/** Removes the replicated chunk from the components of the local players once it has ended play */
+	static void UnregisterReplicatedChunk( AOWGChunk* Chunk );
+protected:
+	/** Sends the updates for the chunks around the player within the bandwidth budget */
+	void TickServerReplication( float DeltaTime );
+	/** Writes and compresses the chunk data against the given changelist, and queues it for sending. Returns false if the chunk has no data to send yet */
+	bool QueueChunkDataPayload( AOWGChunk* Chunk, int32 BaseChangelist );
+	/** Sends the queued fragments while there is bandwidth budget and reliable buffer capacity left */
+	void SendPendingFragments();
+	/** Returns true if the reliable buffer of the owner actor channel has room for another reliable RPC */
+	bool HasReliableBufferCapacity() const;
+
+	/** Applies the received payloads to the chunk in the order they have been received. Payloads are kept until the chunk is available on the client */
+	void ApplyReceivedPayloads( const FChunkCoord& ChunkCoord );
+	/** Compares the hash of the data generated on the client with the server one, and reports the result to the server. Returns false if the chunk is not available on the client yet */
+	bool VerifyClientChunkData( const FChunkCoord& ChunkCoord, int32 SnapshotChangelist, uint64 SnapshotHash );
+	/** Finds the chunk actor at the given coordinate on the client. Chunks that are still being generated on the client are not returned */
+	AOWGChunk* FindClientChunk( const FChunkCoord& ChunkCoord ) const;
+	/** Retries the verifications and the payloads of the chunks that were not available on the client, and requests the data again for the chunks the client has unloaded */
+	void TickClientPendingChunks();
+
+	/** Receives the world generator and the seed used by the server, so that the client can regenerate the chunks locally */
+	UFUNCTION( Client, Reliable )
+	void ClientReceiveWorldParameters( const TSoftObjectPtr<UOWGWorldGeneratorConfiguration>& WorldGenerator, int32 WorldSeed );
+
+	/** Asks the client to compare the hash of it's locally generated chunk data with the hash of the server data snapshot */
+	UFUNCTION( Client, Reliable )
+	void ClientVerifyChunkData( const FChunkCoord& ChunkCoord, int32 SnapshotChangelist, uint64 SnapshotHash );
+
+	/** Reports whenever the chunk data generated on the client matches the server data snapshot with the given changelist and hash */
+	UFUNCTION( Server, Reliable )
+	void ServerChunkDataVerified( const FChunkCoord& ChunkCoord, int32 SnapshotChangelist, uint64 SnapshotHash, bool bDataMatches );
+
+	/** Receives the next fragment of the chunk data payload */
+	UFUNCTION( Client, Reliable )
+	void ClientReceiveChunkDataFragment( const FChunkDataReplicationFragment& Fragment );
+
+	/** Tells the client to drop the data it has received for the chunk, because the chunk is no longer relevant to it */
+	UFUNCTION( Client, Reliable )
+	void ClientForgetChunkData( const FChunkCoord& ChunkCoord );
+
+	/** Requests the full snapshot of the chunk data because the client could not apply the delta it has received, or has lost the data it has received */
+	UFUNCTION( Server, Reliable )
+	void ServerRequestChunkDataSnapshot( const FChunkCoord& ChunkCoord );
+private:
+	/** State of the chunk data that has been sent to the client */
+	struct FSentChunkState
+	{
+		/** Chunk actor the data has been taken from. The data of a different actor at the same coordinate has no relation to the data sent before */
+		TWeakObjectPtr<AOWGChunk> Chunk;
+		int32 ChunkRecycleCount{0};
+		/** Changelist of the chunk data sent to the client, or INDEX_NONE if nothing has been sent yet */
+		int32 Changelist{INDEX_NONE};
+		/** Snapshot changelist and hash the client has been asked to verify it's data against, or INDEX_NONE if the verification is not in progress */
+		int32 VerificationChangelist{INDEX_NONE};
+		uint64 VerificationHash{0};
+		/** True if the client data has already been verified, successfully or not, and should not be verified again */
+		bool bVerificationAttempted{false};
+	};
+
+	/** Verification requested from the client. Only valid on the client */
+	struct FPendingChunkVerification
+	{
+		int32 SnapshotChangelist{INDEX_NONE};
+		uint64 SnapshotHash{0};
+	};
+
+	/** Payload received by the client */
+	struct FReceivedChunkPayload
+	{
+		TArray<uint8> CompressedData;
+		int32 UncompressedSize{0};
+		bool bComplete{false};
+	};
+
+	/** State of the data sent for each chunk in range of the player. Only valid on the server */
+	TMap<FChunkCoord, FSentChunkState> SentChunks;
+	/** Fragments waiting for the bandwidth budget. Only valid on the server */
+	TArray<FChunkDataReplicationFragment> PendingFragments;
+	/** Number of bytes that can be sent to the client before running out of the bandwidth budget */
+	float BandwidthAllowance{0.0f};
+	/** True if the world parameters have been sent to the client. Only valid on the server */
+	bool bWorldParametersSent{false};
+
+	/** Payloads that have been received but not applied yet, in the order of arrival. Only valid on the client */
+	TMap<FChunkCoord, TArray<FReceivedChunkPayload>> ReceivedPayloads;
+	/** Verifications of the chunks that were not available on the client when they have been requested. Only valid on the client */
+	TMap<FChunkCoord, FPendingChunkVerification> PendingVerifications;
+	/** Chunk actors replicated from the server, used to find the chunks when the client has no chunk manager. Only valid on the client */
+	TMap<FChunkCoord, TWeakObjectPtr<AOWGChunk>> ReplicatedChunks;
+	/** Chunks the client has verified or applied the server data to. If the client unloads one of them, the server needs to send it's data again. Only valid on the client */
+	TMap<FChunkCoord, TWeakObjectPtr<AOWGChunk>> SynchronizedChunks;
+	/** Time until the payloads of the chunks that were not available on the client are attempted to be applied again */
+	float PendingPayloadsRetryTime{0.0f};
+};
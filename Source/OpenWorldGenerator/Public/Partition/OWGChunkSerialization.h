@@ -4,11 +4,14 @@
 
 #include "CoreMinimal.h"
 #include "ChunkCoord.h"
+#include "Memory/MemoryView.h"
 #include "Misc/EngineVersion.h"
 #include "Serialization/ArchiveProxy.h"
 #include "Serialization/CustomVersion.h"
+#include "UObject/ObjectKey.h"
 #include "UObject/ObjectMacros.h"
 #include "UObject/TopLevelAssetPath.h"
+#include "UObject/WeakObjectPtr.h"
 
 class UOWGRegionContainer;
 class AOWGChunk;
@@ -21,6 +24,8 @@ struct OPENWORLDGENERATOR_API FOpenWorldGeneratorVersion
 	{
 		// Initial version of the open world generator
 		InitialVersion = 1,
+		// Landscape weights only store the layers with the largest contributions instead of the weights of all layers
+		SparseLandscapeWeights,
 		
 		// Add new versions above this line
 		VersionPlusOne,
@@ -36,6 +41,8 @@ private:
 enum class EChunkPackageVersion : uint32
 {
 	InitialVersion = 0,
+	// Name map and import map are stored in the region container and shared by all of it's chunks instead of being stored in each chunk
+	RegionSharedTables,
 
 	// Add new versions above this line
 	LatestPlusOne,
@@ -104,6 +111,48 @@ struct OPENWORLDGENERATOR_API FChunkObjectImport : FChunkObjectEntry
 	friend FArchive& operator<<( FArchive& Ar, FChunkObjectImport& ObjectImport );
 };
 
+/**
+ * Name map and import map shared by all of the chunks serialized into the same region. Neighbouring chunks reference mostly the same names, biomes, layers and classes,
+ * so storing them once per region keeps the chunk data small, and the imports only need to be resolved once for the entire region instead of once for every chunk load.
+ * Tables are append-only, so the chunk data serialized earlier stays valid when the tables grow. They are written into the region file together with the chunk data.
+ */
+class OPENWORLDGENERATOR_API FChunkSharedSerializationTables
+{
+public:
+	/** Returns the index of the name in the name map, adding it if needed. Name numbers are never stored in the name map */
+	int32 FindOrAddName( FName Name );
+	/** Returns the name from the name map with the given number. Returns false if the name index is not valid */
+	bool GetName( int32 NameIndex, int32 NameNumber, FName& OutName ) const;
+
+	/** Returns the index of the import of the given object, or INDEX_NONE if the object has not been imported yet */
+	int32 FindImport( const UObject* Object ) const;
+	/** Adds the import of the object and returns it's index. The object is considered already resolved for this import */
+	int32 AddImport( UObject* Object );
+	/** Returns the import with the given index */
+	FORCEINLINE FChunkObjectImport& GetImport( int32 ImportIndex ) { return ImportMap[ ImportIndex ]; }
+	FORCEINLINE bool IsValidImportIndex( int32 ImportIndex ) const { return ImportMap.IsValidIndex( ImportIndex ); }
+
+	/** Returns the object the import has been resolved to before, or nullptr if it has not been resolved yet or the object is no longer valid */
+	UObject* FindResolvedImport( int32 ImportIndex ) const;
+	/** Records the object the import has been resolved to, so that it does not need to be resolved again by the other chunks */
+	void SetResolvedImport( int32 ImportIndex, UObject* Object );
+
+	FORCEINLINE int32 NumNames() const { return NameMap.Num(); }
+	FORCEINLINE int32 NumImports() const { return ImportMap.Num(); }
+
+	/** Serializes the name map and the import map to/from the archive */
+	void Serialize( FArchive& Ar );
+private:
+	/** Name map and reverse lookup map */
+	TArray<FName> NameMap;
+	TMap<FName, int32> NameLookupMap;
+
+	/** Import map, reverse lookup map and the objects the imports have been resolved to. Objects might be garbage collected while the region is loaded, so they are not referenced strongly */
+	TArray<FChunkObjectImport> ImportMap;
+	TMap<FObjectKey, int32> ImportIndexMap;
+	TArray<FWeakObjectPtr> ResolvedImports;
+};
+
 struct OPENWORLDGENERATOR_API FChunkObjectExport : FChunkObjectEntry
 {
 	int32 ObjectFlags{RF_NoFlags};
@@ -136,6 +185,9 @@ protected:
 	int32 PackageSummaryOffset{INDEX_NONE};
 	FChunkPackageSummary PackageSummary{};
 
+	// Name and import tables of the region the chunk belongs to, or nullptr if the chunk has it's own name map and import map
+	FChunkSharedSerializationTables* SharedTables{nullptr};
+
 	// Name map and reverse lookup map
 	TMap<FName, int32> NameLookupMap;
 	TArray<FName> NameMap;
@@ -151,7 +203,7 @@ public:
 	FChunkSerializationContext( FArchive& Ar, AOWGChunk* InChunk );
 	FChunkSerializationContext( FArchive& Ar, UOWGRegionContainer* InRegionContainer, FChunkCoord InChunkCoord );
 
-	static AOWGChunk* DeserializeChunk( UOWGRegionContainer* RegionContainer, FChunkCoord ChunkCoord, const TArray<uint8>& ChunkSerializedData, TFunctionRef<void(AOWGChunk*)> PostChunkLoaded );
+	static AOWGChunk* DeserializeChunk( UOWGRegionContainer* RegionContainer, FChunkCoord ChunkCoord, FMemoryView ChunkSerializedData, TFunctionRef<void(AOWGChunk*)> PostChunkLoaded );
 	static void SerializeChunk( AOWGChunk* Chunk, TArray<uint8>& OutChunkSerializedData );
 
 	// Begin FArchive Interface
@@ -175,6 +227,9 @@ protected:
 	UObject* ResolveImport( int32 ImportIndex );
 	UObject* ResolveExport( int32 ExportIndex );
 
+	/** Returns the import entry from the shared import map if the chunk uses one, or from the chunk import map otherwise */
+	FChunkObjectImport& GetImportEntry( int32 ImportIndex );
+
 	int32 WriteImport( UObject* Object );
 	int32 WriteExport( UObject* Object );
 
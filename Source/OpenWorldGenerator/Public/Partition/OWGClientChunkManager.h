@@ -0,0 +1,79 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OWGChunkManagerInterface.h"
+#include "OWGChunkStreamingProvider.h"
+#include "Partition/ChunkMemoryAccounting.h"
+#include "OWGClientChunkManager.generated.h"
+
+class IOWGChunkStreamingProvider;
+
+DECLARE_LOG_CATEGORY_EXTERN( LogClientChunkManager, All, All );
+
+/**
+ * Chunk manager used on the clients. Clients cannot load the chunks from the region files, so instead they regenerate the chunks around the local players
+ * from the world generator and the seed received from the server. Only the deterministic early generation stages are run on the client.
+ * The locally generated data is then verified against the hash of the server data by UOWGChunkDataReplicationComponent, and only the chunks that do not match
+ * or have been modified on the server receive the landscape data from the server.
+ * If the chunk class is replicated, the chunk actors replicated from the server are adopted in place of the locally generated chunks at the same coordinate,
+ * and are only ever destroyed by the server.
+ */
+UCLASS( Within = "OpenWorldGeneratorSubsystem" )
+class OPENWORLDGENERATOR_API UOWGClientChunkManager : public UObject, public IOWGChunkManagerInterface
+{
+	GENERATED_BODY()
+public:
+	// Begin IOWGChunkManagerInterface
+	virtual void Initialize() override;
+	virtual void BeginPlay() override;
+	virtual void Tick( float DeltaTime ) override;
+	virtual void Deinitialize() override;
+	virtual AOWGChunk* FindChunk( const FChunkCoord& ChunkCoord ) const override;
+	virtual EChunkExists DoesChunkExistSync( const FChunkCoord& ChunkCoord ) const override;
+	virtual AOWGChunk* LoadChunk( const FChunkCoord& ChunkCoord ) override;
+	virtual AOWGChunk* LoadOrCreateChunk( const FChunkCoord& ChunkCoord ) override;
+	virtual void NotifyChunkBegunPlay( AOWGChunk* Chunk ) override;
+	virtual void NotifyChunkDestroyed( AOWGChunk* Chunk ) override;
+	virtual void RequestChunkGeneration( AOWGChunk* Chunk ) override;
+	// End IOWGChunkManagerInterface
+
+	/** Registers a streaming provider in the chunk manager */
+	UFUNCTION( BlueprintCallable, Category = "Chunk Manager" )
+	void RegisterStreamingProvider( const TScriptInterface<IOWGChunkStreamingProvider>& StreamingProvider );
+
+	/** Un-registers a streaming provider in the chunk manager */
+	UFUNCTION( BlueprintCallable, Category = "Chunk Manager" )
+	void UnregisterStreamingProvider( const TScriptInterface<IOWGChunkStreamingProvider>& StreamingProvider );
+
+	/** Returns true if the chunk has been generated up to the stage requested from it, and the generation will not touch it's data anymore */
+	static bool IsChunkGenerationFinished( const AOWGChunk* Chunk );
+
+	/** Returns the memory used by all of the locally generated chunks as of the last memory accounting pass */
+	FORCEINLINE const FChunkMemoryUsage& GetTotalChunkMemoryUsage() const { return TotalChunkMemoryUsage; }
+protected:
+	void TickChunkStreaming( float DeltaTime );
+	void TickChunkGeneration();
+	void TickChunkMemoryAccounting( float DeltaTime );
+	void UnloadChunk( AOWGChunk* Chunk );
+protected:
+	/** Chunks generated locally on the client, and the chunks replicated from the server that have been adopted */
+	UPROPERTY( Transient )
+	TMap<FChunkCoord, TObjectPtr<AOWGChunk>> LoadedChunks;
+
+	/** Currently registered chunk streaming providers */
+	UPROPERTY( Transient )
+	TArray<TScriptInterface<IOWGChunkStreamingProvider>> RegisteredStreamingProviders;
+
+	/** Chunks that are currently being generated */
+	UPROPERTY( Transient )
+	TArray<TObjectPtr<AOWGChunk>> ChunksPendingGeneration;
+
+	/** Memory used by all of the locally generated chunks as of the last memory accounting pass */
+	FChunkMemoryUsage TotalChunkMemoryUsage;
+	/** Time elapsed since the last memory accounting pass */
+	float TimeSinceLastMemoryAccounting{0.0f};
+	/** Number of LODs added to the requested LOD of the non-LOD0 chunks because the rendering memory is over budget */
+	int32 MemoryBudgetLODBias{0};
+};
@@ -4,7 +4,10 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Memory/SharedBuffer.h"
 #include "Partition/ChunkCoord.h"
+#include "Partition/OWGChunkSerialization.h"
+#include "Partition/OWGRegionProxy.h"
 #include "OWGRegionContainer.generated.h"
 
 class AOWGChunk;
@@ -12,6 +15,8 @@ class AOWGChunk;
 enum class ERegionContainerVersion : uint32
 {
 	InitialVersion = 0,
+	// Name map and import map shared by the chunks are serialized after the chunk data
+	SharedSerializationTables,
 
 	// Add new versions above this line
 	LatestPlusOne,
@@ -76,6 +81,21 @@ public:
 
 	/** Returns the coordinates of the already loaded chunks */
 	TArray<FChunkCoord> GetLoadedChunkCoords() const;
+
+	/** Updates the far-field proxy with the data of the currently loaded chunks, and returns it */
+	const FOWGRegionProxyData& UpdateRegionProxy();
+
+	/** Returns the far-field proxy of this region, as of the last time the chunks have been unloaded or saved */
+	FORCEINLINE const FOWGRegionProxyData& GetRegionProxy() const { return RegionProxy; }
+
+	/** Replaces the far-field proxy with the one loaded from the region proxy file */
+	void SetRegionProxy( FOWGRegionProxyData&& InRegionProxy );
+
+	/** Takes a chunk actor of the given class out of the chunk actor pool of the server chunk manager owning this region, and renames it to the given name. Returns nullptr if pooling is not available */
+	AOWGChunk* AcquirePooledChunk( const UClass* ChunkClass, FName ChunkName ) const;
+
+	/** Returns the name map and the import map shared by all of the chunks serialized into this region */
+	FORCEINLINE FChunkSharedSerializationTables& GetSharedSerializationTables() { return SharedSerializationTables; }
 protected:
 	friend class AOWGChunk;
 
@@ -85,10 +105,19 @@ private:
 	/** Coordinate of the section this container holds */
 	FChunkCoord RegionCoord;
 
-	/** Binary blobs for each chunk serialized as a part of this region */
-	TMap<FChunkCoord, TArray<uint8>> SerializedChunkData;
+	/**
+	 * Binary blobs for each chunk serialized as a part of this region. Blobs loaded from the region file are views into the decompressed region data,
+	 * which is freed once all of the chunks referencing it have been loaded or re-serialized
+	 */
+	TMap<FChunkCoord, FSharedBuffer> SerializedChunkData;
+
+	/** Name map and import map referenced by the serialized chunk data */
+	FChunkSharedSerializationTables SharedSerializationTables;
 
 	/** A Map of loaded chunks that have been deserialized from the container */
 	UPROPERTY()
 	TMap<FChunkCoord, TObjectPtr<AOWGChunk>> LoadedChunks;
+
+	/** Far-field proxy of the region, updated by the chunks when they are unloaded or saved */
+	FOWGRegionProxyData RegionProxy;
 };
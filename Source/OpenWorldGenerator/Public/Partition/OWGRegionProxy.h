@@ -0,0 +1,102 @@
+// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "DynamicMesh/DynamicMesh3.h"
+#include "Partition/ChunkCoord.h"
+#include "OWGRegionProxy.generated.h"
+
+class AOWGChunk;
+class UDynamicMeshComponent;
+class UMaterialInterface;
+
+enum class ERegionProxyVersion : uint32
+{
+	InitialVersion = 0,
+
+	// Add new versions above this line
+	LatestPlusOne,
+	Latest = LatestPlusOne - 1,
+};
+
+/**
+ * Low resolution representation of the entire region used to render the terrain beyond the chunk streaming distance.
+ * Holds a coarse heightmap and a color grid blended from the landscape layer colors, with a few points per chunk. Chunks update their part of the proxy when they are
+ * unloaded or saved, and the proxy is written into a separate file next to the region file, so it can be loaded without loading the region itself.
+ */
+class OPENWORLDGENERATOR_API FOWGRegionProxyData
+{
+public:
+	/** Number of proxy quads along a single chunk edge */
+	static constexpr int32 QuadsPerChunk = 4;
+	/** Number of proxy points along the region edge. The last row and column overlap with the first ones of the neighbouring region */
+	static constexpr int32 ResolutionXY = FChunkCoord::ChunksPerRegion * QuadsPerChunk + 1;
+
+	FOWGRegionProxyData();
+
+	/** Returns true if the far-field proxies are enabled in the settings. Region containers do not build their proxies otherwise */
+	static bool IsFarFieldProxyEnabled();
+
+	/** Samples the heightmap and the weight map of the chunk into the proxy. Does nothing if the chunk does not have the landscape data generated yet */
+	void UpdateFromChunk( const AOWGChunk* Chunk );
+
+	/** Generates the proxy mesh, relative to the region corner. Chunks that have not been generated, or that are set in the hidden chunk mask, are left out of the mesh */
+	void GenerateProxyMesh( UE::Geometry::FDynamicMesh3& OutProxyMesh, const TBitArray<>& HiddenChunks ) const;
+
+	/** Returns true if none of the chunks have contributed to the proxy yet */
+	FORCEINLINE bool IsEmpty() const { return !GeneratedChunks.Contains( true ); }
+	/** Returns the number incremented every time the proxy data changes */
+	FORCEINLINE int32 GetChangeNumber() const { return ChangeNumber; }
+
+	/** Returns the index of the chunk in the region relative chunk masks */
+	FORCEINLINE static int32 GetChunkMaskIndex( const FChunkCoord& ChunkCoord )
+	{
+		const int32 OffsetX = ChunkCoord.PosX - ChunkCoord.ToRegionCoord().PosX * FChunkCoord::ChunksPerRegion;
+		const int32 OffsetY = ChunkCoord.PosY - ChunkCoord.ToRegionCoord().PosY * FChunkCoord::ChunksPerRegion;
+		return OffsetY * FChunkCoord::ChunksPerRegion + OffsetX;
+	}
+
+	/** Returns the world location of the minimum corner of the region */
+	FORCEINLINE static FVector GetRegionCornerWorldLocation( const FChunkCoord& RegionCoord )
+	{
+		constexpr double RegionSize = (double) FChunkCoord::ChunkSizeWorldUnits * FChunkCoord::ChunksPerRegion;
+		return FVector( RegionCoord.PosX * RegionSize, RegionCoord.PosY * RegionSize, 0.0f );
+	}
+
+	/** Serializes the proxy data with it's header. Returns false if the data could not be loaded */
+	bool Serialize( FArchive& Ar );
+private:
+	/** Allocates the proxy point grids. Grids are only allocated once the first chunk contributes to the proxy */
+	void AllocateProxyData();
+
+	/** Heights of the proxy points in world units */
+	TArray<float> Heights;
+	/** Colors of the proxy points */
+	TArray<FColor> Colors;
+	/** Chunks that have contributed to the proxy */
+	TBitArray<> GeneratedChunks;
+	/** Transient number of the proxy changes, used to determine when the proxy mesh needs to be rebuilt */
+	int32 ChangeNumber{0};
+};
+
+/** Lightweight actor rendering the proxy mesh of a single region. Has no collision, does not tick and is never replicated or saved */
+UCLASS( Transient, NotPlaceable )
+class OPENWORLDGENERATOR_API AOWGRegionProxyActor : public AActor
+{
+	GENERATED_BODY()
+public:
+	AOWGRegionProxyActor();
+
+	/** Rebuilds the proxy mesh if the proxy data or the set of the hidden chunks have changed since the last update */
+	void UpdateProxyMesh( const FOWGRegionProxyData& ProxyData, const TBitArray<>& HiddenChunks, UMaterialInterface* ProxyMaterial );
+protected:
+	UPROPERTY( VisibleAnywhere, Category = "Region Proxy" )
+	TObjectPtr<UDynamicMeshComponent> ProxyMeshComponent;
+
+	/** Change number of the proxy data the mesh has been built from */
+	int32 BuiltChangeNumber{INDEX_NONE};
+	/** Hidden chunk mask the mesh has been built with */
+	TBitArray<> BuiltHiddenChunks;
+};
@@ -5,10 +5,14 @@
 #include "CoreMinimal.h"
 #include "OWGChunkManagerInterface.h"
 #include "OWGChunkStreamingProvider.h"
+#include "Partition/ChunkMemoryAccounting.h"
 #include "OWGServerChunkManager.generated.h"
 
 class OpenWorldGeneratorSubsystem;
+class AOWGRegionProxyActor;
+class FOWGRegionProxyData;
 class IOWGChunkStreamingProvider;
+class UMaterialInterface;
 class UOWGRegionContainer;
 class UOWGWorldGeneratorConfiguration;
 
@@ -51,15 +55,61 @@ public:
 
 	void SetRegionFolderPath(const FString& InRegionFolderPath);
 
+	/** Writes the loaded region to it's region file, including the chunks in it that are currently loaded. Returns false if the region is not loaded or the file could not be written */
+	bool SaveRegionContainer( const FChunkCoord& RegionCoord ) const;
+
+	/**
+	 * Unloads all of the loaded chunks of the region, writes it to it's region file and drops it from the loaded regions. The region is loaded back from the file when it's chunks are needed again.
+	 * Returns false and keeps the region loaded if any of it's chunks cannot be unloaded yet, or if the region file could not be written
+	 */
+	bool UnloadRegionContainer( const FChunkCoord& RegionCoord );
+
+	/** Serializes the loaded chunk and immediately loads it back from the serialized data. Returns the newly loaded chunk, or nullptr if the chunk was not loaded */
+	AOWGChunk* ReloadChunk( const FChunkCoord& ChunkCoord );
+
+	/** Returns true if the chunk actor pool has space for another chunk */
+	bool CanReleaseChunkToPool() const;
+	/** Resets the unloaded chunk and puts it into the chunk actor pool instead of destroying it. The chunk must already be removed from it's region */
+	void ReleaseChunkToPool( AOWGChunk* Chunk );
+	/** Takes a chunk actor of exactly the given class out of the pool and renames it to the given name. Returns nullptr if there is none. The chunk needs to be setup and then reactivated */
+	AOWGChunk* AcquirePooledChunk( const UClass* ChunkClass, FName ChunkName );
+
 	UOpenWorldGeneratorSubsystem* GetOwnerSubsystem() const;
+
+	/** Returns the memory used by all of the loaded chunks as of the last memory accounting pass */
+	FORCEINLINE const FChunkMemoryUsage& GetTotalChunkMemoryUsage() const { return TotalChunkMemoryUsage; }
+
+	/** Logs the memory used by the loaded chunks per category, followed by the given number of chunks using the most memory */
+	void DumpChunkMemoryUsage( int32 NumTopChunks ) const;
 protected:
 	UOWGRegionContainer* LoadRegionContainerSync(const FChunkCoord& RegionCoord);
 	UOWGRegionContainer* LoadOrCreateRegionContainerSync(const FChunkCoord& RegionCoord);
 
+	/** Collects the streaming sources from all of the registered streaming providers */
+	void GatherStreamingSources( TArray<FChunkStreamingSource>& OutStreamingSources ) const;
+
 	void TickChunkStreaming( float DeltaTime );
 	void TickChunkGeneration();
 
+	/** Spawns, updates and destroys the far-field proxies of the regions around the streaming sources */
+	void TickFarFieldProxies( float DeltaTime );
+	/** Destroys all of the far-field proxy actors and drops the cached proxy data */
+	void DestroyFarFieldProxies();
+	/** Returns the far-field proxy of the region that is not loaded, loading it from the region proxy file if needed. Returns nullptr if the region has no proxy */
+	const FOWGRegionProxyData* FindOrLoadFarFieldProxyData( const FChunkCoord& RegionCoord );
+
+	/** Periodically recalculates the memory used by the loaded chunks and enforces the memory budgets */
+	void TickChunkMemoryAccounting( float DeltaTime );
+	/** Unloads idle chunks early and adjusts the LOD bias to get the memory usage back within the configured budgets */
+	void EnforceChunkMemoryBudgets( const TArray<TPair<AOWGChunk*, FChunkMemoryUsage>>& PerChunkMemoryUsage );
+	/** Makes sure that every remote player has the chunk data replication component */
+	void TickChunkDataReplication();
+
 	FString GetFilenameForRegionCoord(const FChunkCoord& RegionCoord) const;
+	FString GetFilenameForRegionProxy( const FChunkCoord& RegionCoord ) const;
+
+	/** Reads the region proxy file. Returns false if the file does not exist or is not valid */
+	bool LoadRegionProxyFromFile( const FChunkCoord& RegionCoord, FOWGRegionProxyData& OutRegionProxy ) const;
 protected:
 	/** A map of loaded regions in the world */
 	UPROPERTY( Transient )
@@ -76,6 +126,32 @@ protected:
 	UPROPERTY( Transient )
 	TArray<TObjectPtr<AOWGChunk>> ChunksPendingGeneration;
 
+	/** Unloaded chunk actors waiting to be reused for the newly loaded chunks */
+	UPROPERTY( Transient )
+	TArray<TObjectPtr<AOWGChunk>> PooledChunks;
+
 	/** Folder where region container files will be saved, or loaded from */
 	FString RegionFolderLocation;
+
+	/** Memory used by all of the loaded chunks as of the last memory accounting pass */
+	FChunkMemoryUsage TotalChunkMemoryUsage;
+	/** Time elapsed since the last memory accounting pass */
+	float TimeSinceLastMemoryAccounting{0.0f};
+	/** Number of LODs added to the requested LOD of the non-LOD0 chunks because the rendering memory is over budget */
+	int32 MemoryBudgetLODBias{0};
+
+	/** Far-field proxy actors of the regions around the streaming sources */
+	UPROPERTY( Transient )
+	TMap<FChunkCoord, TObjectPtr<AOWGRegionProxyActor>> RegionProxyActors;
+
+	/** Far-field proxies of the regions that are not loaded, loaded from the region proxy files. Regions without the proxy file are cached as null until a proxy is written for them */
+	mutable TMap<FChunkCoord, TSharedPtr<FOWGRegionProxyData>> FarFieldProxyDataCache;
+
+	/** Material used for the far-field proxies, resolved from the settings once the first proxy is in range */
+	UPROPERTY( Transient )
+	TObjectPtr<UMaterialInterface> FarFieldProxyMaterial;
+	/** True if the far-field proxy material has been resolved, even if the settings do not specify one */
+	bool bFarFieldProxyMaterialResolved{false};
+	/** Time elapsed since the far-field proxies have been updated. Starts high so the proxies are updated on the first tick */
+	float TimeSinceLastFarFieldProxyUpdate{FLT_MAX};
 };
\ No newline at end of file
@@ -32,6 +32,8 @@ struct OPENWORLDGENERATOR_API FTerraformingBrushFalloffSettings
 	/** Seed for the random falloff effect. Used to seed the random stream generator */
 	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Brush Falloff Settings" )
 	int32 RandomFalloffSeed{0};
+
+	friend uint32 GetTypeHash( const FTerraformingBrushFalloffSettings& Settings );
 };
 
 /** Helper class for applying falloff settings */
@@ -100,6 +102,8 @@ struct OPENWORLDGENERATOR_API FTerraformingBrush
 	virtual FVector2f GetRawExtents() const { return FVector2f::ZeroVector; }
 	/** Renders the brush to the given grid, using the provided grid to world transform to convert grid coordinates to the local, non-transformed coordinates for the brush */
 	virtual bool RenderBrush( const FTransform2f& GridToLocal, int32 GridWidth, int32 GridHeight, TArray<float>& OutWeights ) const { return false; }
+	/** Returns the hash of all of the properties of the brush that affect the rendered weights. Used to look up previously rendered brushes in the stamp cache */
+	virtual uint32 GetRenderStateHash() const;
 
 	/**
 	 * Renders this brush to the grid of the given size, applying rotation and scale, and returns the weights on the grid, in addition to the brush size and grid to world transform
@@ -118,6 +122,15 @@ struct OPENWORLDGENERATOR_API FTerraformingBrush
 	
 	void RenderBrushToSizedGrid( const FVector2f& Origin, float GridOriginOffset, float GridCellSize, FIntPoint& OutGridPosXY, FIntVector2& OutGridSizeXY, TArray<float>& OutWeights, FBox2f* OutBrushBounds = nullptr ) const;
 
+	/**
+	 * Calculates the placement of the brush on the grid with the given cell size without rendering it.
+	 * OutGridOffset is the offset of the first grid point from the brush origin, the brush rendered with the same grid offset, cell size and properties will always have the same weights.
+	 */
+	void CalculateSizedGridPlacement( const FVector2f& Origin, float GridOriginOffset, float GridCellSize, FIntPoint& OutGridPosXY, FIntVector2& OutGridSizeXY, FVector2f& OutGridOffset, FBox2f& OutBrushBounds ) const;
+
+	/** Renders the brush to the grid placed by CalculateSizedGridPlacement. OutWeights should be zeroed and have the size of the grid */
+	void RenderBrushToPlacedGrid( const FVector2f& GridOffset, float GridCellSize, const FIntVector2& GridSizeXY, TArray<float>& OutWeights ) const;
+
 	/** Rotation of this brush, in degrees */
 	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Brush" )
 	float Rotation{0.0f};
@@ -151,6 +164,15 @@ struct OPENWORLDGENERATOR_API FPolymorphicTerraformingBrush
 	bool Serialize(FArchive& Ar);
 
 	const FTerraformingBrush* operator->() const;
+
+	/** Returns the type of the wrapped brush */
+	const UScriptStruct* GetBrushStruct() const;
+
+	/**
+	 * Renders the wrapped brush to the sized grid, re-using the previously rendered weights from the brush stamp cache when the same brush has already been rendered with the same grid alignment.
+	 * Parameters are the same as in FTerraformingBrush::RenderBrushToSizedGrid.
+	 */
+	void RenderBrushToSizedGrid( const FVector2f& Origin, float GridOriginOffset, float GridCellSize, FIntPoint& OutGridPosXY, FIntVector2& OutGridSizeXY, TArray<float>& OutWeights, FBox2f* OutBrushBounds = nullptr ) const;
 private:
 	/** Inner brush of the polymorphic type that this struct is wrapping */
 	TUniquePtr<TStructOnScope<FTerraformingBrush>> InnerBrush;
@@ -179,6 +201,7 @@ struct OPENWORLDGENERATOR_API FBoxTerraformingBrush : public FTerraformingBrush
 	// Begin FTerraformingBrush interface
 	virtual FVector2f GetRawExtents() const override;
 	virtual bool RenderBrush(const FTransform2f& GridToLocal, int32 GridWidth, int32 GridHeight, TArray<float>& OutWeights) const override;
+	virtual uint32 GetRenderStateHash() const override;
 	// End FTerraformingBrush interface
 
 	/** Extents of the box this brush represents */
@@ -198,6 +221,7 @@ struct OPENWORLDGENERATOR_API FEllipseTerraformingBrush : public FTerraformingBr
 	// Begin FTerraformingBrush interface
 	virtual FVector2f GetRawExtents() const override;
 	virtual bool RenderBrush(const FTransform2f& GridToLocal, int32 GridWidth, int32 GridHeight, TArray<float>& OutWeights) const override;
+	virtual uint32 GetRenderStateHash() const override;
 	// End FTerraformingBrush interface
 
 	/** Extents of the ellipse this brush represents */
@@ -208,6 +232,46 @@ struct OPENWORLDGENERATOR_API FEllipseTerraformingBrush : public FTerraformingBr
 	FTerraformingBrushFalloffSettings FalloffSettings;
 };
 
+/**
+ * Cache of the brushes rendered to the sized grids. Keyed by the brush properties, the grid cell size and the alignment of the brush relative to the grid.
+ * Alignment is snapped to a fixed number of steps per grid cell (owg.BrushStampOffsetSteps) and used as an integer key, so brushes placed at slightly different locations can share the entry.
+ * Mostly benefits tools that apply the same brush repeatedly at the same or grid-aligned locations, such as continuous painting.
+ */
+class OPENWORLDGENERATOR_API FTerraformingBrushStampCache
+{
+	struct FStampEntry
+	{
+		FPolymorphicTerraformingBrush Brush;
+		uint32 BrushHash{0};
+		float GridCellSize{0.0f};
+		FIntPoint QuantizedGridOffset{};
+		FIntVector2 GridSizeXY{};
+		TArray<float> Weights;
+		uint64 LastUsedCounter{0};
+	};
+	TArray<FStampEntry> Entries;
+	uint64 UsageCounter{0};
+	mutable FCriticalSection CacheCriticalSection;
+public:
+	/** Returns the global stamp cache instance */
+	static FTerraformingBrushStampCache& Get();
+
+	/** Returns true if the stamp cache is enabled. Brush placement is only snapped to the quantization steps when it is */
+	static bool IsEnabled();
+
+	/** Snaps the offset of the grid relative to the brush origin to the quantization steps, and returns the integer key of the snapped offset */
+	static FIntPoint QuantizeGridOffset( float GridCellSize, FVector2f& InOutGridOffset );
+
+	/** Attempts to find the weights for the brush rendered with the given grid placement. Returns true if they have been found */
+	bool FindStamp( const FPolymorphicTerraformingBrush& Brush, uint32 BrushHash, float GridCellSize, const FIntPoint& QuantizedGridOffset, const FIntVector2& GridSizeXY, TArray<float>& OutWeights );
+
+	/** Adds the rendered brush weights to the cache, evicting the least recently used entry if the cache is full */
+	void AddStamp( const FPolymorphicTerraformingBrush& Brush, uint32 BrushHash, float GridCellSize, const FIntPoint& QuantizedGridOffset, const FIntVector2& GridSizeXY, const TArray<float>& Weights );
+
+	/** Removes all of the cached stamps. Called when the cache settings change, and on module shutdown since the cached brushes cannot outlive the reflection data of their structs */
+	void Reset();
+};
+
 /** A terraforming brush that is formed by an intersection or overlap of multiple independent sub-brushes */
 /*USTRUCT( BlueprintType )
 struct OPENWORLDGENERATOR_API FComplexTerraformingBrush : public FTerraformingBrush
@@ -8,6 +8,7 @@
 #include "OWGChunkLandscapeLayer.h"
 #include "Async/AsyncWork.h"
 #include "Partition/ChunkCoord.h"
+#include "Partition/ChunkData2D.h"
 #include "ChunkLandscapeGrassSubsystem.generated.h"
 
 class AOWGChunk;
@@ -63,6 +64,12 @@ public:
 	// End UTickableWorldSubsystem interface
 
 	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+	/** Returns the memory used by the grass instances built for the given chunk */
+	SIZE_T GetChunkGrassAllocatedSize( const FChunkCoord& ChunkCoord ) const;
+
+	/** Destroys the grass components built for the given chunk immediately, instead of waiting for the stale grass cleanup */
+	void DestroyChunkGrass( const FChunkCoord& ChunkCoord );
 private:
 	void UpdateChunkGrass( const TArray<FVector>& InCameraLocations );
 	void CleanupStaleChunkGrass();
@@ -103,6 +110,9 @@ protected:
 	FOWGLandscapeGrassVariety GrassVariety;
 	FRandomStream RandomStream;
 	TSharedPtr<FCachedChunkLandscapeData> ChunkGrassSourceData;
+	/** Typed views over the source data, validated once when the task is created */
+	TChunkData2DView<const float> HeightMapView;
+	TChunkData2DView<const FVector3f> NormalMapView;
 	int32 HaltonBaseIndex{0};
 	int32 SqrtMaxInstances{0};
 	FBox MeshBox{};
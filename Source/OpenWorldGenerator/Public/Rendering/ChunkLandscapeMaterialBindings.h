@@ -22,6 +22,21 @@ struct OPENWORLDGENERATOR_API FChunkLandscapeMaterialLayerBlendInfo
 	/** Name of the vector parameter which will be populated with the weight map channel mask for this layer */
 	UPROPERTY( EditAnywhere, Category = "Landscape Material" )
 	FName WeightMapChannelMaskParameterName;
+
+	/** Name of the texture parameter which will be populated with the weight map texture array atlas for this layer. Used instead of the weight map texture when weight map atlases are enabled */
+	UPROPERTY( EditAnywhere, Category = "Landscape Material" )
+	FName WeightMapTextureArrayParameterName;
+
+	/** Name of the scalar parameter which will be populated with the index of the weight map atlas slice for this layer */
+	UPROPERTY( EditAnywhere, Category = "Landscape Material" )
+	FName WeightMapSliceIndexParameterName;
+
+	/**
+	 * Name of the scalar parameter which will be populated with the index of the custom primitive data float holding the weight map atlas slice index for this layer.
+	 * Used instead of the slice index parameter when the landscape material instances are shared between the chunks
+	 */
+	UPROPERTY( EditAnywhere, Category = "Landscape Material" )
+	FName WeightMapPrimitiveDataIndexParameterName;
 };
 
 USTRUCT()
@@ -67,6 +82,25 @@ public:
 	UPROPERTY( EditAnywhere, Config, Category = "Landscape Material" )
 	TMap<TSoftObjectPtr<UMaterialFunctionInterface>, FChunkLandscapeMaterialLayerInfo> LayerMappings;
 
+	/**
+	 * When enabled, chunk weight maps are allocated as slices of shared texture array atlases instead of individual textures.
+	 * Requires landscape blends to sample the weight map through the texture array and slice index parameters.
+	 */
+	UPROPERTY( EditAnywhere, Config, Category = "Landscape Material" )
+	bool bUseWeightMapAtlas{false};
+
+	/**
+	 * When enabled, chunks share a single landscape material instance per biome and weight map layout instead of creating their own instances.
+	 * Atlas slice indices of the chunk are passed to the material through the custom primitive data of the landscape mesh instead of the material parameters.
+	 * Requires weight map atlases, and landscape blends to read the slice index from the custom primitive data at the index provided by the primitive data index parameter.
+	 */
+	UPROPERTY( EditAnywhere, Config, Category = "Landscape Material", meta = ( EditCondition = "bUseWeightMapAtlas" ) )
+	bool bShareLandscapeMaterialInstances{false};
+
+	/** Index of the first custom primitive data float used for the weight map atlas slice indices when the landscape material instances are shared */
+	UPROPERTY( EditAnywhere, Config, Category = "Landscape Material", meta = ( EditCondition = "bShareLandscapeMaterialInstances", ClampMin = "0" ) )
+	int32 WeightMapPrimitiveDataOffset{0};
+
 	/** Materials used for visualizing LOD levels of landscapes when enabled, for debugging */
 	UPROPERTY( EditAnywhere, Config, Category = "Landscape Material|Debug" )
 	TArray<TSoftObjectPtr<UMaterialInterface>> LODVisualizationMaterials;
@@ -3,17 +3,74 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Engine/Texture2DArray.h"
+#include "Engine/Texture2DDynamic.h"
+#include "Rendering/ChunkWeightMapAtlasTexture.h"
 #include "UObject/Object.h"
+#include "UObject/ObjectKey.h"
 #include "ChunkTextureManager.generated.h"
 
-class UTexture2D;
-class UTexture2DArray;
+class UTexture2DDynamic;
+class UChunkWeightMapAtlasTexture;
+struct FChunkWeightMapAtlasStagingTexture;
 class FChunkLandscapeWeightMap;
 class FChunkData2D;
 class FChunkLandscapeWeightMapDescriptor;
+class UMaterialInterface;
+class UMaterialInstanceDynamic;
+class UOWGBiome;
 
-/** Manages texture pooling and allocation/population for chunks */
+/** Slice of the weight map texture array atlas allocated for a single weight map texture of the chunk */
+struct OPENWORLDGENERATOR_API FChunkWeightMapAtlasSlice
+{
+	/** Index of the atlas texture array in the texture manager */
+	int32 AtlasIndex{INDEX_NONE};
+	/** Index of the slice in the atlas texture array */
+	int32 SliceIndex{INDEX_NONE};
+
+	FORCEINLINE bool IsValid() const { return AtlasIndex != INDEX_NONE && SliceIndex != INDEX_NONE; }
+};
+
+/**
+ * Identifies a landscape material instance that can be shared between the chunks.
+ * Chunks using the same base material and biome, with the layers of the material bound to the same weight map channels and atlases, end up with identical parameters,
+ * and only differ by the atlas slice indices, which are passed to the material through the custom primitive data of the landscape mesh.
+ */
+struct OPENWORLDGENERATOR_API FSharedLandscapeMaterialKey
+{
+	TObjectKey<UMaterialInterface> BaseMaterial;
+	TObjectKey<UOWGBiome> Biome;
+	/** Weight map layer index and atlas index for each of the material layers, or INDEX_NONE for the layers not present in the chunk */
+	TArray<int32> LayerBindings;
+
+	FORCEINLINE bool IsValid() const { return BaseMaterial != TObjectKey<UMaterialInterface>(); }
+
+	FORCEINLINE friend bool operator==( const FSharedLandscapeMaterialKey& A, const FSharedLandscapeMaterialKey& B )
+	{
+		return A.BaseMaterial == B.BaseMaterial && A.Biome == B.Biome && A.LayerBindings == B.LayerBindings;
+	}
+
+	FORCEINLINE friend uint32 GetTypeHash( const FSharedLandscapeMaterialKey& Key )
+	{
+		uint32 Hash = HashCombine( GetTypeHash( Key.BaseMaterial ), GetTypeHash( Key.Biome ) );
+		for ( const int32 LayerBinding : Key.LayerBindings )
+		{
+			Hash = HashCombine( Hash, ::GetTypeHash( LayerBinding ) );
+		}
+		return Hash;
+	}
+};
+
+/** Landscape material instance shared between the chunks, with the number of chunks currently using it */
+struct FSharedLandscapeMaterialInstance
+{
+	TObjectPtr<UMaterialInstanceDynamic> MaterialInstance;
+	int32 ReferenceCount{0};
+};
+
+/**
+ * Manages texture pooling and allocation/population for chunks, and the landscape material instances shared between the chunks using the weight map atlases.
+ * Weight map textures do not keep a CPU copy of their data, updates are packed into transient staging buffers containing only the dirty region and uploaded on the render thread.
+ */
 UCLASS()
 class OPENWORLDGENERATOR_API UChunkTextureManager : public UObject
 {
@@ -25,21 +82,56 @@ public:
 	void ReleasePooledTextures();
 
 	/** Creates a weight map texture for the given weight map and surface layers. Might re-use one of the textures in the pool */
-	UTexture2D* CreateWeightMapTexture( const FChunkData2D* WeightMap, int32 WeightMapIndex );
+	UTexture2DDynamic* CreateWeightMapTexture( const FChunkData2D* WeightMap, int32 WeightMapIndex );
 
-	/** Performs a partial update of the data on the given weight map texture */
-	static void PartialUpdateWeightMap( UTexture2D* WeightMapTexture, int32 TextureIndex, const FChunkData2D* WeightMap, int32 StartX, int32 StartY, int32 EndX, int32 EndY, bool bFullUpdate = false );
+	/** Performs a partial update of the data on the given weight map textures. Textures are consecutive, and hold 4 layers each starting with the first texture index */
+	static void PartialUpdateWeightMap( TConstArrayView<UTexture2DDynamic*> WeightMapTextures, int32 FirstTextureIndex, const FChunkData2D* WeightMap, int32 StartX, int32 StartY, int32 EndX, int32 EndY );
 
 	/** Releases the previously created surface layers texture back into the pool */
-	void ReleaseSurfaceLayersTexture( UTexture2D* WeightMapTexture );
+	void ReleaseSurfaceLayersTexture( UTexture2DDynamic* WeightMapTexture );
+
+	/** Allocates a slice in one of the weight map atlases with the given resolution, creating a new atlas if all of the existing ones are full, and populates it with the weight map data */
+	FChunkWeightMapAtlasSlice CreateWeightMapAtlasSlice( const FChunkData2D* WeightMap, int32 TextureIndex );
+
+	/** Performs a partial update of the data in the given weight map atlas slices. Slices are consecutive, and hold 4 layers each starting with the first texture index */
+	void PartialUpdateWeightMapAtlasSlices( TConstArrayView<FChunkWeightMapAtlasSlice> AtlasSlices, int32 FirstTextureIndex, const FChunkData2D* WeightMap, int32 StartX, int32 StartY, int32 EndX, int32 EndY );
+
+	/** Returns the slice back to the atlas so it can be re-used by other chunks */
+	void ReleaseWeightMapAtlasSlice( const FChunkWeightMapAtlasSlice& AtlasSlice );
+
+	/** Returns the texture array backing the given atlas slice */
+	UChunkWeightMapAtlasTexture* GetWeightMapAtlasTexture( const FChunkWeightMapAtlasSlice& AtlasSlice ) const;
+
+	/** Returns the shared landscape material instance for the given key, creating it with the provided function if there is none yet. Every call must be paired with a release */
+	UMaterialInstanceDynamic* AcquireSharedLandscapeMaterial( const FSharedLandscapeMaterialKey& MaterialKey, TFunctionRef<UMaterialInstanceDynamic*()> CreateMaterialInstance );
+
+	/** Releases the reference to the shared landscape material instance, destroying it once it is no longer used by any chunks */
+	void ReleaseSharedLandscapeMaterial( const FSharedLandscapeMaterialKey& MaterialKey );
+
+	// Begin UObject interface
+	static void AddReferencedObjects( UObject* InThis, FReferenceCollector& Collector );
+	// End UObject interface
 protected:
 	/** Attempts to retain the weight map texture from the pool, or creates a new one */
-	UTexture2D* RetainSurfaceLayersTexture( int32 WeightMapResolutionXY );
+	UTexture2DDynamic* RetainSurfaceLayersTexture( int32 WeightMapResolutionXY );
 
 	/** Pooled weight map textures available to be re-claimed */
 	UPROPERTY( Transient )
-	TArray<TObjectPtr<UTexture2D>> PooledWeightMapTextures;
+	TArray<TObjectPtr<UTexture2DDynamic>> PooledWeightMapTextures;
 	
 	/** Counter for how many weight map textures we have created */
 	int32 SurfaceLayersTextureCounter{0};
+
+	/** Weight map texture array atlases. Each slice of the atlas holds 4 layers of a single chunk weight map */
+	UPROPERTY( Transient )
+	TArray<TObjectPtr<UChunkWeightMapAtlasTexture>> WeightMapAtlases;
+
+	/** Indices of the slices that are not currently allocated, per atlas */
+	TArray<TArray<int32>> WeightMapAtlasFreeSlices;
+
+	/** Staging texture the dirty regions of the atlas slices are uploaded to before being copied into the atlases. Shared by all atlas updates and only accessed on the render thread */
+	TSharedPtr<FChunkWeightMapAtlasStagingTexture, ESPMode::ThreadSafe> AtlasStagingTexture;
+
+	/** Landscape material instances shared between the chunks */
+	TMap<FSharedLandscapeMaterialKey, FSharedLandscapeMaterialInstance> SharedLandscapeMaterials;
 };
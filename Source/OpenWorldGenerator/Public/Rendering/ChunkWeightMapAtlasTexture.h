@@ -0,0 +1,54 @@
+﻿// Copyright Nikita Zolotukhin. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RHI.h"
+#include "Engine/Texture.h"
+#include "ChunkWeightMapAtlasTexture.generated.h"
+
+/** RHI texture array backing the weight map atlas, shared between the atlas and it's render resource. Contents are only accessed on the render thread */
+struct OPENWORLDGENERATOR_API FChunkWeightMapAtlasRHI
+{
+	FTextureRHIRef TextureRHI;
+	/** Access state the texture is currently in. Every transition performed on the texture must update it */
+	ERHIAccess CurrentAccess{ERHIAccess::Unknown};
+};
+
+/**
+ * Texture array holding the weight map atlas slices of the chunks. Unlike UTexture2DArray, it does not keep any CPU copy of the slices, they are only ever written through the staging uploads.
+ * RHI texture is owned by the atlas rather than the render resource, so the live slices survive the render resource being re-created.
+ */
+UCLASS( Transient )
+class OPENWORLDGENERATOR_API UChunkWeightMapAtlasTexture : public UTexture
+{
+	GENERATED_BODY()
+public:
+	/** Creates a new atlas with the given slice resolution and number of slices, and creates it's render resource */
+	static UChunkWeightMapAtlasTexture* Create( UObject* Outer, FName Name, int32 InSliceSizeXY, int32 InNumSlices );
+
+	FORCEINLINE int32 GetSliceSizeXY() const { return SliceSizeXY; }
+	FORCEINLINE int32 GetNumSlices() const { return NumSlices; }
+
+	/** Returns the RHI texture of the atlas. Must only be dereferenced on the render thread */
+	FORCEINLINE const TSharedPtr<FChunkWeightMapAtlasRHI, ESPMode::ThreadSafe>& GetAtlasRHI() const { return AtlasRHI; }
+
+	// Begin UTexture interface
+	virtual FTextureResource* CreateResource() override;
+	virtual EMaterialValueType GetMaterialType() const override;
+	virtual float GetSurfaceWidth() const override;
+	virtual float GetSurfaceHeight() const override;
+	virtual float GetSurfaceDepth() const override;
+	virtual uint32 GetSurfaceArraySize() const override;
+	virtual ETextureClass GetTextureClass() const override;
+	// End UTexture interface
+protected:
+	/** Resolution of a single slice of the atlas */
+	int32 SliceSizeXY{0};
+
+	/** Number of slices in the atlas */
+	int32 NumSlices{0};
+
+	/** RHI texture of the atlas, outliving the render resource */
+	TSharedPtr<FChunkWeightMapAtlasRHI, ESPMode::ThreadSafe> AtlasRHI;
+};
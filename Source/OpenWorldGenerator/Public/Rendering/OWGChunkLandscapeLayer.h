@@ -27,6 +27,10 @@ public:
 	/** The name under which this layer should be exposed to the Procedural Content Generation framework as a metadata for each point */
 	UPROPERTY( EditAnywhere, Category = "Landscape Layer" )
 	FName PCGMetadataAttributeName;
+
+	/** Average color of this layer, used to tint the far-field region proxies rendered beyond the chunk streaming distance */
+	UPROPERTY( EditAnywhere, Category = "Landscape Layer" )
+	FLinearColor FarFieldColor{FLinearColor::Gray};
 };
 
 UENUM()
@@ -7,7 +7,24 @@
 
 class FChunkData2D;
 
+/** Settings for the skirts generated along the edges of the surface mesh, which hide the cracks between neighbouring surfaces using different LODs */
+struct OPENWORLDGENERATOR_API FSurfaceMeshSkirtSettings
+{
+	/** True if the skirts should be generated */
+	bool bGenerateSkirts{false};
+	/** Minimum depth of the skirts below the edge, in world units */
+	float MinSkirtDepth{0.0f};
+	/** Coarsest LOD the neighbouring surfaces can use. Skirts are made deep enough to cover the cracks against the neighbours using any LOD up to this one */
+	int32 MaxNeighbourLODIndex{0};
+};
+
 namespace SurfaceMeshGenerator
 {
-	OPENWORLDGENERATOR_API void GenerateChunkSurfaceMesh( UE::Geometry::FDynamicMesh3& DynamicMesh, float SurfaceSizeWorldUnits, const FChunkData2D& LandscapeHeightMap, const FChunkData2D& NormalMap, const FChunkData2D& BiomeMap, int32 LODIndex = 0 );
+	OPENWORLDGENERATOR_API void GenerateChunkSurfaceMesh( UE::Geometry::FDynamicMesh3& DynamicMesh, float SurfaceSizeWorldUnits, const FChunkData2D& LandscapeHeightMap, const FChunkData2D& NormalMap, const FChunkData2D& BiomeMap, int32 LODIndex = 0, const FSurfaceMeshSkirtSettings& SkirtSettings = FSurfaceMeshSkirtSettings() );
+
+	/**
+	 * Calculates the maximum vertical distance between the edge of the surface mesh generated for the given LOD and the heightmap samples along that edge.
+	 * Neighbouring surfaces share the edge samples, so the cracks between them are bounded by the sum of their edge errors. Edges are ordered as -Y, +Y, -X, +X
+	 */
+	OPENWORLDGENERATOR_API void CalculateEdgeHeightErrors( const FChunkData2D& LandscapeHeightMap, int32 LODIndex, float OutEdgeHeightErrors[4] );
 }